@@ -23,13 +23,49 @@
 // SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
 
 #import "AMConcurrentOperation.h"
+#import "AMConnectionTransport.h"
+#import "AMUtilities.h"
+
+@class AMRetryPolicy;
+@class AMUploadBody;
 
 // --- Asynchrounous Action Based Values -- //
+// Progress values are NSNumbers from 0.0 to 1.0, or -1.0 if the expected length is unknown.
 extern NSString * const AMAsynchronousConnectionStatusDownloadProgressKey;
 extern NSString * const AMAsynchronousConnectionStatusUploadProgressKey;
 extern NSString * const AMAsynchronousConnectionStatusReceivedURLHeadersKey;
 
-@interface AMAsyncConnectionOperation : AMConcurrentOperation <NSCopying, NSURLConnectionDelegate, NSURLConnectionDataDelegate>
+/*!
+ * The direction of the transfer reported by an AMConnectionProgress.
+ */
+typedef NS_ENUM(NSInteger, AMConnectionProgressPhase)
+{
+    AMConnectionProgressPhaseUpload,
+    AMConnectionProgressPhaseDownload
+};
+
+/*!
+ * Progress of a connection operation.
+ */
+typedef struct
+{
+    AMConnectionProgressPhase phase;
+    long long completedBytes;
+    long long expectedBytes; // -1 if unknown.
+} AMConnectionProgress;
+
+/*!
+ * Returns the completed fraction of a progress.
+ * @param progress The progress.
+ * @return A value from 0.0 to 1.0, or -1.0 if the expected length is unknown.
+ */
+extern float AMConnectionProgressFraction(AMConnectionProgress progress);
+
+/*!
+ * Connection operation performing a NSURLRequest.
+ * @discussion Copies of a cancelled operation resume the download from the bytes already received, using HTTP Range requests, when the server provides an ETag or Last-Modified validator.
+ */
+@interface AMAsyncConnectionOperation : AMConcurrentOperation <NSCopying, AMConnectionTransferDelegate>
 
 /// --------------------------------------------------------------------------------------------------------------------------------
 /// @name Creating and getting instances
@@ -58,9 +94,102 @@ extern NSString * const AMAsynchronousConnectionStatusReceivedURLHeadersKey;
 
 /*!
  * Progress Status Block.
+ * @discussion Updates are throttled and delivered in the same way as for the progressBlock.
  */
 @property (nonatomic, strong) void (^progressStatusBlock)(NSDictionary *info);
 
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Progress
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * Progress Block. Unlike the progressStatusBlock, it receives a plain struct and no object is allocated to report the progress.
+ */
+@property (nonatomic, strong) void (^progressBlock)(AMConnectionProgress progress);
+
+/*!
+ * The minimum time between two progress updates. Default value is 0 (no limit).
+ * @discussion The first update of each phase and the update completing the transfer are always reported.
+ */
+@property (nonatomic, assign) NSTimeInterval progressInterval;
+
+/*!
+ * The minimum change of the completed fraction between two progress updates, from 0.0 to 1.0. Default value is 0 (no limit).
+ * @discussion Ignored when the expected length is unknown.
+ */
+@property (nonatomic, assign) float progressGranularity;
+
+/*!
+ * The serial queue where the progress blocks are executed. If NULL (the default), they are executed in the connection thread.
+ * @discussion Updates are coalesced: while an update is waiting to be executed in the queue, newer updates replace it instead of being enqueued, so a slow queue (like the main queue when the UI is busy) only gets the latest progress.
+ */
+@property (nonatomic, AM_DISPATCH_PROPERTY) dispatch_queue_t progressQueue;
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Downloading to a file
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * If set, the received data is written directly to this file URL instead of being accumulated in memory.
+ * @discussion Each received chunk is written to disk as soon as it arrives, so the memory usage is bounded independently of the size of the response. If the file exists it is overwritten. When the operation fails the partially downloaded file is removed. When the operation is cancelled and the download can be resumed by a copy of the operation, the partial file is kept. The completion block receives nil data.
+ */
+@property (nonatomic, strong) NSURL *destinationURL;
+
+/*!
+ * If YES, the destination file is pre-allocated to the expected content length of the response (when known) before writing the first byte. Default value is NO.
+ */
+@property (nonatomic, assign) BOOL preallocatesDestinationFile;
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Uploading
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * If set, the body of the request is streamed from this object instead of the HTTPBody of the request.
+ * @discussion A new body stream is created for each attempt, so the body can be sent again after a redirect, a retry or when a copy of the operation is performed (for example, when unfreezing a queue). The Content-Length and Content-Type headers are set from the body.
+ */
+@property (nonatomic, strong) AMUploadBody *uploadBody;
+
+/*!
+ * Set to YES to compress the body of the request with gzip. Default value is NO.
+ * @discussion The Content-Encoding header is set to gzip, so only enable it for servers accepting compressed requests. An upload body is compressed as it is streamed and sent without Content-Length. Requests that already have a Content-Encoding are sent as they are. The upload progress counts the bytes of the uncompressed body.
+ */
+@property (nonatomic, assign) BOOL compressesRequestBody;
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Transport
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * The transport performing the request. If nil (the default), the request is performed with a NSURLConnection (AMURLConnectionTransport).
+ */
+@property (nonatomic, strong) id <AMConnectionTransport> transport;
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Deadline
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * The date when the operation must have finished, including the time waiting in the queue, waiting for a connection slot and retrying. If nil (the default), the request timeout of the connection manager queue where the operation is performed is used.
+ * @discussion When the deadline passes the operation stops and finishes with the AMConnectionManagerErrorDeadlineExceeded error. If the operation is still waiting in the queue, it is dropped without getting a network thread. Set it before performing the operation.
+ */
+@property (nonatomic, strong) NSDate *deadline;
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Retrying
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * The retry policy of the receiver. If nil (the default), the retry policy of the connection manager queue where the operation is performed is used.
+ * @discussion Retries are performed by the same operation, so the connection key doesn't change and the completion block is only called with the result of the last attempt. Downloads that have received part of the content continue from the received bytes when possible.
+ */
+@property (nonatomic, strong) AMRetryPolicy *retryPolicy;
+
+/*!
+ * The number of the current attempt, starting at 1.
+ */
+@property (nonatomic, assign, readonly) NSUInteger attemptCount;
+
 /// --------------------------------------------------------------------------------------------------------------------------------
 /// @name Authentication
 /// --------------------------------------------------------------------------------------------------------------------------------
@@ -25,22 +25,109 @@
 #import "AMAsyncConnectionOperation_Private.h"
 
 #import "AMConnectionManager_Private.h"
+#import "AMNetworkThreadPool.h"
+#import "AMRetryPolicy.h"
+#import "AMUploadBody.h"
+#import "AMDataCompressor.h"
+
+#import <errno.h>
+#import <fcntl.h>
+#import <stdatomic.h>
+#import <unistd.h>
 
 NSString * const AMAsynchronousConnectionStatusDownloadProgressKey = @"AMAsynchronousConnectionStatusDownloadProgressKey";
 NSString * const AMAsynchronousConnectionStatusUploadProgressKey = @"AMAsynchronousConnectionStatusUploadProgressKey";
 NSString * const AMAsynchronousConnectionStatusReceivedURLHeadersKey = @"AMAsynchronousConnectionStatusReceivedURLHeadersKey";
 
+float AMConnectionProgressFraction(AMConnectionProgress progress)
+{
+    if (progress.expectedBytes <= 0)
+        return progress.expectedBytes == 0 ? 1.0f : -1.0f;
+    
+    return MIN((float)((double)progress.completedBytes / (double)progress.expectedBytes), 1.0f);
+}
+
+static void AMAsyncConnectionOperationDeliverPendingProgress(void *context);
+
+static BOOL AMPreallocateFile(int fileDescriptor, off_t length)
+{
+#if defined(F_PREALLOCATE)
+    fstore_t store = {F_ALLOCATECONTIG | F_ALLOCATEALL, F_PEOFPOSMODE, 0, length, 0};
+    
+    if (fcntl(fileDescriptor, F_PREALLOCATE, &store) == -1)
+    {
+        // Contiguous space is not available, try non-contiguous.
+        store.fst_flags = F_ALLOCATEALL;
+        if (fcntl(fileDescriptor, F_PREALLOCATE, &store) == -1)
+            return NO;
+    }
+    
+    return ftruncate(fileDescriptor, length) == 0;
+#else
+    return posix_fallocate(fileDescriptor, 0, length) == 0;
+#endif
+}
+
+static BOOL AMParseContentRange(NSString *contentRange, long long *start, long long *total)
+{
+    // Expected format: "bytes <first>-<last>/<total>", where <total> may be "*".
+    NSScanner *scanner = [NSScanner scannerWithString:contentRange];
+    long long first = 0, last = 0, length = -1;
+    
+    if (![scanner scanString:@"bytes" intoString:NULL] ||
+        ![scanner scanLongLong:&first] ||
+        ![scanner scanString:@"-" intoString:NULL] ||
+        ![scanner scanLongLong:&last] ||
+        ![scanner scanString:@"/" intoString:NULL])
+        return NO;
+    
+    if (![scanner scanLongLong:&length])
+        length = -1;
+    
+    *start = first;
+    *total = length;
+    return YES;
+}
+
 @implementation AMAsyncConnectionOperation
 {
-    CGFloat _expectedContentLength;
+    long long _expectedContentLength;
+    
+    AMConnectionProgress _lastProgress;
+    uint64_t _lastProgressTime;
+    AMConnectionProgress _pendingProgress;
+    BOOL _progressDeliveryPending;
     
     NSMutableData* _data;
     NSURLResponse *_response;
     NSError *_error;
-        
-    NSPort *_port;
-    NSRunLoop *_runLoop;
-    NSURLConnection *_connection;
+    
+    int _fileDescriptor;
+    long long _fileLength;
+    BOOL _filePreallocated;
+    
+    NSString *_validator;
+    long long _resumeOffset;
+    NSMutableData *_resumeData;
+    NSString *_resumeValidator;
+    
+    // The body of the current attempt when it is compressed: its uncompressed and compressed lengths, -1 when unknown or not compressed.
+    BOOL _uploadBodyCompressed;
+    long long _requestBodyLength;
+    long long _compressedRequestBodyLength;
+    NSData *_compressedHTTPBody;
+    atomic_llong _consumedRequestBodyLength;
+    
+    NSThread *_thread;
+    id <AMConnectionTransfer> _transfer;
+    BOOL _connectionFinished;
+    BOOL _transferPaused;
+    NSError *_dropError;
+    
+    // The bytes reserved in the memory budget, the ones of the received data and of the data kept to resume.
+    unsigned long long _bufferedByteCount;
+    BOOL _transferAdmitted;
+    BOOL _transferSuspendedForMemory;
     
     BOOL _authenticationFailed;
 }
@@ -59,13 +146,34 @@ NSString * const AMAsynchronousConnectionStatusReceivedURLHeadersKey = @"AMAsync
         _completion = completion;
         
         _data = [NSMutableData data];
-        _expectedContentLength = 0.0f;
+        _fileDescriptor = -1;
+        _attemptCount = 1;
+        _expectedContentLength = NSURLResponseUnknownLength;
+        _requestBodyLength = -1;
+        _compressedRequestBodyLength = -1;
         _serverTurstAuthentication = NO;
         _authenticationFailed = NO;
     }
     return self;
 }
 
+- (void)dealloc
+{
+    AMDispatchRelease(_progressQueue);
+    
+    if (_fileDescriptor >= 0)
+        close(_fileDescriptor);
+}
+
+- (void)setProgressQueue:(dispatch_queue_t)progressQueue
+{
+    if (progressQueue == _progressQueue)
+        return;
+    
+    AMDispatchRelease(_progressQueue);
+    _progressQueue = AMDispatchRetain(progressQueue);
+}
+
 - (NSString*)description
 {
     return [NSString stringWithFormat:@"%@ - %@",[super description], [self.connectionManagerKey description]];
@@ -74,46 +182,697 @@ NSString * const AMAsynchronousConnectionStatusReceivedURLHeadersKey = @"AMAsync
 - (void)cancel
 {
     [super cancel];
-    [self _stopConnection];
+    
+    [_hedgedRequest connectionOperationWasCancelled:self];
+    
+    NSThread *thread = nil;
+    
+    @synchronized(self)
+    {
+        thread = _thread;
+    }
+    
+    // The connection is only manipulated from the thread where it has been scheduled.
+    if (thread)
+        [self performSelector:@selector(_stopConnection) onThread:thread withObject:nil waitUntilDone:NO];
 }
 
-- (void)concurrentMain
+- (void)start
 {
-    _port = [NSPort port];
-    _runLoop = [NSRunLoop currentRunLoop];
+    NSError *dropError = nil;
     
-    _connection = [[NSURLConnection alloc] initWithRequest:_request delegate:self startImmediately:NO];
+    // An operation whose deadline has already passed is dropped before getting a network thread, and so is an operation to a host whose circuit breaker is open.
+    if (!self.isCancelled && _deadline && [_deadline timeIntervalSinceNow] <= 0)
+        dropError = [self _deadlineExceededError];
+    else if (!self.isCancelled)
+        dropError = [_connectionManager am_admissionErrorForConnectionOperation:self];
     
-    [_runLoop addPort:_port forMode:NSDefaultRunLoopMode];
-    [_connection scheduleInRunLoop:_runLoop forMode:NSDefaultRunLoopMode];
-    [_connection start];
+    if (dropError)
+    {
+        @synchronized(self)
+        {
+            _dropError = dropError;
+        }
         
-    while (_connection != nil)
+        [super cancel];
+    }
+    
+    // Registered before the operation becomes executing, so a freeze of the queue doesn't miss it.
+    if (!self.isCancelled)
+        [_connectionManager am_connectionOperationDidStart:self];
+    
+    [super start];
+}
+
+- (NSThread*)concurrentMainThread
+{
+    return [[AMNetworkThreadPool defaultPool] nextThread];
+}
+
+- (BOOL)completesAsynchronously
+{
+    return YES;
+}
+
+- (void)concurrentMain
+{
+    @synchronized(self)
+    {
+        _thread = [NSThread currentThread];
+    }
+    
+    if (self.isCancelled)
     {
-        [_runLoop runUntilDate:[NSDate distantFuture]];
+        [self _stopConnection];
+        return;
     }
+    
+    // Requests over the request rate limit of the queue wait before asking for a connection slot.
+    NSTimeInterval delay = _requestRateBucket.refillRate > 0 ? [_requestRateBucket takeTokens:1.0] : 0.0;
+    
+    if (delay > 0)
+        [self performSelector:@selector(_requestTransfer) withObject:nil afterDelay:delay];
+    else
+        [self _requestTransfer];
+}
+
+- (void)am_startTransfer
+{
+    [self performSelector:@selector(_startTransfer) onThread:_thread withObject:nil waitUntilDone:NO];
+}
+
+- (void)am_deadlineExceeded
+{
+    NSThread *thread = nil;
+    
+    @synchronized(self)
+    {
+        thread = _thread;
+        
+        if (!thread && !_dropError)
+            _dropError = [self _deadlineExceededError];
+    }
+    
+    // Running operations are stopped from their thread. The other ones are cancelled and finish as soon as the queue starts them.
+    if (thread)
+        [self performSelector:@selector(_expire) onThread:thread withObject:nil waitUntilDone:NO];
+    else
+        [self cancel];
 }
 
 - (void)operationDidFinish
-{        
-    if (!self.isCancelled)
+{
+    _timestamps.completionTime = AMConnectionMetricsCurrentTime();
+    
+    NSError *dropError = nil;
+    
+    @synchronized(self)
+    {
+        dropError = _error == nil ? _dropError : nil;
+    }
+    
+    // A dropped operation is cancelled, but its completion block still gets the error.
+    if (dropError)
+    {
+        _error = dropError;
+        [_connectionManager am_connectionOperation:self connectionDidFailWithError:_error];
+    }
+    
+    if (!self.isCancelled || dropError)
     {
         if (_completion)
-            _completion(_response,_data,_error);
+            _completion(_response, _destinationURL ? nil : [self _detachReceivedData], _error);
     }
+    
+    // Once delivered, the received data doesn't count in the memory budget anymore.
+    [_memoryBudget releaseBytes:_bufferedByteCount];
+    _bufferedByteCount = 0;
+    
+    [_memoryBudget finishTransfer:self];
+    
+    [_connectionManager am_connectionOperationDidFinish:self];
 }
 
 #pragma mark Private Methods
 
+- (void)_requestTransfer
+{
+    if (_connectionFinished || self.isCancelled)
+        return;
+    
+    // While the memory budget is exhausted, transfers that receive the data in memory wait for it before asking for a connection slot.
+    if (_memoryBudget && !_destinationURL && !_transferAdmitted)
+    {
+        NSThread *thread = [NSThread currentThread];
+        __weak AMAsyncConnectionOperation *weakSelf = self;
+        
+        _transferAdmitted = [_memoryBudget admitTransfer:self whenAvailable:^{
+            [weakSelf performSelector:@selector(_requestTransfer) onThread:thread withObject:nil waitUntilDone:NO];
+        }];
+        
+        if (!_transferAdmitted)
+            return;
+    }
+    
+    AMConnectionManager *connectionManager = _connectionManager;
+    
+    // Otherwise the manager calls -am_startTransfer when a connection slot is available for the host.
+    if (!connectionManager || [connectionManager am_connectionOperationCanStartTransfer:self])
+        [self _startTransfer];
+}
+
+- (void)_startTransfer
+{
+    if (_connectionFinished || self.isCancelled)
+        return;
+    
+    [self _startConnectionWithRequest:_request];
+}
+
+- (void)_expire
+{
+    if (_connectionFinished || self.isCancelled)
+        return;
+    
+    _error = [self _deadlineExceededError];
+    
+    [_connectionManager am_connectionOperation:self connectionDidFailWithError:_error];
+    
+    [self _stopConnection];
+}
+
+- (NSError*)_deadlineExceededError
+{
+    return [NSError errorWithDomain:AMConnectionManagerErrorDomain
+                               code:AMConnectionManagerErrorDeadlineExceeded
+                           userInfo:@{NSLocalizedDescriptionKey: @"The deadline of the request has passed."}];
+}
+
+- (void)_startConnectionWithRequest:(NSURLRequest*)request
+{
+    BOOL compressesBody = _compressesRequestBody && ![request valueForHTTPHeaderField:@"Content-Encoding"];
+    
+    _uploadBodyCompressed = NO;
+    _requestBodyLength = -1;
+    _compressedRequestBodyLength = -1;
+    
+    if (_resumeOffset > 0 || _uploadBody || compressesBody)
+    {
+        NSMutableURLRequest *mutableRequest = [request mutableCopy];
+        
+        if (_resumeOffset > 0)
+        {
+            // Ask only for the bytes not received yet. If the resource has changed the server will send it complete.
+            [mutableRequest setValue:[NSString stringWithFormat:@"bytes=%lld-", _resumeOffset] forHTTPHeaderField:@"Range"];
+            [mutableRequest setValue:_resumeValidator forHTTPHeaderField:@"If-Range"];
+        }
+        
+        if (_uploadBody)
+        {
+            // A stream can only be read once, each attempt gets a new one.
+            long long contentLength = _uploadBody.contentLength;
+            
+            if (compressesBody)
+            {
+                _uploadBodyCompressed = YES;
+                _requestBodyLength = contentLength;
+                [mutableRequest setValue:nil forHTTPHeaderField:@"Content-Length"];
+                [mutableRequest setValue:@"gzip" forHTTPHeaderField:@"Content-Encoding"];
+            }
+            else if (contentLength >= 0)
+            {
+                [mutableRequest setValue:[NSString stringWithFormat:@"%lld", contentLength] forHTTPHeaderField:@"Content-Length"];
+            }
+            
+            if (_uploadBody.contentType)
+                [mutableRequest setValue:_uploadBody.contentType forHTTPHeaderField:@"Content-Type"];
+            
+            mutableRequest.HTTPBodyStream = [self _uploadBodyStream];
+        }
+        else if (compressesBody && request.HTTPBody.length > 0)
+        {
+            // The body is already in memory, it is compressed once for all the attempts.
+            if (!_compressedHTTPBody)
+                _compressedHTTPBody = [AMDataCompressor compressedData:request.HTTPBody format:AMCompressionFormatGzip];
+            
+            _requestBodyLength = request.HTTPBody.length;
+            _compressedRequestBodyLength = _compressedHTTPBody.length;
+            
+            mutableRequest.HTTPBody = _compressedHTTPBody;
+            [mutableRequest setValue:@"gzip" forHTTPHeaderField:@"Content-Encoding"];
+        }
+        
+        request = mutableRequest;
+    }
+    
+    // Retries keep the start of the first attempt, so the time waiting for them counts as time to first byte.
+    if (_timestamps.startTime == 0)
+        _timestamps.startTime = AMConnectionMetricsCurrentTime();
+    
+    id <AMConnectionTransport> transport = _transport ?: [AMURLConnectionTransport defaultTransport];
+    
+    _transferPaused = NO;
+    _transfer = [transport transferWithRequest:request delegate:self];
+    
+    [_transfer start];
+    
+    // A retry keeps the suspension of the previous attempt until the memory budget resumes it.
+    if (_transferSuspendedForMemory)
+        [_transfer suspend];
+}
+
+- (NSInputStream*)_uploadBodyStream
+{
+    if (!_uploadBodyCompressed)
+        return [_uploadBody inputStream];
+    
+    atomic_store(&_consumedRequestBodyLength, 0);
+    
+    __weak AMAsyncConnectionOperation *weakSelf = self;
+    
+    return [_uploadBody compressedInputStreamWithFormat:AMCompressionFormatGzip consumedLengthBlock:^(long long consumedLength) {
+        AMAsyncConnectionOperation *strongSelf = weakSelf;
+        
+        if (strongSelf)
+            atomic_store(&strongSelf->_consumedRequestBodyLength, consumedLength);
+    }];
+}
+
+- (void)_throttleTransferredBytes:(NSUInteger)length
+{
+    AMTokenBucket *bucket = _bandwidthBucket;
+    
+    if (bucket.refillRate <= 0)
+        return;
+    
+    NSTimeInterval delay = [bucket takeTokens:length];
+    
+    if (delay <= 0 || _transferPaused)
+        return;
+    
+    // A suspended transfer stops delivering data. Only if the transport stops reading the socket too does TCP flow
+    // control slow down the other end (see -[AMConnectionTransfer suspend]).
+    _transferPaused = YES;
+    
+    if (!_transferSuspendedForMemory)
+        [_transfer suspend];
+    
+    [self performSelector:@selector(_resumeTransfer) withObject:nil afterDelay:delay];
+}
+
+- (void)_resumeTransfer
+{
+    if (!_transferPaused)
+        return;
+    
+    _transferPaused = NO;
+    
+    if (!_transferSuspendedForMemory)
+        [_transfer resume];
+}
+
+- (void)_suspendTransferIfMemoryBudgetIsExhausted
+{
+    if (!_transferAdmitted || _transferSuspendedForMemory)
+        return;
+    
+    NSThread *thread = [NSThread currentThread];
+    __weak AMAsyncConnectionOperation *weakSelf = self;
+    
+    _transferSuspendedForMemory = [_memoryBudget suspendTransfer:self untilAvailable:^{
+        [weakSelf performSelector:@selector(_resumeTransferSuspendedForMemory) onThread:thread withObject:nil waitUntilDone:NO];
+    }];
+    
+    // As with the bandwidth limit, how far the other end is slowed down depends on the transport.
+    if (_transferSuspendedForMemory && !_transferPaused)
+        [_transfer suspend];
+}
+
+- (void)_resumeTransferSuspendedForMemory
+{
+    if (!_transferSuspendedForMemory)
+        return;
+    
+    _transferSuspendedForMemory = NO;
+    
+    if (!_transferPaused)
+        [_transfer resume];
+}
+
+- (void)_updateBufferedByteCount
+{
+    unsigned long long bufferedByteCount = 0;
+    
+    @synchronized(self)
+    {
+        bufferedByteCount = _data.length + (_resumeData != _data ? _resumeData.length : 0);
+    }
+    
+    if (bufferedByteCount > _bufferedByteCount)
+        [_memoryBudget reserveBytes:bufferedByteCount - _bufferedByteCount];
+    else if (bufferedByteCount < _bufferedByteCount)
+        [_memoryBudget releaseBytes:_bufferedByteCount - bufferedByteCount];
+    
+    _bufferedByteCount = bufferedByteCount;
+}
+
+- (NSData*)_detachReceivedData
+{
+    NSMutableData *data = nil;
+    
+    @synchronized(self)
+    {
+        data = _data;
+        _data = nil;
+    }
+    
+    // Delivered without copying. The buffer goes back to the pool when the caller releases the data.
+    return _bufferPool ? [_bufferPool dataByRecyclingBuffer:data] : data;
+}
+
+- (void)_discardResumeState
+{
+    @synchronized(self)
+    {
+        _resumeOffset = 0;
+        _resumeData = nil;
+        _resumeValidator = nil;
+    }
+}
+
+- (BOOL)_isResumable
+{
+    // Must be called while holding the lock of the receiver.
+    if (_resumeOffset > 0)
+        return YES;
+    
+    long long receivedLength = _destinationURL ? _fileLength : (long long)_data.length;
+    
+    return self.isCancelled && _error == nil && _validator != nil && receivedLength > 0;
+}
+
+- (NSString*)_validatorForResponse:(NSURLResponse*)response
+{
+    if (![response isKindOfClass:[NSHTTPURLResponse class]])
+        return nil;
+    
+    NSHTTPURLResponse *httpResponse = (id)response;
+    NSDictionary *headers = [httpResponse allHeaderFields];
+    
+    NSInteger statusCode = [httpResponse statusCode];
+    if (statusCode != 200 && statusCode != 206)
+        return nil;
+    
+    // Byte ranges refer to the encoded representation, but the received data has already been decoded.
+    NSString *contentEncoding = [headers valueForKey:@"Content-Encoding"];
+    if (contentEncoding.length > 0 && ![contentEncoding isEqualToString:@"identity"])
+        return nil;
+    
+    if ([[headers valueForKey:@"Accept-Ranges"] isEqualToString:@"none"])
+        return nil;
+    
+    // If-Range requires a strong entity tag.
+    NSString *entityTag = [headers valueForKey:@"ETag"];
+    if (entityTag.length > 0 && ![entityTag hasPrefix:@"W/"])
+        return entityTag;
+    
+    NSString *lastModified = [headers valueForKey:@"Last-Modified"];
+    if (lastModified.length > 0)
+        return lastModified;
+    
+    return nil;
+}
+
+- (NSHTTPURLResponse*)_responseByStitchingPartialResponse:(NSURLResponse*)response
+{
+    if (![response isKindOfClass:[NSHTTPURLResponse class]])
+        return nil;
+    
+    NSHTTPURLResponse *httpResponse = (id)response;
+    
+    if ([httpResponse statusCode] != 206)
+        return nil;
+    
+    NSMutableDictionary *headers = [[httpResponse allHeaderFields] mutableCopy];
+    
+    long long start = 0;
+    long long total = -1;
+    
+    if (!AMParseContentRange([headers valueForKey:@"Content-Range"], &start, &total) || start != _resumeOffset)
+        return nil;
+    
+    // Present the result as the complete resource, as if it had been received in a single response.
+    [headers removeObjectForKey:@"Content-Range"];
+    
+    if (total >= 0)
+        [headers setValue:[NSString stringWithFormat:@"%lld", total] forKey:@"Content-Length"];
+    else
+        [headers removeObjectForKey:@"Content-Length"];
+    
+    return [[NSHTTPURLResponse alloc] initWithURL:httpResponse.URL statusCode:200 HTTPVersion:@"HTTP/1.1" headerFields:headers];
+}
+
+- (BOOL)_retryWithResponse:(NSURLResponse*)response error:(NSError*)error
+{
+    AMRetryPolicy *policy = _retryPolicy ?: _queueRetryPolicy;
+    
+    if (!policy || self.isCancelled)
+        return NO;
+    
+    NSTimeInterval delay = [policy retryDelayForRequest:_request response:response error:error attempt:_attemptCount sharedBudget:_sharedRetryBudget];
+    
+    if (delay < 0)
+        return NO;
+    
+    // Don't wait for an attempt that can't start before the deadline.
+    if (_deadline && delay >= [_deadline timeIntervalSinceNow])
+        return NO;
+    
+    [NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(_resumeTransfer) object:nil];
+    
+    [_transfer cancel];
+    _transfer = nil;
+    
+    @synchronized(self)
+    {
+        // Continue from the received bytes when possible. If the attempt was already resuming, keep resuming from the same point.
+        long long receivedLength = _destinationURL ? _fileLength : (long long)_data.length;
+        
+        if (_resumeOffset == 0 && _validator != nil && receivedLength > 0)
+        {
+            _resumeOffset = receivedLength;
+            _resumeData = _destinationURL ? nil : _data;
+            _resumeValidator = _validator;
+        }
+        
+        if (_resumeData != _data)
+            [_bufferPool recycleBuffer:_data];
+        
+        _data = [NSMutableData data];
+        _response = nil;
+        _validator = nil;
+    }
+    
+    [self _updateBufferedByteCount];
+    
+    _expectedContentLength = NSURLResponseUnknownLength;
+    _lastProgressTime = 0;
+    _attemptCount++;
+    
+    // The connection slot is kept while waiting, so the retries don't add load to a host that is already at its limit.
+    [self performSelector:@selector(_startTransfer) withObject:nil afterDelay:delay];
+    
+    return YES;
+}
+
 - (void)_stopConnection
-{    
-    [_connection cancel];
+{
+    // Always called from the connection thread. The operation is completed only once.
+    if (_connectionFinished)
+        return;
+    
+    _connectionFinished = YES;
+    
+    [NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(_requestTransfer) object:nil];
+    [NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(_startTransfer) object:nil];
+    [NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(_resumeTransfer) object:nil];
+    
+    [_transfer cancel];
+    _transfer = nil;
+    
+    @synchronized(self)
+    {
+        // A cancelled download is kept on disk if a copy of the operation can resume it. If a copy has already been
+        // made, it has closed the file and the receiver doesn't touch it anymore.
+        BOOL keepFile = (_response != nil && _error == nil && !self.isCancelled) || [self _isResumable];
+        
+        [self _closeDestinationFileKeepingContent:keepFile];
+    }
+    
+    [self completeOperation];
+}
+
+- (BOOL)_openDestinationFileWithExpectedLength:(long long)expectedLength offset:(long long)offset
+{
+    // Must be called while holding the lock of the receiver.
+    // A redirect or an authentication retry may deliver more than one response. Start again from the given offset.
+    if (_fileDescriptor >= 0)
+        close(_fileDescriptor);
+    
+    int flags = O_WRONLY | O_CREAT | (offset > 0 ? 0 : O_TRUNC);
+    
+    _fileLength = 0;
+    _filePreallocated = NO;
+    _fileDescriptor = open([[_destinationURL path] fileSystemRepresentation], flags, 0644);
+    
+    if (_fileDescriptor < 0)
+        return NO;
+    
+    if (_preallocatesDestinationFile && expectedLength > 0)
+        _filePreallocated = AMPreallocateFile(_fileDescriptor, (off_t)expectedLength);
+    
+    if (offset > 0)
+    {
+        // Discard anything written after the resume point.
+        if ((!_filePreallocated && ftruncate(_fileDescriptor, (off_t)offset) != 0) || lseek(_fileDescriptor, (off_t)offset, SEEK_SET) < 0)
+            return NO;
+        
+        _fileLength = offset;
+    }
+    
+    return YES;
+}
+
+- (BOOL)_writeDataToDestinationFile:(NSData*)data
+{
+    // Must be called while holding the lock of the receiver.
+    const char *bytes = data.bytes;
+    NSUInteger length = data.length;
+    
+    while (length > 0)
+    {
+        ssize_t written = write(_fileDescriptor, bytes, length);
+        
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            
+            return NO;
+        }
+        
+        bytes += written;
+        length -= written;
+        _fileLength += written;
+    }
+    
+    return YES;
+}
+
+- (void)_closeDestinationFileKeepingContent:(BOOL)keep
+{
+    // Must be called while holding the lock of the receiver.
+    if (_fileDescriptor < 0)
+        return;
+    
+    // Drop the pre-allocated space that has not been used.
+    if (keep && _filePreallocated)
+        ftruncate(_fileDescriptor, (off_t)_fileLength);
+    
+    close(_fileDescriptor);
+    _fileDescriptor = -1;
+    
+    if (!keep)
+        unlink([[_destinationURL path] fileSystemRepresentation]);
+}
+
+- (BOOL)_shouldReportProgress:(AMConnectionProgress)progress now:(uint64_t)now
+{
+    if (_lastProgressTime == 0 || progress.phase != _lastProgress.phase)
+        return YES;
+    
+    if (progress.expectedBytes >= 0 && progress.completedBytes >= progress.expectedBytes)
+        return YES;
+    
+    if (_progressInterval > 0 && now - _lastProgressTime < (uint64_t)(_progressInterval * 1e6))
+        return NO;
+    
+    if (_progressGranularity > 0 && progress.expectedBytes > 0)
+    {
+        float delta = AMConnectionProgressFraction(progress) - AMConnectionProgressFraction(_lastProgress);
+        if (delta < _progressGranularity)
+            return NO;
+    }
+    
+    return YES;
+}
+
+- (void)_reportProgress:(AMConnectionProgress)progress
+{
+    // Always called from the connection thread.
+    if (!_progressBlock && !_progressStatusBlock)
+        return;
+    
+    uint64_t now = AMConnectionMetricsCurrentTime();
+    
+    if (![self _shouldReportProgress:progress now:now])
+        return;
+    
+    _lastProgress = progress;
+    _lastProgressTime = now;
+    
+    if (!_progressQueue)
+    {
+        [self _deliverProgress:progress];
+        return;
+    }
+    
+    @synchronized(self)
+    {
+        _pendingProgress = progress;
+        
+        // The pending delivery will pick up this value.
+        if (_progressDeliveryPending)
+            return;
+        
+        _progressDeliveryPending = YES;
+    }
+    
+    dispatch_async_f(_progressQueue, (__bridge_retained void*)self, AMAsyncConnectionOperationDeliverPendingProgress);
+}
+
+- (void)_deliverPendingProgress
+{
+    AMConnectionProgress progress;
+    
+    @synchronized(self)
+    {
+        progress = _pendingProgress;
+        _progressDeliveryPending = NO;
+    }
+    
+    [self _deliverProgress:progress];
+}
+
+- (void)_deliverProgress:(AMConnectionProgress)progress
+{
+    if (_progressBlock)
+        _progressBlock(progress);
+    
+    if (_progressStatusBlock)
+    {
+        NSString *key = progress.phase == AMConnectionProgressPhaseUpload ? AMAsynchronousConnectionStatusUploadProgressKey : AMAsynchronousConnectionStatusDownloadProgressKey;
+        _progressStatusBlock(@{key: @(AMConnectionProgressFraction(progress))});
+    }
+}
+
+- (void)_failWithPOSIXError:(int)code
+{
+    _error = [NSError errorWithDomain:NSPOSIXErrorDomain code:code userInfo:nil];
     
-    [_port invalidate];
-    [_runLoop removePort:_port forMode:NSDefaultRunLoopMode];
-    _port = nil;
+    [_connectionManager am_connectionOperation:self connectionDidFailWithError:_error];
     
-    _connection = nil;
+    [self _stopConnection];
 }
 
 #pragma mark - Protocols
@@ -125,25 +884,70 @@ NSString * const AMAsynchronousConnectionStatusReceivedURLHeadersKey = @"AMAsync
     AMAsyncConnectionOperation *operation = [[AMAsyncConnectionOperation allocWithZone:zone] initWithRequest:_request
                                                                                              completionBlock:_completion];
     operation.progressStatusBlock = _progressStatusBlock;
+    operation.progressBlock = _progressBlock;
+    operation.progressInterval = _progressInterval;
+    operation.progressGranularity = _progressGranularity;
+    operation.progressQueue = _progressQueue;
     operation.connectionManagerKey = _connectionManagerKey;
+    operation.destinationURL = _destinationURL;
+    operation.preallocatesDestinationFile = _preallocatesDestinationFile;
+    operation.uploadBody = _uploadBody;
+    operation.compressesRequestBody = _compressesRequestBody;
+    operation.transport = _transport;
+    operation.retryPolicy = _retryPolicy;
+    operation.deadline = _deadline;
+    operation.queueRetryPolicy = _queueRetryPolicy;
+    operation.sharedRetryBudget = _sharedRetryBudget;
+    operation.bandwidthBucket = _bandwidthBucket;
+    operation.requestRateBucket = _requestRateBucket;
+    operation.memoryBudget = _memoryBudget;
+    operation.bufferPool = _bufferPool;
+    operation.queueIdentifier = _queueIdentifier;
+    operation.connectionManager = _connectionManager;
     
     operation.queuePriority = self.queuePriority;
     operation.completionBlock = self.completionBlock;
     
+    @synchronized(self)
+    {
+        // Transfer the received bytes to the copy so it can continue where the receiver has stopped.
+        if (_resumeOffset > 0)
+        {
+            operation->_resumeOffset = _resumeOffset;
+            operation->_resumeData = [_resumeData mutableCopy];
+            operation->_resumeValidator = _resumeValidator;
+        }
+        else if ([self _isResumable])
+        {
+            operation->_resumeOffset = _destinationURL ? _fileLength : (long long)_data.length;
+            operation->_resumeData = _destinationURL ? nil : [_data mutableCopy];
+            operation->_resumeValidator = _validator;
+        }
+        
+        // Hand the destination file over to the copy: a cancelled receiver neither writes to it nor opens it again, and
+        // closing it now makes sure its truncation or removal can't happen after the copy has started writing.
+        if (self.isCancelled)
+            [self _closeDestinationFileKeepingContent:[self _isResumable]];
+    }
+    
     return operation;
 }
 
-#pragma mark NSURLConnectionDelegate
+#pragma mark AMConnectionTransferDelegate
 
-- (void)connection:(NSURLConnection *)connection didFailWithError:(NSError *)error
+- (void)transfer:(id <AMConnectionTransfer>)transfer didFailWithError:(NSError *)error
 {
+    if ([self _retryWithResponse:_response error:error])
+        return;
+    
     _error = error;
-    [self _stopConnection];
     
-    [[AMConnectionManager defaultManager] am_connectionOperation:self connectionDidFailWithError:error];
+    [_connectionManager am_connectionOperation:self connectionDidFailWithError:error];
+    
+    [self _stopConnection];
 }
 
-- (BOOL)connection:(NSURLConnection *)connection canAuthenticateAgainstProtectionSpace:(NSURLProtectionSpace *)protectionSpace
+- (BOOL)transfer:(id <AMConnectionTransfer>)transfer canAuthenticateAgainstProtectionSpace:(NSURLProtectionSpace *)protectionSpace
 {
     if (_canAuthenticateAgainstProtectionSpace)
         return _canAuthenticateAgainstProtectionSpace(protectionSpace);
@@ -162,7 +966,7 @@ NSString * const AMAsynchronousConnectionStatusReceivedURLHeadersKey = @"AMAsync
     return canAuthenticate;
 }
 
-- (void)connection:(NSURLConnection *)connection didReceiveAuthenticationChallenge:(NSURLAuthenticationChallenge *)challenge
+- (void)transfer:(id <AMConnectionTransfer>)transfer didReceiveAuthenticationChallenge:(NSURLAuthenticationChallenge *)challenge
 {
     if (_performAuthenticationWithChallenge)
     {
@@ -191,63 +995,233 @@ NSString * const AMAsynchronousConnectionStatusReceivedURLHeadersKey = @"AMAsync
             if (_authenticationDidFail)
                 _authenticationDidFail(self, challenge);
             
-            [[AMConnectionManager defaultManager] am_connectionOperation:self authenticationDidFailWithAuthenticationChallenge:challenge];
+            [_connectionManager am_connectionOperation:self authenticationDidFailWithAuthenticationChallenge:challenge];
             
             [[challenge sender] cancelAuthenticationChallenge:challenge];
         }
     }
 }
 
-- (void)connection:(NSURLConnection *)connection didCancelAuthenticationChallenge:(NSURLAuthenticationChallenge *)challenge
+- (void)transfer:(id <AMConnectionTransfer>)transfer didCancelAuthenticationChallenge:(NSURLAuthenticationChallenge *)challenge
 {
     _authenticationFailed = YES;
     
     if (_authenticationDidFail)
         _authenticationDidFail(self, challenge);
     
-    [[AMConnectionManager defaultManager] am_connectionOperation:self authenticationDidFailWithAuthenticationChallenge:challenge];
+    [_connectionManager am_connectionOperation:self authenticationDidFailWithAuthenticationChallenge:challenge];
 }
 
-#pragma mark NSURLConnectionDataDelegate
-
-- (void)connection:(NSURLConnection *)connection didReceiveResponse:(NSURLResponse *)response
+- (void)transfer:(id <AMConnectionTransfer>)transfer didReceiveResponse:(NSURLResponse *)response
 {
-    _response = response;
+    long long resumeOffset = 0;
+    
+    _timestamps.firstByteTime = AMConnectionMetricsCurrentTime();
     
+    if ([self _retryWithResponse:response error:nil])
+        return;
+    
+    if (_resumeOffset > 0)
+    {
+        NSInteger statusCode = [response isKindOfClass:[NSHTTPURLResponse class]] ? [(NSHTTPURLResponse*)response statusCode] : 0;
+        NSHTTPURLResponse *stitchedResponse = [self _responseByStitchingPartialResponse:response];
+        
+        // The requested range is not satisfiable, or the server sent another range than the requested one and its
+        // body can't be appended to the received bytes. Download again the whole resource.
+        if (statusCode == 416 || (statusCode == 206 && !stitchedResponse))
+        {
+            [_transfer cancel];
+            [self _discardResumeState];
+            [self _startConnectionWithRequest:_request];
+            return;
+        }
+        
+        if (stitchedResponse)
+        {
+            resumeOffset = _resumeOffset;
+            response = stitchedResponse;
+        }
+        
+        @synchronized(self)
+        {
+            if (stitchedResponse)
+                _data = _resumeData ?: [NSMutableData data];
+            
+            // A 206 response might not include the validators, keep the ones of the original response.
+            _validator = [self _validatorForResponse:response] ?: (stitchedResponse ? _resumeValidator : nil);
+        }
+        
+        // Otherwise the server is sending the whole resource again and the received bytes are discarded.
+        [self _discardResumeState];
+    }
+    else
+    {
+        @synchronized(self)
+        {
+            _validator = [self _validatorForResponse:response];
+        }
+    }
+    
+    @synchronized(self)
+    {
+        _response = response;
+    }
+    
+    // Unknown (NSURLResponseUnknownLength) for chunked or compressed responses.
+    _expectedContentLength = [response expectedContentLength];
+    
+    // Some transports report the length of the encoded body, but the received data has already been decoded.
     if ([response isKindOfClass:[NSHTTPURLResponse class]])
     {
-        NSHTTPURLResponse *httpResponse = (id)response;
-        if ([httpResponse statusCode] == 200)
+        NSString *contentEncoding = [[(NSHTTPURLResponse*)response allHeaderFields] valueForKey:@"Content-Encoding"];
+        
+        if (contentEncoding.length > 0 && ![contentEncoding isEqualToString:@"identity"])
+            _expectedContentLength = NSURLResponseUnknownLength;
+    }
+    
+    if (!_destinationURL && _bufferPool)
+    {
+        @synchronized(self)
         {
-            _expectedContentLength = [httpResponse expectedContentLength];
+            // Sized for the expected length, so the buffer doesn't grow while receiving the response.
+            if (_data.length == 0)
+            {
+                [_bufferPool recycleBuffer:_data];
+                _data = [_bufferPool bufferWithCapacity:_expectedContentLength > 0 ? (NSUInteger)_expectedContentLength : 0];
+            }
         }
     }
     
-    if (_progressStatusBlock)
-        _progressStatusBlock(@{AMAsynchronousConnectionStatusReceivedURLHeadersKey:response});
+    [self _updateBufferedByteCount];
+    
+    if (_destinationURL)
+    {
+        BOOL opened = NO;
+        int openError = 0;
+        
+        @synchronized(self)
+        {
+            // A copy of a cancelled operation may already be writing to the destination file.
+            if (self.isCancelled)
+                return;
+            
+            opened = [self _openDestinationFileWithExpectedLength:_expectedContentLength offset:resumeOffset];
+            openError = errno;
+        }
+        
+        if (!opened)
+        {
+            [self _failWithPOSIXError:openError];
+            return;
+        }
+    }
+    
+    void (^progressStatusBlock)(NSDictionary *info) = _progressStatusBlock;
+    
+    if (progressStatusBlock)
+    {
+        if (_progressQueue)
+            dispatch_async(_progressQueue, ^{ progressStatusBlock(@{AMAsynchronousConnectionStatusReceivedURLHeadersKey:response}); });
+        else
+            progressStatusBlock(@{AMAsynchronousConnectionStatusReceivedURLHeadersKey:response});
+    }
 }
 
-- (void)connection:(NSURLConnection *)connection didReceiveData:(NSData *)data
+- (void)transfer:(id <AMConnectionTransfer>)transfer didReceiveData:(NSData *)data
 {
-    [_data appendData:data];
+    long long receivedLength = 0;
     
-    float progress = ((float)_data.length) / ((float)_expectedContentLength);
+    if (self.isCancelled)
+        return;
     
-    if (_progressStatusBlock)
-        _progressStatusBlock(@{AMAsynchronousConnectionStatusDownloadProgressKey:[NSNumber numberWithFloat:progress]});
+    _receivedByteCount += data.length;
+    
+    [self _throttleTransferredBytes:data.length];
+    
+    if (_destinationURL)
+    {
+        BOOL written = NO;
+        int writeError = 0;
+        
+        @synchronized(self)
+        {
+            // Once cancelled, the destination file belongs to the copy that resumes from it.
+            if (self.isCancelled || _fileDescriptor < 0)
+                return;
+            
+            written = [self _writeDataToDestinationFile:data];
+            writeError = errno;
+            receivedLength = _fileLength;
+        }
+        
+        if (!written)
+        {
+            [self _failWithPOSIXError:writeError];
+            return;
+        }
+    }
+    else
+    {
+        @synchronized(self)
+        {
+            // Once cancelled, the received data must stay as it is because a copy might be resuming from it.
+            if (self.isCancelled)
+                return;
+            
+            [_data appendData:data];
+            receivedLength = _data.length;
+        }
+        
+        [self _updateBufferedByteCount];
+        [self _suspendTransferIfMemoryBudgetIsExhausted];
+    }
+    
+    [self _reportProgress:(AMConnectionProgress){AMConnectionProgressPhaseDownload, receivedLength, _expectedContentLength}];
+}
+
+- (NSInputStream *)transfer:(id <AMConnectionTransfer>)transfer needNewBodyStream:(NSURLRequest *)request
+{
+    // Redirects and authentication challenges send the body again.
+    return [self _uploadBodyStream];
 }
 
-- (void)connection:(NSURLConnection *)connection didSendBodyData:(NSInteger)bytesWritten totalBytesWritten:(NSInteger)totalBytesWritten totalBytesExpectedToWrite:(NSInteger)totalBytesExpectedToWrite
+- (void)transfer:(id <AMConnectionTransfer>)transfer didSendBodyData:(NSInteger)bytesWritten totalBytesWritten:(NSInteger)totalBytesWritten totalBytesExpectedToWrite:(NSInteger)totalBytesExpectedToWrite
 {
-    float progress = ((float)totalBytesWritten)/((float)totalBytesExpectedToWrite);
+    _sentByteCount += bytesWritten;
     
-    if (_progressStatusBlock)
-        _progressStatusBlock(@{AMAsynchronousConnectionStatusUploadProgressKey:[NSNumber numberWithFloat:progress]});
+    [self _throttleTransferredBytes:bytesWritten];
+    
+    // Body streams may not know their length.
+    long long completedBytes = totalBytesWritten;
+    long long expectedBytes = totalBytesExpectedToWrite > 0 ? totalBytesExpectedToWrite : NSURLResponseUnknownLength;
+    
+    // Compressed bodies report the progress of the uncompressed body.
+    if (_uploadBodyCompressed)
+    {
+        completedBytes = atomic_load(&_consumedRequestBodyLength);
+        expectedBytes = _requestBodyLength;
+    }
+    else if (_compressedRequestBodyLength > 0)
+    {
+        completedBytes = (long long)((double)totalBytesWritten * _requestBodyLength / _compressedRequestBodyLength);
+        expectedBytes = _requestBodyLength;
+    }
+    
+    [self _reportProgress:(AMConnectionProgress){AMConnectionProgressPhaseUpload, MIN(completedBytes, expectedBytes >= 0 ? expectedBytes : completedBytes), expectedBytes}];
 }
 
-- (void)connectionDidFinishLoading:(NSURLConnection *)connection
+- (void)transferDidFinishLoading:(id <AMConnectionTransfer>)transfer
 {
+    _timestamps.lastByteTime = AMConnectionMetricsCurrentTime();
+    
     [self _stopConnection];
 }
 
 @end
+
+static void AMAsyncConnectionOperationDeliverPendingProgress(void *context)
+{
+    // Balances the retain done when the delivery was enqueued.
+    AMAsyncConnectionOperation *operation = (__bridge_transfer AMAsyncConnectionOperation*)context;
+    [operation _deliverPendingProgress];
+}
@@ -24,6 +24,13 @@
 
 
 #import "AMAsyncConnectionOperation.h"
+#import "AMConnectionMetrics.h"
+#import "AMTokenBucket.h"
+#import "AMHedgedRequest.h"
+#import "AMMemoryBudget.h"
+#import "AMBufferPool.h"
+
+@class AMConnectionManager;
 
 @interface AMAsyncConnectionOperation ()
 
@@ -33,4 +40,97 @@
  */
 @property (nonatomic, strong, readwrite) id connectionManagerKey;
 
+/*!
+ * The AMConnectionManager performing the operation, set when the operation is enqueued. The operation reports its progress to it.
+ * @discussion Nil for operations added to a queue directly: they start their transfer without waiting for a connection slot.
+ */
+@property (nonatomic, weak) AMConnectionManager *connectionManager;
+
+/*!
+ * The identifier of the queue where the operation is performed.
+ */
+@property (nonatomic, strong) NSString *queueIdentifier;
+
+/*!
+ * The timestamps of the operation, used to collect the connection metrics. The AMConnectionManager sets the enqueue time; the operation sets the other ones.
+ */
+@property (nonatomic, assign) AMConnectionTimestamps timestamps;
+
+/*!
+ * The number of bytes received, including the ones of failed attempts.
+ */
+@property (nonatomic, assign, readonly) unsigned long long receivedByteCount;
+
+/*!
+ * The number of bytes sent, including the ones of failed attempts.
+ */
+@property (nonatomic, assign, readonly) unsigned long long sentByteCount;
+
+/*!
+ * The response of the operation.
+ */
+@property (nonatomic, strong, readonly) NSURLResponse *response;
+
+/*!
+ * The error of the operation.
+ */
+@property (nonatomic, strong, readonly) NSError *error;
+
+/*!
+ * The retry policy of the queue where the operation is performed. Used when `retryPolicy` is nil.
+ */
+@property (nonatomic, strong) AMRetryPolicy *queueRetryPolicy;
+
+/*!
+ * The retry budget of the AMConnectionManager, shared by all its operations. Used when the retry policy has no budget of its own.
+ */
+@property (nonatomic, strong) AMTokenBucket *sharedRetryBudget;
+
+/*!
+ * The bandwidth limit of the queue where the operation is performed, shared by all its operations. Not used if its refill rate is 0.
+ */
+@property (nonatomic, strong) AMTokenBucket *bandwidthBucket;
+
+/*!
+ * The request rate limit of the queue where the operation is performed, shared by all its operations. Not used if its refill rate is 0.
+ */
+@property (nonatomic, strong) AMTokenBucket *requestRateBucket;
+
+/*!
+ * The memory budget shared by all the operations of the AMConnectionManager. The operation reserves in it the bytes it buffers and waits for it before starting the transfer.
+ */
+@property (nonatomic, strong) AMMemoryBudget *memoryBudget;
+
+/*!
+ * The pool the operation takes its receive buffer from. The received data is returned to it when released.
+ */
+@property (nonatomic, strong) AMBufferPool *bufferPool;
+
+/*!
+ * The ticket used by the AMConnectionManager to get a connection slot from its host scheduler.
+ */
+@property (nonatomic, strong) id schedulerTicket;
+
+/*!
+ * YES if the operation has been admitted as a probe by the circuit breaker of its host.
+ */
+@property (nonatomic, assign) BOOL circuitBreakerProbe;
+
+/*!
+ * The hedged request the operation is an attempt of, or nil if the request is not hedged.
+ */
+@property (nonatomic, strong) AMHedgedRequest *hedgedRequest;
+
+/*!
+ * Starts the transfer of an operation that has been waiting for a connection slot.
+ * @discussion The AMConnectionManager calls this method when the slot is granted. It can be called from any thread.
+ */
+- (void)am_startTransfer;
+
+/*!
+ * Stops the operation because its deadline has passed.
+ * @discussion The AMConnectionManager calls this method when the deadline of the operation passes. It can be called from any thread.
+ */
+- (void)am_deadlineExceeded;
+
 @end
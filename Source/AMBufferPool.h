@@ -0,0 +1,91 @@
+//
+//  AMBufferPool.h
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import <Foundation/Foundation.h>
+
+/*!
+ * Thread-safe pool of reusable data buffers.
+ * @discussion Buffers are grouped in size classes (16 KB, 64 KB, 256 KB, 1 MB, 4 MB and 16 MB), so a buffer taken for a response of a given length is large enough to hold it without being reallocated while it grows. Recycled buffers are kept for the next requests of their size class, up to `maximumPooledBytes`. Only buffers taken from the pool can be recycled in it.
+ */
+@interface AMBufferPool : NSObject
+
+/*!
+ * Default initializer.
+ * @param maximumPooledBytes The maximum number of bytes kept by the buffers waiting in the pool.
+ */
+- (id)initWithMaximumPooledBytes:(NSUInteger)maximumPooledBytes;
+
+/*!
+ * The maximum number of bytes kept by the buffers waiting in the pool. Default value is 8 MB.
+ * @discussion Lowering it doesn't release the buffers already in the pool, but no more buffers are added until they are below it. Set it to 0 to stop pooling buffers.
+ */
+@property (nonatomic, assign) NSUInteger maximumPooledBytes;
+
+/*!
+ * The number of bytes kept by the buffers waiting in the pool.
+ */
+@property (nonatomic, assign, readonly) NSUInteger pooledBytes;
+
+/*!
+ * The number of buffers taken from the pool.
+ */
+@property (nonatomic, assign, readonly) NSUInteger hitCount;
+
+/*!
+ * The number of buffers allocated because the pool had none of the required size class.
+ */
+@property (nonatomic, assign, readonly) NSUInteger missCount;
+
+/*!
+ * The fraction of the requested buffers that have been taken from the pool, from 0 to 1. 0 if no buffer has been requested.
+ */
+@property (nonatomic, assign, readonly) double hitRate;
+
+/*!
+ * Returns an empty buffer.
+ * @param capacity The number of bytes the buffer is expected to hold, or 0 if unknown.
+ * @return A buffer from the pool or a newly allocated one, with a capacity of at least the given one. Buffers larger than the largest size class are not pooled.
+ */
+- (NSMutableData*)bufferWithCapacity:(NSUInteger)capacity;
+
+/*!
+ * Returns a buffer to the pool, to be used again by `bufferWithCapacity:`.
+ * @param buffer A buffer taken from the pool. Other buffers are ignored.
+ * @discussion Do not use the buffer after recycling it.
+ */
+- (void)recycleBuffer:(NSMutableData*)buffer;
+
+/*!
+ * Returns an immutable data object with the bytes of a buffer, without copying them. The buffer is recycled when the data object is deallocated.
+ * @param buffer A buffer taken from the pool.
+ * @return The data object.
+ * @discussion Do not modify nor use the buffer after calling this method.
+ */
+- (NSData*)dataByRecyclingBuffer:(NSMutableData*)buffer;
+
+/*!
+ * Releases the buffers waiting in the pool.
+ */
+- (void)purge;
+
+@end
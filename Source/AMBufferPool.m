@@ -0,0 +1,238 @@
+//
+//  AMBufferPool.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMBufferPool.h"
+
+#import <pthread.h>
+
+#define AMBufferPoolSizeClassCount 6
+
+static const NSUInteger AMBufferPoolMinimumBufferSize = 16 * 1024;
+
+static NSUInteger AMBufferPoolSizeOfClass(NSUInteger sizeClass)
+{
+    // Each size class is 4 times larger than the previous one.
+    return AMBufferPoolMinimumBufferSize << (2 * sizeClass);
+}
+
+@implementation AMBufferPool
+{
+    pthread_mutex_t _lock;
+    
+    NSUInteger _maximumPooledBytes;
+    NSUInteger _pooledBytes;
+    NSUInteger _hitCount;
+    NSUInteger _missCount;
+    
+    NSMutableArray *_buffers[AMBufferPoolSizeClassCount];
+    
+    // The size classes of the buffers taken from the pool, not retained, so buffers that are never recycled don't stay alive.
+    NSMapTable *_sizeClasses;
+}
+
+- (id)init
+{
+    return [self initWithMaximumPooledBytes:8 * 1024 * 1024];
+}
+
+- (id)initWithMaximumPooledBytes:(NSUInteger)maximumPooledBytes
+{
+    self = [super init];
+    if (self)
+    {
+        pthread_mutex_init(&_lock, NULL);
+        
+        _maximumPooledBytes = maximumPooledBytes;
+        
+        for (NSUInteger i = 0; i < AMBufferPoolSizeClassCount; ++i)
+            _buffers[i] = [NSMutableArray array];
+        
+        _sizeClasses = [[NSMapTable alloc] initWithKeyOptions:NSPointerFunctionsWeakMemory | NSPointerFunctionsObjectPointerPersonality
+                                                 valueOptions:NSPointerFunctionsStrongMemory
+                                                     capacity:0];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    pthread_mutex_destroy(&_lock);
+}
+
+#pragma mark Properties
+
+- (NSUInteger)maximumPooledBytes
+{
+    pthread_mutex_lock(&_lock);
+    NSUInteger maximumPooledBytes = _maximumPooledBytes;
+    pthread_mutex_unlock(&_lock);
+    
+    return maximumPooledBytes;
+}
+
+- (void)setMaximumPooledBytes:(NSUInteger)maximumPooledBytes
+{
+    pthread_mutex_lock(&_lock);
+    _maximumPooledBytes = maximumPooledBytes;
+    pthread_mutex_unlock(&_lock);
+}
+
+- (NSUInteger)pooledBytes
+{
+    pthread_mutex_lock(&_lock);
+    NSUInteger pooledBytes = _pooledBytes;
+    pthread_mutex_unlock(&_lock);
+    
+    return pooledBytes;
+}
+
+- (NSUInteger)hitCount
+{
+    pthread_mutex_lock(&_lock);
+    NSUInteger hitCount = _hitCount;
+    pthread_mutex_unlock(&_lock);
+    
+    return hitCount;
+}
+
+- (NSUInteger)missCount
+{
+    pthread_mutex_lock(&_lock);
+    NSUInteger missCount = _missCount;
+    pthread_mutex_unlock(&_lock);
+    
+    return missCount;
+}
+
+- (double)hitRate
+{
+    pthread_mutex_lock(&_lock);
+    NSUInteger requestCount = _hitCount + _missCount;
+    double hitRate = requestCount > 0 ? (double)_hitCount / (double)requestCount : 0.0;
+    pthread_mutex_unlock(&_lock);
+    
+    return hitRate;
+}
+
+#pragma mark Public Methods
+
+- (NSMutableData*)bufferWithCapacity:(NSUInteger)capacity
+{
+    NSUInteger sizeClass = 0;
+    
+    while (sizeClass < AMBufferPoolSizeClassCount && AMBufferPoolSizeOfClass(sizeClass) < capacity)
+        ++sizeClass;
+    
+    NSMutableData *buffer = nil;
+    
+    pthread_mutex_lock(&_lock);
+    
+    if (sizeClass < AMBufferPoolSizeClassCount)
+    {
+        buffer = [_buffers[sizeClass] lastObject];
+        
+        if (buffer)
+        {
+            [_buffers[sizeClass] removeLastObject];
+            _pooledBytes -= AMBufferPoolSizeOfClass(sizeClass);
+            _hitCount++;
+        }
+        else
+        {
+            buffer = [NSMutableData dataWithCapacity:AMBufferPoolSizeOfClass(sizeClass)];
+            _missCount++;
+        }
+        
+        [_sizeClasses setObject:@(sizeClass) forKey:buffer];
+    }
+    else
+    {
+        _missCount++;
+    }
+    
+    pthread_mutex_unlock(&_lock);
+    
+    // Too large to be pooled.
+    if (!buffer)
+        buffer = [NSMutableData dataWithCapacity:capacity];
+    
+    return buffer;
+}
+
+- (void)recycleBuffer:(NSMutableData*)buffer
+{
+    if (!buffer)
+        return;
+    
+    pthread_mutex_lock(&_lock);
+    
+    NSNumber *sizeClass = [_sizeClasses objectForKey:buffer];
+    
+    if (sizeClass)
+    {
+        [_sizeClasses removeObjectForKey:buffer];
+        
+        NSUInteger size = AMBufferPoolSizeOfClass([sizeClass unsignedIntegerValue]);
+        
+        if (_pooledBytes + size <= _maximumPooledBytes)
+        {
+            // Keeps the allocated memory, so the next transfer doesn't allocate it again.
+            buffer.length = 0;
+            
+            [_buffers[[sizeClass unsignedIntegerValue]] addObject:buffer];
+            _pooledBytes += size;
+        }
+    }
+    
+    pthread_mutex_unlock(&_lock);
+}
+
+- (NSData*)dataByRecyclingBuffer:(NSMutableData*)buffer
+{
+    if (buffer.length == 0)
+    {
+        [self recycleBuffer:buffer];
+        return [NSData data];
+    }
+    
+    __weak AMBufferPool *weakSelf = self;
+    
+    return [[NSData alloc] initWithBytesNoCopy:buffer.mutableBytes length:buffer.length deallocator:^(void *bytes, NSUInteger length) {
+        // The buffer is captured by the block, so it stays alive as long as the data object.
+        [weakSelf recycleBuffer:buffer];
+    }];
+}
+
+- (void)purge
+{
+    pthread_mutex_lock(&_lock);
+    
+    for (NSUInteger i = 0; i < AMBufferPoolSizeClassCount; ++i)
+        [_buffers[i] removeAllObjects];
+    
+    _pooledBytes = 0;
+    
+    pthread_mutex_unlock(&_lock);
+}
+
+@end
@@ -0,0 +1,148 @@
+//
+//  AMCircuitBreaker.h
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import <Foundation/Foundation.h>
+
+/*!
+ * @typedef AMCircuitBreakerState
+ * @abstract The states of an AMCircuitBreaker.
+ */
+typedef NS_ENUM(NSInteger, AMCircuitBreakerState)
+{
+    /** Requests are performed and their results are counted. */
+    AMCircuitBreakerStateClosed,
+    
+    /** Too many requests have failed: requests fail immediately until the open duration passes. */
+    AMCircuitBreakerStateOpen,
+    
+    /** The open duration has passed: a few probe requests are performed to find out if the host has recovered. */
+    AMCircuitBreakerStateHalfOpen
+};
+
+/*!
+ * Describes when the circuit breaker of a host opens and how it recovers.
+ * @discussion The circuit opens when, within a window of `windowDuration` seconds with at least `minimumRequestCount` finished requests, the fraction of failed requests reaches `failureRateThreshold`. After `openDuration` seconds it lets `probeCount` requests through, and closes when all of them succeed or opens again when any of them fails.
+ *
+ * Configure the policy before using it.
+ */
+@interface AMCircuitBreakerPolicy : NSObject
+
+/*!
+ * Returns a policy with the default values.
+ * @return A new policy.
+ */
++ (AMCircuitBreakerPolicy*)defaultPolicy;
+
+/*!
+ * The fraction of failed requests that opens the circuit, from 0.0 to 1.0. Default value is 0.5.
+ */
+@property (nonatomic, assign) double failureRateThreshold;
+
+/*!
+ * The minimum number of finished requests in the window before the circuit can open. Default value is 10.
+ */
+@property (nonatomic, assign) NSUInteger minimumRequestCount;
+
+/*!
+ * The duration of the window where requests are counted. Default value is 30 seconds.
+ */
+@property (nonatomic, assign) NSTimeInterval windowDuration;
+
+/*!
+ * The time an open circuit fails requests before letting probes through. Default value is 15 seconds.
+ */
+@property (nonatomic, assign) NSTimeInterval openDuration;
+
+/*!
+ * The number of probe requests performed while the circuit is half-open. Default value is 1.
+ */
+@property (nonatomic, assign) NSUInteger probeCount;
+
+/*!
+ * The HTTP status codes counted as failures. By default 500, 502, 503 and 504. Other responses count as successes.
+ */
+@property (nonatomic, strong) NSIndexSet *failureStatusCodes;
+
+/*!
+ * Returns whether the result of a request counts as a failure of the host.
+ * @param response The response or nil.
+ * @param error The error or nil.
+ * @return YES for network errors other than cancellations, and for responses with one of the `failureStatusCodes`.
+ */
+- (BOOL)isFailureWithResponse:(NSURLResponse*)response error:(NSError*)error;
+
+@end
+
+/*!
+ * Thread-safe circuit breaker of a host.
+ */
+@interface AMCircuitBreaker : NSObject
+
+/*!
+ * Default initializer.
+ * @param policy The policy.
+ */
+- (id)initWithPolicy:(AMCircuitBreakerPolicy*)policy;
+
+/*!
+ * The policy.
+ */
+@property (nonatomic, strong, readonly) AMCircuitBreakerPolicy *policy;
+
+/*!
+ * The current state.
+ */
+@property (nonatomic, assign, readonly) AMCircuitBreakerState state;
+
+/*!
+ * Block called after each change of state, outside the lock of the breaker.
+ */
+@property (nonatomic, copy) void (^stateChangeBlock)(AMCircuitBreakerState state);
+
+/*!
+ * Returns whether requests are being failed, without admitting any.
+ * @return YES if the circuit is open and the open duration has not passed.
+ */
+- (BOOL)rejectsRequests;
+
+/*!
+ * Admits a request that is about to be performed.
+ * @param probe On return, YES if the request is admitted as a probe of a half-open circuit.
+ * @return YES if the request can be performed, NO if it must fail.
+ * @discussion A probe must always be followed by a call to `recordResultSucceeded:probe:` or `cancelProbe`.
+ */
+- (BOOL)admitRequestAsProbe:(BOOL*)probe;
+
+/*!
+ * Records the result of a finished request.
+ * @param succeeded NO if the request failed.
+ * @param probe YES if the request was admitted as a probe.
+ */
+- (void)recordResultSucceeded:(BOOL)succeeded probe:(BOOL)probe;
+
+/*!
+ * Releases a probe that has been cancelled without a result.
+ */
+- (void)cancelProbe;
+
+@end
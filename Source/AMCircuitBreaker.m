@@ -0,0 +1,245 @@
+//
+//  AMCircuitBreaker.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMCircuitBreaker.h"
+
+#import <pthread.h>
+
+@implementation AMCircuitBreakerPolicy
+
++ (AMCircuitBreakerPolicy*)defaultPolicy
+{
+    return [[AMCircuitBreakerPolicy alloc] init];
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self)
+    {
+        _failureRateThreshold = 0.5;
+        _minimumRequestCount = 10;
+        _windowDuration = 30.0;
+        _openDuration = 15.0;
+        _probeCount = 1;
+        
+        NSMutableIndexSet *statusCodes = [NSMutableIndexSet indexSet];
+        [statusCodes addIndex:500];
+        [statusCodes addIndex:502];
+        [statusCodes addIndex:503];
+        [statusCodes addIndex:504];
+        _failureStatusCodes = statusCodes;
+    }
+    return self;
+}
+
+#pragma mark Public Methods
+
+- (BOOL)isFailureWithResponse:(NSURLResponse*)response error:(NSError*)error
+{
+    if (error)
+        return [error.domain isEqualToString:NSURLErrorDomain] && error.code != NSURLErrorCancelled;
+    
+    if (![response isKindOfClass:[NSHTTPURLResponse class]])
+        return NO;
+    
+    return [_failureStatusCodes containsIndex:(NSUInteger)[(NSHTTPURLResponse*)response statusCode]];
+}
+
+@end
+
+@implementation AMCircuitBreaker
+{
+    pthread_mutex_t _lock;
+    
+    AMCircuitBreakerState _state;
+    
+    NSTimeInterval _windowStartTime;
+    NSUInteger _requestCount;
+    NSUInteger _failureCount;
+    
+    NSTimeInterval _openTime;
+    NSUInteger _runningProbeCount;
+    NSUInteger _succeededProbeCount;
+}
+
+- (id)init
+{
+    return [self initWithPolicy:[AMCircuitBreakerPolicy defaultPolicy]];
+}
+
+- (id)initWithPolicy:(AMCircuitBreakerPolicy*)policy
+{
+    self = [super init];
+    if (self)
+    {
+        pthread_mutex_init(&_lock, NULL);
+        
+        _policy = policy;
+        _state = AMCircuitBreakerStateClosed;
+        _windowStartTime = [NSDate timeIntervalSinceReferenceDate];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    pthread_mutex_destroy(&_lock);
+}
+
+#pragma mark Properties
+
+- (AMCircuitBreakerState)state
+{
+    pthread_mutex_lock(&_lock);
+    AMCircuitBreakerState state = _state;
+    pthread_mutex_unlock(&_lock);
+    
+    return state;
+}
+
+#pragma mark Public Methods
+
+- (BOOL)rejectsRequests
+{
+    pthread_mutex_lock(&_lock);
+    BOOL rejects = _state == AMCircuitBreakerStateOpen && [NSDate timeIntervalSinceReferenceDate] - _openTime < _policy.openDuration;
+    pthread_mutex_unlock(&_lock);
+    
+    return rejects;
+}
+
+- (BOOL)admitRequestAsProbe:(BOOL*)probe
+{
+    *probe = NO;
+    
+    pthread_mutex_lock(&_lock);
+    
+    BOOL changed = NO;
+    
+    if (_state == AMCircuitBreakerStateOpen && [NSDate timeIntervalSinceReferenceDate] - _openTime >= _policy.openDuration)
+    {
+        _state = AMCircuitBreakerStateHalfOpen;
+        _runningProbeCount = 0;
+        _succeededProbeCount = 0;
+        changed = YES;
+    }
+    
+    BOOL admitted = _state == AMCircuitBreakerStateClosed;
+    
+    if (_state == AMCircuitBreakerStateHalfOpen && _succeededProbeCount + _runningProbeCount < MAX(_policy.probeCount, 1))
+    {
+        _runningProbeCount++;
+        *probe = YES;
+        admitted = YES;
+    }
+    
+    AMCircuitBreakerState state = _state;
+    
+    pthread_mutex_unlock(&_lock);
+    
+    if (changed && _stateChangeBlock)
+        _stateChangeBlock(state);
+    
+    return admitted;
+}
+
+- (void)recordResultSucceeded:(BOOL)succeeded probe:(BOOL)probe
+{
+    pthread_mutex_lock(&_lock);
+    
+    NSTimeInterval now = [NSDate timeIntervalSinceReferenceDate];
+    BOOL changed = NO;
+    
+    switch (_state)
+    {
+        case AMCircuitBreakerStateClosed:
+        {
+            if (now - _windowStartTime >= _policy.windowDuration)
+            {
+                _windowStartTime = now;
+                _requestCount = 0;
+                _failureCount = 0;
+            }
+            
+            _requestCount++;
+            
+            if (!succeeded)
+                _failureCount++;
+            
+            if (_requestCount >= _policy.minimumRequestCount && (double)_failureCount / _requestCount >= _policy.failureRateThreshold)
+            {
+                _state = AMCircuitBreakerStateOpen;
+                _openTime = now;
+                changed = YES;
+            }
+            break;
+        }
+            
+        case AMCircuitBreakerStateHalfOpen:
+        {
+            if (probe && _runningProbeCount > 0)
+                _runningProbeCount--;
+            
+            // Any failure, also of requests admitted before the circuit opened, means the host has not recovered.
+            if (!succeeded)
+            {
+                _state = AMCircuitBreakerStateOpen;
+                _openTime = now;
+                changed = YES;
+            }
+            else if (probe && ++_succeededProbeCount >= MAX(_policy.probeCount, 1))
+            {
+                _state = AMCircuitBreakerStateClosed;
+                _windowStartTime = now;
+                _requestCount = 0;
+                _failureCount = 0;
+                changed = YES;
+            }
+            break;
+        }
+            
+        case AMCircuitBreakerStateOpen:
+            // Results of requests admitted before the circuit opened.
+            break;
+    }
+    
+    AMCircuitBreakerState state = _state;
+    
+    pthread_mutex_unlock(&_lock);
+    
+    if (changed && _stateChangeBlock)
+        _stateChangeBlock(state);
+}
+
+- (void)cancelProbe
+{
+    pthread_mutex_lock(&_lock);
+    
+    if (_state == AMCircuitBreakerStateHalfOpen && _runningProbeCount > 0)
+        _runningProbeCount--;
+    
+    pthread_mutex_unlock(&_lock);
+}
+
+@end
@@ -0,0 +1,51 @@
+//
+//  AMCompletionQueue.h
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import <Foundation/Foundation.h>
+
+#import "AMUtilities.h"
+
+/*!
+ * This class delivers blocks on a target dispatch queue in batches.
+ * @discussion Blocks can be enqueued from any thread without locks. Instead of dispatching each block on its own, a single drain is dispatched to the target queue and it executes every block enqueued until then, in order. During bursts of finished connections this keeps the target queue (usually the main queue) from being flooded with small blocks.
+ */
+@interface AMCompletionQueue : NSObject
+
+/*!
+ * Default initializer.
+ * @param targetQueue The dispatch queue where the blocks are executed. If NULL, the main queue is used.
+ */
+- (id)initWithTargetQueue:(dispatch_queue_t)targetQueue;
+
+/*!
+ * The dispatch queue where the blocks are executed.
+ */
+@property (nonatomic, AM_DISPATCH_PROPERTY, readonly) dispatch_queue_t targetQueue;
+
+/*!
+ * Enqueues a block to be executed on the target queue.
+ * @param block The block to execute.
+ */
+- (void)enqueueBlock:(void (^)(void))block;
+
+@end
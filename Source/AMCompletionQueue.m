@@ -0,0 +1,138 @@
+//
+//  AMCompletionQueue.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMCompletionQueue.h"
+
+#import <stdatomic.h>
+#import <stdlib.h>
+
+typedef struct AMCompletionQueueNode
+{
+    struct AMCompletionQueueNode *next;
+    void *block;
+} AMCompletionQueueNode;
+
+static void AMCompletionQueueDrain(void *context);
+
+@implementation AMCompletionQueue
+{
+    // Last enqueued node. Producers push with a compare-and-swap; the drain takes the whole list at once.
+    _Atomic(AMCompletionQueueNode*) _head;
+    atomic_bool _drainScheduled;
+}
+
+- (id)init
+{
+    return [self initWithTargetQueue:NULL];
+}
+
+- (id)initWithTargetQueue:(dispatch_queue_t)targetQueue
+{
+    self = [super init];
+    if (self)
+    {
+        _targetQueue = AMDispatchRetain(targetQueue ?: dispatch_get_main_queue());
+        
+        atomic_init(&_head, NULL);
+        atomic_init(&_drainScheduled, false);
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    // A scheduled drain retains the receiver, so only blocks enqueued after the last drain can be left.
+    AMCompletionQueueNode *node = atomic_exchange(&_head, NULL);
+    
+    while (node)
+    {
+        AMCompletionQueueNode *next = node->next;
+        (void)(__bridge_transfer id)node->block;
+        free(node);
+        node = next;
+    }
+    
+    AMDispatchRelease(_targetQueue);
+}
+
+#pragma mark Public Methods
+
+- (void)enqueueBlock:(void (^)(void))block
+{
+    if (!block)
+        return;
+    
+    AMCompletionQueueNode *node = malloc(sizeof(AMCompletionQueueNode));
+    node->block = (__bridge_retained void*)[block copy];
+    node->next = atomic_load_explicit(&_head, memory_order_relaxed);
+    
+    while (!atomic_compare_exchange_weak_explicit(&_head, &node->next, node, memory_order_release, memory_order_relaxed));
+    
+    // Only the first block since the last drain dispatches a new one.
+    if (!atomic_exchange(&_drainScheduled, true))
+        dispatch_async_f(_targetQueue, (__bridge_retained void*)self, AMCompletionQueueDrain);
+}
+
+#pragma mark Private Methods
+
+- (void)_drain
+{
+    // Clear the flag before taking the list: blocks enqueued from now on schedule another drain.
+    atomic_store(&_drainScheduled, false);
+    
+    AMCompletionQueueNode *node = atomic_exchange(&_head, NULL);
+    
+    // The list is in reverse order of insertion.
+    AMCompletionQueueNode *first = NULL;
+    
+    while (node)
+    {
+        AMCompletionQueueNode *next = node->next;
+        node->next = first;
+        first = node;
+        node = next;
+    }
+    
+    while (first)
+    {
+        AMCompletionQueueNode *next = first->next;
+        
+        @autoreleasepool
+        {
+            void (^block)(void) = (__bridge_transfer id)first->block;
+            block();
+        }
+        
+        free(first);
+        first = next;
+    }
+}
+
+@end
+
+static void AMCompletionQueueDrain(void *context)
+{
+    // Balances the retain done when the drain was dispatched.
+    AMCompletionQueue *completionQueue = (__bridge_transfer AMCompletionQueue*)context;
+    [completionQueue _drain];
+}
@@ -0,0 +1,79 @@
+//
+//  AMConcurrencyLimiter.h
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import <Foundation/Foundation.h>
+
+/*!
+ * Thread-safe adaptive concurrency limit, following an additive-increase/multiplicative-decrease (AIMD) rule driven by the latency and the failures of the finished connections.
+ * @discussion The limiter keeps the lowest latency observed recently as the latency of an unloaded server. While connections finish below `latencyTolerance` times that latency and don't fail, the limit grows by one every `limit` connections, but only while the limit is actually in use. When a connection fails with an overload error or takes longer than tolerated, the limit is multiplied by `backoffRatio`, at most once per latency period, so the connections that were already running when the server got congested don't shrink it again. The limit always stays between `minimumLimit` and `maximumLimit`.
+ */
+@interface AMConcurrencyLimiter : NSObject
+
+/*!
+ * Default initializer.
+ * @param initialLimit The limit before any connection finishes. It is clamped to the bounds.
+ * @param minimumLimit The lowest limit, at least 1.
+ * @param maximumLimit The highest limit, at least `minimumLimit`.
+ */
+- (id)initWithInitialLimit:(NSUInteger)initialLimit minimumLimit:(NSUInteger)minimumLimit maximumLimit:(NSUInteger)maximumLimit;
+
+/*!
+ * The lowest limit.
+ */
+@property (nonatomic, assign, readonly) NSUInteger minimumLimit;
+
+/*!
+ * The highest limit.
+ */
+@property (nonatomic, assign, readonly) NSUInteger maximumLimit;
+
+/*!
+ * The current limit.
+ */
+@property (nonatomic, assign, readonly) NSUInteger limit;
+
+/*!
+ * The latency of a connection, relative to the lowest latency observed, above which the server is considered congested. Default value is 2.0.
+ */
+@property (nonatomic, assign) double latencyTolerance;
+
+/*!
+ * The factor applied to the limit when the server is congested, between 0 and 1. Default value is 0.9.
+ */
+@property (nonatomic, assign) double backoffRatio;
+
+/*!
+ * The lowest latency observed recently, or 0 if no connection has finished yet.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval minimumLatency;
+
+/*!
+ * Updates the limit with the result of a finished connection.
+ * @param latency The time since the connection started until it got the first byte of the response, or 0 if it didn't get any.
+ * @param dropped YES if the connection failed in a way that signals an overloaded server or network, such as a timeout or a 503 response.
+ * @param inflightCount The number of connections running when the connection finished, including it.
+ * @return YES if the limit has changed.
+ */
+- (BOOL)recordLatency:(NSTimeInterval)latency dropped:(BOOL)dropped inflightCount:(NSUInteger)inflightCount;
+
+@end
@@ -0,0 +1,172 @@
+//
+//  AMConcurrencyLimiter.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMConcurrencyLimiter.h"
+
+#import <pthread.h>
+
+// The lowest latency is measured again every this number of samples, so it follows changes of route or server.
+static const NSUInteger AMConcurrencyLimiterLatencyWindowSampleCount = 256;
+
+@implementation AMConcurrencyLimiter
+{
+    pthread_mutex_t _lock;
+    
+    double _latencyTolerance;
+    double _backoffRatio;
+    NSTimeInterval _minimumLatency;
+    
+    double _currentLimit;
+    NSTimeInterval _windowMinimumLatency;
+    NSUInteger _windowSampleCount;
+    NSTimeInterval _lastDecreaseTime;
+}
+
+- (id)init
+{
+    return [self initWithInitialLimit:4 minimumLimit:1 maximumLimit:64];
+}
+
+- (id)initWithInitialLimit:(NSUInteger)initialLimit minimumLimit:(NSUInteger)minimumLimit maximumLimit:(NSUInteger)maximumLimit
+{
+    self = [super init];
+    if (self)
+    {
+        pthread_mutex_init(&_lock, NULL);
+        
+        _minimumLimit = MAX(minimumLimit, 1);
+        _maximumLimit = MAX(maximumLimit, _minimumLimit);
+        _currentLimit = MIN(MAX(initialLimit, _minimumLimit), _maximumLimit);
+        
+        _latencyTolerance = 2.0;
+        _backoffRatio = 0.9;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    pthread_mutex_destroy(&_lock);
+}
+
+#pragma mark Properties
+
+- (NSUInteger)limit
+{
+    pthread_mutex_lock(&_lock);
+    NSUInteger limit = (NSUInteger)_currentLimit;
+    pthread_mutex_unlock(&_lock);
+    
+    return limit;
+}
+
+- (NSTimeInterval)minimumLatency
+{
+    pthread_mutex_lock(&_lock);
+    NSTimeInterval minimumLatency = _minimumLatency;
+    pthread_mutex_unlock(&_lock);
+    
+    return minimumLatency;
+}
+
+- (double)latencyTolerance
+{
+    pthread_mutex_lock(&_lock);
+    double latencyTolerance = _latencyTolerance;
+    pthread_mutex_unlock(&_lock);
+    
+    return latencyTolerance;
+}
+
+- (void)setLatencyTolerance:(double)latencyTolerance
+{
+    pthread_mutex_lock(&_lock);
+    _latencyTolerance = MAX(latencyTolerance, 1.0);
+    pthread_mutex_unlock(&_lock);
+}
+
+- (double)backoffRatio
+{
+    pthread_mutex_lock(&_lock);
+    double backoffRatio = _backoffRatio;
+    pthread_mutex_unlock(&_lock);
+    
+    return backoffRatio;
+}
+
+- (void)setBackoffRatio:(double)backoffRatio
+{
+    pthread_mutex_lock(&_lock);
+    _backoffRatio = MIN(MAX(backoffRatio, 0.0), 1.0);
+    pthread_mutex_unlock(&_lock);
+}
+
+#pragma mark Public Methods
+
+- (BOOL)recordLatency:(NSTimeInterval)latency dropped:(BOOL)dropped inflightCount:(NSUInteger)inflightCount
+{
+    pthread_mutex_lock(&_lock);
+    
+    NSUInteger previousLimit = (NSUInteger)_currentLimit;
+    
+    if (!dropped && latency > 0)
+    {
+        if (_minimumLatency == 0 || latency < _minimumLatency)
+            _minimumLatency = latency;
+        
+        if (_windowSampleCount == 0 || latency < _windowMinimumLatency)
+            _windowMinimumLatency = latency;
+        
+        if (++_windowSampleCount == AMConcurrencyLimiterLatencyWindowSampleCount)
+        {
+            _minimumLatency = _windowMinimumLatency;
+            _windowSampleCount = 0;
+        }
+    }
+    
+    BOOL congested = dropped || (_minimumLatency > 0 && latency > _minimumLatency * _latencyTolerance);
+    
+    if (congested)
+    {
+        NSTimeInterval now = [NSDate timeIntervalSinceReferenceDate];
+        
+        if (now - _lastDecreaseTime >= MAX(latency, _minimumLatency * _latencyTolerance))
+        {
+            _currentLimit = MAX(_currentLimit * _backoffRatio, (double)_minimumLimit);
+            _lastDecreaseTime = now;
+        }
+    }
+    else if (inflightCount * 2 >= (NSUInteger)_currentLimit)
+    {
+        // An idle queue says nothing about the capacity of the server, so the limit only grows while it is being used.
+        _currentLimit = MIN(_currentLimit + 1.0 / _currentLimit, (double)_maximumLimit);
+    }
+    
+    BOOL changed = (NSUInteger)_currentLimit != previousLimit;
+    
+    pthread_mutex_unlock(&_lock);
+    
+    return changed;
+}
+
+@end
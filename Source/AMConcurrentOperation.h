@@ -36,8 +36,26 @@
 
 /*!
  * This method is called when the concurrentMain method is finished. Subclasses may override this method.
- * @discussion This method is executed in the main thread and before the "completionBlock" NSOperation property.
+ * @discussion This method is executed in the thread of the concurrentMain method (the concurrentMainThread, or the thread detached for the operation) and before the "completionBlock" NSOperation property. If the operation is cancelled before it starts, concurrentMain is not called and this method is executed in the thread calling -start.
  */
 - (void)operationDidFinish;
 
+/*!
+ * Returns the thread where the concurrentMain method is going to be executed. Subclasses may override this method.
+ * @discussion By default returns nil and a new thread is detached for each operation.
+ */
+- (NSThread*)concurrentMainThread;
+
+/*!
+ * Subclasses that finish their work asynchronously must override this method and return YES. Default value is NO.
+ * @discussion If YES, the operation is not finished when the concurrentMain method returns and the subclass is responsible of calling -completeOperation.
+ */
+- (BOOL)completesAsynchronously;
+
+/*!
+ * Moves the operation to the finished state.
+ * @discussion Only subclasses that return YES in -completesAsynchronously may call this method, and only once.
+ */
+- (void)completeOperation;
+
 @end
@@ -58,12 +58,6 @@
 
 - (void)start
 {
-    if (![NSThread isMainThread])
-    {
-        [self performSelectorOnMainThread:@selector(start) withObject:self waitUntilDone:NO];
-        return;
-    }
-    
     if ([self isCancelled])
     {
         // Must move the operation to the finished state if it is canceled.
@@ -76,9 +70,15 @@
     
     // If the operation is not canceled, begin executing the task.
     [self willChangeValueForKey:@"isExecuting"];
-    [NSThread detachNewThreadSelector:@selector(main) toTarget:self withObject:nil];
     _executing = YES;
     [self didChangeValueForKey:@"isExecuting"];
+    
+    NSThread *thread = [self concurrentMainThread];
+    
+    if (thread)
+        [self performSelector:@selector(main) onThread:thread withObject:nil waitUntilDone:NO];
+    else
+        [NSThread detachNewThreadSelector:@selector(main) toTarget:self withObject:nil];
 }
 
 - (void)main
@@ -88,7 +88,8 @@
         // Do the main work of the operation here.
         [self concurrentMain];
         
-        [self completeOperation];
+        if (![self completesAsynchronously])
+            [self completeOperation];
     }
     @catch(...)
     {
@@ -120,4 +121,16 @@
     // Override in subclasses
 }
 
+- (NSThread*)concurrentMainThread
+{
+    // Override in subclasses
+    return nil;
+}
+
+- (BOOL)completesAsynchronously
+{
+    // Override in subclasses
+    return NO;
+}
+
 @end
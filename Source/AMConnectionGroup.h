@@ -29,6 +29,8 @@
 /*!
  * This class allows to group connections by passing the keys of those we want to put together. Then, the class allows to manipulate those conection by cancel or pausing them.
  * @discussion Typically, use this class by holding one instance in each UIViewController and registering all connections that are created from this controller. The view controller have to cancel, pause or restart the connections or just change the priorities in the dealloc, viewDidDisappear or viewWillAppear methods.
+ *
+ * Groups are also returned by -[AMConnectionManager performRequests:priority:inQueue:completionBlock:groupCompletion:]. All the methods of this class can be called from any thread and manipulate all the connections of the group with a single call to the connection manager.
  */
 @interface AMConnectionGroup : NSObject
 
@@ -41,4 +43,14 @@
 
 - (void)changeConnectionPrioritiesTo:(AMConnectionPriority)priority;
 
-@end
\ No newline at end of file
+/*!
+ * The keys of the connections of the group that are not paused.
+ */
+@property (nonatomic, strong, readonly) NSIndexSet *connectionKeys;
+
+/*!
+ * For groups returned by -[AMConnectionManager performRequests:priority:inQueue:completionBlock:groupCompletion:], the block called once when all the requests of the batch have finished or have been cancelled through the group.
+ */
+@property (nonatomic, strong) void (^completionBlock)(void);
+
+@end
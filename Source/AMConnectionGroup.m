@@ -22,15 +22,19 @@
 // OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
 // SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
 
-#import "AMConnectionGroup.h"
+#import "AMConnectionGroup_Private.h"
 
 #import "AMConnectionManager.h"
-#import "AMAsyncConnectionOperation.h"
+#import "AMAsyncConnectionOperation_Private.h"
 
 @implementation AMConnectionGroup
 {
     NSMutableIndexSet *_connectionKeys;
     NSMutableArray *_pausedConnections;
+    
+    NSMutableIndexSet *_pendingConnectionKeys;
+    BOOL _sealed;
+    BOOL _completed;
 }
 
 - (id)init
@@ -40,21 +44,48 @@
     {
         _connectionKeys = [NSMutableIndexSet indexSet];
         _pausedConnections = [NSMutableArray array];
+        _pendingConnectionKeys = [NSMutableIndexSet indexSet];
     }
     return self;
 }
 
+#pragma mark Properties
+
+- (AMConnectionManager*)connectionManager
+{
+    return _connectionManager ?: [AMConnectionManager defaultManager];
+}
+
+- (NSIndexSet*)connectionKeys
+{
+    @synchronized(self)
+    {
+        return [_connectionKeys copy];
+    }
+}
+
 #pragma mark Public Methods
 
 - (void)addConnectionKey:(NSInteger)connectionKey
 {
-    if (connectionKey != NSNotFound)
+    if (connectionKey == NSNotFound)
+        return;
+    
+    @synchronized(self)
+    {
         [_connectionKeys addIndex:connectionKey];
+    }
 }
 
 - (void)removeConnectionKey:(NSInteger)connectionKey
 {
-    [_connectionKeys removeIndex:connectionKey];
+    @synchronized(self)
+    {
+        [_connectionKeys removeIndex:connectionKey];
+        [_pendingConnectionKeys removeIndex:connectionKey];
+    }
+    
+    [self _completeIfFinished];
 }
 
 - (void)cancel
@@ -72,73 +103,111 @@
     [self _restartCurrentConnections];
 }
 
-#pragma mark Private Methods
+- (void)changeConnectionPrioritiesTo:(AMConnectionPriority)priority
+{
+    [self.connectionManager changeToPriority:priority requestsWithKeys:self.connectionKeys];
+}
 
-- (void)_cancelCurrentConnections
-{    
-    AMConnectionManager *connectionManager = [AMConnectionManager defaultManager];
+- (void)am_addPendingConnectionKey:(NSInteger)key
+{
+    @synchronized(self)
+    {
+        [_connectionKeys addIndex:key];
+        [_pendingConnectionKeys addIndex:key];
+    }
+}
+
+- (void)am_connectionDidFinishWithKey:(NSInteger)key
+{
+    @synchronized(self)
+    {
+        [_connectionKeys removeIndex:key];
+        [_pendingConnectionKeys removeIndex:key];
+    }
     
-    NSIndexSet *indexSet = [_connectionKeys copy];
+    [self _completeIfFinished];
+}
+
+- (void)am_seal
+{
+    @synchronized(self)
+    {
+        _sealed = YES;
+    }
     
-    NSInteger index = [indexSet firstIndex];
+    [self _completeIfFinished];
+}
+
+#pragma mark Private Methods
+
+- (void)_cancelCurrentConnections
+{
+    NSIndexSet *indexSet = nil;
     
-    while (index != NSNotFound)
+    @synchronized(self)
     {
-        [connectionManager cancelRequestWithKey:index];
-        index = [indexSet indexGreaterThanIndex:index];
+        indexSet = [_connectionKeys copy];
+        
+        [_connectionKeys removeAllIndexes];
+        [_pausedConnections removeAllObjects];
+        [_pendingConnectionKeys removeAllIndexes];
     }
     
-    [_pausedConnections removeAllObjects];
+    [self.connectionManager cancelRequestsWithKeys:indexSet];
+    
+    [self _completeIfFinished];
 }
 
 - (void)_pauseCurrentConnections
-{    
-    AMConnectionManager *connectionManager = [AMConnectionManager defaultManager];
+{
+    NSIndexSet *indexSet = nil;
     
-    NSIndexSet *indexSet = [_connectionKeys copy];
+    @synchronized(self)
+    {
+        indexSet = [_connectionKeys copy];
+        [_connectionKeys removeAllIndexes];
+    }
     
-    NSInteger key = [indexSet firstIndex];
+    // Paused connections are still pending: they finish after being resumed.
+    NSArray *connectionOperations = [self.connectionManager cancelRequestsWithKeys:indexSet];
     
-    while (key != NSNotFound)
+    @synchronized(self)
     {
-        AMAsyncConnectionOperation *connectionOperation = [connectionManager cancelRequestWithKey:key];
-        
-        if (connectionOperation)
-            [_pausedConnections addObject:connectionOperation];
-        
-        key = [indexSet indexGreaterThanIndex:key];
+        [_pausedConnections addObjectsFromArray:connectionOperations];
     }
-    
-    [_connectionKeys removeAllIndexes];
 }
 
 - (void)_restartCurrentConnections
 {
-    AMConnectionManager *connectionManager = [AMConnectionManager defaultManager];
+    NSArray *pausedConnections = nil;
     
-    for (AMAsyncConnectionOperation *operation in _pausedConnections)
+    @synchronized(self)
     {
-        NSInteger key = [connectionManager performConnectionOperation:operation inQueue:AMConnectionManagerDefaultQueueIdentifier useAuthentication:YES];
-        [_connectionKeys addIndex:key];
+        pausedConnections = [_pausedConnections copy];
+        [_pausedConnections removeAllObjects];
+        
+        for (AMAsyncConnectionOperation *operation in pausedConnections)
+            [_connectionKeys addIndex:[operation.connectionManagerKey integerValue]];
     }
     
-    [_pausedConnections removeAllObjects];
+    [self.connectionManager resumeConnectionOperations:pausedConnections];
 }
 
-- (void)changeConnectionPrioritiesTo:(AMConnectionPriority)priority
+- (void)_completeIfFinished
 {
-    AMConnectionManager *connectionManager = [AMConnectionManager defaultManager];
+    void (^completionBlock)(void) = nil;
     
-    NSIndexSet *indexSet = [_connectionKeys copy];
-    
-    NSInteger key = [indexSet firstIndex];
-    
-    while (key != NSNotFound)
+    @synchronized(self)
     {
-        [connectionManager changeToPriority:priority requestWithKey:key];
-        key = [indexSet indexGreaterThanIndex:key];
+        if (!_sealed || _completed || _pendingConnectionKeys.count > 0)
+            return;
+        
+        _completed = YES;
+        completionBlock = _completionBlock;
     }
     
+    if (completionBlock)
+        completionBlock();
 }
 
 @end
@@ -0,0 +1,50 @@
+//
+//  AMConnectionGroup_Private.h
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMConnectionGroup.h"
+
+@interface AMConnectionGroup ()
+
+/*!
+ * The AMConnectionManager performing the requests of the group. Groups created with alloc/init use the default manager.
+ */
+@property (nonatomic, strong) AMConnectionManager *connectionManager;
+
+/*!
+ * Adds the key of a request of a batch. The completionBlock is not called until all the keys added with this method have finished.
+ * @param key The request key.
+ */
+- (void)am_addPendingConnectionKey:(NSInteger)key;
+
+/*!
+ * The AMConnectionManager calls this method when a request of a batch has finished.
+ * @param key The request key.
+ */
+- (void)am_connectionDidFinishWithKey:(NSInteger)key;
+
+/*!
+ * The AMConnectionManager calls this method when all the requests of a batch have been added. The completionBlock can't be called before.
+ */
+- (void)am_seal;
+
+@end
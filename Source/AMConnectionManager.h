@@ -25,12 +25,47 @@
 #import <Foundation/Foundation.h>
 
 #import "AMAsyncConnectionOperation.h"
+#import "AMResponseCache.h"
+#import "AMRetryPolicy.h"
+#import "AMHedgingPolicy.h"
+#import "AMCircuitBreaker.h"
+#import "AMTokenBucket.h"
+#import "AMConcurrencyLimiter.h"
+#import "AMConnectionMetrics.h"
+#import "AMMemoryBudget.h"
+#import "AMBufferPool.h"
+#import "AMUploadBody.h"
+#import "AMResponseDecoder.h"
+#import "AMCurlTransport.h"
 
 extern NSString * const AMConnectionManagerConnectionsDidStartNotification;
 extern NSString * const AMConnectionManagerConnectionsDidFinishNotification;
 extern NSString * const AMConnectionManagerConnectionsQueueIdentifierKey;
 
+extern NSString * const AMConnectionManagerConcurrencyLimitDidChangeNotification;
+extern NSString * const AMConnectionManagerConcurrencyLimitKey;
+
+extern NSString * const AMConnectionManagerCircuitBreakerDidChangeStateNotification;
+extern NSString * const AMConnectionManagerHostKey;
+extern NSString * const AMConnectionManagerCircuitBreakerStateKey;
+
 extern NSString * const AMConnectionManagerDefaultQueueIdentifier;
+extern NSString * const AMConnectionManagerPrefetchQueueIdentifier;
+
+extern NSString * const AMConnectionManagerErrorDomain;
+
+/*!
+ * @typedef AMConnectionManagerError
+ * @abstract Error codes of the AMConnectionManagerErrorDomain.
+ */
+typedef NS_ENUM(NSInteger, AMConnectionManagerError)
+{
+    /** The deadline of the request has passed before the request could finish. */
+    AMConnectionManagerErrorDeadlineExceeded = 1,
+    
+    /** The circuit breaker of the host of the request is open, the request has not been performed. */
+    AMConnectionManagerErrorCircuitOpen = 2
+};
 
 /*!
  * @typedef AMConnectionPriority
@@ -57,6 +92,7 @@ typedef NS_ENUM(NSInteger, AMConnectionPriority)
 
 @class AMConcurrentOperation;
 @class AMAsyncConnectionOperation;
+@class AMConnectionGroup;
 @protocol AMConnectionManagerDelegate;
 
 /*!
@@ -79,7 +115,7 @@ typedef NS_ENUM(NSInteger, AMConnectionPriority)
 /// --------------------------------------------------------------------------------------------------------------------------------
 
 /*!
- * This property allows to turn on/off the UIApplication's networkActivityIndicator while requests are being performed.
+ * This property allows to turn on/off the UIApplication's networkActivityIndicator while requests are being performed. Only available on iOS.
  */
 @property (nonatomic, assign) BOOL showsNetworkActivityIndicator;
 
@@ -89,21 +125,251 @@ typedef NS_ENUM(NSInteger, AMConnectionPriority)
 @property (nonatomic, readwrite) NSInteger maxConcurrentConnectionCount;
 
 /*!
- * When the attribute is set to YES (the default) the connection manager present alert views when connection errors occurs.
+ * When the attribute is set to YES (the default) the connection manager present alert views when connection errors occurs. Only available on iOS.
  */
 @property (nonatomic, assign) BOOL showConnectionErrors;
 
 /*!
  * Set to YES to execute completionBlocks on main thread, otherwise the completion block is executed in the same background thread as the connection. Defaule value is NO.
+ * @discussion The completion blocks that are ready at the same time are executed together in a single main queue block.
  */
 @property (nonatomic, assign) BOOL executeCompletionBlocksOnMainThread;
 
+/*!
+ * The transport used by the connections created by the performRequest methods. If nil (the default), requests are performed with NSURLConnection.
+ * @discussion Set it before performing requests. For example, an AMCurlTransport reuses connections between requests to the same host.
+ */
+@property (nonatomic, strong) id <AMConnectionTransport> transport;
+
+/*!
+ * Set to YES to compress with gzip the bodies of the requests performed with the performRequest methods. Default value is NO.
+ * @discussion Only enable it if the servers accept compressed requests. See `compressesRequestBody` of AMAsyncConnectionOperation.
+ */
+@property (nonatomic, assign) BOOL compressesRequestBodies;
+
+/*!
+ * The queue where the completion blocks of the performRequest methods are executed. If NULL (the default), `executeCompletionBlocksOnMainThread` decides where they are executed.
+ * @discussion Completion blocks are delivered in batches: a single block dispatched to the queue executes every completion block ready until then, in order. Set it before performing requests.
+ */
+@property (nonatomic, AM_DISPATCH_PROPERTY) dispatch_queue_t completionQueue;
+
+/*!
+ * Set to YES to pre-allocate the destination file of download requests to the expected content length of the response. Default value is NO.
+ */
+@property (nonatomic, assign) BOOL preallocatesDownloadedFiles;
+
+/*!
+ * The response cache used by the performRequest methods. Default value is nil (no cache).
+ * @discussion Fresh cached responses are returned without performing any connection. Stale cached responses with a validator are revalidated with a conditional request (If-None-Match, If-Modified-Since), and the cached data is returned if the server answers 304 (Not Modified). Only GET requests are cached. Set an instance of AMResponseCache or any object implementing the AMResponseCaching protocol.
+ */
+@property (nonatomic, strong) id <AMResponseCaching> responseCache;
+
+/*!
+ * Set to YES to deduplicate identical GET and HEAD requests while one of them is in flight. Default value is NO.
+ * @discussion Requests are identical if they have the same method, URL and header fields. Each caller gets its own connection key and completion block, all fed from a single connection. Cancelling one of the keys only detaches that caller; the connection is cancelled when the last caller cancels. Only applies to the performRequest methods.
+ */
+@property (nonatomic, assign) BOOL coalescesRequests;
+
+/*!
+ * The minimum time between two progress status updates of the connections created by the performRequest methods. Default value is 0 (no limit).
+ */
+@property (nonatomic, assign) NSTimeInterval progressInterval;
+
+/*!
+ * The serial queue where the progress status blocks of the connections created by the performRequest methods are executed. If NULL (the default), they are executed in the connection thread.
+ * @discussion While an update is waiting to be executed in the queue, newer updates replace it. Use the main queue to update the UI.
+ */
+@property (nonatomic, AM_DISPATCH_PROPERTY) dispatch_queue_t progressQueue;
+
 /*!
  * Configure the max number of concurrent connections for a specific queue.
  * @param maxConcurrentConnectionCount The maximum number of connections. Specify -1 (default) and the system will determine the value automatically.
  */
 - (void)setMaxConcurrentConnectionCount:(NSInteger)maxConcurrentConnectionCount inQueue:(NSString*)queueIdentifier;
 
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Adaptive concurrency
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * Set an adaptive limit of concurrent connections for a specific queue. By default queues have a fixed limit.
+ * @param concurrencyLimiter The limiter, or nil to keep the current limit fixed.
+ * @param queueIdentifier The queue identifier. Use nil or AMConnectionManagerDefaultQueueIdentifier for the default queue.
+ * @discussion The limit of the queue is set to the limit of the limiter, and it is updated with the latency and the failures of every finished connection of the queue. While a limiter is set it overrides the values given to `setMaxConcurrentConnectionCount:inQueue:`. Every change of the limit posts an AMConnectionManagerConcurrencyLimitDidChangeNotification, with the queue identifier and the new limit in the keys AMConnectionManagerConnectionsQueueIdentifierKey and AMConnectionManagerConcurrencyLimitKey of the user info.
+ */
+- (void)setConcurrencyLimiter:(AMConcurrencyLimiter*)concurrencyLimiter forQueue:(NSString*)queueIdentifier;
+
+/*!
+ * Returns the adaptive limit of concurrent connections of a specific queue.
+ * @param queueIdentifier The queue identifier. Use nil or AMConnectionManagerDefaultQueueIdentifier for the default queue.
+ * @return The limiter, or nil if the queue has a fixed limit.
+ */
+- (AMConcurrencyLimiter*)concurrencyLimiterForQueue:(NSString*)queueIdentifier;
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Metrics
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * The metrics of the finished connections, per queue identifier and per host: counters, bytes per second and histograms of the queue wait time, time to first byte, transfer time and total time.
+ * @discussion Metrics are enabled by default. Set `metrics.enabled` to NO to stop recording them.
+ */
+@property (nonatomic, strong, readonly) AMConnectionMetrics *metrics;
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Memory
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * The budget of the bytes received in memory by the running connections of all queues.
+ * @discussion The budget is not limited by default. Set its `byteBudget` to limit it: while it is exhausted, new connections wait before starting and running connections are suspended, except one, until the buffered bytes are released. Downloads to a file don't use the budget.
+ * The budget counts the bytes delivered to the connections. A suspended AMCurlTransport connection stops reading its socket, but the default transport only delays the delivery of the data: the system may keep receiving it into its own buffers, which don't count in the budget. Its `peakBufferedBytes` is the maximum number of bytes buffered at the same time.
+ */
+@property (nonatomic, strong, readonly) AMMemoryBudget *memoryBudget;
+
+/*!
+ * The pool of the buffers where the connections receive the data.
+ * @discussion The data passed to the completion blocks uses the buffer of the connection without copying it, and the buffer returns to the pool when the data is released. Its `hitRate` is the fraction of the connections that have reused a buffer.
+ */
+@property (nonatomic, strong, readonly) AMBufferPool *bufferPool;
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Deadlines
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * Set the time limit of the requests of a specific queue, counting from the moment they are performed: it includes the time waiting in the queue, waiting for a connection slot, the transfer and the retries.
+ * @param timeout The time limit in seconds, or 0 (the default) for no limit.
+ * @param queueIdentifier The queue identifier. Use nil or AMConnectionManagerDefaultQueueIdentifier for the default queue.
+ * @discussion Requests that exceed the time limit fail with the AMConnectionManagerErrorDeadlineExceeded error. Requests still waiting in the queue are dropped without getting a network thread. Connection operations with their own deadline keep it.
+ */
+- (void)setRequestTimeout:(NSTimeInterval)timeout forQueue:(NSString*)queueIdentifier;
+
+/*!
+ * Returns the time limit of the requests of a specific queue.
+ * @param queueIdentifier The queue identifier. Use nil or AMConnectionManagerDefaultQueueIdentifier for the default queue.
+ * @return The time limit in seconds, or 0 for no limit.
+ */
+- (NSTimeInterval)requestTimeoutForQueue:(NSString*)queueIdentifier;
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Bandwidth and request rate limits
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * Limits the bandwidth used by all the connections of a specific queue, counting both received and sent bytes.
+ * @param bytesPerSecond The maximum number of bytes per second, or 0 (the default) for no limit.
+ * @param queueIdentifier The queue identifier. Use nil or AMConnectionManagerDefaultQueueIdentifier for the default queue.
+ * @discussion The limit can be changed at any time and it applies to the connections already running, for example to slow down a prefetch queue while the user is waiting for other requests. Connections over the limit suspend their transfer for a while. With a transport that stops reading the socket, like AMCurlTransport, the server slows down too; the default transport only delays the delivery of the data, the system may keep receiving it.
+ */
+- (void)setBandwidthLimit:(double)bytesPerSecond forQueue:(NSString*)queueIdentifier;
+
+/*!
+ * Returns the bandwidth limit of a specific queue.
+ * @param queueIdentifier The queue identifier. Use nil or AMConnectionManagerDefaultQueueIdentifier for the default queue.
+ * @return The maximum number of bytes per second, or 0 if there is no limit.
+ */
+- (double)bandwidthLimitForQueue:(NSString*)queueIdentifier;
+
+/*!
+ * Limits the number of connections per second started by a specific queue.
+ * @param requestsPerSecond The maximum number of connections started per second, or 0 (the default) for no limit.
+ * @param queueIdentifier The queue identifier. Use nil or AMConnectionManagerDefaultQueueIdentifier for the default queue.
+ * @discussion Connections over the limit wait before asking for a connection slot. The limit can be changed at any time.
+ */
+- (void)setRequestRateLimit:(double)requestsPerSecond forQueue:(NSString*)queueIdentifier;
+
+/*!
+ * Returns the request rate limit of a specific queue.
+ * @param queueIdentifier The queue identifier. Use nil or AMConnectionManagerDefaultQueueIdentifier for the default queue.
+ * @return The maximum number of connections started per second, or 0 if there is no limit.
+ */
+- (double)requestRateLimitForQueue:(NSString*)queueIdentifier;
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Retrying failed connections
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * Set the retry policy for the connections of a specific queue. By default queues have no retry policy and failed connections are not retried.
+ * @param retryPolicy The retry policy or nil to disable the retries.
+ * @param queueIdentifier The queue identifier. Use nil or AMConnectionManagerDefaultQueueIdentifier for the default queue.
+ * @discussion The policy applies to the connections performed after calling this method. A connection operation with its own `retryPolicy` uses it instead. The delegate and the completion block only get the result of the last attempt.
+ */
+- (void)setRetryPolicy:(AMRetryPolicy*)retryPolicy forQueue:(NSString*)queueIdentifier;
+
+/*!
+ * Returns the retry policy for the connections of a specific queue.
+ * @param queueIdentifier The queue identifier. Use nil or AMConnectionManagerDefaultQueueIdentifier for the default queue.
+ * @return The retry policy or nil if the connections of the queue are not retried.
+ */
+- (AMRetryPolicy*)retryPolicyForQueue:(NSString*)queueIdentifier;
+
+/*!
+ * The retry budget shared by all the connections of the manager, used by the retry policies without a `retryBudget` of their own. By default, a bucket of 10 tokens refilled at 1 token per second.
+ * @discussion Each retry takes a token, so however many requests fail at the same time, the retries can't multiply the load of the servers. Set to nil to disable the shared budget.
+ */
+@property (nonatomic, strong) AMTokenBucket *retryBudget;
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Hedging slow requests
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * Set the hedging policy for the requests of a specific queue. By default queues have no hedging policy.
+ * @param hedgingPolicy The hedging policy or nil to disable hedging.
+ * @param queueIdentifier The queue identifier. Use nil or AMConnectionManagerDefaultQueueIdentifier for the default queue.
+ * @discussion Applies to the requests performed with the performRequest methods after calling this method. When a request hasn't received a response after the delay of the policy, a second connection for the same request is performed in the same queue. The first one to succeed is delivered to the completion block and the other one is cancelled. Both connections are identified by the key returned by the performRequest method: cancelling it cancels both. Hedges are counted by the `hedgeCount` and `hedgeWinCount` of the metrics.
+ */
+- (void)setHedgingPolicy:(AMHedgingPolicy*)hedgingPolicy forQueue:(NSString*)queueIdentifier;
+
+/*!
+ * Returns the hedging policy for the requests of a specific queue.
+ * @param queueIdentifier The queue identifier. Use nil or AMConnectionManagerDefaultQueueIdentifier for the default queue.
+ * @return The hedging policy or nil if the requests of the queue are not hedged.
+ */
+- (AMHedgingPolicy*)hedgingPolicyForQueue:(NSString*)queueIdentifier;
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Circuit breakers
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * The policy of the circuit breakers of the hosts. Default value is nil (no circuit breakers).
+ * @discussion Each host gets its own circuit breaker. While the circuit of a host is open, new requests to it fail immediately with the AMConnectionManagerErrorCircuitOpen error, and queued connections to it fail when they are dequeued, without taking a network thread or a connection slot. Changes of state are notified to the delegate and with an AMConnectionManagerCircuitBreakerDidChangeStateNotification, with the host and the new state in the keys AMConnectionManagerHostKey and AMConnectionManagerCircuitBreakerStateKey of the user info. Set it before performing requests.
+ */
+@property (nonatomic, strong) AMCircuitBreakerPolicy *circuitBreakerPolicy;
+
+/*!
+ * Returns the state of the circuit breaker of a host.
+ * @param host The host.
+ * @return The state. Hosts without requests yet are closed.
+ */
+- (AMCircuitBreakerState)circuitBreakerStateForHost:(NSString*)host;
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Global and per host connection limits
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * Set the maximum number of concurrent connections of all queues together. By default (-1), there is no global limit.
+ * @discussion This limit is applied on top of the limits of each queue. Connections waiting for a slot are dispatched fairly between hosts: higher priorities first and round-robin between hosts with the same priority.
+ */
+@property (nonatomic, readwrite) NSInteger maxTotalConcurrentConnectionCount;
+
+/*!
+ * Set the maximum number of concurrent connections against the same host, from any queue. By default (-1), there is no limit.
+ * @discussion The host is taken from the URL of the request.
+ */
+@property (nonatomic, readwrite) NSInteger maxConcurrentConnectionCountPerHost;
+
+/*!
+ * Configure the max number of concurrent connections against a specific host.
+ * @param maxConcurrentConnectionCount The maximum number of connections. Specify -1 to use the value of maxConcurrentConnectionCountPerHost.
+ * @param host The host.
+ */
+- (void)setMaxConcurrentConnectionCount:(NSInteger)maxConcurrentConnectionCount forHost:(NSString*)host;
+
 /// --------------------------------------------------------------------------------------------------------------------------------
 /// @name Freeze & unfreeze connections
 /// --------------------------------------------------------------------------------------------------------------------------------
@@ -111,14 +377,14 @@ typedef NS_ENUM(NSInteger, AMConnectionPriority)
 /*!
  * This method freezes the queue with the given identifier: supsends the queue and pauses the executing connections.
  * @param identifier The queue identifier. Pass nil to refere to the default queue.
- * @discussion Because it is not possible to pause a connection, this method cancel the executing connections and these can be fired again calling the -unfreezeQueueWithIdentifier: method.
+ * @discussion Because it is not possible to pause a connection, this method cancel the executing connections and these can be fired again calling the -unfreezeQueueWithIdentifier: method. The bytes already received are kept so the connections can be resumed later.
  */
 - (void)freezeQueueWithIdentifier:(NSString*)identifier;
 
 /*!
  * This method unfreezes the queue with the given identifier: restarts the queue and the paused executing connections.
  * @param identifier The queue identifier. Pass nil to refere to the default queue.
- * @discussion Because it is not possible to pause a connection, this method fires from scratch the paused connections. The corresponding paused connections keys are keept the same.
+ * @discussion The paused connections are fired again asking only for the bytes not received yet (using the HTTP Range and If-Range headers) when the server provided an ETag or Last-Modified validator. If the server does not support ranges or the resource has changed, the connections are restarted from scratch. The corresponding paused connections keys are keept the same.
  */
 - (void)unfreezeQueueWithIdentifier:(NSString*)identifier;
 
@@ -232,7 +498,7 @@ typedef NS_ENUM(NSInteger, AMConnectionPriority)
  * @param progressStatus This block is potentially called multiple times, containing in the dictionary information about the headers and download & upload progress.
  * @param completionBlock This block is called when the connection ends.
  * @return The method returns an integer used as a key to identify the request. This identifier can be used in order to cancel the request.
- * @discussion The result operation will be inserted into the default queue.
+ * @discussion The result operation will be inserted into the default queue. If a fresh response for the request is found in the responseCache, no connection is performed and the completion block is called asynchronously with the cached response; in this case the returned key does not identify any operation.
  */
 - (NSInteger)performRequest:(NSURLRequest*)request
                    priority:(AMConnectionPriority)priority
@@ -240,6 +506,132 @@ typedef NS_ENUM(NSInteger, AMConnectionPriority)
              progressStatus:(void (^)(NSDictionary *progressStatus))progressStatusBlock
             completionBlock:(void (^)(NSURLResponse* response, NSData* data, NSError* error, NSInteger key))completion;
 
+/*!
+ * Use this method to perform a request connection asynchronously and get back the decoded response.
+ * @param request The request to perform.
+ * @param decoder The decoder of the received data, for example an AMJSONResponseDecoder.
+ * @param completionBlock This block is called with the decoded object when the connection ends.
+ * @return The method returns an integer used as a key to identify the request. This identifier can be used in order to cancel the request.
+ * @discussion The result operation will be inserted into the default queue.
+ */
+- (NSInteger)performRequest:(NSURLRequest*)request
+                    decoder:(id <AMResponseDecoding>)decoder
+            completionBlock:(void (^)(NSURLResponse* response, id object, NSError* error, NSInteger key))completion;
+
+/*!
+ * This methods performs asynchornously a connection request and decodes the received data.
+ * @param request The request to perform.
+ * @param priority The request priority.
+ * @param queueIdentifier The identifier of the queue to perform the request. USe nil to use the default queue.
+ * @param decoder The decoder of the received data, for example an AMJSONResponseDecoder.
+ * @param progressStatus This block is potentially called multiple times, containing in the dictionary information about the headers and download & upload progress.
+ * @param completionBlock This block is called with the decoded object when the connection ends. If the data can't be decoded, the object is nil and the error is the one of the decoder.
+ * @return The method returns an integer used as a key to identify the request. This identifier can be used in order to cancel the request.
+ * @discussion The data is decoded in a background queue limited to one decoding per processor, before the completion block is dispatched, so decoding large payloads doesn't block the connection threads nor the main thread. The decoding time is recorded in the `decodingTime` histogram of the metrics. Responses from the response cache are decoded too.
+ */
+- (NSInteger)performRequest:(NSURLRequest*)request
+                   priority:(AMConnectionPriority)priority
+                    inQueue:(NSString*)queueIdentifier
+                    decoder:(id <AMResponseDecoding>)decoder
+             progressStatus:(void (^)(NSDictionary *progressStatus))progressStatusBlock
+            completionBlock:(void (^)(NSURLResponse* response, id object, NSError* error, NSInteger key))completion;
+
+/*!
+ * This methods performs asynchornously a connection request writing the received data directly to a file.
+ * @param request The request to perform.
+ * @param fileURL The file URL where the received data is written. If the file exists it is overwritten.
+ * @param priority The request priority.
+ * @param queueIdentifier The identifier of the queue to perform the request. USe nil to use the default queue.
+ * @param progressStatus This block is potentially called multiple times, containing in the dictionary information about the headers and download & upload progress.
+ * @param completionBlock This block is called when the connection ends. The fileURL is nil if the connection fails.
+ * @return The method returns an integer used as a key to identify the request. This identifier can be used in order to cancel the request.
+ * @discussion The received data is never accumulated in memory, so use this method to download large resources. If the connection fails the partially downloaded file is removed. If the connection is paused, the partially downloaded file is kept and the download is resumed from it when possible.
+ */
+- (NSInteger)performDownloadRequest:(NSURLRequest*)request
+                          toFileURL:(NSURL*)fileURL
+                           priority:(AMConnectionPriority)priority
+                            inQueue:(NSString*)queueIdentifier
+                     progressStatus:(void (^)(NSDictionary *progressStatus))progressStatusBlock
+                    completionBlock:(void (^)(NSURLResponse* response, NSURL* fileURL, NSError* error, NSInteger key))completion;
+
+/*!
+ * This methods performs asynchornously a connection request streaming its body from the given upload body.
+ * @param request The request to perform. Its HTTPBody and HTTPBodyStream are ignored.
+ * @param body The body of the request.
+ * @param priority The request priority.
+ * @param queueIdentifier The identifier of the queue to perform the request. USe nil to use the default queue.
+ * @param progressStatus This block is potentially called multiple times, containing in the dictionary information about the headers and download & upload progress.
+ * @param completionBlock This block is called when the connection ends.
+ * @return The method returns an integer used as a key to identify the request. This identifier can be used in order to cancel the request.
+ * @discussion The body is read from its files and data segments while it is sent, so use this method to upload large files. If the connection is paused, the body is sent again from the beginning when the connection is resumed.
+ */
+- (NSInteger)performUploadRequest:(NSURLRequest*)request
+                             body:(AMUploadBody*)body
+                         priority:(AMConnectionPriority)priority
+                          inQueue:(NSString*)queueIdentifier
+                   progressStatus:(void (^)(NSDictionary *progressStatus))progressStatusBlock
+                  completionBlock:(void (^)(NSURLResponse* response, NSData* data, NSError* error, NSInteger key))completion;
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Performing batches of requests
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * Performs a batch of requests in the given queue.
+ * @param requests An array of NSURLRequest.
+ * @param priority The priority of all the requests.
+ * @param queueIdentifier The queue identifier. Use nil or AMConnectionManagerDefaultQueueIdentifier for the default queue.
+ * @param completion The completion block, called once per request.
+ * @param groupCompletion A block called once, after the completion blocks of all the requests, when all of them have finished or have been cancelled through the returned group.
+ * @return A group containing all the requests, to cancel, pause, resume or change the priority of all of them at once.
+ * @discussion Requests are handled as in the performRequest methods (response cache and request coalescing included), but all the operations are added to the queue at once.
+ */
+- (AMConnectionGroup*)performRequests:(NSArray*)requests
+                             priority:(AMConnectionPriority)priority
+                              inQueue:(NSString*)queueIdentifier
+                      completionBlock:(void (^)(NSURLResponse* response, NSData* data, NSError* error, NSInteger key))completion
+                      groupCompletion:(void (^)(void))groupCompletion;
+
+/*!
+ * Cancels the requests with the given keys.
+ * @param keys The request keys.
+ * @return An array with a copy of each cancelled connection operation, as returned by -cancelRequestWithKey:. Pass it to -resumeConnectionOperations: to perform them again.
+ */
+- (NSArray*)cancelRequestsWithKeys:(NSIndexSet*)keys;
+
+/*!
+ * Performs again connection operations returned by -cancelRequestWithKey: or -cancelRequestsWithKeys:.
+ * @param operations An array of AMAsyncConnectionOperation.
+ * @discussion Each operation is performed in the queue where it was performed before and keeps its request key.
+ */
+- (void)resumeConnectionOperations:(NSArray*)operations;
+
+/*!
+ * Changes the priority of the requests with the given keys.
+ * @param priority The new priority.
+ * @param keys The request keys.
+ */
+- (void)changeToPriority:(AMConnectionPriority)priority requestsWithKeys:(NSIndexSet*)keys;
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Prefetching
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * Performs a request that will probably be needed soon, in the prefetch queue (AMConnectionManagerPrefetchQueueIdentifier).
+ * @param request The request to prefetch.
+ * @return The key of the request, to cancel it.
+ * @discussion Prefetch requests have the lowest priority and only run while the other queues have spare capacity: as soon as another queue has connections waiting at its limit, a connection waits for a global or per host connection slot, or a connection with a high priority runs, the running prefetch requests are paused, and they continue when the other queues have spare capacity again. Freezing and unfreezing the prefetch queue is independent of this: a frozen prefetch queue stays frozen. When a request identical to a prefetch request is performed while the prefetch request is in flight, it waits for it instead of performing a new connection and the prefetch request is promoted to its queue and priority. Otherwise the received response is only kept in the `responseCache`, so set one to get the benefit of prefetching. By default the prefetch queue performs 2 connections at the same time.
+ */
+- (NSInteger)prefetchRequest:(NSURLRequest*)request;
+
+/*!
+ * Performs a batch of requests that will probably be needed soon, in the prefetch queue.
+ * @param requests An array of NSURLRequest.
+ * @return A group containing all the requests, for example to cancel them when the content they are prefetched for is no longer going to be visible.
+ * @discussion See -prefetchRequest:.
+ */
+- (AMConnectionGroup*)prefetchRequests:(NSArray*)requests;
 
 /// --------------------------------------------------------------------------------------------------------------------------------
 /// @name Managing existing requests
@@ -249,7 +641,7 @@ typedef NS_ENUM(NSInteger, AMConnectionPriority)
  * This method allow request cancelation.
  * @param key The request key.
  * @discussion If the request has been already executed or the key is unknown, this method does nothing.
- * @return The method return a new copy of the connection operation that can be reused to perform the connection again if needed.
+ * @return The method return a new copy of the connection operation that can be reused to perform the connection again if needed. The copy resumes the connection from the bytes already received when possible.
  */
 - (AMAsyncConnectionOperation*)cancelRequestWithKey:(NSInteger)key;
 
@@ -346,4 +738,12 @@ typedef NS_ENUM(NSInteger, AMConnectionPriority)
  */
 - (void)connectionManager:(AMConnectionManager*)manager authenticationDidFailForConnectionOperation:(AMAsyncConnectionOperation*)operation authenticationChallange:(NSURLAuthenticationChallenge*)challange;
 
+/*!
+ * When the circuit breaker of a host changes its state, this method is called. It can be called from any thread.
+ * @param manager The connection manager.
+ * @param host The host.
+ * @param state The new state.
+ */
+- (void)connectionManager:(AMConnectionManager*)manager circuitBreakerForHost:(NSString*)host didChangeState:(AMCircuitBreakerState)state;
+
 @end
\ No newline at end of file
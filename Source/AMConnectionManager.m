@@ -25,27 +25,67 @@
 #import "AMConnectionManager_Private.h"
 
 #import "AMAsyncConnectionOperation_Private.h"
+#import "AMOperationRegistry.h"
+#import "AMHostScheduler.h"
+#import "AMRetryPolicy.h"
+#import "AMRequestCoalescer.h"
+#import "AMConnectionGroup_Private.h"
+#import "AMCompletionQueue.h"
+#import "AMConnectionQueueState.h"
+
+#import <stdatomic.h>
+
+#if TARGET_OS_IPHONE
+#import <UIKit/UIKit.h>
+#endif
 
 NSString * const AMConnectionManagerConnectionsDidStartNotification = @"AMConnectionManagerConnectionsDidStartNotification";
 NSString * const AMConnectionManagerConnectionsDidFinishNotification = @"AMConnectionManagerConnectionsDidFinishNotification";
 NSString * const AMConnectionManagerConnectionsQueueIdentifierKey = @"AMConnectionManagerConnectionsQueueIdentifierKey";
+NSString * const AMConnectionManagerConcurrencyLimitDidChangeNotification = @"AMConnectionManagerConcurrencyLimitDidChangeNotification";
+NSString * const AMConnectionManagerConcurrencyLimitKey = @"AMConnectionManagerConcurrencyLimitKey";
+NSString * const AMConnectionManagerCircuitBreakerDidChangeStateNotification = @"AMConnectionManagerCircuitBreakerDidChangeStateNotification";
+NSString * const AMConnectionManagerHostKey = @"AMConnectionManagerHostKey";
+NSString * const AMConnectionManagerCircuitBreakerStateKey = @"AMConnectionManagerCircuitBreakerStateKey";
 NSString * const AMConnectionManagerDefaultQueueIdentifier = @"AMConnectionManagerDefaultQueueIdentifier";
+NSString * const AMConnectionManagerPrefetchQueueIdentifier = @"AMConnectionManagerPrefetchQueueIdentifier";
 
+NSString * const AMConnectionManagerErrorDomain = @"AMConnectionManagerErrorDomain";
+
+#if TARGET_OS_IPHONE
 @interface AMConnectionManager () <UIAlertViewDelegate>
 
 @end
+#endif
 
 @implementation AMConnectionManager
 {
-    NSMutableDictionary *_queues;
-    NSMutableDictionary *_pausedOperations;
+    NSMutableDictionary *_queueStates;
+    NSMutableDictionary *_retryPolicies;
+    NSMutableDictionary *_hedgingPolicies;
+    NSMutableDictionary *_circuitBreakers;
+    NSMutableDictionary *_requestTimeouts;
+    NSMutableDictionary *_bandwidthBuckets;
+    NSMutableDictionary *_requestRateBuckets;
         
-    NSMutableDictionary *_operations;
-    NSInteger _lastKey;
+    AMOperationRegistry *_operations;
+    AMRequestCoalescer *_coalescer;
+    AMHostScheduler *_scheduler;
+    
+    atomic_bool _prefetchesRequests;
+    atomic_bool _prefetchUpdatePending;
+    
+    AMCompletionQueue *_mainCompletionQueue;
+    AMCompletionQueue *_targetCompletionQueue;
+    
+    NSOperationQueue *_decodingQueue;
     
     BOOL _isShowingAlert;
     
+#if TARGET_OS_IPHONE
     UIBackgroundTaskIdentifier _bgTask;
+    atomic_bool _networkActivityIndicatorRefreshPending;
+#endif
     NSInteger _queuesNotEmpty;
     BOOL _isBackroundExecution;
     
@@ -53,6 +93,8 @@ NSString * const AMConnectionManagerDefaultQueueIdentifier = @"AMConnectionManag
 }
 
 @dynamic maxConcurrentConnectionCount;
+@dynamic maxTotalConcurrentConnectionCount;
+@dynamic maxConcurrentConnectionCountPerHost;
 
 + (AMConnectionManager*)defaultManager
 {
@@ -70,29 +112,58 @@ NSString * const AMConnectionManagerDefaultQueueIdentifier = @"AMConnectionManag
     if (self)
     {
         _executeCompletionBlocksOnMainThread = NO;
+        _mainCompletionQueue = [[AMCompletionQueue alloc] initWithTargetQueue:dispatch_get_main_queue()];
         
-        _queues = [NSMutableDictionary dictionary];
-        _pausedOperations = [NSMutableDictionary dictionary];
+        _queueStates = [NSMutableDictionary dictionary];
+        
+        atomic_init(&_prefetchesRequests, false);
+        atomic_init(&_prefetchUpdatePending, false);
+        _retryPolicies = [NSMutableDictionary dictionary];
+        _retryBudget = [[AMTokenBucket alloc] initWithCapacity:10.0 refillRate:1.0];
+        _hedgingPolicies = [NSMutableDictionary dictionary];
+        _circuitBreakers = [NSMutableDictionary dictionary];
+        _requestTimeouts = [NSMutableDictionary dictionary];
+        _bandwidthBuckets = [NSMutableDictionary dictionary];
+        _requestRateBuckets = [NSMutableDictionary dictionary];
         
         _backgroundExecutionQueueIdentifiers = [NSSet set];
         
         _isBackroundExecution = NO;
         _queuesNotEmpty = 0;
+#if TARGET_OS_IPHONE
         _bgTask = UIBackgroundTaskInvalid;
+        atomic_init(&_networkActivityIndicatorRefreshPending, false);
+#endif
+        
+        _operations = [[AMOperationRegistry alloc] init];
+        _coalescer = [[AMRequestCoalescer alloc] init];
+        _scheduler = [[AMHostScheduler alloc] init];
+        _metrics = [[AMConnectionMetrics alloc] init];
+        _memoryBudget = [[AMMemoryBudget alloc] init];
+        _bufferPool = [[AMBufferPool alloc] init];
         
-        _lastKey = -1;
-        _operations = [NSMutableDictionary dictionary];
+        _decodingQueue = [[NSOperationQueue alloc] init];
+        _decodingQueue.maxConcurrentOperationCount = [[NSProcessInfo processInfo] activeProcessorCount];
         _showConnectionErrors = NO;
         
         _credentials = [NSMutableDictionary dictionary];
         
+#if TARGET_OS_IPHONE
         NSNotificationCenter *nc = [NSNotificationCenter defaultCenter];
         [nc addObserver:self selector:@selector(am_notificationReceived:) name:UIApplicationDidEnterBackgroundNotification object:nil];
         [nc addObserver:self selector:@selector(am_notificationReceived:) name:UIApplicationDidBecomeActiveNotification object:nil];
+        [nc addObserver:self selector:@selector(am_notificationReceived:) name:UIApplicationDidReceiveMemoryWarningNotification object:nil];
+#endif
     }
     return self;
 }
 
+- (void)dealloc
+{
+    AMDispatchRelease(_completionQueue);
+    AMDispatchRelease(_progressQueue);
+}
+
 #pragma mark Properties
 
 - (NSInteger)maxConcurrentConnectionCount
@@ -105,9 +176,51 @@ NSString * const AMConnectionManagerDefaultQueueIdentifier = @"AMConnectionManag
     [[self am_queueWithIdentifier:AMConnectionManagerDefaultQueueIdentifier] setMaxConcurrentOperationCount:maxConcurrentConnectionCount];
 }
 
+- (NSInteger)maxTotalConcurrentConnectionCount
+{
+    return _scheduler.maximumConnectionCount;
+}
+
+- (void)setMaxTotalConcurrentConnectionCount:(NSInteger)maxTotalConcurrentConnectionCount
+{
+    _scheduler.maximumConnectionCount = maxTotalConcurrentConnectionCount;
+}
+
+- (NSInteger)maxConcurrentConnectionCountPerHost
+{
+    return _scheduler.maximumConnectionCountPerHost;
+}
+
+- (void)setMaxConcurrentConnectionCountPerHost:(NSInteger)maxConcurrentConnectionCountPerHost
+{
+    _scheduler.maximumConnectionCountPerHost = maxConcurrentConnectionCountPerHost;
+}
+
 - (void)setBackgroundExecutionQueueIdentifiers:(NSSet *)backgroundExecutionQueueIdentifiers
 {
     _backgroundExecutionQueueIdentifiers = backgroundExecutionQueueIdentifiers;
+    
+    for (AMConnectionQueueState *state in [self am_allQueueStates])
+        state.executesInBackground = [backgroundExecutionQueueIdentifiers containsObject:state.identifier];
+}
+
+- (void)setCompletionQueue:(dispatch_queue_t)completionQueue
+{
+    if (completionQueue == _completionQueue)
+        return;
+    
+    AMDispatchRelease(_completionQueue);
+    _completionQueue = AMDispatchRetain(completionQueue);
+    _targetCompletionQueue = completionQueue ? [[AMCompletionQueue alloc] initWithTargetQueue:completionQueue] : nil;
+}
+
+- (void)setProgressQueue:(dispatch_queue_t)progressQueue
+{
+    if (progressQueue == _progressQueue)
+        return;
+    
+    AMDispatchRelease(_progressQueue);
+    _progressQueue = AMDispatchRetain(progressQueue);
 }
 
 #pragma mark Public Methods
@@ -117,63 +230,155 @@ NSString * const AMConnectionManagerDefaultQueueIdentifier = @"AMConnectionManag
     [[self am_queueWithIdentifier:queueIdentifier] setMaxConcurrentOperationCount:maxConcurrentConnectionCount];
 }
 
-- (void)freezeQueueWithIdentifier:(NSString*)identifier
+- (void)setConcurrencyLimiter:(AMConcurrencyLimiter*)concurrencyLimiter forQueue:(NSString*)queueIdentifier
 {
-    NSOperationQueue *queue = [self operationQueueForIdentifier:identifier];
-    NSMutableArray *pausedOperations = [_pausedOperations valueForKey:identifier];
+    AMConnectionQueueState *state = [self am_queueStateForIdentifier:queueIdentifier];
+    
+    state.concurrencyLimiter = concurrencyLimiter;
     
-    [queue setSuspended:YES];
+    if (concurrencyLimiter)
+        state.queue.maxConcurrentOperationCount = concurrencyLimiter.limit;
+}
+
+- (AMConcurrencyLimiter*)concurrencyLimiterForQueue:(NSString*)queueIdentifier
+{
+    return [[self am_queueStateForIdentifier:queueIdentifier] concurrencyLimiter];
+}
+
+- (void)setMaxConcurrentConnectionCount:(NSInteger)maxConcurrentConnectionCount forHost:(NSString*)host
+{
+    [_scheduler setMaximumConnectionCount:maxConcurrentConnectionCount forHost:host];
+}
+
+- (void)setRetryPolicy:(AMRetryPolicy*)retryPolicy forQueue:(NSString*)queueIdentifier
+{
+    if (queueIdentifier == nil)
+        queueIdentifier = AMConnectionManagerDefaultQueueIdentifier;
     
-    if (!pausedOperations)
+    @synchronized(_retryPolicies)
     {
-        pausedOperations = [NSMutableArray array];
-        [_pausedOperations setValue:pausedOperations forKey:identifier];
+        [_retryPolicies setValue:retryPolicy forKey:queueIdentifier];
     }
+}
+
+- (AMRetryPolicy*)retryPolicyForQueue:(NSString*)queueIdentifier
+{
+    if (queueIdentifier == nil)
+        queueIdentifier = AMConnectionManagerDefaultQueueIdentifier;
     
-    for (AMAsyncConnectionOperation *operation in queue.operations)
+    @synchronized(_retryPolicies)
     {
-        if (operation.isExecuting)
-        {
-            [operation cancel];
-            [pausedOperations addObject:operation];
-        }
+        return [_retryPolicies valueForKey:queueIdentifier];
     }
 }
 
-- (void)unfreezeQueueWithIdentifier:(NSString*)identifier
-{    
-    NSOperationQueue *queue = [self operationQueueForIdentifier:identifier];
-    NSMutableArray *pausedOperations = [_pausedOperations valueForKey:identifier];
+- (void)setHedgingPolicy:(AMHedgingPolicy*)hedgingPolicy forQueue:(NSString*)queueIdentifier
+{
+    if (queueIdentifier == nil)
+        queueIdentifier = AMConnectionManagerDefaultQueueIdentifier;
     
-    for (AMAsyncConnectionOperation *operation in pausedOperations)
+    @synchronized(_hedgingPolicies)
     {
-        AMAsyncConnectionOperation *newOperation = [operation copy];
-        
-        [_operations setObject:newOperation forKey:newOperation.connectionManagerKey];
+        [_hedgingPolicies setValue:hedgingPolicy forKey:queueIdentifier];
+    }
+}
 
-        [queue addOperation:newOperation];
-        [self am_refreshNetworkActivityIndicatorState];
+- (AMHedgingPolicy*)hedgingPolicyForQueue:(NSString*)queueIdentifier
+{
+    if (queueIdentifier == nil)
+        queueIdentifier = AMConnectionManagerDefaultQueueIdentifier;
+    
+    @synchronized(_hedgingPolicies)
+    {
+        return [_hedgingPolicies valueForKey:queueIdentifier];
+    }
+}
+
+- (AMCircuitBreakerState)circuitBreakerStateForHost:(NSString*)host
+{
+    @synchronized(_circuitBreakers)
+    {
+        AMCircuitBreaker *circuitBreaker = [_circuitBreakers objectForKey:[host lowercaseString] ?: @""];
+        return circuitBreaker ? circuitBreaker.state : AMCircuitBreakerStateClosed;
+    }
+}
+
+- (void)setRequestTimeout:(NSTimeInterval)timeout forQueue:(NSString*)queueIdentifier
+{
+    if (queueIdentifier == nil)
+        queueIdentifier = AMConnectionManagerDefaultQueueIdentifier;
+    
+    @synchronized(_requestTimeouts)
+    {
+        [_requestTimeouts setValue:(timeout > 0 ? @(timeout) : nil) forKey:queueIdentifier];
+    }
+}
+
+- (NSTimeInterval)requestTimeoutForQueue:(NSString*)queueIdentifier
+{
+    if (queueIdentifier == nil)
+        queueIdentifier = AMConnectionManagerDefaultQueueIdentifier;
+    
+    @synchronized(_requestTimeouts)
+    {
+        return [[_requestTimeouts valueForKey:queueIdentifier] doubleValue];
     }
+}
+
+- (void)setBandwidthLimit:(double)bytesPerSecond forQueue:(NSString*)queueIdentifier
+{
+    // Bursts of up to one second of transfer.
+    [[self am_tokenBucketForQueue:queueIdentifier inDictionary:_bandwidthBuckets] setCapacity:bytesPerSecond refillRate:bytesPerSecond];
+}
+
+- (double)bandwidthLimitForQueue:(NSString*)queueIdentifier
+{
+    return [[self am_tokenBucketForQueue:queueIdentifier inDictionary:_bandwidthBuckets] refillRate];
+}
+
+- (void)setRequestRateLimit:(double)requestsPerSecond forQueue:(NSString*)queueIdentifier
+{
+    [[self am_tokenBucketForQueue:queueIdentifier inDictionary:_requestRateBuckets] setCapacity:MAX(requestsPerSecond, 1.0) refillRate:requestsPerSecond];
+}
+
+- (double)requestRateLimitForQueue:(NSString*)queueIdentifier
+{
+    return [[self am_tokenBucketForQueue:queueIdentifier inDictionary:_requestRateBuckets] refillRate];
+}
+
+- (void)freezeQueueWithIdentifier:(NSString*)identifier
+{
+    AMConnectionQueueState *state = [self am_queueStateForIdentifier:identifier];
+    
+    // Hedges are not resumed: cancelling their primary operation cancels them.
+    [state pauseForReason:AMConnectionQueuePauseReasonFreeze operationsPassingTest:^BOOL(AMAsyncConnectionOperation *operation) {
+        return operation.hedgedRequest.hedgeOperation != operation;
+    }];
+}
+
+- (void)unfreezeQueueWithIdentifier:(NSString*)identifier
+{    
+    AMConnectionQueueState *state = [self am_queueStateForIdentifier:identifier];
     
-    [pausedOperations removeAllObjects];
-    [queue setSuspended:NO];
+    // A preempted prefetch queue stays paused until the other queues have spare capacity again.
+    [state resumeForReason:AMConnectionQueuePauseReasonFreeze performingPausedOperations:^(NSArray *pausedOperations) {
+        [self am_performPausedOperations:pausedOperations inQueue:state];
+    }];
 }
 
 - (void)freeze
 {
-    NSArray *allKeys = [_queues allKeys];
-    for (NSString *key in allKeys)
+    for (AMConnectionQueueState *state in [self am_allQueueStates])
     {
-        [self freezeQueueWithIdentifier:key];
+        [self freezeQueueWithIdentifier:state.identifier];
     }
 }
 
 - (void)unfreeze
 {
-    NSArray *allKeys = [_queues allKeys];
-    for (NSString *key in allKeys)
+    for (AMConnectionQueueState *state in [self am_allQueueStates])
     {
-        [self unfreezeQueueWithIdentifier:key];
+        [self unfreezeQueueWithIdentifier:state.identifier];
     }
 }
 
@@ -193,8 +398,8 @@ NSString * const AMConnectionManagerDefaultQueueIdentifier = @"AMConnectionManag
     
     NSInteger operationKey = [self am_nextKey];
     
-    NSNumber *numberKey = @(operationKey);
-    operation.connectionManagerKey = numberKey;
+    operation.connectionManagerKey = @(operationKey);
+    [self am_prepareConnectionOperation:operation forQueue:queueIdentifier];
     
     if (flag)
     {
@@ -202,13 +407,7 @@ NSString * const AMConnectionManagerDefaultQueueIdentifier = @"AMConnectionManag
         operation.credential = [_credentials valueForKey:operation.request.URL.host];
     }
     
-    [_operations setObject:operation forKey:numberKey];
-    
-    __weak AMConnectionManager *connectionManager = self;
-    [operation setCompletionBlock:^{
-        [_operations removeObjectForKey:numberKey];
-        [connectionManager am_refreshNetworkActivityIndicatorState];
-    }];
+    [_operations setOperation:operation forKey:operationKey];
     
     [queue addOperation:operation];
     [self am_refreshNetworkActivityIndicatorState];
@@ -270,88 +469,486 @@ NSString * const AMConnectionManagerDefaultQueueIdentifier = @"AMConnectionManag
                     inQueue:(NSString*)queueIdentifier
              progressStatus:(void (^)(NSDictionary *progressStatus))progressStatusBlock
             completionBlock:(void (^)(NSURLResponse* response, NSData* data, NSError* error, NSInteger key))completion
+{
+    NSInteger operationKey = [self am_performRequest:request
+                                            priority:priority
+                                             inQueue:queueIdentifier
+                                             decoder:nil
+                                      progressStatus:progressStatusBlock
+                                     completionBlock:completion
+                                   pendingOperations:nil];
+    
+    [self am_refreshNetworkActivityIndicatorState];
+    
+    return operationKey;
+}
+
+- (NSInteger)performRequest:(NSURLRequest*)request
+                    decoder:(id <AMResponseDecoding>)decoder
+            completionBlock:(void (^)(NSURLResponse* response, id object, NSError* error, NSInteger key))completion
+{
+    return [self performRequest:request
+                       priority:AMConnectionPriorityNormal
+                        inQueue:nil
+                        decoder:decoder
+                 progressStatus:NULL
+                completionBlock:completion];
+}
+
+- (NSInteger)performRequest:(NSURLRequest*)request
+                   priority:(AMConnectionPriority)priority
+                    inQueue:(NSString*)queueIdentifier
+                    decoder:(id <AMResponseDecoding>)decoder
+             progressStatus:(void (^)(NSDictionary *progressStatus))progressStatusBlock
+            completionBlock:(void (^)(NSURLResponse* response, id object, NSError* error, NSInteger key))completion
+{
+    NSInteger operationKey = [self am_performRequest:request
+                                            priority:priority
+                                             inQueue:queueIdentifier
+                                             decoder:decoder
+                                      progressStatus:progressStatusBlock
+                                     completionBlock:completion
+                                   pendingOperations:nil];
+    
+    [self am_refreshNetworkActivityIndicatorState];
+    
+    return operationKey;
+}
+
+- (NSInteger)am_performRequest:(NSURLRequest*)request
+                      priority:(AMConnectionPriority)priority
+                       inQueue:(NSString*)queueIdentifier
+                       decoder:(id <AMResponseDecoding>)decoder
+                progressStatus:(void (^)(NSDictionary *progressStatus))progressStatusBlock
+               completionBlock:(void (^)(NSURLResponse* response, id data, NSError* error, NSInteger key))completion
+             pendingOperations:(NSMutableArray*)pendingOperations
 {
     NSInteger operationKey = [self am_nextKey];
     
-    void (^connectionCompletion)(NSURLResponse* response, NSData* data, NSError* error) = ^(NSURLResponse* response, NSData* data, NSError* error) {
+    void (^deliverCompletion)(NSURLResponse* response, NSData* data, NSError* error) = ^(NSURLResponse* response, NSData* data, NSError* error) {
         
         if (!completion)
             return;
         
-        if (_executeCompletionBlocksOnMainThread)
+        if (decoder && !error)
+        {
+            // Decoded in the decoding queue, so large payloads don't block the connection threads or the completion queue.
+            [self am_decodeData:data response:response request:request inQueue:queueIdentifier decoder:decoder completion:^(id object, NSError *decodingError) {
+                [self am_deliverCompletion:^{
+                    completion(response, object, decodingError, operationKey);
+                }];
+            }];
+            return;
+        }
+        
+        [self am_deliverCompletion:^{
+            completion(response, decoder ? nil : data, error, operationKey);
+        }];
+    };
+    
+    id <AMResponseCaching> responseCache = _responseCache;
+    AMCachedResponse *cachedResponse = [self am_cachedResponseForRequest:request];
+    
+    if (cachedResponse.isFresh || (cachedResponse && request.cachePolicy == NSURLRequestReturnCacheDataElseLoad))
+    {
+        if (completion)
+        {
+            dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+                deliverCompletion(cachedResponse.response, cachedResponse.data, nil);
+            });
+        }
+        
+        return operationKey;
+    }
+    
+    // While the circuit of the host is open the request fails right away, without taking a place in the queue.
+    if ([[self am_circuitBreakerForHost:request.URL.host create:NO] rejectsRequests])
+    {
+        if (completion)
         {
-            dispatch_async(dispatch_get_main_queue(), ^{
-                completion(response, data, error, operationKey);
+            NSError *error = [self am_circuitOpenErrorForRequest:request];
+            
+            dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+                deliverCompletion(nil, nil, error);
             });
         }
+        
+        return operationKey;
+    }
+    
+    NSURLRequest *connectionRequest = request;
+    
+    if (cachedResponse.canBeRevalidated)
+        connectionRequest = [cachedResponse conditionalRequestForRequest:request];
+    else
+        cachedResponse = nil;
+    
+    BOOL prefetching = [queueIdentifier isEqualToString:AMConnectionManagerPrefetchQueueIdentifier];
+    
+    if (prefetching)
+        atomic_store(&_prefetchesRequests, true);
+    
+    AMRequestCoalescer *coalescer = _coalescer;
+    AMRequestFlight *flight = nil;
+    
+    // Without request coalescing, requests only need a fingerprint to join the prefetch flights in progress.
+    BOOL joinsFlights = _coalescesRequests || prefetching || coalescer.prefetchFlightCount > 0;
+    NSString *fingerprint = joinsFlights ? [AMRequestCoalescer fingerprintForRequest:connectionRequest] : nil;
+    
+    if (fingerprint)
+    {
+        // An identical request is already in flight: wait for its result instead of performing a new connection.
+        // Without request coalescing, only prefetch requests have flights.
+        AMRequestFlight *joinedFlight = [coalescer joinFlightWithFingerprint:fingerprint key:operationKey completion:deliverCompletion progressStatus:progressStatusBlock];
+        
+        if (joinedFlight)
+        {
+            if (!prefetching && joinedFlight.isPrefetch)
+                [self am_promotePrefetchOperationWithKey:joinedFlight.operationKey toPriority:priority inQueue:queueIdentifier];
+            
+            return operationKey;
+        }
+    }
+    
+    // The operation of a flight is registered under an internal key: every key returned to a caller is resolved through the
+    // coalescer, so cancelling it twice can't reach the operation the other waiters are sharing.
+    NSInteger connectionOperationKey = operationKey;
+    
+    if (fingerprint && (_coalescesRequests || prefetching))
+    {
+        connectionOperationKey = [self am_nextKey];
+        flight = [coalescer beginFlightWithFingerprint:fingerprint key:operationKey operationKey:connectionOperationKey prefetch:prefetching completion:deliverCompletion progressStatus:progressStatusBlock];
+        
+        progressStatusBlock = ^(NSDictionary *progressStatus) {
+            [flight deliverProgressStatus:progressStatus];
+        };
+    }
+    
+    void (^connectionCompletion)(NSURLResponse* response, NSData* data, NSError* error) = ^(NSURLResponse* response, NSData* data, NSError* error) {
+        
+        if (!error && responseCache)
+        {
+            if (cachedResponse && [response isKindOfClass:[NSHTTPURLResponse class]] && [(NSHTTPURLResponse*)response statusCode] == 304)
+            {
+                AMCachedResponse *revalidatedResponse = [cachedResponse cachedResponseByRevalidatingWithResponse:(NSHTTPURLResponse*)response];
+                [responseCache storeCachedResponse:revalidatedResponse forRequest:request];
+                
+                response = revalidatedResponse.response;
+                data = revalidatedResponse.data;
+            }
+            else if ([AMCachedResponse isCacheableResponse:response forRequest:request])
+            {
+                [responseCache storeCachedResponse:[[AMCachedResponse alloc] initWithResponse:(NSHTTPURLResponse*)response data:data date:[NSDate date]]
+                                        forRequest:request];
+            }
+        }
+        
+        if (flight)
+        {
+            for (AMRequestFlightWaiter *waiter in [coalescer finishFlight:flight])
+                waiter.completion(response, data, error);
+        }
         else
         {
-            completion(response, data, error, operationKey);
+            deliverCompletion(response, data, error);
         }
     };
-
-    AMAsyncConnectionOperation *operation = [[AMAsyncConnectionOperation alloc] initWithRequest:request completionBlock:connectionCompletion];
-    operation.serverTurstAuthentication = [_trustedHosts containsObject:request.URL.host];
-    operation.credential = [_credentials valueForKey:request.URL.host];
     
-    operation.progressStatusBlock = progressStatusBlock;
-    operation.queuePriority = (NSOperationQueuePriority)priority;
+    AMHedgingPolicy *hedgingPolicy = [self hedgingPolicyForQueue:queueIdentifier];
+    NSTimeInterval hedgeDelay = -1;
+    AMHedgedRequest *hedgedRequest = nil;
     
-    NSNumber *numberKey = @(operationKey);
-    operation.connectionManagerKey = numberKey;
-    [_operations setObject:operation forKey:numberKey];
+    if (hedgingPolicy)
+        hedgeDelay = [hedgingPolicy hedgeDelayForRequest:connectionRequest metrics:_metrics];
     
-    __weak AMConnectionManager *connectionManager = self;
-    [operation setCompletionBlock:^{
-        [_operations removeObjectForKey:numberKey];
-        [connectionManager am_refreshNetworkActivityIndicatorState];
-    }];
+    if (hedgeDelay >= 0)
+    {
+        AMConnectionMetrics *metrics = _metrics;
+        NSString *host = connectionRequest.URL.host;
+        NSString *hedgeQueueIdentifier = queueIdentifier ?: AMConnectionManagerDefaultQueueIdentifier;
+        
+        // Both attempts complete through the hedged request, which delivers only one result.
+        hedgedRequest = [[AMHedgedRequest alloc] initWithCompletion:connectionCompletion hedgeWinBlock:^{
+            [metrics recordHedgeWinInQueue:hedgeQueueIdentifier host:host];
+        }];
+        
+        connectionCompletion = [hedgedRequest primaryCompletion];
+    }
     
-    NSOperationQueue *queue = [self am_queueWithIdentifier:queueIdentifier];
+    AMAsyncConnectionOperation *operation = [self am_connectionOperationWithRequest:connectionRequest
+                                                                           priority:priority
+                                                                     progressStatus:progressStatusBlock
+                                                                    completionBlock:connectionCompletion];
     
-    [queue addOperation:operation];
-    [self am_refreshNetworkActivityIndicatorState];
+    [self am_registerConnectionOperation:operation withKey:connectionOperationKey inQueue:queueIdentifier];
+    
+    if (hedgedRequest)
+    {
+        hedgedRequest.primaryOperation = operation;
+        operation.hedgedRequest = hedgedRequest;
+        
+        [self am_scheduleHedgeForRequest:hedgedRequest policy:hedgingPolicy afterDelay:hedgeDelay];
+    }
+    
+    // Batches add all their operations to the queue at once.
+    if (pendingOperations)
+        [pendingOperations addObject:operation];
+    else
+        [[self am_queueWithIdentifier:queueIdentifier] addOperation:operation];
     
     return operationKey;
 }
 
-- (AMAsyncConnectionOperation*)cancelRequestWithKey:(NSInteger)key
+- (NSInteger)prefetchRequest:(NSURLRequest*)request
+{
+    return [self performRequest:request
+                       priority:AMConnectionPriorityVeryLow
+                        inQueue:AMConnectionManagerPrefetchQueueIdentifier
+                 progressStatus:NULL
+                completionBlock:NULL];
+}
+
+- (AMConnectionGroup*)prefetchRequests:(NSArray*)requests
+{
+    return [self performRequests:requests
+                        priority:AMConnectionPriorityVeryLow
+                         inQueue:AMConnectionManagerPrefetchQueueIdentifier
+                 completionBlock:NULL
+                 groupCompletion:NULL];
+}
+
+- (NSInteger)performDownloadRequest:(NSURLRequest*)request
+                          toFileURL:(NSURL*)fileURL
+                           priority:(AMConnectionPriority)priority
+                            inQueue:(NSString*)queueIdentifier
+                     progressStatus:(void (^)(NSDictionary *progressStatus))progressStatusBlock
+                    completionBlock:(void (^)(NSURLResponse* response, NSURL* fileURL, NSError* error, NSInteger key))completion
 {
-    NSOperation *operation = [_operations objectForKey:@(key)];
+    NSInteger operationKey = [self am_nextKey];
     
-    AMAsyncConnectionOperation *copy = [operation copy];
+    void (^connectionCompletion)(NSURLResponse* response, NSData* data, NSError* error) = ^(NSURLResponse* response, NSData* data, NSError* error) {
+        
+        if (!completion)
+            return;
+        
+        [self am_deliverCompletion:^{
+            completion(response, error ? nil : fileURL, error, operationKey);
+        }];
+    };
     
-    [operation cancel];
+    AMAsyncConnectionOperation *operation = [self am_connectionOperationWithRequest:request
+                                                                           priority:priority
+                                                                     progressStatus:progressStatusBlock
+                                                                    completionBlock:connectionCompletion];
+    operation.destinationURL = fileURL;
+    operation.preallocatesDestinationFile = _preallocatesDownloadedFiles;
+    
+    [self am_registerConnectionOperation:operation withKey:operationKey inQueue:queueIdentifier];
     
-    [_operations removeObjectForKey:@(key)];
+    [[self am_queueWithIdentifier:queueIdentifier] addOperation:operation];
     [self am_refreshNetworkActivityIndicatorState];
     
-    return copy;
+    return operationKey;
 }
 
-- (void)cancelAllRequests
+- (NSInteger)performUploadRequest:(NSURLRequest*)request
+                             body:(AMUploadBody*)body
+                         priority:(AMConnectionPriority)priority
+                          inQueue:(NSString*)queueIdentifier
+                   progressStatus:(void (^)(NSDictionary *progressStatus))progressStatusBlock
+                  completionBlock:(void (^)(NSURLResponse* response, NSData* data, NSError* error, NSInteger key))completion
 {
-    [[_operations allValues] makeObjectsPerformSelector:@selector(cancel)];
-    [_operations removeAllObjects];
+    NSInteger operationKey = [self am_nextKey];
+    
+    void (^connectionCompletion)(NSURLResponse* response, NSData* data, NSError* error) = ^(NSURLResponse* response, NSData* data, NSError* error) {
+        
+        if (!completion)
+            return;
+        
+        [self am_deliverCompletion:^{
+            completion(response, data, error, operationKey);
+        }];
+    };
+    
+    NSMutableURLRequest *uploadRequest = [request mutableCopy];
+    uploadRequest.HTTPBodyStream = nil;
+    uploadRequest.HTTPBody = nil;
+    
+    AMAsyncConnectionOperation *operation = [self am_connectionOperationWithRequest:uploadRequest
+                                                                           priority:priority
+                                                                     progressStatus:progressStatusBlock
+                                                                    completionBlock:connectionCompletion];
+    operation.uploadBody = body;
+    
+    [self am_registerConnectionOperation:operation withKey:operationKey inQueue:queueIdentifier];
+    
+    [[self am_queueWithIdentifier:queueIdentifier] addOperation:operation];
     [self am_refreshNetworkActivityIndicatorState];
+    
+    return operationKey;
 }
 
-- (void)changeToPriority:(AMConnectionPriority)priority requestWithKey:(NSInteger)key
+- (AMConnectionGroup*)performRequests:(NSArray*)requests
+                             priority:(AMConnectionPriority)priority
+                              inQueue:(NSString*)queueIdentifier
+                      completionBlock:(void (^)(NSURLResponse* response, NSData* data, NSError* error, NSInteger key))completion
+                      groupCompletion:(void (^)(void))groupCompletion
 {
-    NSOperation *operation = [_operations objectForKey:@(key)];
-    [operation setQueuePriority:(NSOperationQueuePriority)priority];
+    AMConnectionGroup *group = [[AMConnectionGroup alloc] init];
+    group.connectionManager = self;
+    group.completionBlock = groupCompletion;
+    
+    void (^requestCompletion)(NSURLResponse* response, NSData* data, NSError* error, NSInteger key) = ^(NSURLResponse* response, NSData* data, NSError* error, NSInteger key) {
+        
+        if (completion)
+            completion(response, data, error, key);
+        
+        [group am_connectionDidFinishWithKey:key];
+    };
+    
+    NSMutableArray *pendingOperations = [NSMutableArray arrayWithCapacity:requests.count];
+    
+    for (NSURLRequest *request in requests)
+    {
+        // Cached responses may complete before this method returns, so the group tracks the keys from the start.
+        NSInteger key = [self am_performRequest:request
+                                       priority:priority
+                                        inQueue:queueIdentifier
+                                        decoder:nil
+                                 progressStatus:nil
+                                completionBlock:requestCompletion
+                              pendingOperations:pendingOperations];
+        
+        [group am_addPendingConnectionKey:key];
+    }
+    
+    [[self am_queueWithIdentifier:queueIdentifier] addOperations:pendingOperations waitUntilFinished:NO];
+    [self am_refreshNetworkActivityIndicatorState];
+    
+    [group am_seal];
+    
+    return group;
 }
 
-- (void)addBackgroundExecutionQueueIdentifier:(NSString*)queueIdentifier
+- (AMAsyncConnectionOperation*)cancelRequestWithKey:(NSInteger)key
 {
-    _backgroundExecutionQueueIdentifiers = [_backgroundExecutionQueueIdentifiers setByAddingObject:queueIdentifier];
-}
-
+    AMRequestFlightWaiter *waiter = [_coalescer removeWaiterWithKey:key];
+    
+    if (waiter)
+        return [self am_detachFlightWaiter:waiter];
+    
+    NSOperation *operation = [_operations removeOperationForKey:key];
+    
+    // Cancel before copying, so the copy gets the final state of the received data and can resume from it.
+    [operation cancel];
+    
+    AMAsyncConnectionOperation *copy = [operation copy];
+    
+    [self am_refreshNetworkActivityIndicatorState];
+    
+    return copy;
+}
+
+- (NSArray*)cancelRequestsWithKeys:(NSIndexSet*)keys
+{
+    NSMutableArray *operations = [NSMutableArray arrayWithCapacity:keys.count];
+    NSMutableArray *copies = [NSMutableArray arrayWithCapacity:keys.count];
+    
+    [keys enumerateIndexesUsingBlock:^(NSUInteger key, BOOL *stop) {
+        
+        AMRequestFlightWaiter *waiter = [_coalescer removeWaiterWithKey:key];
+        
+        if (waiter)
+        {
+            AMAsyncConnectionOperation *copy = [self am_detachFlightWaiter:waiter];
+            if (copy)
+                [copies addObject:copy];
+            return;
+        }
+        
+        NSOperation *operation = [_operations removeOperationForKey:key];
+        if (operation)
+            [operations addObject:operation];
+    }];
+    
+    // Cancel all of them before copying, so the copies get the final state of the received data.
+    [operations makeObjectsPerformSelector:@selector(cancel)];
+    
+    for (AMAsyncConnectionOperation *operation in operations)
+        [copies addObject:[operation copy]];
+    
+    [self am_refreshNetworkActivityIndicatorState];
+    
+    return copies;
+}
+
+- (void)resumeConnectionOperations:(NSArray*)operations
+{
+    NSMutableDictionary *operationsByQueue = [NSMutableDictionary dictionary];
+    
+    for (AMAsyncConnectionOperation *operation in operations)
+    {
+        NSString *queueIdentifier = operation.queueIdentifier ?: AMConnectionManagerDefaultQueueIdentifier;
+        NSInteger key = operation.connectionManagerKey ? [operation.connectionManagerKey integerValue] : [self am_nextKey];
+        
+        [self am_registerConnectionOperation:operation withKey:key inQueue:queueIdentifier];
+        
+        NSMutableArray *queueOperations = [operationsByQueue objectForKey:queueIdentifier];
+        if (!queueOperations)
+        {
+            queueOperations = [NSMutableArray array];
+            [operationsByQueue setObject:queueOperations forKey:queueIdentifier];
+        }
+        
+        [queueOperations addObject:operation];
+    }
+    
+    [operationsByQueue enumerateKeysAndObjectsUsingBlock:^(NSString *queueIdentifier, NSArray *queueOperations, BOOL *stop) {
+        [[self am_queueWithIdentifier:queueIdentifier] addOperations:queueOperations waitUntilFinished:NO];
+    }];
+    
+    [self am_refreshNetworkActivityIndicatorState];
+}
+
+- (void)changeToPriority:(AMConnectionPriority)priority requestsWithKeys:(NSIndexSet*)keys
+{
+    [keys enumerateIndexesUsingBlock:^(NSUInteger key, BOOL *stop) {
+        [self changeToPriority:priority requestWithKey:key];
+    }];
+}
+
+- (void)cancelAllRequests
+{
+    [_coalescer removeAllFlights];
+    [[_operations removeAllOperations] makeObjectsPerformSelector:@selector(cancel)];
+    [self am_refreshNetworkActivityIndicatorState];
+}
+
+- (void)changeToPriority:(AMConnectionPriority)priority requestWithKey:(NSInteger)key
+{
+    AMRequestFlight *flight = [_coalescer flightForKey:key];
+    
+    NSOperation *operation = [_operations operationForKey:flight ? flight.operationKey : key];
+    
+    // An operation shared by several callers is never demoted by one of them.
+    if (flight.waiterCount > 1 && (NSOperationQueuePriority)priority < operation.queuePriority)
+        return;
+    
+    [operation setQueuePriority:(NSOperationQueuePriority)priority];
+}
+
+- (void)addBackgroundExecutionQueueIdentifier:(NSString*)queueIdentifier
+{
+    _backgroundExecutionQueueIdentifiers = [_backgroundExecutionQueueIdentifiers setByAddingObject:queueIdentifier];
+    [[self am_queueStateForIdentifier:queueIdentifier] setExecutesInBackground:YES];
+}
+
 - (void)removeBackgroundExecutionQueueIdentifier:(NSString*)queueIdentifier
 {
     NSMutableSet *set = [_backgroundExecutionQueueIdentifiers mutableCopy];
     [set removeObject:queueIdentifier];
     _backgroundExecutionQueueIdentifiers = [set copy];
+    [[self am_queueStateForIdentifier:queueIdentifier] setExecutesInBackground:NO];
 }
 
 - (NSURLCredential*)credentialForHost:(NSString*)host
@@ -366,25 +963,491 @@ NSString * const AMConnectionManagerDefaultQueueIdentifier = @"AMConnectionManag
 
 #pragma mark Private Methods
 
+- (AMAsyncConnectionOperation*)am_connectionOperationWithRequest:(NSURLRequest*)request
+                                                       priority:(AMConnectionPriority)priority
+                                                 progressStatus:(void (^)(NSDictionary *progressStatus))progressStatusBlock
+                                                completionBlock:(void (^)(NSURLResponse* response, NSData* data, NSError* error))completion
+{
+    AMAsyncConnectionOperation *operation = [[AMAsyncConnectionOperation alloc] initWithRequest:request completionBlock:completion];
+    operation.serverTurstAuthentication = [_trustedHosts containsObject:request.URL.host];
+    operation.credential = [_credentials valueForKey:request.URL.host];
+    
+    operation.progressStatusBlock = progressStatusBlock;
+    operation.progressInterval = _progressInterval;
+    operation.progressQueue = _progressQueue;
+    operation.transport = _transport;
+    operation.compressesRequestBody = _compressesRequestBodies;
+    operation.queuePriority = (NSOperationQueuePriority)priority;
+    
+    return operation;
+}
+
+- (AMAsyncConnectionOperation*)am_detachFlightWaiter:(AMRequestFlightWaiter*)waiter
+{
+    AMRequestFlight *flight = waiter.flight;
+    AMAsyncConnectionOperation *operation = [_operations operationForKey:flight.operationKey];
+    
+    // The shared operation is only cancelled when the last waiter leaves.
+    if (flight.waiterCount == 0 && [_operations removeOperation:operation forKey:flight.operationKey])
+    {
+        [operation cancel];
+        [self am_refreshNetworkActivityIndicatorState];
+    }
+    
+    if (!operation)
+        return nil;
+    
+    AMAsyncConnectionOperation *copy = [[AMAsyncConnectionOperation alloc] initWithRequest:operation.request completionBlock:waiter.completion];
+    copy.progressStatusBlock = waiter.progressStatusBlock;
+    copy.connectionManagerKey = @(waiter.key);
+    copy.queueIdentifier = operation.queueIdentifier;
+    copy.queuePriority = operation.queuePriority;
+    
+    return copy;
+}
+
+- (AMCachedResponse*)am_cachedResponseForRequest:(NSURLRequest*)request
+{
+    if (!_responseCache)
+        return nil;
+    
+    if (request.HTTPMethod.length > 0 && ![request.HTTPMethod isEqualToString:@"GET"])
+        return nil;
+    
+    NSURLRequestCachePolicy cachePolicy = request.cachePolicy;
+    
+    if (cachePolicy == NSURLRequestReloadIgnoringLocalCacheData || cachePolicy == NSURLRequestReloadIgnoringLocalAndRemoteCacheData)
+        return nil;
+    
+    return [_responseCache cachedResponseForRequest:request];
+}
+
+- (void)am_registerConnectionOperation:(AMAsyncConnectionOperation*)operation withKey:(NSInteger)key inQueue:(NSString*)queueIdentifier
+{
+    operation.connectionManagerKey = @(key);
+    [self am_prepareConnectionOperation:operation forQueue:queueIdentifier];
+    
+    [_operations setOperation:operation forKey:key];
+}
+
+- (void)am_prepareConnectionOperation:(AMAsyncConnectionOperation*)operation forQueue:(NSString*)queueIdentifier
+{
+    if (queueIdentifier == nil)
+        queueIdentifier = AMConnectionManagerDefaultQueueIdentifier;
+    
+    operation.connectionManager = self;
+    operation.queueIdentifier = queueIdentifier;
+    operation.queueRetryPolicy = [self retryPolicyForQueue:queueIdentifier];
+    operation.sharedRetryBudget = _retryBudget;
+    operation.bandwidthBucket = [self am_tokenBucketForQueue:queueIdentifier inDictionary:_bandwidthBuckets];
+    operation.requestRateBucket = [self am_tokenBucketForQueue:queueIdentifier inDictionary:_requestRateBuckets];
+    operation.memoryBudget = _memoryBudget;
+    operation.bufferPool = _bufferPool;
+    
+    AMConnectionTimestamps timestamps = {0};
+    timestamps.enqueueTime = AMConnectionMetricsCurrentTime();
+    operation.timestamps = timestamps;
+    
+    NSTimeInterval timeout = [self requestTimeoutForQueue:queueIdentifier];
+    
+    if (!operation.deadline && timeout > 0)
+        operation.deadline = [NSDate dateWithTimeIntervalSinceNow:timeout];
+    
+    if (operation.deadline)
+    {
+        // The deadline covers the time in the queue too, so it can't wait for the operation to start.
+        __weak AMAsyncConnectionOperation *weakOperation = operation;
+        NSTimeInterval remaining = MAX([operation.deadline timeIntervalSinceNow], 0);
+        
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(remaining * NSEC_PER_SEC)), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            [weakOperation am_deadlineExceeded];
+        });
+    }
+}
+
+- (void)am_scheduleHedgeForRequest:(AMHedgedRequest*)hedgedRequest policy:(AMHedgingPolicy*)policy afterDelay:(NSTimeInterval)delay
+{
+    // Finished requests are released by their operations, and then there is nothing to hedge.
+    __weak AMHedgedRequest *weakHedgedRequest = hedgedRequest;
+    
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        [self am_hedgeRequest:weakHedgedRequest policy:policy delay:delay];
+    });
+}
+
+- (void)am_hedgeRequest:(AMHedgedRequest*)hedgedRequest policy:(AMHedgingPolicy*)policy delay:(NSTimeInterval)delay
+{
+    AMAsyncConnectionOperation *primaryOperation = hedgedRequest.primaryOperation;
+    
+    if (!primaryOperation || primaryOperation.isCancelled || primaryOperation.isFinished || primaryOperation.response)
+        return;
+    
+    // The delay counts from the start of the connection. A primary still waiting in its queue would only be queued again by the hedge.
+    if (primaryOperation.timestamps.startTime == 0)
+    {
+        [self am_scheduleHedgeForRequest:hedgedRequest policy:policy afterDelay:delay];
+        return;
+    }
+    
+    if (![policy consumeHedgeToken])
+        return;
+    
+    AMAsyncConnectionOperation *hedgeOperation = [self am_connectionOperationWithRequest:primaryOperation.request
+                                                                                priority:(AMConnectionPriority)primaryOperation.queuePriority
+                                                                          progressStatus:nil
+                                                                         completionBlock:[hedgedRequest hedgeCompletion]];
+    
+    if (![hedgedRequest beginHedgeWithOperation:hedgeOperation])
+        return;
+    
+    // The hedge has no key of its own: the key of the request belongs to the primary operation, and cancelling it cancels the hedge.
+    hedgeOperation.hedgedRequest = hedgedRequest;
+    hedgeOperation.deadline = primaryOperation.deadline;
+    [self am_prepareConnectionOperation:hedgeOperation forQueue:primaryOperation.queueIdentifier];
+    
+    [_metrics recordHedgeInQueue:primaryOperation.queueIdentifier host:primaryOperation.request.URL.host];
+    
+    [[self am_queueWithIdentifier:primaryOperation.queueIdentifier] addOperation:hedgeOperation];
+}
+
+- (void)am_promotePrefetchOperationWithKey:(NSInteger)key toPriority:(AMConnectionPriority)priority inQueue:(NSString*)queueIdentifier
+{
+    // Serialized with the updates of the prefetch state, which run in the main queue too.
+    dispatch_async(dispatch_get_main_queue(), ^{
+        
+        AMConnectionQueueState *prefetchState = [self am_queueStateForIdentifier:AMConnectionManagerPrefetchQueueIdentifier];
+        AMAsyncConnectionOperation *operation = [prefetchState removePausedOperationPassingTest:^BOOL(AMAsyncConnectionOperation *pausedOperation) {
+            return [pausedOperation.connectionManagerKey integerValue] == key;
+        }];
+        
+        if (!operation)
+        {
+            operation = [_operations operationForKey:key];
+            
+            if (![operation.queueIdentifier isEqualToString:AMConnectionManagerPrefetchQueueIdentifier] || operation.isCancelled || operation.isFinished)
+                return;
+            
+            // A running prefetch request only needs a higher priority to not be preempted.
+            if (operation.isExecuting)
+            {
+                if ((NSOperationQueuePriority)priority > operation.queuePriority)
+                    [operation setQueuePriority:(NSOperationQueuePriority)priority];
+                return;
+            }
+        }
+        
+        // Queued and paused prefetch requests are moved to the queue of the request waiting for them. The copy keeps the key, the completion and the received data.
+        AMAsyncConnectionOperation *newOperation = [operation copy];
+        newOperation.queuePriority = (NSOperationQueuePriority)priority;
+        
+        [operation cancel];
+        
+        [self am_registerConnectionOperation:newOperation withKey:key inQueue:queueIdentifier];
+        [[self am_queueWithIdentifier:queueIdentifier] addOperation:newOperation];
+    });
+}
+
+- (void)am_setNeedsUpdatePrefetchState
+{
+    if (!atomic_load(&_prefetchesRequests))
+        return;
+    
+    // A single update waits in the main queue: it reads the state of the queues when it runs.
+    if (atomic_exchange(&_prefetchUpdatePending, true))
+        return;
+    
+    dispatch_async(dispatch_get_main_queue(), ^{
+        atomic_store(&_prefetchUpdatePending, false);
+        [self am_updatePrefetchState];
+    });
+}
+
+- (void)am_updatePrefetchState
+{
+    // Always called from the main queue, so the preemption can't change between the check and the update.
+    AMConnectionQueueState *prefetchState = [self am_queueStateForIdentifier:AMConnectionManagerPrefetchQueueIdentifier];
+    BOOL preempts = [self am_otherQueuesLackCapacityForQueue:prefetchState];
+    
+    if (preempts && !prefetchState.isPreempted)
+    {
+        // Running prefetch requests are paused as in a freeze, except the ones promoted by a request waiting for them.
+        [prefetchState pauseForReason:AMConnectionQueuePauseReasonPreemption operationsPassingTest:^BOOL(AMAsyncConnectionOperation *operation) {
+            return operation.queuePriority <= NSOperationQueuePriorityVeryLow;
+        }];
+    }
+    else if (!preempts && prefetchState.isPreempted)
+    {
+        // A queue frozen by the app, or when going to background, stays frozen.
+        [prefetchState resumeForReason:AMConnectionQueuePauseReasonPreemption performingPausedOperations:^(NSArray *pausedOperations) {
+            [self am_performPausedOperations:pausedOperations inQueue:prefetchState];
+        }];
+    }
+}
+
+- (BOOL)am_otherQueuesLackCapacityForQueue:(AMConnectionQueueState*)preemptedState
+{
+    // Connections waiting for a global or per host connection slot would get the slots of the prefetch requests.
+    if ([_scheduler hasWaitingTicketWithPriorityHigherThan:NSOperationQueuePriorityVeryLow])
+        return YES;
+    
+    for (AMConnectionQueueState *state in [self am_allQueueStates])
+    {
+        if (state == preemptedState || state.queue.isSuspended)
+            continue;
+        
+        NSInteger maxCount = state.queue.maxConcurrentOperationCount;
+        NSUInteger runningCount = state.runningOperationCount;
+        
+        // A queue at its limit with more operations waiting has no spare capacity.
+        if (maxCount != NSOperationQueueDefaultMaxConcurrentOperationCount && (NSInteger)runningCount >= maxCount && state.queue.operationCount > runningCount)
+            return YES;
+        
+        // Urgent requests get all the bandwidth. Only the running operations are visited, not the whole queue.
+        if (runningCount > 0)
+        {
+            for (NSOperation *operation in [state runningOperations])
+            {
+                if (operation.queuePriority >= NSOperationQueuePriorityHigh && !operation.isCancelled)
+                    return YES;
+            }
+        }
+    }
+    
+    return NO;
+}
+
+- (void)am_performPausedOperations:(NSArray*)pausedOperations inQueue:(AMConnectionQueueState*)state
+{
+    // The copies keep the key, the completion and the received data of the paused operations.
+    for (AMAsyncConnectionOperation *operation in pausedOperations)
+    {
+        AMAsyncConnectionOperation *newOperation = [operation copy];
+        [self am_prepareConnectionOperation:newOperation forQueue:state.identifier];
+        
+        [_operations setOperation:newOperation forKey:[newOperation.connectionManagerKey integerValue]];
+        
+        [state.queue addOperation:newOperation];
+    }
+    
+    [self am_refreshNetworkActivityIndicatorState];
+}
+
+- (AMCircuitBreaker*)am_circuitBreakerForHost:(NSString*)host create:(BOOL)create
+{
+    AMCircuitBreakerPolicy *policy = _circuitBreakerPolicy;
+    
+    if (!policy)
+        return nil;
+    
+    host = [host lowercaseString] ?: @"";
+    
+    @synchronized(_circuitBreakers)
+    {
+        AMCircuitBreaker *circuitBreaker = [_circuitBreakers objectForKey:host];
+        
+        if (!circuitBreaker && create)
+        {
+            circuitBreaker = [[AMCircuitBreaker alloc] initWithPolicy:policy];
+            
+            __weak AMConnectionManager *weakSelf = self;
+            circuitBreaker.stateChangeBlock = ^(AMCircuitBreakerState state) {
+                [weakSelf am_circuitBreakerForHost:host didChangeState:state];
+            };
+            
+            [_circuitBreakers setObject:circuitBreaker forKey:host];
+        }
+        
+        return circuitBreaker;
+    }
+}
+
+- (void)am_circuitBreakerForHost:(NSString*)host didChangeState:(AMCircuitBreakerState)state
+{
+    if ([_delegate respondsToSelector:@selector(connectionManager:circuitBreakerForHost:didChangeState:)])
+        [_delegate connectionManager:self circuitBreakerForHost:host didChangeState:state];
+    
+    [[NSNotificationCenter defaultCenter] postNotificationName:AMConnectionManagerCircuitBreakerDidChangeStateNotification
+                                                        object:self
+                                                      userInfo:@{AMConnectionManagerHostKey : host,
+                                                                 AMConnectionManagerCircuitBreakerStateKey : @(state)}];
+}
+
+- (NSError*)am_circuitOpenErrorForRequest:(NSURLRequest*)request
+{
+    NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithObject:@"The host is not available, the request has not been performed." forKey:NSLocalizedDescriptionKey];
+    [userInfo setValue:request.URL forKey:NSURLErrorFailingURLErrorKey];
+    
+    return [NSError errorWithDomain:AMConnectionManagerErrorDomain code:AMConnectionManagerErrorCircuitOpen userInfo:userInfo];
+}
+
+- (void)am_recordCircuitBreakerResultForConnectionOperation:(AMAsyncConnectionOperation*)op
+{
+    AMCircuitBreaker *circuitBreaker = [self am_circuitBreakerForHost:op.request.URL.host create:NO];
+    NSError *error = op.error;
+    
+    if (!circuitBreaker)
+        return;
+    
+    // Cancelled operations and operations dropped by the manager say nothing about the host.
+    if ((op.isCancelled && !error) || [error.domain isEqualToString:AMConnectionManagerErrorDomain])
+    {
+        if (op.circuitBreakerProbe)
+            [circuitBreaker cancelProbe];
+        return;
+    }
+    
+    BOOL failed = [circuitBreaker.policy isFailureWithResponse:op.response error:error];
+    [circuitBreaker recordResultSucceeded:!failed probe:op.circuitBreakerProbe];
+}
+
+- (AMTokenBucket*)am_tokenBucketForQueue:(NSString*)queueIdentifier inDictionary:(NSMutableDictionary*)dictionary
+{
+    if (queueIdentifier == nil)
+        queueIdentifier = AMConnectionManagerDefaultQueueIdentifier;
+    
+    @synchronized(dictionary)
+    {
+        AMTokenBucket *bucket = [dictionary valueForKey:queueIdentifier];
+        
+        // Every queue has its buckets, so the limits can be changed while its operations are running. A refill rate of 0 means no limit.
+        if (!bucket)
+        {
+            bucket = [[AMTokenBucket alloc] initWithCapacity:0.0 refillRate:0.0];
+            [dictionary setValue:bucket forKey:queueIdentifier];
+        }
+        
+        return bucket;
+    }
+}
+
+- (void)am_recordMetricsForConnectionOperation:(AMAsyncConnectionOperation*)op
+{
+    AMConnectionOutcome outcome = AMConnectionOutcomeSucceeded;
+    
+    // Operations dropped because of their deadline are cancelled, but count as failed.
+    if (op.error)
+        outcome = AMConnectionOutcomeFailed;
+    else if (op.isCancelled)
+        outcome = AMConnectionOutcomeCancelled;
+    
+    NSInteger statusCode = [op.response isKindOfClass:[NSHTTPURLResponse class]] ? [(NSHTTPURLResponse*)op.response statusCode] : 0;
+    
+    [_metrics recordConnectionInQueue:op.queueIdentifier
+                                 host:op.request.URL.host
+                           timestamps:op.timestamps
+                        receivedBytes:op.receivedByteCount
+                            sentBytes:op.sentByteCount
+                           statusCode:statusCode
+                              outcome:outcome];
+}
+
+- (void)am_updateConcurrencyLimitOfQueue:(AMConnectionQueueState*)state withConnectionOperation:(AMAsyncConnectionOperation*)op
+{
+    AMConcurrencyLimiter *limiter = state.concurrencyLimiter;
+    NSError *error = op.error;
+    
+    // Cancelled connections say nothing about the load of the server.
+    if (!limiter || (op.isCancelled && !error) || ([error.domain isEqualToString:NSURLErrorDomain] && error.code == NSURLErrorCancelled))
+        return;
+    
+    NSInteger statusCode = [op.response isKindOfClass:[NSHTTPURLResponse class]] ? [(NSHTTPURLResponse*)op.response statusCode] : 0;
+    AMConnectionTimestamps timestamps = op.timestamps;
+    
+    NSTimeInterval latency = timestamps.firstByteTime > timestamps.startTime && timestamps.startTime > 0 ? (timestamps.firstByteTime - timestamps.startTime) / 1e6 : 0;
+    BOOL dropped = error != nil || statusCode == 429 || statusCode == 503;
+    
+    // The finished operation has already left the running operations.
+    if (![limiter recordLatency:latency dropped:dropped inflightCount:state.runningOperationCount + 1])
+        return;
+    
+    NSUInteger limit = limiter.limit;
+    state.queue.maxConcurrentOperationCount = limit;
+    
+    [[NSNotificationCenter defaultCenter] postNotificationName:AMConnectionManagerConcurrencyLimitDidChangeNotification
+                                                        object:self
+                                                      userInfo:@{AMConnectionManagerConnectionsQueueIdentifierKey : state.identifier,
+                                                                 AMConnectionManagerConcurrencyLimitKey : @(limit)}];
+}
+
+- (void)am_decodeData:(NSData*)data
+             response:(NSURLResponse*)response
+              request:(NSURLRequest*)request
+              inQueue:(NSString*)queueIdentifier
+              decoder:(id <AMResponseDecoding>)decoder
+           completion:(void (^)(id object, NSError *error))completion
+{
+    AMConnectionMetrics *metrics = _metrics;
+    
+    [_decodingQueue addOperationWithBlock:^{
+        
+        uint64_t startTime = AMConnectionMetricsCurrentTime();
+        
+        NSError *error = nil;
+        id object = [decoder decodedObjectForResponse:response data:data error:&error];
+        
+        [metrics recordDecodingTime:AMConnectionMetricsCurrentTime() - startTime
+                            inQueue:queueIdentifier ?: AMConnectionManagerDefaultQueueIdentifier
+                               host:request.URL.host];
+        
+        completion(object, object ? nil : error);
+    }];
+}
+
+- (void)am_deliverCompletion:(void (^)(void))block
+{
+    AMCompletionQueue *completionQueue = _targetCompletionQueue;
+    
+    if (!completionQueue && _executeCompletionBlocksOnMainThread)
+        completionQueue = _mainCompletionQueue;
+    
+    if (completionQueue)
+        [completionQueue enqueueBlock:block];
+    else
+        block();
+}
+
 - (NSOperationQueue*)am_queueWithIdentifier:(NSString*)identifier
+{
+    return [self am_queueStateForIdentifier:identifier].queue;
+}
+
+- (AMConnectionQueueState*)am_queueStateForIdentifier:(NSString*)identifier
 {
     if (identifier == nil)
         identifier = AMConnectionManagerDefaultQueueIdentifier;
-
-    NSOperationQueue *queue = [_queues valueForKey:identifier];
     
-    if (!queue)
+    @synchronized(_queueStates)
     {
-        queue = [[NSOperationQueue alloc] init];
-        [_queues setValue:queue forKey:identifier];
+        AMConnectionQueueState *state = [_queueStates objectForKey:identifier];
         
-        [queue addObserver:self
-                forKeyPath:@"operationCount"
-                   options:NSKeyValueObservingOptionNew | NSKeyValueObservingOptionOld
-                   context:nil];
+        if (!state)
+        {
+            state = [[AMConnectionQueueState alloc] initWithIdentifier:identifier];
+            state.executesInBackground = [_backgroundExecutionQueueIdentifiers containsObject:identifier];
+            
+            // Created with the first prefetch request, or when the app configures it.
+            if ([identifier isEqualToString:AMConnectionManagerPrefetchQueueIdentifier])
+                state.queue.maxConcurrentOperationCount = 2;
+            
+            [_queueStates setObject:state forKey:identifier];
+            
+            // The state is the context of the observation, so the observer knows the changed queue without looking for it. Queue states are never removed, so the context stays valid.
+            [state.queue addObserver:self
+                          forKeyPath:@"operationCount"
+                             options:NSKeyValueObservingOptionNew | NSKeyValueObservingOptionOld
+                             context:(__bridge void*)state];
+        }
+        
+        return state;
+    }
+}
+
+- (NSArray*)am_allQueueStates
+{
+    @synchronized(_queueStates)
+    {
+        return [_queueStates allValues];
     }
-    
-    return queue;
 }
 
 - (void)am_refreshNetworkActivityIndicatorState
@@ -392,29 +1455,30 @@ NSString * const AMConnectionManagerDefaultQueueIdentifier = @"AMConnectionManag
     if (!_showsNetworkActivityIndicator)
         return;
     
+#if TARGET_OS_IPHONE
+    // At most one refresh waits in the main queue: the pending one reads the state when it runs, so it covers every change until then.
+    if (atomic_exchange(&_networkActivityIndicatorRefreshPending, true))
+        return;
+    
     dispatch_async(dispatch_get_main_queue(), ^{
         
+        atomic_store(&_networkActivityIndicatorRefreshPending, false);
+        
         BOOL state = _operations.count > 0;
         
         [[UIApplication sharedApplication] setNetworkActivityIndicatorVisible:state];
     });
+#endif
 }
 
 - (NSInteger)am_nextKey
 {
-    NSInteger operationKey;
-    
-    @synchronized(self)
-    {
-        operationKey = _lastKey + 1;
-        _lastKey = operationKey;
-    }
-    
-    return operationKey;
+    return [_operations nextKey];
 }
 
 - (void)am_presentAlertViewForError:(NSError*)error;
 {
+#if TARGET_OS_IPHONE
     if (!_showConnectionErrors)
         return;
         
@@ -434,11 +1498,17 @@ NSString * const AMConnectionManagerDefaultQueueIdentifier = @"AMConnectionManag
                                                   otherButtonTitles:nil];
         [alertView show];
     });
+#endif
 }
 
+#if TARGET_OS_IPHONE
 - (void)am_notificationReceived:(NSNotification*)notification
 {
-    if ([notification.name isEqualToString:UIApplicationDidBecomeActiveNotification])
+    if ([notification.name isEqualToString:UIApplicationDidReceiveMemoryWarningNotification])
+    {
+        [_bufferPool purge];
+    }
+    else if ([notification.name isEqualToString:UIApplicationDidBecomeActiveNotification])
     {
         _isBackroundExecution = NO;
         _queuesNotEmpty = 0;
@@ -449,17 +1519,12 @@ NSString * const AMConnectionManagerDefaultQueueIdentifier = @"AMConnectionManag
         _isBackroundExecution = YES;
         _queuesNotEmpty = 0;
         
-        NSArray *queueIdentifiers = [_queues allKeys];
-        
-        for (NSString *queueIdentifier in queueIdentifiers)
+        for (AMConnectionQueueState *state in [self am_allQueueStates])
         {
-            if (![_backgroundExecutionQueueIdentifiers containsObject:queueIdentifier])
-                [self freezeQueueWithIdentifier:queueIdentifier];
+            if (!state.executesInBackground)
+                [self freezeQueueWithIdentifier:state.identifier];
             else
-            {
-                NSOperationQueue *queue = [_queues valueForKey:queueIdentifier];
-                _queuesNotEmpty += queue.operationCount == 0 ? 0 : 1;
-            }
+                _queuesNotEmpty += state.queue.operationCount == 0 ? 0 : 1;
         }
         
         if (_queuesNotEmpty > 0)
@@ -486,6 +1551,7 @@ NSString * const AMConnectionManagerDefaultQueueIdentifier = @"AMConnectionManag
     [application endBackgroundTask:_bgTask];
     _bgTask = UIBackgroundTaskInvalid;
 }
+#endif
 
 #pragma mark - Protocols
 
@@ -493,59 +1559,52 @@ NSString * const AMConnectionManagerDefaultQueueIdentifier = @"AMConnectionManag
 
 - (void)observeValueForKeyPath:(NSString *)keyPath ofObject:(id)object change:(NSDictionary *)change context:(void *)context
 {
-    if ([keyPath isEqualToString:@"operationCount"])
+    if (context != NULL && [keyPath isEqualToString:@"operationCount"])
     {
-        NSArray *keys = [_queues allKeys];
+        AMConnectionQueueState *state = (__bridge AMConnectionQueueState*)context;
         
-        NSInteger oldOperationCount = [[change valueForKey:NSKeyValueChangeOldKey] integerValue];
-        NSInteger newOperationCount = [[change valueForKey:NSKeyValueChangeNewKey] integerValue];
+        NSInteger oldOperationCount = [[change objectForKey:NSKeyValueChangeOldKey] integerValue];
+        NSInteger newOperationCount = [[change objectForKey:NSKeyValueChangeNewKey] integerValue];
+        
+        // Whether the other queues have spare capacity changes with their number of operations.
+        [self am_setNeedsUpdatePrefetchState];
         
         if (newOperationCount == 0)
         {
-            for (NSString *key in keys)
+            [[NSNotificationCenter defaultCenter] postNotificationName:AMConnectionManagerConnectionsDidFinishNotification
+                                                                object:self
+                                                              userInfo:@{AMConnectionManagerConnectionsQueueIdentifierKey : state.identifier}];
+            
+            if (state.executesInBackground && _isBackroundExecution)
             {
-                NSOperationQueue *queue = [_queues valueForKey:key];
-                if (object == queue)
+                _queuesNotEmpty--;
+                
+#if TARGET_OS_IPHONE
+                if (_queuesNotEmpty == 0)
                 {
-                    [[NSNotificationCenter defaultCenter] postNotificationName:AMConnectionManagerConnectionsDidFinishNotification
-                                                                        object:self
-                                                                      userInfo:@{AMConnectionManagerConnectionsQueueIdentifierKey : key}];
-                    
-                    if ([_backgroundExecutionQueueIdentifiers containsObject:key] && _isBackroundExecution)
-                    {
-                        _queuesNotEmpty--;
-                        
-                        if (_queuesNotEmpty == 0)
-                        {
-                            // By executing this method at the end of the run loop we give a chance to the app to add new requests and cancel the background execution cancelation.
-                            [self performSelector:@selector(am_stopBackgroundTask) withObject:nil afterDelay:0.0];
-                        }
-                    }
+                    // By executing this method at the end of the run loop we give a chance to the app to add new requests and cancel the background execution cancelation.
+                    [self performSelector:@selector(am_stopBackgroundTask) withObject:nil afterDelay:0.0];
                 }
+#endif
             }
         }
         else if (newOperationCount > 0 && oldOperationCount == 0)
         {
-            for (NSString *key in keys)
-            {
-                NSOperationQueue *queue = [_queues valueForKey:key];
-                if (object == queue)
-                {
-                    [[NSNotificationCenter defaultCenter] postNotificationName:AMConnectionManagerConnectionsDidStartNotification
-                                                                        object:self
-                                                                      userInfo:@{AMConnectionManagerConnectionsQueueIdentifierKey : key}];
-                }
-            }
+            [[NSNotificationCenter defaultCenter] postNotificationName:AMConnectionManagerConnectionsDidStartNotification
+                                                                object:self
+                                                              userInfo:@{AMConnectionManagerConnectionsQueueIdentifierKey : state.identifier}];
         }
     }
 }
 
+#if TARGET_OS_IPHONE
 #pragma mark UIAlertViewDelegate
 
 - (void)alertView:(UIAlertView *)alertView didDismissWithButtonIndex:(NSInteger)buttonIndex
 {
     _isShowingAlert = NO;
 }
+#endif
 
 @end
 
@@ -566,4 +1625,68 @@ NSString * const AMConnectionManagerDefaultQueueIdentifier = @"AMConnectionManag
         [_delegate connectionManager:self authenticationDidFailForConnectionOperation:op authenticationChallange:challange];
 }
 
+- (NSError*)am_admissionErrorForConnectionOperation:(AMAsyncConnectionOperation*)op
+{
+    AMCircuitBreaker *circuitBreaker = [self am_circuitBreakerForHost:op.request.URL.host create:YES];
+    BOOL probe = NO;
+    
+    if (!circuitBreaker || [circuitBreaker admitRequestAsProbe:&probe])
+    {
+        op.circuitBreakerProbe = probe;
+        return nil;
+    }
+    
+    return [self am_circuitOpenErrorForRequest:op.request];
+}
+
+- (void)am_connectionOperationDidStart:(AMAsyncConnectionOperation*)op
+{
+    [[self am_queueStateForIdentifier:op.queueIdentifier] operationDidStart:op];
+    
+    // A running request with a high priority preempts the prefetch requests.
+    if (op.queuePriority >= NSOperationQueuePriorityHigh)
+        [self am_setNeedsUpdatePrefetchState];
+}
+
+- (BOOL)am_connectionOperationCanStartTransfer:(AMAsyncConnectionOperation*)op
+{
+    __weak AMAsyncConnectionOperation *weakOperation = op;
+    
+    AMHostSchedulerTicket *ticket = [[AMHostSchedulerTicket alloc] initWithHost:op.request.URL.host priority:op.queuePriority grantBlock:^{
+        [weakOperation am_startTransfer];
+    }];
+    
+    ticket.deadline = op.deadline ? [op.deadline timeIntervalSinceReferenceDate] : 0;
+    op.schedulerTicket = ticket;
+    
+    BOOL granted = [_scheduler acquireSlotWithTicket:ticket];
+    
+    // A connection waiting for a slot preempts the prefetch requests.
+    if (!granted)
+        [self am_setNeedsUpdatePrefetchState];
+    
+    return granted;
+}
+
+- (void)am_connectionOperationDidFinish:(AMAsyncConnectionOperation*)op
+{
+    [_scheduler releaseSlotWithTicket:op.schedulerTicket];
+    
+    AMConnectionQueueState *state = [self am_queueStateForIdentifier:op.queueIdentifier];
+    [state operationDidFinish:op];
+    
+    [self am_recordMetricsForConnectionOperation:op];
+    [self am_updateConcurrencyLimitOfQueue:state withConnectionOperation:op];
+    [self am_recordCircuitBreakerResultForConnectionOperation:op];
+    
+    NSNumber *key = op.connectionManagerKey;
+    
+    if (!key)
+        return;
+    
+    // Only remove the entry if it still belongs to this operation: a copy may have been registered with the same key.
+    if ([_operations removeOperation:op forKey:[key integerValue]])
+        [self am_refreshNetworkActivityIndicatorState];
+}
+
 @end
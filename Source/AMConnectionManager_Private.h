@@ -43,4 +43,30 @@
  */
 - (void)am_connectionOperation:(AMAsyncConnectionOperation*)op authenticationDidFailWithAuthenticationChallenge:(NSURLAuthenticationChallenge*)challange;
 
+/*!
+ * When a connection operation starts executing notifies the connection manager through this method.
+ * @param op The connection operation.
+ */
+- (void)am_connectionOperationDidStart:(AMAsyncConnectionOperation*)op;
+
+/*!
+ * Connection operations call this method when they are dequeued, before getting a network thread.
+ * @param op The connection operation.
+ * @return nil if the operation can be performed, or the error to fail it with.
+ */
+- (NSError*)am_admissionErrorForConnectionOperation:(AMAsyncConnectionOperation*)op;
+
+/*!
+ * Connection operations call this method before starting the transfer, in order to respect the global and per host connection limits.
+ * @param op The connection operation.
+ * @return YES if the operation can start the transfer now. Otherwise, the connection manager calls -am_startTransfer on the operation when a connection slot is available.
+ */
+- (BOOL)am_connectionOperationCanStartTransfer:(AMAsyncConnectionOperation*)op;
+
+/*!
+ * When a connection operation finishes (successfully, with errors or cancelled) notifies the connection manager through this method.
+ * @param op The connection operation.
+ */
+- (void)am_connectionOperationDidFinish:(AMAsyncConnectionOperation*)op;
+
 @end
@@ -0,0 +1,249 @@
+//
+//  AMConnectionMetrics.h
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import <Foundation/Foundation.h>
+
+#import "AMLatencyHistogram.h"
+
+/*!
+ * How a connection operation has finished.
+ */
+typedef NS_ENUM(NSInteger, AMConnectionOutcome)
+{
+    AMConnectionOutcomeSucceeded,
+    AMConnectionOutcomeFailed,
+    AMConnectionOutcomeCancelled
+};
+
+/*!
+ * The moments of the life of a connection operation, in microseconds of AMConnectionMetricsCurrentTime(). Zero if the moment has not been reached.
+ */
+typedef struct
+{
+    uint64_t enqueueTime;
+    uint64_t startTime;
+    uint64_t firstByteTime;
+    uint64_t lastByteTime;
+    uint64_t completionTime;
+} AMConnectionTimestamps;
+
+/*!
+ * Returns the current time of a monotonic clock, in microseconds.
+ */
+extern uint64_t AMConnectionMetricsCurrentTime(void);
+
+/*!
+ * Immutable copy of the metrics of a queue or a host.
+ */
+@interface AMConnectionMetricsSnapshot : NSObject
+
+/*!
+ * The number of finished connections.
+ */
+@property (nonatomic, assign, readonly) unsigned long long connectionCount;
+
+/*!
+ * The number of connections that have finished receiving a response.
+ */
+@property (nonatomic, assign, readonly) unsigned long long succeededCount;
+
+/*!
+ * The number of connections that have failed with an error.
+ */
+@property (nonatomic, assign, readonly) unsigned long long failedCount;
+
+/*!
+ * The number of cancelled connections.
+ */
+@property (nonatomic, assign, readonly) unsigned long long cancelledCount;
+
+/*!
+ * The number of succeeded connections with an HTTP status code of 400 or greater.
+ */
+@property (nonatomic, assign, readonly) unsigned long long HTTPErrorCount;
+
+/*!
+ * The number of hedges started for slow requests.
+ */
+@property (nonatomic, assign, readonly) unsigned long long hedgeCount;
+
+/*!
+ * The number of hedges that have succeeded before the connection they hedged.
+ */
+@property (nonatomic, assign, readonly) unsigned long long hedgeWinCount;
+
+/*!
+ * The number of bytes received.
+ */
+@property (nonatomic, assign, readonly) unsigned long long receivedBytes;
+
+/*!
+ * The number of bytes sent.
+ */
+@property (nonatomic, assign, readonly) unsigned long long sentBytes;
+
+/*!
+ * The time since the metrics started to be collected (or since the last reset).
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval interval;
+
+/*!
+ * The average number of bytes received per second over the `interval`.
+ */
+@property (nonatomic, assign, readonly) double receivedBytesPerSecond;
+
+/*!
+ * The average number of bytes sent per second over the `interval`.
+ */
+@property (nonatomic, assign, readonly) double sentBytesPerSecond;
+
+/*!
+ * Time from the enqueue of the operation to the start of the connection, including the time waiting for a connection slot.
+ */
+@property (nonatomic, strong, readonly) AMLatencyHistogramSnapshot *queueWaitTime;
+
+/*!
+ * Time from the start of the connection to the reception of the response headers.
+ */
+@property (nonatomic, strong, readonly) AMLatencyHistogramSnapshot *timeToFirstByte;
+
+/*!
+ * Time from the reception of the response headers to the reception of the last byte.
+ */
+@property (nonatomic, strong, readonly) AMLatencyHistogramSnapshot *transferTime;
+
+/*!
+ * Time from the enqueue of the operation to its completion.
+ */
+@property (nonatomic, strong, readonly) AMLatencyHistogramSnapshot *totalTime;
+
+/*!
+ * Time spent decoding the received data of the connections performed with a response decoder.
+ */
+@property (nonatomic, strong, readonly) AMLatencyHistogramSnapshot *decodingTime;
+
+/*!
+ * Returns a dictionary with all the values of the snapshot.
+ * @return A dictionary that can be serialized with NSJSONSerialization and NSPropertyListSerialization.
+ */
+- (NSDictionary*)dictionaryRepresentation;
+
+@end
+
+/*!
+ * Collects the metrics of the connection operations per queue and per host.
+ * @discussion Counters and histograms are updated with atomic operations, without locks. Only the first connection to a new queue or host takes a lock to create its metrics, so recording is cheap enough to keep it always enabled.
+ */
+@interface AMConnectionMetrics : NSObject
+
+/*!
+ * If NO, the metrics are not recorded. Default value is YES.
+ */
+@property (assign) BOOL enabled;
+
+/*!
+ * Records the metrics of a finished connection operation.
+ * @param queueIdentifier The identifier of the queue where the operation was performed.
+ * @param host The host of the request.
+ * @param timestamps The timestamps of the operation.
+ * @param receivedBytes The number of bytes received.
+ * @param sentBytes The number of bytes sent.
+ * @param statusCode The HTTP status code of the response or zero.
+ * @param outcome How the operation finished.
+ */
+- (void)recordConnectionInQueue:(NSString*)queueIdentifier
+                           host:(NSString*)host
+                     timestamps:(AMConnectionTimestamps)timestamps
+                  receivedBytes:(unsigned long long)receivedBytes
+                      sentBytes:(unsigned long long)sentBytes
+                     statusCode:(NSInteger)statusCode
+                        outcome:(AMConnectionOutcome)outcome;
+
+/*!
+ * Records the time spent decoding the received data of a connection.
+ * @param microseconds The decoding time in microseconds.
+ * @param queueIdentifier The identifier of the queue where the connection was performed.
+ * @param host The host of the request.
+ */
+- (void)recordDecodingTime:(uint64_t)microseconds inQueue:(NSString*)queueIdentifier host:(NSString*)host;
+
+/*!
+ * Records a hedge started for a slow request.
+ * @param queueIdentifier The identifier of the queue where the hedge is performed.
+ * @param host The host of the request.
+ * @discussion The hedge connection itself is recorded as any other connection when it finishes.
+ */
+- (void)recordHedgeInQueue:(NSString*)queueIdentifier host:(NSString*)host;
+
+/*!
+ * Records a hedge that has succeeded before the connection it hedged.
+ * @param queueIdentifier The identifier of the queue where the hedge was performed.
+ * @param host The host of the request.
+ */
+- (void)recordHedgeWinInQueue:(NSString*)queueIdentifier host:(NSString*)host;
+
+/*!
+ * The identifiers of the queues with metrics.
+ */
+@property (nonatomic, strong, readonly) NSArray *queueIdentifiers;
+
+/*!
+ * The hosts with metrics.
+ */
+@property (nonatomic, strong, readonly) NSArray *hosts;
+
+/*!
+ * Returns the metrics of a queue.
+ * @param queueIdentifier The queue identifier.
+ * @return The snapshot or nil if no connection has finished in the queue.
+ */
+- (AMConnectionMetricsSnapshot*)snapshotForQueue:(NSString*)queueIdentifier;
+
+/*!
+ * Returns the metrics of a host.
+ * @param host The host.
+ * @return The snapshot or nil if no connection to the host has finished.
+ */
+- (AMConnectionMetricsSnapshot*)snapshotForHost:(NSString*)host;
+
+/*!
+ * Returns a percentile of the time to first byte of a host, without taking a snapshot of its metrics.
+ * @param percentile The percentile, from 0.0 to 100.0.
+ * @param host The host.
+ * @param sampleCount On return, the number of recorded times to first byte of the host. Pass NULL if not needed.
+ * @return The value in seconds, or zero if no connection to the host has received data.
+ */
+- (NSTimeInterval)timeToFirstByteAtPercentile:(double)percentile forHost:(NSString*)host sampleCount:(unsigned long long*)sampleCount;
+
+/*!
+ * Exports all the metrics.
+ * @return A dictionary with the keys "queues" and "hosts", each one containing the dictionary representation of the snapshot of each queue or host. It can be serialized with NSJSONSerialization and NSPropertyListSerialization.
+ */
+- (NSDictionary*)dictionaryRepresentation;
+
+/*!
+ * Removes all the recorded metrics.
+ */
+- (void)reset;
+
+@end
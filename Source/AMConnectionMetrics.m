@@ -0,0 +1,440 @@
+//
+//  AMConnectionMetrics.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMConnectionMetrics.h"
+
+#import <dispatch/dispatch.h>
+#import <pthread.h>
+#import <stdatomic.h>
+#import <time.h>
+
+#if defined(__APPLE__)
+#import <mach/mach_time.h>
+#endif
+
+uint64_t AMConnectionMetricsCurrentTime(void)
+{
+#if defined(__APPLE__)
+    static mach_timebase_info_data_t timebase;
+    static dispatch_once_t pred = 0;
+    dispatch_once(&pred, ^{
+        mach_timebase_info(&timebase);
+    });
+    
+    return (mach_absolute_time() * timebase.numer / timebase.denom) / 1000;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    
+    return (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000;
+#endif
+}
+
+@interface AMConnectionMetricsSnapshot ()
+
+@property (nonatomic, assign, readwrite) unsigned long long connectionCount;
+@property (nonatomic, assign, readwrite) unsigned long long succeededCount;
+@property (nonatomic, assign, readwrite) unsigned long long failedCount;
+@property (nonatomic, assign, readwrite) unsigned long long cancelledCount;
+@property (nonatomic, assign, readwrite) unsigned long long HTTPErrorCount;
+@property (nonatomic, assign, readwrite) unsigned long long hedgeCount;
+@property (nonatomic, assign, readwrite) unsigned long long hedgeWinCount;
+@property (nonatomic, assign, readwrite) unsigned long long receivedBytes;
+@property (nonatomic, assign, readwrite) unsigned long long sentBytes;
+@property (nonatomic, assign, readwrite) NSTimeInterval interval;
+@property (nonatomic, strong, readwrite) AMLatencyHistogramSnapshot *queueWaitTime;
+@property (nonatomic, strong, readwrite) AMLatencyHistogramSnapshot *timeToFirstByte;
+@property (nonatomic, strong, readwrite) AMLatencyHistogramSnapshot *transferTime;
+@property (nonatomic, strong, readwrite) AMLatencyHistogramSnapshot *totalTime;
+@property (nonatomic, strong, readwrite) AMLatencyHistogramSnapshot *decodingTime;
+
+@end
+
+@implementation AMConnectionMetricsSnapshot
+
+#pragma mark Properties
+
+- (double)receivedBytesPerSecond
+{
+    return _interval > 0 ? _receivedBytes / _interval : 0.0;
+}
+
+- (double)sentBytesPerSecond
+{
+    return _interval > 0 ? _sentBytes / _interval : 0.0;
+}
+
+#pragma mark Public Methods
+
+- (NSDictionary*)dictionaryRepresentation
+{
+    return @{@"connectionCount": @(_connectionCount),
+             @"succeededCount": @(_succeededCount),
+             @"failedCount": @(_failedCount),
+             @"cancelledCount": @(_cancelledCount),
+             @"HTTPErrorCount": @(_HTTPErrorCount),
+             @"hedgeCount": @(_hedgeCount),
+             @"hedgeWinCount": @(_hedgeWinCount),
+             @"receivedBytes": @(_receivedBytes),
+             @"sentBytes": @(_sentBytes),
+             @"interval": @(_interval),
+             @"receivedBytesPerSecond": @(self.receivedBytesPerSecond),
+             @"sentBytesPerSecond": @(self.sentBytesPerSecond),
+             @"queueWaitTime": [_queueWaitTime dictionaryRepresentation],
+             @"timeToFirstByte": [_timeToFirstByte dictionaryRepresentation],
+             @"transferTime": [_transferTime dictionaryRepresentation],
+             @"totalTime": [_totalTime dictionaryRepresentation],
+             @"decodingTime": [_decodingTime dictionaryRepresentation],
+             };
+}
+
+- (NSString*)description
+{
+    return [NSString stringWithFormat:@"%@ - %@", [super description], [[self dictionaryRepresentation] description]];
+}
+
+@end
+
+/*!
+ * The metrics of a single queue or host.
+ */
+@interface AMConnectionStatistics : NSObject
+
+- (void)recordTimestamps:(AMConnectionTimestamps)timestamps receivedBytes:(unsigned long long)receivedBytes sentBytes:(unsigned long long)sentBytes statusCode:(NSInteger)statusCode outcome:(AMConnectionOutcome)outcome;
+- (void)recordDecodingMicroseconds:(uint64_t)microseconds;
+- (void)recordHedge;
+- (void)recordHedgeWin;
+- (AMConnectionMetricsSnapshot*)snapshot;
+
+@property (nonatomic, strong, readonly) AMLatencyHistogram *timeToFirstByte;
+
+@end
+
+@implementation AMConnectionStatistics
+{
+    atomic_ullong _connectionCount;
+    atomic_ullong _succeededCount;
+    atomic_ullong _failedCount;
+    atomic_ullong _cancelledCount;
+    atomic_ullong _HTTPErrorCount;
+    atomic_ullong _hedgeCount;
+    atomic_ullong _hedgeWinCount;
+    atomic_ullong _receivedBytes;
+    atomic_ullong _sentBytes;
+    
+    uint64_t _startTime;
+    
+    AMLatencyHistogram *_queueWaitTime;
+    AMLatencyHistogram *_timeToFirstByte;
+    AMLatencyHistogram *_transferTime;
+    AMLatencyHistogram *_totalTime;
+    AMLatencyHistogram *_decodingTime;
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self)
+    {
+        atomic_init(&_connectionCount, 0);
+        atomic_init(&_succeededCount, 0);
+        atomic_init(&_failedCount, 0);
+        atomic_init(&_cancelledCount, 0);
+        atomic_init(&_HTTPErrorCount, 0);
+        atomic_init(&_hedgeCount, 0);
+        atomic_init(&_hedgeWinCount, 0);
+        atomic_init(&_receivedBytes, 0);
+        atomic_init(&_sentBytes, 0);
+        
+        _startTime = AMConnectionMetricsCurrentTime();
+        
+        _queueWaitTime = [[AMLatencyHistogram alloc] init];
+        _timeToFirstByte = [[AMLatencyHistogram alloc] init];
+        _transferTime = [[AMLatencyHistogram alloc] init];
+        _totalTime = [[AMLatencyHistogram alloc] init];
+        _decodingTime = [[AMLatencyHistogram alloc] init];
+    }
+    return self;
+}
+
+- (void)recordTimestamps:(AMConnectionTimestamps)timestamps receivedBytes:(unsigned long long)receivedBytes sentBytes:(unsigned long long)sentBytes statusCode:(NSInteger)statusCode outcome:(AMConnectionOutcome)outcome
+{
+    atomic_fetch_add_explicit(&_connectionCount, 1, memory_order_relaxed);
+    
+    switch (outcome)
+    {
+        case AMConnectionOutcomeSucceeded:
+            atomic_fetch_add_explicit(&_succeededCount, 1, memory_order_relaxed);
+            if (statusCode >= 400)
+                atomic_fetch_add_explicit(&_HTTPErrorCount, 1, memory_order_relaxed);
+            break;
+            
+        case AMConnectionOutcomeFailed:
+            atomic_fetch_add_explicit(&_failedCount, 1, memory_order_relaxed);
+            break;
+            
+        case AMConnectionOutcomeCancelled:
+            atomic_fetch_add_explicit(&_cancelledCount, 1, memory_order_relaxed);
+            break;
+    }
+    
+    atomic_fetch_add_explicit(&_receivedBytes, receivedBytes, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_sentBytes, sentBytes, memory_order_relaxed);
+    
+    // Only the intervals with both moments reached are recorded.
+    if (timestamps.enqueueTime > 0 && timestamps.startTime >= timestamps.enqueueTime)
+        [_queueWaitTime recordMicroseconds:timestamps.startTime - timestamps.enqueueTime];
+    
+    if (timestamps.startTime > 0 && timestamps.firstByteTime >= timestamps.startTime)
+        [_timeToFirstByte recordMicroseconds:timestamps.firstByteTime - timestamps.startTime];
+    
+    if (timestamps.firstByteTime > 0 && timestamps.lastByteTime >= timestamps.firstByteTime)
+        [_transferTime recordMicroseconds:timestamps.lastByteTime - timestamps.firstByteTime];
+    
+    if (timestamps.enqueueTime > 0 && timestamps.completionTime >= timestamps.enqueueTime)
+        [_totalTime recordMicroseconds:timestamps.completionTime - timestamps.enqueueTime];
+}
+
+- (void)recordDecodingMicroseconds:(uint64_t)microseconds
+{
+    [_decodingTime recordMicroseconds:microseconds];
+}
+
+- (void)recordHedge
+{
+    atomic_fetch_add_explicit(&_hedgeCount, 1, memory_order_relaxed);
+}
+
+- (void)recordHedgeWin
+{
+    atomic_fetch_add_explicit(&_hedgeWinCount, 1, memory_order_relaxed);
+}
+
+- (AMConnectionMetricsSnapshot*)snapshot
+{
+    AMConnectionMetricsSnapshot *snapshot = [[AMConnectionMetricsSnapshot alloc] init];
+    
+    snapshot.connectionCount = atomic_load_explicit(&_connectionCount, memory_order_relaxed);
+    snapshot.succeededCount = atomic_load_explicit(&_succeededCount, memory_order_relaxed);
+    snapshot.failedCount = atomic_load_explicit(&_failedCount, memory_order_relaxed);
+    snapshot.cancelledCount = atomic_load_explicit(&_cancelledCount, memory_order_relaxed);
+    snapshot.HTTPErrorCount = atomic_load_explicit(&_HTTPErrorCount, memory_order_relaxed);
+    snapshot.hedgeCount = atomic_load_explicit(&_hedgeCount, memory_order_relaxed);
+    snapshot.hedgeWinCount = atomic_load_explicit(&_hedgeWinCount, memory_order_relaxed);
+    snapshot.receivedBytes = atomic_load_explicit(&_receivedBytes, memory_order_relaxed);
+    snapshot.sentBytes = atomic_load_explicit(&_sentBytes, memory_order_relaxed);
+    snapshot.interval = (AMConnectionMetricsCurrentTime() - _startTime) / 1e6;
+    
+    snapshot.queueWaitTime = [_queueWaitTime snapshot];
+    snapshot.timeToFirstByte = [_timeToFirstByte snapshot];
+    snapshot.transferTime = [_transferTime snapshot];
+    snapshot.totalTime = [_totalTime snapshot];
+    snapshot.decodingTime = [_decodingTime snapshot];
+    
+    return snapshot;
+}
+
+@end
+
+@implementation AMConnectionMetrics
+{
+    pthread_rwlock_t _lock;
+    
+    NSMutableDictionary *_queueStatistics;
+    NSMutableDictionary *_hostStatistics;
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self)
+    {
+        pthread_rwlock_init(&_lock, NULL);
+        
+        _enabled = YES;
+        
+        _queueStatistics = [NSMutableDictionary dictionary];
+        _hostStatistics = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    pthread_rwlock_destroy(&_lock);
+}
+
+#pragma mark Properties
+
+- (NSArray*)queueIdentifiers
+{
+    pthread_rwlock_rdlock(&_lock);
+    NSArray *queueIdentifiers = [_queueStatistics allKeys];
+    pthread_rwlock_unlock(&_lock);
+    
+    return queueIdentifiers;
+}
+
+- (NSArray*)hosts
+{
+    pthread_rwlock_rdlock(&_lock);
+    NSArray *hosts = [_hostStatistics allKeys];
+    pthread_rwlock_unlock(&_lock);
+    
+    return hosts;
+}
+
+#pragma mark Public Methods
+
+- (void)recordConnectionInQueue:(NSString*)queueIdentifier
+                           host:(NSString*)host
+                     timestamps:(AMConnectionTimestamps)timestamps
+                  receivedBytes:(unsigned long long)receivedBytes
+                      sentBytes:(unsigned long long)sentBytes
+                     statusCode:(NSInteger)statusCode
+                        outcome:(AMConnectionOutcome)outcome
+{
+    if (!self.enabled)
+        return;
+    
+    AMConnectionStatistics *queueStatistics = [self _statisticsForKey:queueIdentifier ?: @"" inDictionary:_queueStatistics];
+    AMConnectionStatistics *hostStatistics = [self _statisticsForKey:[host lowercaseString] ?: @"" inDictionary:_hostStatistics];
+    
+    [queueStatistics recordTimestamps:timestamps receivedBytes:receivedBytes sentBytes:sentBytes statusCode:statusCode outcome:outcome];
+    [hostStatistics recordTimestamps:timestamps receivedBytes:receivedBytes sentBytes:sentBytes statusCode:statusCode outcome:outcome];
+}
+
+- (void)recordDecodingTime:(uint64_t)microseconds inQueue:(NSString*)queueIdentifier host:(NSString*)host
+{
+    if (!self.enabled)
+        return;
+    
+    [[self _statisticsForKey:queueIdentifier ?: @"" inDictionary:_queueStatistics] recordDecodingMicroseconds:microseconds];
+    [[self _statisticsForKey:[host lowercaseString] ?: @"" inDictionary:_hostStatistics] recordDecodingMicroseconds:microseconds];
+}
+
+- (void)recordHedgeInQueue:(NSString*)queueIdentifier host:(NSString*)host
+{
+    if (!self.enabled)
+        return;
+    
+    [[self _statisticsForKey:queueIdentifier ?: @"" inDictionary:_queueStatistics] recordHedge];
+    [[self _statisticsForKey:[host lowercaseString] ?: @"" inDictionary:_hostStatistics] recordHedge];
+}
+
+- (void)recordHedgeWinInQueue:(NSString*)queueIdentifier host:(NSString*)host
+{
+    if (!self.enabled)
+        return;
+    
+    [[self _statisticsForKey:queueIdentifier ?: @"" inDictionary:_queueStatistics] recordHedgeWin];
+    [[self _statisticsForKey:[host lowercaseString] ?: @"" inDictionary:_hostStatistics] recordHedgeWin];
+}
+
+- (AMConnectionMetricsSnapshot*)snapshotForQueue:(NSString*)queueIdentifier
+{
+    pthread_rwlock_rdlock(&_lock);
+    AMConnectionStatistics *statistics = [_queueStatistics objectForKey:queueIdentifier ?: @""];
+    pthread_rwlock_unlock(&_lock);
+    
+    return [statistics snapshot];
+}
+
+- (AMConnectionMetricsSnapshot*)snapshotForHost:(NSString*)host
+{
+    pthread_rwlock_rdlock(&_lock);
+    AMConnectionStatistics *statistics = [_hostStatistics objectForKey:[host lowercaseString] ?: @""];
+    pthread_rwlock_unlock(&_lock);
+    
+    return [statistics snapshot];
+}
+
+- (NSTimeInterval)timeToFirstByteAtPercentile:(double)percentile forHost:(NSString*)host sampleCount:(unsigned long long*)sampleCount
+{
+    pthread_rwlock_rdlock(&_lock);
+    AMConnectionStatistics *statistics = [_hostStatistics objectForKey:[host lowercaseString] ?: @""];
+    pthread_rwlock_unlock(&_lock);
+    
+    AMLatencyHistogram *timeToFirstByte = statistics.timeToFirstByte;
+    
+    if (sampleCount)
+        *sampleCount = timeToFirstByte.count;
+    
+    return [timeToFirstByte valueAtPercentile:percentile];
+}
+
+- (NSDictionary*)dictionaryRepresentation
+{
+    pthread_rwlock_rdlock(&_lock);
+    NSDictionary *queueStatistics = [_queueStatistics copy];
+    NSDictionary *hostStatistics = [_hostStatistics copy];
+    pthread_rwlock_unlock(&_lock);
+    
+    NSMutableDictionary *queues = [NSMutableDictionary dictionary];
+    [queueStatistics enumerateKeysAndObjectsUsingBlock:^(NSString *key, AMConnectionStatistics *statistics, BOOL *stop) {
+        [queues setObject:[[statistics snapshot] dictionaryRepresentation] forKey:key];
+    }];
+    
+    NSMutableDictionary *hosts = [NSMutableDictionary dictionary];
+    [hostStatistics enumerateKeysAndObjectsUsingBlock:^(NSString *key, AMConnectionStatistics *statistics, BOOL *stop) {
+        [hosts setObject:[[statistics snapshot] dictionaryRepresentation] forKey:key];
+    }];
+    
+    return @{@"queues": queues, @"hosts": hosts};
+}
+
+- (void)reset
+{
+    pthread_rwlock_wrlock(&_lock);
+    [_queueStatistics removeAllObjects];
+    [_hostStatistics removeAllObjects];
+    pthread_rwlock_unlock(&_lock);
+}
+
+#pragma mark Private Methods
+
+- (AMConnectionStatistics*)_statisticsForKey:(NSString*)key inDictionary:(NSMutableDictionary*)dictionary
+{
+    pthread_rwlock_rdlock(&_lock);
+    AMConnectionStatistics *statistics = [dictionary objectForKey:key];
+    pthread_rwlock_unlock(&_lock);
+    
+    if (statistics)
+        return statistics;
+    
+    pthread_rwlock_wrlock(&_lock);
+    
+    // Another thread might have created it while the lock was released.
+    statistics = [dictionary objectForKey:key];
+    if (!statistics)
+    {
+        statistics = [[AMConnectionStatistics alloc] init];
+        [dictionary setObject:statistics forKey:key];
+    }
+    
+    pthread_rwlock_unlock(&_lock);
+    
+    return statistics;
+}
+
+@end
@@ -0,0 +1,127 @@
+//
+//  AMConnectionQueueState.h
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import <Foundation/Foundation.h>
+
+#import "AMConcurrencyLimiter.h"
+
+/*!
+ * The reasons a queue is paused. A paused queue runs again when no reason is left.
+ */
+typedef NS_OPTIONS(NSUInteger, AMConnectionQueuePauseReason)
+{
+    /** The queue has been frozen with -[AMConnectionManager freezeQueueWithIdentifier:]. */
+    AMConnectionQueuePauseReasonFreeze      = 1 << 0,
+    
+    /** The connection manager preempts the queue in favour of the other queues, as it does with the prefetch queue. */
+    AMConnectionQueuePauseReasonPreemption  = 1 << 1,
+};
+
+/*!
+ * The state of a connection manager queue: the operation queue, its running operations, the operations paused by a freeze or a preemption and whether it executes in background.
+ * @discussion The connection manager keeps one instance per queue identifier and uses it as the KVO context of the operation queue, so the identifier of a changed queue is found without scanning all the queues. Running operations are tracked as they start and finish, so freezing a queue doesn't need to snapshot all its queued operations. Pausing and resuming the queue can be done from any thread.
+ */
+@interface AMConnectionQueueState : NSObject
+
+/*!
+ * Default initializer.
+ * @param identifier The queue identifier.
+ */
+- (id)initWithIdentifier:(NSString*)identifier;
+
+/*!
+ * The queue identifier.
+ */
+@property (nonatomic, strong, readonly) NSString *identifier;
+
+/*!
+ * The operation queue.
+ */
+@property (nonatomic, strong, readonly) NSOperationQueue *queue;
+
+/*!
+ * YES while the queue is frozen.
+ */
+@property (nonatomic, assign, readonly, getter = isFrozen) BOOL frozen;
+
+/*!
+ * YES while the queue is preempted. Independent of the freezes: unfreezing a preempted queue doesn't run it.
+ */
+@property (nonatomic, assign, readonly, getter = isPreempted) BOOL preempted;
+
+/*!
+ * YES if the connections of the queue continue while the app is in background.
+ */
+@property (assign) BOOL executesInBackground;
+
+/*!
+ * The adaptive limit of concurrent connections of the queue, or nil if the limit is fixed.
+ */
+@property (strong) AMConcurrencyLimiter *concurrencyLimiter;
+
+/*!
+ * The number of running operations.
+ */
+@property (nonatomic, assign, readonly) NSUInteger runningOperationCount;
+
+/*!
+ * Adds an operation to the running operations.
+ * @param operation The operation.
+ */
+- (void)operationDidStart:(NSOperation*)operation;
+
+/*!
+ * Removes an operation from the running operations.
+ * @param operation The operation.
+ */
+- (void)operationDidFinish:(NSOperation*)operation;
+
+/*!
+ * Returns the running operations.
+ * @return A copy of the running operations.
+ */
+- (NSArray*)runningOperations;
+
+/*!
+ * Pauses the queue: the operation queue is suspended and the running operations are cancelled and kept, so they can be performed again when the queue resumes.
+ * @param reason The reason to pause the queue.
+ * @param predicate Returns YES for the running operations to pause. The other ones continue.
+ */
+- (void)pauseForReason:(AMConnectionQueuePauseReason)reason operationsPassingTest:(BOOL (^)(id operation))predicate;
+
+/*!
+ * Removes a reason to pause the queue. When no reason is left, the paused operations are performed again and the operation queue is resumed.
+ * @param reason The reason to remove.
+ * @param block Adds the operations performing again the given paused operations to the queue. Called before resuming the operation queue, while no other thread can pause or resume the queue.
+ * @return YES if the queue runs again, NO if it is still paused for another reason.
+ */
+- (BOOL)resumeForReason:(AMConnectionQueuePauseReason)reason performingPausedOperations:(void (^)(NSArray *pausedOperations))block;
+
+/*!
+ * Removes a paused operation, for example to perform it in another queue.
+ * @param predicate Returns YES for the operation to remove.
+ * @return The removed operation, or nil if no paused operation passes the test.
+ */
+- (id)removePausedOperationPassingTest:(BOOL (^)(id operation))predicate;
+
+@end
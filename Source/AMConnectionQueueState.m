@@ -0,0 +1,185 @@
+//
+//  AMConnectionQueueState.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMConnectionQueueState.h"
+
+#import <pthread.h>
+
+@implementation AMConnectionQueueState
+{
+    pthread_mutex_t _lock;
+    pthread_mutex_t _pauseLock;
+    
+    NSMutableSet *_runningOperations;
+    
+    // Guarded by _pauseLock, which is held during the whole pause or resume so they don't interleave.
+    NSMutableArray *_pausedOperations;
+    AMConnectionQueuePauseReason _pauseReasons;
+}
+
+- (id)init
+{
+    return [self initWithIdentifier:nil];
+}
+
+- (id)initWithIdentifier:(NSString*)identifier
+{
+    self = [super init];
+    if (self)
+    {
+        pthread_mutex_init(&_lock, NULL);
+        pthread_mutex_init(&_pauseLock, NULL);
+        
+        _identifier = identifier;
+        _queue = [[NSOperationQueue alloc] init];
+        _pausedOperations = [NSMutableArray array];
+        _runningOperations = [NSMutableSet set];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    pthread_mutex_destroy(&_lock);
+    pthread_mutex_destroy(&_pauseLock);
+}
+
+#pragma mark Properties
+
+- (NSUInteger)runningOperationCount
+{
+    pthread_mutex_lock(&_lock);
+    NSUInteger count = _runningOperations.count;
+    pthread_mutex_unlock(&_lock);
+    
+    return count;
+}
+
+- (BOOL)isFrozen
+{
+    pthread_mutex_lock(&_pauseLock);
+    BOOL frozen = (_pauseReasons & AMConnectionQueuePauseReasonFreeze) != 0;
+    pthread_mutex_unlock(&_pauseLock);
+    
+    return frozen;
+}
+
+- (BOOL)isPreempted
+{
+    pthread_mutex_lock(&_pauseLock);
+    BOOL preempted = (_pauseReasons & AMConnectionQueuePauseReasonPreemption) != 0;
+    pthread_mutex_unlock(&_pauseLock);
+    
+    return preempted;
+}
+
+#pragma mark Public Methods
+
+- (void)operationDidStart:(NSOperation*)operation
+{
+    pthread_mutex_lock(&_lock);
+    [_runningOperations addObject:operation];
+    pthread_mutex_unlock(&_lock);
+}
+
+- (void)operationDidFinish:(NSOperation*)operation
+{
+    pthread_mutex_lock(&_lock);
+    [_runningOperations removeObject:operation];
+    pthread_mutex_unlock(&_lock);
+}
+
+- (NSArray*)runningOperations
+{
+    pthread_mutex_lock(&_lock);
+    NSArray *operations = [_runningOperations allObjects];
+    pthread_mutex_unlock(&_lock);
+    
+    return operations;
+}
+
+- (void)pauseForReason:(AMConnectionQueuePauseReason)reason operationsPassingTest:(BOOL (^)(id operation))predicate
+{
+    pthread_mutex_lock(&_pauseLock);
+    
+    _pauseReasons |= reason;
+    [_queue setSuspended:YES];
+    
+    // Only the running operations are visited, not the whole queue. Paused operations are already cancelled.
+    for (NSOperation *operation in [self runningOperations])
+    {
+        if (!operation.isFinished && !operation.isCancelled && predicate(operation))
+        {
+            [operation cancel];
+            [_pausedOperations addObject:operation];
+        }
+    }
+    
+    pthread_mutex_unlock(&_pauseLock);
+}
+
+- (BOOL)resumeForReason:(AMConnectionQueuePauseReason)reason performingPausedOperations:(void (^)(NSArray *pausedOperations))block
+{
+    pthread_mutex_lock(&_pauseLock);
+    
+    _pauseReasons &= ~reason;
+    
+    BOOL resumed = _pauseReasons == 0;
+    
+    if (resumed)
+    {
+        NSArray *pausedOperations = [_pausedOperations copy];
+        [_pausedOperations removeAllObjects];
+        
+        block(pausedOperations);
+        
+        [_queue setSuspended:NO];
+    }
+    
+    pthread_mutex_unlock(&_pauseLock);
+    
+    return resumed;
+}
+
+- (id)removePausedOperationPassingTest:(BOOL (^)(id operation))predicate
+{
+    id operation = nil;
+    
+    pthread_mutex_lock(&_pauseLock);
+    
+    NSUInteger index = [_pausedOperations indexOfObjectPassingTest:^BOOL(id pausedOperation, NSUInteger idx, BOOL *stop) {
+        return predicate(pausedOperation);
+    }];
+    
+    if (index != NSNotFound)
+    {
+        operation = [_pausedOperations objectAtIndex:index];
+        [_pausedOperations removeObjectAtIndex:index];
+    }
+    
+    pthread_mutex_unlock(&_pauseLock);
+    
+    return operation;
+}
+
+@end
@@ -0,0 +1,161 @@
+//
+//  AMConnectionTransport.h
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import <Foundation/Foundation.h>
+
+@protocol AMConnectionTransfer;
+
+/*!
+ * The delegate of a transfer, usually an AMAsyncConnectionOperation.
+ * @discussion All the messages are sent in the thread where the transfer has been started. No message is sent after the transfer has been cancelled, has failed or has finished.
+ */
+@protocol AMConnectionTransferDelegate <NSObject>
+
+/*!
+ * The response headers have been received. It may be sent more than once, for example after a redirect.
+ * @param transfer The transfer.
+ * @param response The response.
+ */
+- (void)transfer:(id <AMConnectionTransfer>)transfer didReceiveResponse:(NSURLResponse*)response;
+
+/*!
+ * A chunk of the response body has been received.
+ * @param transfer The transfer.
+ * @param data The received data.
+ */
+- (void)transfer:(id <AMConnectionTransfer>)transfer didReceiveData:(NSData*)data;
+
+/*!
+ * A chunk of the request body has been sent.
+ * @param transfer The transfer.
+ * @param bytesWritten The number of bytes sent since the last message.
+ * @param totalBytesWritten The number of bytes sent.
+ * @param totalBytesExpectedToWrite The length of the body, or a value lower or equal to 0 if unknown.
+ */
+- (void)transfer:(id <AMConnectionTransfer>)transfer didSendBodyData:(NSInteger)bytesWritten totalBytesWritten:(NSInteger)totalBytesWritten totalBytesExpectedToWrite:(NSInteger)totalBytesExpectedToWrite;
+
+/*!
+ * The transfer has failed.
+ * @param transfer The transfer.
+ * @param error The error, in the NSURLErrorDomain when possible.
+ */
+- (void)transfer:(id <AMConnectionTransfer>)transfer didFailWithError:(NSError*)error;
+
+/*!
+ * The transfer has finished successfully.
+ * @param transfer The transfer.
+ */
+- (void)transferDidFinishLoading:(id <AMConnectionTransfer>)transfer;
+
+@optional
+
+/*!
+ * The request body has to be sent again, for example after a redirect.
+ * @param transfer The transfer.
+ * @param request The request whose body has to be sent.
+ * @return A new unopened stream with the body.
+ */
+- (NSInputStream*)transfer:(id <AMConnectionTransfer>)transfer needNewBodyStream:(NSURLRequest*)request;
+
+/*!
+ * Asks the delegate if it can handle authentication challenges of the given protection space. Only sent by transports supporting authentication challenges.
+ * @param transfer The transfer.
+ * @param protectionSpace The protection space.
+ * @return YES if the delegate handles the challenges.
+ */
+- (BOOL)transfer:(id <AMConnectionTransfer>)transfer canAuthenticateAgainstProtectionSpace:(NSURLProtectionSpace*)protectionSpace;
+
+/*!
+ * An authentication challenge has been received. Only sent by transports supporting authentication challenges.
+ * @param transfer The transfer.
+ * @param challenge The challenge.
+ */
+- (void)transfer:(id <AMConnectionTransfer>)transfer didReceiveAuthenticationChallenge:(NSURLAuthenticationChallenge*)challenge;
+
+/*!
+ * An authentication challenge has been cancelled. Only sent by transports supporting authentication challenges.
+ * @param transfer The transfer.
+ * @param challenge The challenge.
+ */
+- (void)transfer:(id <AMConnectionTransfer>)transfer didCancelAuthenticationChallenge:(NSURLAuthenticationChallenge*)challenge;
+
+@end
+
+/*!
+ * A single request being performed by a transport.
+ * @discussion All the methods must be called from the same thread, which must have a running run loop. The transfer retains its delegate until it is cancelled, fails or finishes.
+ */
+@protocol AMConnectionTransfer <NSObject>
+
+/*!
+ * Starts the transfer.
+ */
+- (void)start;
+
+/*!
+ * Cancels the transfer. The delegate doesn't receive any other message.
+ */
+- (void)cancel;
+
+/*!
+ * Stops delivering data to the delegate, for example to limit the bandwidth.
+ * @discussion A transport that also stops reading from the socket makes TCP flow control slow down the server. AMURLConnectionTransport can't: it only delays the delivery of the data.
+ */
+- (void)suspend;
+
+/*!
+ * Continues reading and writing data after -suspend.
+ */
+- (void)resume;
+
+@end
+
+/*!
+ * A transport performs the requests of the connection operations.
+ * @discussion Transports are shared by many operations and must be thread safe.
+ */
+@protocol AMConnectionTransport <NSObject>
+
+/*!
+ * Creates a transfer for the given request. The transfer is not started.
+ * @param request The request.
+ * @param delegate The delegate of the transfer.
+ * @return The new transfer.
+ */
+- (id <AMConnectionTransfer>)transferWithRequest:(NSURLRequest*)request delegate:(id <AMConnectionTransferDelegate>)delegate;
+
+@end
+
+/*!
+ * Transport performing each request with a NSURLConnection scheduled in the run loop of the thread starting the transfer.
+ * @discussion This is the default transport. It supports authentication challenges. Suspended transfers stop calling their delegate, but the system may keep reading their socket.
+ */
+@interface AMURLConnectionTransport : NSObject <AMConnectionTransport>
+
+/*!
+ * Returns the shared instance.
+ * @return The shared transport.
+ */
++ (AMURLConnectionTransport*)defaultTransport;
+
+@end
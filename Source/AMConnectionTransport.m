@@ -0,0 +1,188 @@
+//
+//  AMConnectionTransport.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMConnectionTransport.h"
+
+#import <dispatch/dispatch.h>
+
+/*!
+ * Transfer of the AMURLConnectionTransport, forwarding the NSURLConnection delegate messages to its delegate.
+ */
+@interface AMURLConnectionTransfer : NSObject <AMConnectionTransfer, NSURLConnectionDelegate, NSURLConnectionDataDelegate>
+
+- (id)initWithRequest:(NSURLRequest*)request delegate:(id <AMConnectionTransferDelegate>)delegate;
+
+@end
+
+@implementation AMURLConnectionTransfer
+{
+    NSURLConnection *_connection;
+    id <AMConnectionTransferDelegate> _delegate;
+    BOOL _suspended;
+}
+
+- (id)initWithRequest:(NSURLRequest*)request delegate:(id <AMConnectionTransferDelegate>)delegate
+{
+    self = [super init];
+    if (self)
+    {
+        _delegate = delegate;
+        _connection = [[NSURLConnection alloc] initWithRequest:request delegate:self startImmediately:NO];
+    }
+    return self;
+}
+
+#pragma mark Public Methods
+
+- (void)start
+{
+    [_connection scheduleInRunLoop:[NSRunLoop currentRunLoop] forMode:NSDefaultRunLoopMode];
+    [_connection start];
+}
+
+- (void)cancel
+{
+    [_connection cancel];
+    [self _invalidate];
+}
+
+- (void)suspend
+{
+    if (_suspended || !_connection)
+        return;
+    
+    // Out of the run loop the connection stops calling its delegate. The CFNetwork loader thread may still read the
+    // socket into its own buffers, so this delays the delivery of the data but doesn't necessarily slow the server down.
+    _suspended = YES;
+    [_connection unscheduleFromRunLoop:[NSRunLoop currentRunLoop] forMode:NSDefaultRunLoopMode];
+}
+
+- (void)resume
+{
+    if (!_suspended || !_connection)
+        return;
+    
+    _suspended = NO;
+    [_connection scheduleInRunLoop:[NSRunLoop currentRunLoop] forMode:NSDefaultRunLoopMode];
+}
+
+#pragma mark Private Methods
+
+- (void)_invalidate
+{
+    // Breaks the retain cycles with the connection and the delegate.
+    _connection = nil;
+    _delegate = nil;
+}
+
+#pragma mark - Protocols
+
+#pragma mark NSURLConnectionDelegate
+
+- (void)connection:(NSURLConnection *)connection didFailWithError:(NSError *)error
+{
+    id <AMConnectionTransferDelegate> delegate = _delegate;
+    [self _invalidate];
+    
+    [delegate transfer:self didFailWithError:error];
+}
+
+- (BOOL)connection:(NSURLConnection *)connection canAuthenticateAgainstProtectionSpace:(NSURLProtectionSpace *)protectionSpace
+{
+    if ([_delegate respondsToSelector:@selector(transfer:canAuthenticateAgainstProtectionSpace:)])
+        return [_delegate transfer:self canAuthenticateAgainstProtectionSpace:protectionSpace];
+    
+    return NO;
+}
+
+- (void)connection:(NSURLConnection *)connection didReceiveAuthenticationChallenge:(NSURLAuthenticationChallenge *)challenge
+{
+    if ([_delegate respondsToSelector:@selector(transfer:didReceiveAuthenticationChallenge:)])
+        [_delegate transfer:self didReceiveAuthenticationChallenge:challenge];
+    else
+        [challenge.sender continueWithoutCredentialForAuthenticationChallenge:challenge];
+}
+
+- (void)connection:(NSURLConnection *)connection didCancelAuthenticationChallenge:(NSURLAuthenticationChallenge *)challenge
+{
+    if ([_delegate respondsToSelector:@selector(transfer:didCancelAuthenticationChallenge:)])
+        [_delegate transfer:self didCancelAuthenticationChallenge:challenge];
+}
+
+#pragma mark NSURLConnectionDataDelegate
+
+- (void)connection:(NSURLConnection *)connection didReceiveResponse:(NSURLResponse *)response
+{
+    [_delegate transfer:self didReceiveResponse:response];
+}
+
+- (void)connection:(NSURLConnection *)connection didReceiveData:(NSData *)data
+{
+    [_delegate transfer:self didReceiveData:data];
+}
+
+- (NSInputStream *)connection:(NSURLConnection *)connection needNewBodyStream:(NSURLRequest *)request
+{
+    if ([_delegate respondsToSelector:@selector(transfer:needNewBodyStream:)])
+        return [_delegate transfer:self needNewBodyStream:request];
+    
+    return nil;
+}
+
+- (void)connection:(NSURLConnection *)connection didSendBodyData:(NSInteger)bytesWritten totalBytesWritten:(NSInteger)totalBytesWritten totalBytesExpectedToWrite:(NSInteger)totalBytesExpectedToWrite
+{
+    [_delegate transfer:self didSendBodyData:bytesWritten totalBytesWritten:totalBytesWritten totalBytesExpectedToWrite:totalBytesExpectedToWrite];
+}
+
+- (void)connectionDidFinishLoading:(NSURLConnection *)connection
+{
+    id <AMConnectionTransferDelegate> delegate = _delegate;
+    [self _invalidate];
+    
+    [delegate transferDidFinishLoading:self];
+}
+
+@end
+
+@implementation AMURLConnectionTransport
+
++ (AMURLConnectionTransport*)defaultTransport
+{
+    static dispatch_once_t pred = 0;
+    __strong static id _sharedObject = nil;
+    dispatch_once(&pred, ^{
+        _sharedObject = [[AMURLConnectionTransport alloc] init];
+    });
+    return _sharedObject;
+}
+
+#pragma mark - Protocols
+
+#pragma mark AMConnectionTransport
+
+- (id <AMConnectionTransfer>)transferWithRequest:(NSURLRequest*)request delegate:(id <AMConnectionTransferDelegate>)delegate
+{
+    return [[AMURLConnectionTransfer alloc] initWithRequest:request delegate:delegate];
+}
+
+@end
@@ -0,0 +1,55 @@
+//
+//  AMCurlTransport.h
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import <Foundation/Foundation.h>
+
+#import "AMConnectionTransport.h"
+
+#if AM_HAS_LIBCURL
+
+/*!
+ * Transport performing the requests with libcurl. Only available when building with AM_HAS_LIBCURL=1 and linking libcurl (7.68 or newer), which the AM_WITH_LIBCURL CMake option does.
+ * @discussion All the transfers of a transport are driven by a single libcurl multi handle running in its own thread, so connections are kept alive and reused between requests to the same host, and HTTP/2 requests to the same host are multiplexed over a single connection. Transports are long-lived: the thread of a transport is never stopped. Authentication challenges are not supported: credentials must be included in the request headers, and server certificates are verified against the CA bundle of libcurl.
+ */
+@interface AMCurlTransport : NSObject <AMConnectionTransport>
+
+/*!
+ * Returns the shared instance, with up to 6 connections per host.
+ * @return The shared transport.
+ */
++ (AMCurlTransport*)defaultTransport;
+
+/*!
+ * Default initializer.
+ * @param maximumConnectionCountPerHost The maximum number of connections opened against the same host. Zero for no limit.
+ */
+- (id)initWithMaximumConnectionCountPerHost:(NSUInteger)maximumConnectionCountPerHost;
+
+/*!
+ * The maximum number of connections opened against the same host. Transfers beyond the limit wait for a free connection.
+ */
+@property (nonatomic, assign, readonly) NSUInteger maximumConnectionCountPerHost;
+
+@end
+
+#endif
@@ -0,0 +1,625 @@
+//
+//  AMCurlTransport.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMCurlTransport.h"
+
+#if AM_HAS_LIBCURL
+
+#import <curl/curl.h>
+#import <dispatch/dispatch.h>
+#import <pthread.h>
+#import <stdatomic.h>
+
+@class AMCurlTransfer;
+
+@interface AMCurlTransport ()
+
+- (void)_performBlock:(void (^)(CURLM *multi))block;
+- (void)_addPausedUploadTransfer:(AMCurlTransfer*)transfer;
+
+@end
+
+/*!
+ * Transfer of the AMCurlTransport.
+ * @discussion Once the transfer has started, the easy handle is only used from the thread of the transport, where it is also cleaned up; the delegate is only messaged from the thread that started the transfer.
+ */
+@interface AMCurlTransfer : NSObject <AMConnectionTransfer>
+
+- (id)initWithTransport:(AMCurlTransport*)transport request:(NSURLRequest*)request delegate:(id <AMConnectionTransferDelegate>)delegate;
+
+- (void)_didCompleteWithResult:(CURLcode)result;
+- (BOOL)_resumeUploadIfBodyAvailable;
+
+@end
+
+static size_t AMCurlTransferHeaderCallback(char *buffer, size_t size, size_t count, void *context);
+static size_t AMCurlTransferWriteCallback(char *buffer, size_t size, size_t count, void *context);
+static size_t AMCurlTransferReadCallback(char *buffer, size_t size, size_t count, void *context);
+static int AMCurlTransferProgressCallback(void *context, curl_off_t downloadTotal, curl_off_t downloadNow, curl_off_t uploadTotal, curl_off_t uploadNow);
+
+static NSInteger AMURLErrorCodeForCurlCode(CURLcode code)
+{
+    switch (code)
+    {
+        case CURLE_UNSUPPORTED_PROTOCOL:
+            return NSURLErrorUnsupportedURL;
+        case CURLE_URL_MALFORMAT:
+            return NSURLErrorBadURL;
+        case CURLE_COULDNT_RESOLVE_PROXY:
+        case CURLE_COULDNT_RESOLVE_HOST:
+            return NSURLErrorCannotFindHost;
+        case CURLE_COULDNT_CONNECT:
+            return NSURLErrorCannotConnectToHost;
+        case CURLE_OPERATION_TIMEDOUT:
+            return NSURLErrorTimedOut;
+        case CURLE_TOO_MANY_REDIRECTS:
+            return NSURLErrorHTTPTooManyRedirects;
+        case CURLE_GOT_NOTHING:
+            return NSURLErrorZeroByteResource;
+        case CURLE_SEND_ERROR:
+        case CURLE_RECV_ERROR:
+        case CURLE_PARTIAL_FILE:
+            return NSURLErrorNetworkConnectionLost;
+        case CURLE_SSL_CONNECT_ERROR:
+            return NSURLErrorSecureConnectionFailed;
+        case CURLE_PEER_FAILED_VERIFICATION:
+            return NSURLErrorServerCertificateUntrusted;
+        case CURLE_ABORTED_BY_CALLBACK:
+            return NSURLErrorCancelled;
+        default:
+            return NSURLErrorUnknown;
+    }
+}
+
+@implementation AMCurlTransfer
+{
+    __weak AMCurlTransport *_transport;
+    id <AMConnectionTransferDelegate> _delegate;
+    NSThread *_thread;
+    
+    NSURLRequest *_request;
+    CURL *_easy;
+    struct curl_slist *_requestHeaders;
+    
+    // Only used from the thread of the transport.
+    NSInteger _statusCode;
+    NSMutableDictionary *_responseHeaders;
+    NSData *_body;
+    NSInputStream *_bodyStream;
+    long long _bodyOffset;
+    long long _bodyLength;
+    curl_off_t _sentLength;
+    BOOL _uploadPaused;
+    
+    atomic_bool _cancelled;
+}
+
+- (id)initWithTransport:(AMCurlTransport*)transport request:(NSURLRequest*)request delegate:(id <AMConnectionTransferDelegate>)delegate
+{
+    self = [super init];
+    if (self)
+    {
+        _transport = transport;
+        _request = request;
+        _delegate = delegate;
+        _bodyLength = -1;
+        
+        atomic_init(&_cancelled, false);
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    CURL *easy = _easy;
+    struct curl_slist *requestHeaders = _requestHeaders;
+    AMCurlTransport *transport = _transport;
+    
+    // The last reference may be released by any thread, but the handle may still be known by the multi handle (for
+    // example in its connection cache): it is cleaned up in the thread of the transport.
+    if (easy && transport)
+    {
+        [transport _performBlock:^(CURLM *multi) {
+            curl_easy_cleanup(easy);
+            curl_slist_free_all(requestHeaders);
+        }];
+    }
+    else
+    {
+        if (easy)
+            curl_easy_cleanup(easy);
+        
+        if (requestHeaders)
+            curl_slist_free_all(requestHeaders);
+    }
+    
+    [_bodyStream close];
+}
+
+#pragma mark Public Methods
+
+- (void)start
+{
+    _thread = [NSThread currentThread];
+    
+    [self _configureEasyHandle];
+    
+    // The transport keeps the transfer alive while its handle is in the multi handle.
+    void *context = (__bridge_retained void*)self;
+    CURL *easy = _easy;
+    
+    [_transport _performBlock:^(CURLM *multi) {
+        curl_easy_setopt(easy, CURLOPT_PRIVATE, context);
+        curl_multi_add_handle(multi, easy);
+    }];
+}
+
+- (void)cancel
+{
+    if (atomic_exchange(&_cancelled, true))
+        return;
+    
+    _delegate = nil;
+    
+    // The blocks retain the transfer, so its handle can't be cleaned up before they run.
+    [_transport _performBlock:^(CURLM *multi) {
+        
+        CURL *easy = self->_easy;
+        void *context = NULL;
+        
+        if (!easy)
+            return;
+        
+        curl_easy_getinfo(easy, CURLINFO_PRIVATE, (char**)&context);
+        
+        // The handle is only retained while it has not completed.
+        if (context && curl_multi_remove_handle(multi, easy) == CURLM_OK)
+        {
+            curl_easy_setopt(easy, CURLOPT_PRIVATE, NULL);
+            (void)(__bridge_transfer id)context;
+        }
+    }];
+}
+
+- (void)suspend
+{
+    [_transport _performBlock:^(CURLM *multi) {
+        if (self->_easy)
+            curl_easy_pause(self->_easy, CURLPAUSE_ALL);
+    }];
+}
+
+- (void)resume
+{
+    [_transport _performBlock:^(CURLM *multi) {
+        if (self->_easy)
+            curl_easy_pause(self->_easy, CURLPAUSE_CONT);
+    }];
+}
+
+#pragma mark Private Methods
+
+- (void)_configureEasyHandle
+{
+    _easy = curl_easy_init();
+    
+    curl_easy_setopt(_easy, CURLOPT_URL, [[_request.URL absoluteString] UTF8String]);
+    curl_easy_setopt(_easy, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(_easy, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(_easy, CURLOPT_MAXREDIRS, 16L);
+    
+    // As NSURLConnection, compressed responses are decoded.
+    curl_easy_setopt(_easy, CURLOPT_ACCEPT_ENCODING, "");
+    
+    // Prefer waiting for a multiplexed HTTP/2 connection over opening a new one.
+    curl_easy_setopt(_easy, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+    curl_easy_setopt(_easy, CURLOPT_PIPEWAIT, 1L);
+    
+    // The timeout of NSURLRequest is an idle timeout, not a limit of the whole transfer.
+    long timeout = (long)ceil(_request.timeoutInterval);
+    if (timeout > 0)
+    {
+        curl_easy_setopt(_easy, CURLOPT_CONNECTTIMEOUT, timeout);
+        curl_easy_setopt(_easy, CURLOPT_LOW_SPEED_LIMIT, 1L);
+        curl_easy_setopt(_easy, CURLOPT_LOW_SPEED_TIME, timeout);
+    }
+    
+    curl_easy_setopt(_easy, CURLOPT_HEADERFUNCTION, AMCurlTransferHeaderCallback);
+    curl_easy_setopt(_easy, CURLOPT_HEADERDATA, (__bridge void*)self);
+    curl_easy_setopt(_easy, CURLOPT_WRITEFUNCTION, AMCurlTransferWriteCallback);
+    curl_easy_setopt(_easy, CURLOPT_WRITEDATA, (__bridge void*)self);
+    curl_easy_setopt(_easy, CURLOPT_XFERINFOFUNCTION, AMCurlTransferProgressCallback);
+    curl_easy_setopt(_easy, CURLOPT_XFERINFODATA, (__bridge void*)self);
+    curl_easy_setopt(_easy, CURLOPT_NOPROGRESS, 0L);
+    
+    NSString *method = _request.HTTPMethod.length > 0 ? _request.HTTPMethod : @"GET";
+    
+    [_request.allHTTPHeaderFields enumerateKeysAndObjectsUsingBlock:^(NSString *field, NSString *value, BOOL *stop) {
+        _requestHeaders = curl_slist_append(_requestHeaders, [[NSString stringWithFormat:@"%@: %@", field, value] UTF8String]);
+    }];
+    
+    // Don't wait for a "100 Continue" before sending the body.
+    _requestHeaders = curl_slist_append(_requestHeaders, "Expect:");
+    curl_easy_setopt(_easy, CURLOPT_HTTPHEADER, _requestHeaders);
+    
+    if ([method isEqualToString:@"HEAD"])
+    {
+        curl_easy_setopt(_easy, CURLOPT_NOBODY, 1L);
+    }
+    else if (_request.HTTPBodyStream || _request.HTTPBody)
+    {
+        _body = _request.HTTPBody;
+        _bodyStream = _request.HTTPBodyStream;
+        _bodyLength = _body ? (long long)_body.length : [[_request valueForHTTPHeaderField:@"Content-Length"] longLongValue] ?: -1;
+        
+        [_bodyStream open];
+        
+        // The body is read with the read callback; without a known length it is sent chunked.
+        curl_easy_setopt(_easy, CURLOPT_POST, 1L);
+        curl_easy_setopt(_easy, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)_bodyLength);
+        curl_easy_setopt(_easy, CURLOPT_READFUNCTION, AMCurlTransferReadCallback);
+        curl_easy_setopt(_easy, CURLOPT_READDATA, (__bridge void*)self);
+        
+        if (![method isEqualToString:@"POST"])
+            curl_easy_setopt(_easy, CURLOPT_CUSTOMREQUEST, [method UTF8String]);
+    }
+    else if (![method isEqualToString:@"GET"])
+    {
+        curl_easy_setopt(_easy, CURLOPT_CUSTOMREQUEST, [method UTF8String]);
+    }
+}
+
+- (void)_deliver:(void (^)(id <AMConnectionTransferDelegate> delegate))block
+{
+    // Called from the thread of the transport. Messages keep their order because they are queued in the same run loop.
+    [self performSelector:@selector(_deliverOnTransferThread:) onThread:_thread withObject:block waitUntilDone:NO];
+}
+
+- (void)_deliverOnTransferThread:(void (^)(id <AMConnectionTransferDelegate> delegate))block
+{
+    if (atomic_load(&_cancelled))
+        return;
+    
+    block(_delegate);
+}
+
+- (void)_finishDeliveringWithBlock:(void (^)(id <AMConnectionTransferDelegate> delegate))block
+{
+    [self _deliver:^(id <AMConnectionTransferDelegate> delegate) {
+        
+        // No other message is sent, so the delegate can be released.
+        atomic_store(&_cancelled, true);
+        _delegate = nil;
+        
+        block(delegate);
+    }];
+}
+
+- (size_t)_didReceiveHeaderLine:(char*)buffer length:(size_t)length
+{
+    NSString *line = [[NSString alloc] initWithBytes:buffer length:length encoding:NSISOLatin1StringEncoding];
+    line = [line stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]];
+    
+    if ([line hasPrefix:@"HTTP/"])
+    {
+        // A new response starts: interim responses and redirects have their own headers.
+        NSArray *components = [line componentsSeparatedByString:@" "];
+        _statusCode = components.count > 1 ? [[components objectAtIndex:1] integerValue] : 0;
+        _responseHeaders = [NSMutableDictionary dictionary];
+    }
+    else if (line.length > 0)
+    {
+        NSRange separator = [line rangeOfString:@":"];
+        
+        if (separator.location != NSNotFound)
+        {
+            NSString *field = [line substringToIndex:separator.location];
+            NSString *value = [[line substringFromIndex:separator.location + 1] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+            NSString *previousValue = [_responseHeaders objectForKey:field];
+            
+            [_responseHeaders setObject:(previousValue ? [NSString stringWithFormat:@"%@, %@", previousValue, value] : value) forKey:field];
+        }
+    }
+    else if (_responseHeaders)
+    {
+        // End of the headers. Interim responses and followed redirects are not delivered.
+        BOOL isRedirect = _statusCode >= 300 && _statusCode < 400 && [_responseHeaders objectForKey:@"Location"] != nil && _statusCode != 304;
+        
+        if (_statusCode >= 200 && !isRedirect)
+        {
+            char *effectiveURL = NULL;
+            curl_easy_getinfo(_easy, CURLINFO_EFFECTIVE_URL, &effectiveURL);
+            
+            NSURL *URL = effectiveURL ? [NSURL URLWithString:[NSString stringWithUTF8String:effectiveURL]] : _request.URL;
+            NSHTTPURLResponse *response = [[NSHTTPURLResponse alloc] initWithURL:URL statusCode:_statusCode HTTPVersion:@"HTTP/1.1" headerFields:_responseHeaders];
+            
+            [self _deliver:^(id <AMConnectionTransferDelegate> delegate) {
+                [delegate transfer:self didReceiveResponse:response];
+            }];
+        }
+        
+        _responseHeaders = nil;
+    }
+    
+    return length;
+}
+
+- (size_t)_didReceiveData:(char*)buffer length:(size_t)length
+{
+    NSData *data = [NSData dataWithBytes:buffer length:length];
+    
+    [self _deliver:^(id <AMConnectionTransferDelegate> delegate) {
+        [delegate transfer:self didReceiveData:data];
+    }];
+    
+    return length;
+}
+
+- (size_t)_readBodyData:(char*)buffer length:(size_t)length
+{
+    if (_body)
+    {
+        size_t count = (size_t)MIN((long long)length, (long long)_body.length - _bodyOffset);
+        [_body getBytes:buffer range:NSMakeRange((NSUInteger)_bodyOffset, count)];
+        _bodyOffset += count;
+        return count;
+    }
+    
+    // Reading a stream that has no bytes yet would block the thread of all the transfers. Pause the upload until it has.
+    if (![_bodyStream hasBytesAvailable])
+    {
+        NSStreamStatus status = _bodyStream.streamStatus;
+        
+        if (status == NSStreamStatusAtEnd || status == NSStreamStatusClosed)
+            return 0;
+        
+        if (status == NSStreamStatusError)
+            return CURL_READFUNC_ABORT;
+        
+        _uploadPaused = YES;
+        [_transport _addPausedUploadTransfer:self];
+        return CURL_READFUNC_PAUSE;
+    }
+    
+    NSInteger count = [_bodyStream read:(uint8_t*)buffer maxLength:length];
+    
+    return count < 0 ? CURL_READFUNC_ABORT : (size_t)count;
+}
+
+- (BOOL)_resumeUploadIfBodyAvailable
+{
+    // Called from the thread of the transport. Cancelled transfers are no longer in the multi handle.
+    if (atomic_load(&_cancelled))
+        return YES;
+    
+    NSStreamStatus status = _bodyStream.streamStatus;
+    
+    if (!_uploadPaused || (![_bodyStream hasBytesAvailable] && status != NSStreamStatusAtEnd && status != NSStreamStatusError && status != NSStreamStatusClosed))
+        return NO;
+    
+    _uploadPaused = NO;
+    curl_easy_pause(_easy, CURLPAUSE_CONT);
+    
+    return YES;
+}
+
+- (int)_didProgressUploadingBytes:(curl_off_t)uploadNow total:(curl_off_t)uploadTotal
+{
+    if (atomic_load(&_cancelled))
+        return 1;
+    
+    if (uploadNow > _sentLength)
+    {
+        NSInteger bytesWritten = (NSInteger)(uploadNow - _sentLength);
+        NSInteger totalBytesWritten = (NSInteger)uploadNow;
+        NSInteger totalBytesExpectedToWrite = (NSInteger)(uploadTotal > 0 ? uploadTotal : _bodyLength);
+        
+        _sentLength = uploadNow;
+        
+        [self _deliver:^(id <AMConnectionTransferDelegate> delegate) {
+            [delegate transfer:self didSendBodyData:bytesWritten totalBytesWritten:totalBytesWritten totalBytesExpectedToWrite:totalBytesExpectedToWrite];
+        }];
+    }
+    
+    return 0;
+}
+
+- (void)_didCompleteWithResult:(CURLcode)result
+{
+    if (result == CURLE_OK)
+    {
+        [self _finishDeliveringWithBlock:^(id <AMConnectionTransferDelegate> delegate) {
+            [delegate transferDidFinishLoading:self];
+        }];
+    }
+    else
+    {
+        NSError *error = [NSError errorWithDomain:NSURLErrorDomain
+                                             code:AMURLErrorCodeForCurlCode(result)
+                                         userInfo:@{NSLocalizedDescriptionKey: [NSString stringWithUTF8String:curl_easy_strerror(result)],
+                                                    NSURLErrorFailingURLErrorKey: _request.URL,
+                                                    @"AMCurlErrorCode": @(result)}];
+        
+        [self _finishDeliveringWithBlock:^(id <AMConnectionTransferDelegate> delegate) {
+            [delegate transfer:self didFailWithError:error];
+        }];
+    }
+}
+
+@end
+
+static size_t AMCurlTransferHeaderCallback(char *buffer, size_t size, size_t count, void *context)
+{
+    return [(__bridge AMCurlTransfer*)context _didReceiveHeaderLine:buffer length:size * count];
+}
+
+static size_t AMCurlTransferWriteCallback(char *buffer, size_t size, size_t count, void *context)
+{
+    return [(__bridge AMCurlTransfer*)context _didReceiveData:buffer length:size * count];
+}
+
+static size_t AMCurlTransferReadCallback(char *buffer, size_t size, size_t count, void *context)
+{
+    return [(__bridge AMCurlTransfer*)context _readBodyData:buffer length:size * count];
+}
+
+static int AMCurlTransferProgressCallback(void *context, curl_off_t downloadTotal, curl_off_t downloadNow, curl_off_t uploadTotal, curl_off_t uploadNow)
+{
+    return [(__bridge AMCurlTransfer*)context _didProgressUploadingBytes:uploadNow total:uploadTotal];
+}
+
+@implementation AMCurlTransport
+{
+    CURLM *_multi;
+    NSThread *_thread;
+    
+    pthread_mutex_t _lock;
+    NSMutableArray *_pendingBlocks;
+    
+    // Only used from the thread of the transport.
+    NSMutableArray *_pausedUploadTransfers;
+}
+
++ (AMCurlTransport*)defaultTransport
+{
+    static dispatch_once_t pred = 0;
+    __strong static id _sharedObject = nil;
+    dispatch_once(&pred, ^{
+        _sharedObject = [[AMCurlTransport alloc] initWithMaximumConnectionCountPerHost:6];
+    });
+    return _sharedObject;
+}
+
+- (id)init
+{
+    return [self initWithMaximumConnectionCountPerHost:6];
+}
+
+- (id)initWithMaximumConnectionCountPerHost:(NSUInteger)maximumConnectionCountPerHost
+{
+    self = [super init];
+    if (self)
+    {
+        static dispatch_once_t pred = 0;
+        dispatch_once(&pred, ^{
+            curl_global_init(CURL_GLOBAL_ALL);
+        });
+        
+        _maximumConnectionCountPerHost = maximumConnectionCountPerHost;
+        
+        pthread_mutex_init(&_lock, NULL);
+        _pendingBlocks = [NSMutableArray array];
+        _pausedUploadTransfers = [NSMutableArray array];
+        
+        _multi = curl_multi_init();
+        curl_multi_setopt(_multi, CURLMOPT_PIPELINING, (long)CURLPIPE_MULTIPLEX);
+        curl_multi_setopt(_multi, CURLMOPT_MAX_HOST_CONNECTIONS, (long)maximumConnectionCountPerHost);
+        
+        _thread = [[NSThread alloc] initWithTarget:self selector:@selector(_run) object:nil];
+        _thread.name = @"AMCurlTransport";
+        [_thread start];
+    }
+    return self;
+}
+
+#pragma mark - Protocols
+#pragma mark AMConnectionTransport
+
+- (id <AMConnectionTransfer>)transferWithRequest:(NSURLRequest*)request delegate:(id <AMConnectionTransferDelegate>)delegate
+{
+    return [[AMCurlTransfer alloc] initWithTransport:self request:request delegate:delegate];
+}
+
+#pragma mark Private Methods
+
+- (void)_performBlock:(void (^)(CURLM *multi))block
+{
+    pthread_mutex_lock(&_lock);
+    [_pendingBlocks addObject:[block copy]];
+    pthread_mutex_unlock(&_lock);
+    
+    curl_multi_wakeup(_multi);
+}
+
+- (void)_addPausedUploadTransfer:(AMCurlTransfer*)transfer
+{
+    [_pausedUploadTransfers addObject:transfer];
+}
+
+- (void)_run
+{
+    while (YES)
+    {
+        @autoreleasepool
+        {
+            pthread_mutex_lock(&_lock);
+            NSArray *blocks = _pendingBlocks;
+            _pendingBlocks = [NSMutableArray array];
+            pthread_mutex_unlock(&_lock);
+            
+            for (void (^block)(CURLM *multi) in blocks)
+                block(_multi);
+            
+            for (AMCurlTransfer *transfer in [_pausedUploadTransfers copy])
+            {
+                if ([transfer _resumeUploadIfBodyAvailable])
+                    [_pausedUploadTransfers removeObjectIdenticalTo:transfer];
+            }
+            
+            int runningCount = 0;
+            curl_multi_perform(_multi, &runningCount);
+            
+            CURLMsg *message = NULL;
+            int queuedCount = 0;
+            
+            while ((message = curl_multi_info_read(_multi, &queuedCount)))
+            {
+                if (message->msg != CURLMSG_DONE)
+                    continue;
+                
+                CURL *easy = message->easy_handle;
+                CURLcode result = message->data.result;
+                
+                void *context = NULL;
+                curl_easy_getinfo(easy, CURLINFO_PRIVATE, (char**)&context);
+                
+                curl_multi_remove_handle(_multi, easy);
+                curl_easy_setopt(easy, CURLOPT_PRIVATE, NULL);
+                
+                if (context)
+                {
+                    AMCurlTransfer *transfer = (__bridge_transfer AMCurlTransfer*)context;
+                    [_pausedUploadTransfers removeObjectIdenticalTo:transfer];
+                    [transfer _didCompleteWithResult:result];
+                }
+            }
+            
+            // Paused uploads are polled for new body bytes; otherwise sleep until there is network activity or a new block.
+            curl_multi_poll(_multi, NULL, 0, _pausedUploadTransfers.count > 0 ? 10 : 1000, NULL);
+        }
+    }
+}
+
+@end
+
+#endif
@@ -0,0 +1,82 @@
+//
+//  AMDataCompressor.h
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import <Foundation/Foundation.h>
+
+/*!
+ * The formats of an AMDataCompressor.
+ */
+typedef NS_ENUM(NSInteger, AMCompressionFormat)
+{
+    /** gzip (RFC 1952), the "gzip" content coding. */
+    AMCompressionFormatGzip,
+    
+    /** zlib (RFC 1950), the "deflate" content coding. */
+    AMCompressionFormatDeflate
+};
+
+/*!
+ * Streaming zlib compressor.
+ * @discussion The input is compressed in chunks as it is appended, so the memory usage doesn't depend on the length of the input. A compressor is not thread-safe, but it can be used from any thread.
+ */
+@interface AMDataCompressor : NSObject
+
+/*!
+ * Compresses a whole data.
+ * @param data The data.
+ * @param format The format of the compressed data.
+ * @return The compressed data.
+ */
++ (NSData*)compressedData:(NSData*)data format:(AMCompressionFormat)format;
+
+/*!
+ * Default initializer.
+ * @param format The format of the compressed data.
+ */
+- (id)initWithFormat:(AMCompressionFormat)format;
+
+/*!
+ * The format of the compressed data.
+ */
+@property (nonatomic, assign, readonly) AMCompressionFormat format;
+
+/*!
+ * The value of the Content-Encoding header for the format.
+ */
+@property (nonatomic, strong, readonly) NSString *contentEncoding;
+
+/*!
+ * Compresses the next chunk of the input.
+ * @param bytes The bytes.
+ * @param length The number of bytes.
+ * @return The compressed bytes produced so far. It may be empty: the compressor keeps the input until it has enough to compress.
+ */
+- (NSData*)compressBytes:(const void*)bytes length:(NSUInteger)length;
+
+/*!
+ * Ends the input.
+ * @return The remaining compressed bytes. No more input can be compressed afterwards.
+ */
+- (NSData*)finish;
+
+@end
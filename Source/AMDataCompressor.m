@@ -0,0 +1,136 @@
+//
+//  AMDataCompressor.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMDataCompressor.h"
+
+#import <zlib.h>
+
+#define AMDataCompressorBufferSize (16 * 1024)
+
+@implementation AMDataCompressor
+{
+    z_stream _stream;
+    BOOL _finished;
+}
+
++ (NSData*)compressedData:(NSData*)data format:(AMCompressionFormat)format
+{
+    AMDataCompressor *compressor = [[AMDataCompressor alloc] initWithFormat:format];
+    
+    NSMutableData *compressedData = [[compressor compressBytes:data.bytes length:data.length] mutableCopy];
+    [compressedData appendData:[compressor finish]];
+    
+    return compressedData;
+}
+
+- (id)init
+{
+    return [self initWithFormat:AMCompressionFormatGzip];
+}
+
+- (id)initWithFormat:(AMCompressionFormat)format
+{
+    self = [super init];
+    if (self)
+    {
+        _format = format;
+        
+        // A window of 15 bits, plus 16 to write a gzip header and trailer instead of the zlib ones.
+        int windowBits = format == AMCompressionFormatGzip ? 15 + 16 : 15;
+        
+        if (deflateInit2(&_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            return nil;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    deflateEnd(&_stream);
+}
+
+#pragma mark Properties
+
+- (NSString*)contentEncoding
+{
+    return _format == AMCompressionFormatGzip ? @"gzip" : @"deflate";
+}
+
+#pragma mark Public Methods
+
+- (NSData*)compressBytes:(const void*)bytes length:(NSUInteger)length
+{
+    NSAssert(!_finished, @"The compressor has already finished.");
+    
+    return [self _deflateBytes:bytes length:length flush:Z_NO_FLUSH];
+}
+
+- (NSData*)finish
+{
+    if (_finished)
+        return [NSData data];
+    
+    _finished = YES;
+    
+    return [self _deflateBytes:NULL length:0 flush:Z_FINISH];
+}
+
+#pragma mark Private Methods
+
+- (NSData*)_deflateBytes:(const void*)bytes length:(NSUInteger)length flush:(int)flush
+{
+    NSMutableData *output = [NSMutableData data];
+    uint8_t buffer[AMDataCompressorBufferSize];
+    
+    _stream.next_in = (Bytef*)bytes;
+    
+    // avail_in is 32 bits wide, longer inputs are compressed in pieces.
+    while (YES)
+    {
+        uInt chunkLength = (uInt)MIN(length, (NSUInteger)UINT_MAX);
+        int chunkFlush = chunkLength == length ? flush : Z_NO_FLUSH;
+        
+        _stream.avail_in = chunkLength;
+        length -= chunkLength;
+        
+        int status = Z_OK;
+        
+        do
+        {
+            _stream.next_out = buffer;
+            _stream.avail_out = sizeof(buffer);
+            
+            status = deflate(&_stream, chunkFlush);
+            
+            [output appendBytes:buffer length:sizeof(buffer) - _stream.avail_out];
+        }
+        while (_stream.avail_out == 0 && status == Z_OK);
+        
+        if (length == 0)
+            break;
+    }
+    
+    return output;
+}
+
+@end
@@ -0,0 +1,76 @@
+//
+//  AMHedgedRequest.h
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import <Foundation/Foundation.h>
+
+@class AMAsyncConnectionOperation;
+
+/*!
+ * A request performed by up to two connection operations: the primary one and, if the primary is slow, a hedge. The first one to succeed is delivered and the other one is cancelled.
+ * @discussion The completion is called once. When an attempt fails while the other one is still running, the failure is kept and only delivered if the other attempt fails too. The request holds its operations weakly; the operations keep it alive through their completion blocks.
+ */
+@interface AMHedgedRequest : NSObject
+
+/*!
+ * Default initializer.
+ * @param completion The block called with the result of the request.
+ * @param hedgeWinBlock The block called when the hedge succeeds before the primary operation. It can be nil.
+ */
+- (id)initWithCompletion:(void (^)(NSURLResponse* response, NSData* data, NSError* error))completion hedgeWinBlock:(void (^)(void))hedgeWinBlock;
+
+/*!
+ * Returns a completion block for the primary operation. The block retains the receiver.
+ * @return A new block.
+ */
+- (void (^)(NSURLResponse* response, NSData* data, NSError* error))primaryCompletion;
+
+/*!
+ * Returns a completion block for the hedge operation. The block retains the receiver.
+ * @return A new block.
+ */
+- (void (^)(NSURLResponse* response, NSData* data, NSError* error))hedgeCompletion;
+
+/*!
+ * The primary operation.
+ */
+@property (nonatomic, weak) AMAsyncConnectionOperation *primaryOperation;
+
+/*!
+ * The hedge operation, or nil if the request has not been hedged.
+ */
+@property (nonatomic, weak, readonly) AMAsyncConnectionOperation *hedgeOperation;
+
+/*!
+ * Registers the hedge operation, before it is performed.
+ * @param operation The operation, performing the same request with the `hedgeCompletion` block.
+ * @return YES if the hedge can be performed; NO if the request has already been hedged or has finished.
+ */
+- (BOOL)beginHedgeWithOperation:(AMAsyncConnectionOperation*)operation;
+
+/*!
+ * Tells the request that one of its operations has been cancelled. Cancelling the primary operation cancels the hedge too, unless the result of the request has already been delivered.
+ * @param operation The cancelled operation.
+ */
+- (void)connectionOperationWasCancelled:(AMAsyncConnectionOperation*)operation;
+
+@end
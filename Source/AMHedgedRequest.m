@@ -0,0 +1,183 @@
+//
+//  AMHedgedRequest.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMHedgedRequest.h"
+
+#import "AMAsyncConnectionOperation.h"
+
+#import <pthread.h>
+
+@implementation AMHedgedRequest
+{
+    pthread_mutex_t _lock;
+    
+    void (^_completion)(NSURLResponse* response, NSData* data, NSError* error);
+    void (^_hedgeWinBlock)(void);
+    
+    BOOL _finished;
+    BOOL _primaryDone;
+    BOOL _hedgeIssued;
+    BOOL _hedgeDone;
+    
+    // The failure of an attempt, kept while the other attempt is running.
+    BOOL _hasFailure;
+    NSURLResponse *_failureResponse;
+    NSData *_failureData;
+    NSError *_failureError;
+}
+
+- (id)init
+{
+    return [self initWithCompletion:nil hedgeWinBlock:nil];
+}
+
+- (id)initWithCompletion:(void (^)(NSURLResponse* response, NSData* data, NSError* error))completion hedgeWinBlock:(void (^)(void))hedgeWinBlock
+{
+    self = [super init];
+    if (self)
+    {
+        pthread_mutex_init(&_lock, NULL);
+        
+        _completion = completion;
+        _hedgeWinBlock = hedgeWinBlock;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    pthread_mutex_destroy(&_lock);
+}
+
+#pragma mark Public Methods
+
+- (void (^)(NSURLResponse* response, NSData* data, NSError* error))primaryCompletion
+{
+    // Only the operations retain the blocks, so the request lives as long as one of its operations.
+    return ^(NSURLResponse* response, NSData* data, NSError* error) {
+        [self _attemptDidCompleteAsHedge:NO response:response data:data error:error];
+    };
+}
+
+- (void (^)(NSURLResponse* response, NSData* data, NSError* error))hedgeCompletion
+{
+    return ^(NSURLResponse* response, NSData* data, NSError* error) {
+        [self _attemptDidCompleteAsHedge:YES response:response data:data error:error];
+    };
+}
+
+- (BOOL)beginHedgeWithOperation:(AMAsyncConnectionOperation*)operation
+{
+    pthread_mutex_lock(&_lock);
+    
+    BOOL canHedge = !_finished && !_primaryDone && !_hedgeIssued;
+    
+    if (canHedge)
+    {
+        _hedgeIssued = YES;
+        _hedgeOperation = operation;
+    }
+    
+    pthread_mutex_unlock(&_lock);
+    
+    return canHedge;
+}
+
+- (void)connectionOperationWasCancelled:(AMAsyncConnectionOperation*)operation
+{
+    if (operation == _primaryOperation)
+    {
+        // Cancelled through its key or dropped because of its deadline, the request is abandoned and so is the hedge. Once a
+        // result has been delivered, the primary operation is the loser cancelled by the winning hedge, which must not be cancelled.
+        pthread_mutex_lock(&_lock);
+        AMAsyncConnectionOperation *hedgeOperation = _finished ? nil : _hedgeOperation;
+        pthread_mutex_unlock(&_lock);
+        
+        [hedgeOperation cancel];
+        return;
+    }
+    
+    pthread_mutex_lock(&_lock);
+    
+    if (_finished || !_hedgeIssued || _hedgeDone)
+    {
+        pthread_mutex_unlock(&_lock);
+        return;
+    }
+    
+    // The hedge will not complete. If the primary operation has already failed, its failure is the result.
+    _hedgeDone = YES;
+    BOOL deliversFailure = _hasFailure;
+    _finished = deliversFailure;
+    
+    pthread_mutex_unlock(&_lock);
+    
+    if (deliversFailure && _completion)
+        _completion(_failureResponse, _failureData, _failureError);
+}
+
+#pragma mark Private Methods
+
+- (void)_attemptDidCompleteAsHedge:(BOOL)isHedge response:(NSURLResponse*)response data:(NSData*)data error:(NSError*)error
+{
+    pthread_mutex_lock(&_lock);
+    
+    if (_finished)
+    {
+        pthread_mutex_unlock(&_lock);
+        return;
+    }
+    
+    if (isHedge)
+        _hedgeDone = YES;
+    else
+        _primaryDone = YES;
+    
+    BOOL otherAttemptRunning = isHedge ? !_primaryDone : (_hedgeIssued && !_hedgeDone);
+    
+    if (error && otherAttemptRunning)
+    {
+        _hasFailure = YES;
+        _failureResponse = response;
+        _failureData = data;
+        _failureError = error;
+        
+        pthread_mutex_unlock(&_lock);
+        return;
+    }
+    
+    _finished = YES;
+    AMAsyncConnectionOperation *loser = otherAttemptRunning ? (isHedge ? _primaryOperation : _hedgeOperation) : nil;
+    
+    pthread_mutex_unlock(&_lock);
+    
+    [loser cancel];
+    
+    if (isHedge && !error && _hedgeWinBlock)
+        _hedgeWinBlock();
+    
+    if (_completion)
+        _completion(response, data, error);
+}
+
+@end
@@ -0,0 +1,112 @@
+//
+//  AMHedgingPolicy.h
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import <Foundation/Foundation.h>
+
+@class AMTokenBucket;
+@class AMConnectionMetrics;
+
+/*!
+ * Describes when slow requests are hedged: if a request hasn't received a response after a delay, a second identical connection is started and the first one to succeed is delivered, cancelling the other one.
+ * @discussion The delay is either fixed or taken from a percentile of the time to first byte of the host, so only the slowest requests are hedged. Only idempotent requests without a body stream are hedged.
+ *
+ * Each request earns `budgetRatio` tokens of the `hedgeBudget` and each hedge takes one, so hedges add at most a `budgetRatio` fraction of extra connections (plus the bursts allowed by the capacity of the budget), even when a server becomes slow for all the requests.
+ *
+ * Configure the policy before using it. The same policy can be shared by many queues.
+ */
+@interface AMHedgingPolicy : NSObject
+
+/*!
+ * Returns a policy with the default values.
+ * @return A new policy.
+ */
++ (AMHedgingPolicy*)defaultPolicy;
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Hedge delay
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * The time waiting for the response before hedging a request. Default value is 0: the delay is the `percentile` of the time to first byte of the host.
+ */
+@property (nonatomic, assign) NSTimeInterval delay;
+
+/*!
+ * The percentile of the time to first byte of the host used as delay when `delay` is 0, from 0.0 to 100.0. Default value is 95.0.
+ */
+@property (nonatomic, assign) double percentile;
+
+/*!
+ * The minimum number of connections to the host needed to use its percentile. Until then, `maximumDelay` is used. Default value is 20.
+ */
+@property (nonatomic, assign) NSUInteger minimumSampleCount;
+
+/*!
+ * The lower bound of the delay taken from the percentile, so fast hosts are not hedged on every small hiccup. Default value is 0.05 seconds.
+ */
+@property (nonatomic, assign) NSTimeInterval minimumDelay;
+
+/*!
+ * The upper bound of the delay taken from the percentile. Default value is 2 seconds.
+ */
+@property (nonatomic, assign) NSTimeInterval maximumDelay;
+
+/*!
+ * If NO (the default), only requests with idempotent methods (GET, HEAD, OPTIONS, TRACE, PUT and DELETE) are hedged.
+ */
+@property (nonatomic, assign) BOOL hedgesNonIdempotentRequests;
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Hedge budget
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * The tokens earned by the budget for each hedgeable request. Default value is 0.1 (at most one hedge every 10 requests).
+ */
+@property (nonatomic, assign) double budgetRatio;
+
+/*!
+ * Each hedge takes one token from this bucket, and requests are not hedged when the bucket is empty. By default, a bucket of 10 tokens that is only refilled by `budgetRatio`. Set to nil to disable the budget.
+ */
+@property (nonatomic, strong) AMTokenBucket *hedgeBudget;
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Evaluating the policy
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * Returns the time to wait for the response before hedging a request.
+ * @param request The request.
+ * @param metrics The metrics with the time to first byte of the host of the request, or nil if unknown.
+ * @return The delay in seconds, or a negative value if the request must not be hedged.
+ * @discussion If the request can be hedged, the hedge budget earns `budgetRatio` tokens. The metrics are only read for requests that can be hedged, when `delay` is 0.
+ */
+- (NSTimeInterval)hedgeDelayForRequest:(NSURLRequest*)request metrics:(AMConnectionMetrics*)metrics;
+
+/*!
+ * Takes a token from the hedge budget.
+ * @return YES if a hedge can be started.
+ */
+- (BOOL)consumeHedgeToken;
+
+@end
@@ -0,0 +1,105 @@
+//
+//  AMHedgingPolicy.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMHedgingPolicy.h"
+
+#import "AMTokenBucket.h"
+#import "AMConnectionMetrics.h"
+
+#import <dispatch/dispatch.h>
+
+@implementation AMHedgingPolicy
+
++ (AMHedgingPolicy*)defaultPolicy
+{
+    return [[AMHedgingPolicy alloc] init];
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self)
+    {
+        _delay = 0;
+        _percentile = 95.0;
+        _minimumSampleCount = 20;
+        _minimumDelay = 0.05;
+        _maximumDelay = 2.0;
+        _hedgesNonIdempotentRequests = NO;
+        
+        _budgetRatio = 0.1;
+        _hedgeBudget = [[AMTokenBucket alloc] initWithCapacity:10.0 refillRate:0.0];
+    }
+    return self;
+}
+
+#pragma mark Public Methods
+
+- (NSTimeInterval)hedgeDelayForRequest:(NSURLRequest*)request metrics:(AMConnectionMetrics*)metrics
+{
+    if (![self _isHedgeableRequest:request])
+        return -1;
+    
+    [_hedgeBudget depositTokens:_budgetRatio];
+    
+    if (_delay > 0)
+        return _delay;
+    
+    // Read from the live histogram of the host: this runs for every request submitted to the queue.
+    unsigned long long sampleCount = 0;
+    NSTimeInterval timeToFirstByte = [metrics timeToFirstByteAtPercentile:_percentile forHost:request.URL.host sampleCount:&sampleCount];
+    
+    if (sampleCount < _minimumSampleCount)
+        return _maximumDelay;
+    
+    return MIN(MAX(timeToFirstByte, _minimumDelay), _maximumDelay);
+}
+
+- (BOOL)consumeHedgeToken
+{
+    return !_hedgeBudget || [_hedgeBudget consumeTokens:1.0];
+}
+
+#pragma mark Private Methods
+
+- (BOOL)_isHedgeableRequest:(NSURLRequest*)request
+{
+    // A body stream can only be read once.
+    if (request.HTTPBodyStream)
+        return NO;
+    
+    if (_hedgesNonIdempotentRequests)
+        return YES;
+    
+    static NSSet *idempotentMethods = nil;
+    static dispatch_once_t pred = 0;
+    dispatch_once(&pred, ^{
+        idempotentMethods = [NSSet setWithObjects:@"GET", @"HEAD", @"OPTIONS", @"TRACE", @"PUT", @"DELETE", nil];
+    });
+    
+    NSString *method = [request.HTTPMethod uppercaseString] ?: @"GET";
+    
+    return [idempotentMethods containsObject:method];
+}
+
+@end
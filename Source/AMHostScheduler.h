@@ -0,0 +1,101 @@
+//
+//  AMHostScheduler.h
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import <Foundation/Foundation.h>
+
+/*!
+ * A request for a connection slot in the host scheduler.
+ */
+@interface AMHostSchedulerTicket : NSObject
+
+/*!
+ * Default initializer.
+ * @param host The host the connection is going to be performed against.
+ * @param priority The priority of the connection.
+ * @param grantBlock The block called when the slot is granted, if it is not granted immediately.
+ */
+- (id)initWithHost:(NSString*)host priority:(NSOperationQueuePriority)priority grantBlock:(void (^)(void))grantBlock;
+
+/*!
+ * The host the connection is going to be performed against.
+ */
+@property (nonatomic, strong, readonly) NSString *host;
+
+/*!
+ * The priority of the connection.
+ */
+@property (nonatomic, assign, readonly) NSOperationQueuePriority priority;
+
+/*!
+ * The absolute time (see -[NSDate timeIntervalSinceReferenceDate]) when the connection must have finished, or 0 if the connection has no deadline. Set it before acquiring the slot.
+ * @discussion Between connections with the same priority, those with an earlier deadline go first.
+ */
+@property (nonatomic, assign) NSTimeInterval deadline;
+
+@end
+
+/*!
+ * This class limits the number of concurrent connections globally and per host, on top of the limits of each queue.
+ * @discussion When a slot is released, the waiting connections are dispatched fairly between hosts: the waiting connection with the highest priority goes first, then the one with the earliest deadline, and hosts with waiting connections of the same priority and no deadline are served round-robin.
+ */
+@interface AMHostScheduler : NSObject
+
+/*!
+ * The maximum number of concurrent connections. Default value is -1 (no limit).
+ */
+@property (nonatomic, assign) NSInteger maximumConnectionCount;
+
+/*!
+ * The maximum number of concurrent connections for each host. Default value is -1 (no limit).
+ */
+@property (nonatomic, assign) NSInteger maximumConnectionCountPerHost;
+
+/*!
+ * Sets the maximum number of concurrent connections for a specific host.
+ * @param count The maximum number of connections. Specify -1 to use the value of maximumConnectionCountPerHost.
+ * @param host The host.
+ */
+- (void)setMaximumConnectionCount:(NSInteger)count forHost:(NSString*)host;
+
+/*!
+ * Asks for a connection slot.
+ * @param ticket The ticket.
+ * @return YES if the slot is granted immediately, otherwise NO. In this case, the ticket is queued and its grant block is called when the slot is granted.
+ */
+- (BOOL)acquireSlotWithTicket:(AMHostSchedulerTicket*)ticket;
+
+/*!
+ * Releases the slot of the given ticket or removes it from the waiting tickets if the slot has not been granted yet.
+ * @param ticket The ticket.
+ * @discussion Calling this method more than once for the same ticket does nothing.
+ */
+- (void)releaseSlotWithTicket:(AMHostSchedulerTicket*)ticket;
+
+/*!
+ * Returns YES if a connection with a priority higher than the given one is waiting for a slot.
+ * @param priority The priority.
+ * @return YES if such a connection is waiting, otherwise NO.
+ */
+- (BOOL)hasWaitingTicketWithPriorityHigherThan:(NSOperationQueuePriority)priority;
+
+@end
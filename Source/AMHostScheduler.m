@@ -0,0 +1,358 @@
+//
+//  AMHostScheduler.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMHostScheduler.h"
+
+#import <pthread.h>
+
+typedef NS_ENUM(NSInteger, AMHostSchedulerTicketState)
+{
+    AMHostSchedulerTicketStateIdle,
+    AMHostSchedulerTicketStateWaiting,
+    AMHostSchedulerTicketStateGranted,
+    AMHostSchedulerTicketStateReleased
+};
+
+static BOOL AMHostSchedulerTicketPrecedesTicket(AMHostSchedulerTicket *ticket, AMHostSchedulerTicket *otherTicket)
+{
+    if (ticket.priority != otherTicket.priority)
+        return ticket.priority > otherTicket.priority;
+    
+    // Earliest deadline first within the same priority. Tickets without deadline go last.
+    if (ticket.deadline > 0)
+        return otherTicket.deadline <= 0 || ticket.deadline < otherTicket.deadline;
+    
+    return NO;
+}
+
+@interface AMHostSchedulerTicket ()
+
+@property (nonatomic, strong) void (^grantBlock)(void);
+@property (nonatomic, assign) AMHostSchedulerTicketState state;
+
+@end
+
+@implementation AMHostSchedulerTicket
+
+- (id)initWithHost:(NSString*)host priority:(NSOperationQueuePriority)priority grantBlock:(void (^)(void))grantBlock
+{
+    self = [super init];
+    if (self)
+    {
+        _host = [host lowercaseString] ?: @"";
+        _priority = priority;
+        _grantBlock = grantBlock;
+        _state = AMHostSchedulerTicketStateIdle;
+    }
+    return self;
+}
+
+@end
+
+@implementation AMHostScheduler
+{
+    pthread_mutex_t _lock;
+    
+    NSInteger _activeCount;
+    NSMutableDictionary *_activeCounts;
+    NSMutableDictionary *_hostLimits;
+    
+    NSMutableDictionary *_waitingTickets;
+    NSMutableArray *_waitingHosts;
+    NSUInteger _nextHostIndex;
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self)
+    {
+        pthread_mutex_init(&_lock, NULL);
+        
+        _maximumConnectionCount = -1;
+        _maximumConnectionCountPerHost = -1;
+        
+        _activeCount = 0;
+        _activeCounts = [NSMutableDictionary dictionary];
+        _hostLimits = [NSMutableDictionary dictionary];
+        
+        _waitingTickets = [NSMutableDictionary dictionary];
+        _waitingHosts = [NSMutableArray array];
+        _nextHostIndex = 0;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    pthread_mutex_destroy(&_lock);
+}
+
+#pragma mark Properties
+
+- (void)setMaximumConnectionCount:(NSInteger)maximumConnectionCount
+{
+    pthread_mutex_lock(&_lock);
+    _maximumConnectionCount = maximumConnectionCount;
+    NSArray *grantedTickets = [self _dequeueGrantableTickets];
+    pthread_mutex_unlock(&_lock);
+    
+    [self _grantTickets:grantedTickets];
+}
+
+- (void)setMaximumConnectionCountPerHost:(NSInteger)maximumConnectionCountPerHost
+{
+    pthread_mutex_lock(&_lock);
+    _maximumConnectionCountPerHost = maximumConnectionCountPerHost;
+    NSArray *grantedTickets = [self _dequeueGrantableTickets];
+    pthread_mutex_unlock(&_lock);
+    
+    [self _grantTickets:grantedTickets];
+}
+
+#pragma mark Public Methods
+
+- (void)setMaximumConnectionCount:(NSInteger)count forHost:(NSString*)host
+{
+    host = [host lowercaseString] ?: @"";
+    
+    pthread_mutex_lock(&_lock);
+    
+    if (count < 0)
+        [_hostLimits removeObjectForKey:host];
+    else
+        [_hostLimits setObject:@(count) forKey:host];
+    
+    NSArray *grantedTickets = [self _dequeueGrantableTickets];
+    
+    pthread_mutex_unlock(&_lock);
+    
+    [self _grantTickets:grantedTickets];
+}
+
+- (BOOL)acquireSlotWithTicket:(AMHostSchedulerTicket*)ticket
+{
+    pthread_mutex_lock(&_lock);
+    
+    if (ticket.state == AMHostSchedulerTicketStateIdle)
+    {
+        // Waiting tickets of the same host imply the host is full: the new ticket never overtakes them.
+        if ([self _hasGlobalCapacity] && [self _hasCapacityForHost:ticket.host])
+            [self _grantTicket:ticket];
+        else
+            [self _enqueueTicket:ticket];
+    }
+    
+    BOOL granted = ticket.state == AMHostSchedulerTicketStateGranted;
+    
+    pthread_mutex_unlock(&_lock);
+    
+    return granted;
+}
+
+- (void)releaseSlotWithTicket:(AMHostSchedulerTicket*)ticket
+{
+    NSArray *grantedTickets = nil;
+    
+    pthread_mutex_lock(&_lock);
+    
+    if (ticket.state == AMHostSchedulerTicketStateWaiting)
+    {
+        [self _dequeueTicket:ticket];
+    }
+    else if (ticket.state == AMHostSchedulerTicketStateGranted)
+    {
+        _activeCount--;
+        [_activeCounts setObject:@([self _activeCountForHost:ticket.host] - 1) forKey:ticket.host];
+        
+        grantedTickets = [self _dequeueGrantableTickets];
+    }
+    
+    ticket.state = AMHostSchedulerTicketStateReleased;
+    
+    pthread_mutex_unlock(&_lock);
+    
+    [self _grantTickets:grantedTickets];
+}
+
+- (BOOL)hasWaitingTicketWithPriorityHigherThan:(NSOperationQueuePriority)priority
+{
+    BOOL waiting = NO;
+    
+    pthread_mutex_lock(&_lock);
+    
+    // The tickets of each host are sorted by priority: only the first one needs to be checked.
+    for (NSArray *tickets in [_waitingTickets objectEnumerator])
+    {
+        AMHostSchedulerTicket *ticket = [tickets firstObject];
+        
+        if (ticket && ticket.priority > priority)
+        {
+            waiting = YES;
+            break;
+        }
+    }
+    
+    pthread_mutex_unlock(&_lock);
+    
+    return waiting;
+}
+
+#pragma mark Private Methods
+
+// All private methods but -_grantTickets: must be called while holding the lock.
+
+- (NSInteger)_activeCountForHost:(NSString*)host
+{
+    return [[_activeCounts objectForKey:host] integerValue];
+}
+
+- (BOOL)_hasGlobalCapacity
+{
+    return _maximumConnectionCount < 0 || _activeCount < _maximumConnectionCount;
+}
+
+- (BOOL)_hasCapacityForHost:(NSString*)host
+{
+    NSNumber *hostLimit = [_hostLimits objectForKey:host];
+    NSInteger limit = hostLimit ? [hostLimit integerValue] : _maximumConnectionCountPerHost;
+    
+    return limit < 0 || [self _activeCountForHost:host] < limit;
+}
+
+- (void)_grantTicket:(AMHostSchedulerTicket*)ticket
+{
+    ticket.state = AMHostSchedulerTicketStateGranted;
+    
+    _activeCount++;
+    [_activeCounts setObject:@([self _activeCountForHost:ticket.host] + 1) forKey:ticket.host];
+}
+
+- (void)_enqueueTicket:(AMHostSchedulerTicket*)ticket
+{
+    ticket.state = AMHostSchedulerTicketStateWaiting;
+    
+    NSMutableArray *tickets = [_waitingTickets objectForKey:ticket.host];
+    
+    if (!tickets)
+    {
+        tickets = [NSMutableArray array];
+        [_waitingTickets setObject:tickets forKey:ticket.host];
+        [_waitingHosts addObject:ticket.host];
+    }
+    
+    // Sorted by priority and deadline, FIFO between equivalent tickets.
+    NSUInteger index = tickets.count;
+    while (index > 0 && AMHostSchedulerTicketPrecedesTicket(ticket, [tickets objectAtIndex:index - 1]))
+        index--;
+    
+    [tickets insertObject:ticket atIndex:index];
+}
+
+- (void)_dequeueTicket:(AMHostSchedulerTicket*)ticket
+{
+    NSMutableArray *tickets = [_waitingTickets objectForKey:ticket.host];
+    [tickets removeObjectIdenticalTo:ticket];
+    
+    if (tickets.count == 0)
+    {
+        NSUInteger hostIndex = [_waitingHosts indexOfObject:ticket.host];
+        
+        if (hostIndex != NSNotFound)
+        {
+            [_waitingHosts removeObjectAtIndex:hostIndex];
+            
+            if (hostIndex < _nextHostIndex)
+                _nextHostIndex--;
+        }
+        
+        [_waitingTickets removeObjectForKey:ticket.host];
+    }
+}
+
+- (AMHostSchedulerTicket*)_nextGrantableTicket
+{
+    NSUInteger hostCount = _waitingHosts.count;
+    AMHostSchedulerTicket *nextTicket = nil;
+    NSUInteger nextHostIndex = 0;
+    
+    // Round-robin between hosts, starting after the last served one. Higher priorities and earlier deadlines go first.
+    for (NSUInteger i=0; i<hostCount; ++i)
+    {
+        NSUInteger hostIndex = (_nextHostIndex + i) % hostCount;
+        NSString *host = [_waitingHosts objectAtIndex:hostIndex];
+        
+        if (![self _hasCapacityForHost:host])
+            continue;
+        
+        AMHostSchedulerTicket *ticket = [[_waitingTickets objectForKey:host] firstObject];
+        
+        if (!nextTicket || AMHostSchedulerTicketPrecedesTicket(ticket, nextTicket))
+        {
+            nextTicket = ticket;
+            nextHostIndex = hostIndex;
+        }
+    }
+    
+    if (nextTicket)
+        _nextHostIndex = nextHostIndex + 1;
+    
+    return nextTicket;
+}
+
+- (NSArray*)_dequeueGrantableTickets
+{
+    NSMutableArray *grantedTickets = nil;
+    
+    while ([self _hasGlobalCapacity])
+    {
+        AMHostSchedulerTicket *ticket = [self _nextGrantableTicket];
+        
+        if (!ticket)
+            break;
+        
+        [self _dequeueTicket:ticket];
+        [self _grantTicket:ticket];
+        
+        if (!grantedTickets)
+            grantedTickets = [NSMutableArray array];
+        
+        [grantedTickets addObject:ticket];
+    }
+    
+    return grantedTickets;
+}
+
+- (void)_grantTickets:(NSArray*)tickets
+{
+    // Called without holding the lock.
+    for (AMHostSchedulerTicket *ticket in tickets)
+    {
+        if (ticket.grantBlock)
+            ticket.grantBlock();
+        
+        ticket.grantBlock = nil;
+    }
+}
+
+@end
@@ -0,0 +1,109 @@
+//
+//  AMLatencyHistogram.h
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import <Foundation/Foundation.h>
+
+/*!
+ * Immutable copy of the values recorded by an AMLatencyHistogram.
+ */
+@interface AMLatencyHistogramSnapshot : NSObject
+
+/*!
+ * The number of recorded values.
+ */
+@property (nonatomic, assign, readonly) unsigned long long count;
+
+/*!
+ * The minimum recorded value, in seconds. Zero if there are no values.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval minimum;
+
+/*!
+ * The maximum recorded value, in seconds. Zero if there are no values.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval maximum;
+
+/*!
+ * The mean of the recorded values, in seconds. Zero if there are no values.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval mean;
+
+/*!
+ * Returns the value below which the given percentage of the recorded values fall.
+ * @param percentile The percentile, from 0.0 to 100.0.
+ * @return The value in seconds, with a relative error lower than 7%. Zero if there are no values.
+ */
+- (NSTimeInterval)valueAtPercentile:(double)percentile;
+
+/*!
+ * Returns a dictionary with the count, minimum, maximum, mean and the 50th, 90th, 99th and 99.9th percentiles, in seconds.
+ * @return A dictionary that can be serialized with NSJSONSerialization and NSPropertyListSerialization.
+ */
+- (NSDictionary*)dictionaryRepresentation;
+
+@end
+
+/*!
+ * Lock-free histogram of durations.
+ * @discussion Values are stored with microsecond resolution in logarithmic buckets, each one split in 16 linear sub-buckets, so the histogram has a fixed size while keeping a relative error lower than 7% from microseconds to days. Recording a value only performs a few atomic operations; it can be called concurrently from any thread.
+ */
+@interface AMLatencyHistogram : NSObject
+
+/*!
+ * Records a value.
+ * @param latency The value in seconds. Negative values are recorded as zero.
+ */
+- (void)recordLatency:(NSTimeInterval)latency;
+
+/*!
+ * Records a value.
+ * @param microseconds The value in microseconds.
+ */
+- (void)recordMicroseconds:(uint64_t)microseconds;
+
+/*!
+ * The number of recorded values.
+ */
+@property (nonatomic, assign, readonly) unsigned long long count;
+
+/*!
+ * Returns the value below which the given percentage of the recorded values fall, without taking a snapshot.
+ * @param percentile The percentile, from 0.0 to 100.0.
+ * @return The value in seconds, with a relative error lower than 7%. Zero if there are no values.
+ * @discussion Like a snapshot, the values being recorded concurrently may be only partially included.
+ */
+- (NSTimeInterval)valueAtPercentile:(double)percentile;
+
+/*!
+ * Returns a copy of the recorded values.
+ * @return The snapshot.
+ * @discussion The snapshot is taken without stopping the threads recording values, so values being recorded concurrently may be only partially included.
+ */
+- (AMLatencyHistogramSnapshot*)snapshot;
+
+/*!
+ * Removes all the recorded values.
+ */
+- (void)reset;
+
+@end
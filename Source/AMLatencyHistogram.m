@@ -0,0 +1,238 @@
+//
+//  AMLatencyHistogram.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMLatencyHistogram.h"
+
+#import <stdatomic.h>
+
+// Values below 2^AMLatencyHistogramSubBucketBits are stored exactly. Above that, each power of two is split in
+// 2^AMLatencyHistogramSubBucketBits linear sub-buckets.
+#define AMLatencyHistogramSubBucketBits 4
+#define AMLatencyHistogramSubBucketCount (1 << AMLatencyHistogramSubBucketBits)
+#define AMLatencyHistogramBucketCount ((64 - AMLatencyHistogramSubBucketBits + 1) * AMLatencyHistogramSubBucketCount)
+
+static NSUInteger AMLatencyHistogramIndexForValue(uint64_t value)
+{
+    if (value < AMLatencyHistogramSubBucketCount)
+        return (NSUInteger)value;
+    
+    int magnitude = 63 - __builtin_clzll(value);
+    int shift = magnitude - AMLatencyHistogramSubBucketBits;
+    uint64_t subBucket = (value >> shift) - AMLatencyHistogramSubBucketCount;
+    
+    return (NSUInteger)((shift + 1) * AMLatencyHistogramSubBucketCount + subBucket);
+}
+
+static uint64_t AMLatencyHistogramValueForIndex(NSUInteger index)
+{
+    // Returns the middle of the bucket.
+    if (index < AMLatencyHistogramSubBucketCount)
+        return index;
+    
+    int shift = (int)(index / AMLatencyHistogramSubBucketCount) - 1;
+    uint64_t subBucket = (index % AMLatencyHistogramSubBucketCount) + AMLatencyHistogramSubBucketCount;
+    
+    return (subBucket << shift) + ((1ULL << shift) >> 1);
+}
+
+static NSTimeInterval AMLatencyHistogramValueAtPercentile(const uint64_t *counts, double percentile, NSTimeInterval minimum, NSTimeInterval maximum)
+{
+    // The bucket counts and the total count are read separately, so use the sum of the buckets.
+    uint64_t total = 0;
+    for (NSUInteger i = 0; i < AMLatencyHistogramBucketCount; ++i)
+        total += counts[i];
+    
+    if (total == 0)
+        return 0.0;
+    
+    percentile = MIN(MAX(percentile, 0.0), 100.0);
+    
+    uint64_t target = (uint64_t)ceil((percentile / 100.0) * (double)total);
+    target = MAX(target, 1ULL);
+    
+    uint64_t accumulated = 0;
+    for (NSUInteger i = 0; i < AMLatencyHistogramBucketCount; ++i)
+    {
+        accumulated += counts[i];
+        
+        if (accumulated >= target)
+        {
+            NSTimeInterval value = AMLatencyHistogramValueForIndex(i) / 1e6;
+            return MIN(MAX(value, minimum), maximum);
+        }
+    }
+    
+    return maximum;
+}
+
+@interface AMLatencyHistogramSnapshot ()
+
+- (id)initWithCounts:(uint64_t*)counts count:(uint64_t)count minimum:(uint64_t)minimum maximum:(uint64_t)maximum sum:(uint64_t)sum;
+
+@end
+
+@implementation AMLatencyHistogramSnapshot
+{
+    uint64_t *_counts;
+}
+
+- (id)initWithCounts:(uint64_t*)counts count:(uint64_t)count minimum:(uint64_t)minimum maximum:(uint64_t)maximum sum:(uint64_t)sum
+{
+    // Takes ownership of the counts buffer.
+    self = [super init];
+    if (self)
+    {
+        _counts = counts;
+        _count = count;
+        _minimum = count > 0 ? minimum / 1e6 : 0.0;
+        _maximum = maximum / 1e6;
+        _mean = count > 0 ? ((double)sum / (double)count) / 1e6 : 0.0;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_counts);
+}
+
+#pragma mark Public Methods
+
+- (NSTimeInterval)valueAtPercentile:(double)percentile
+{
+    return AMLatencyHistogramValueAtPercentile(_counts, percentile, _minimum, _maximum);
+}
+
+- (NSDictionary*)dictionaryRepresentation
+{
+    return @{@"count": @(_count),
+             @"min": @(_minimum),
+             @"max": @(_maximum),
+             @"mean": @(_mean),
+             @"p50": @([self valueAtPercentile:50.0]),
+             @"p90": @([self valueAtPercentile:90.0]),
+             @"p99": @([self valueAtPercentile:99.0]),
+             @"p999": @([self valueAtPercentile:99.9]),
+             };
+}
+
+- (NSString*)description
+{
+    return [NSString stringWithFormat:@"%@ - %@", [super description], [[self dictionaryRepresentation] description]];
+}
+
+@end
+
+@implementation AMLatencyHistogram
+{
+    atomic_ullong _counts[AMLatencyHistogramBucketCount];
+    
+    atomic_ullong _count;
+    atomic_ullong _sum;
+    atomic_ullong _minimum;
+    atomic_ullong _maximum;
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self)
+    {
+        for (NSUInteger i = 0; i < AMLatencyHistogramBucketCount; ++i)
+            atomic_init(&_counts[i], 0);
+        
+        atomic_init(&_count, 0);
+        atomic_init(&_sum, 0);
+        atomic_init(&_minimum, UINT64_MAX);
+        atomic_init(&_maximum, 0);
+    }
+    return self;
+}
+
+#pragma mark Properties
+
+- (unsigned long long)count
+{
+    return atomic_load_explicit(&_count, memory_order_relaxed);
+}
+
+#pragma mark Public Methods
+
+- (void)recordLatency:(NSTimeInterval)latency
+{
+    [self recordMicroseconds:latency > 0 ? (uint64_t)(latency * 1e6) : 0];
+}
+
+- (void)recordMicroseconds:(uint64_t)microseconds
+{
+    atomic_fetch_add_explicit(&_counts[AMLatencyHistogramIndexForValue(microseconds)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_sum, microseconds, memory_order_relaxed);
+    
+    unsigned long long minimum = atomic_load_explicit(&_minimum, memory_order_relaxed);
+    while (microseconds < minimum && !atomic_compare_exchange_weak_explicit(&_minimum, &minimum, microseconds, memory_order_relaxed, memory_order_relaxed));
+    
+    unsigned long long maximum = atomic_load_explicit(&_maximum, memory_order_relaxed);
+    while (microseconds > maximum && !atomic_compare_exchange_weak_explicit(&_maximum, &maximum, microseconds, memory_order_relaxed, memory_order_relaxed));
+}
+
+- (AMLatencyHistogramSnapshot*)snapshot
+{
+    uint64_t *counts = malloc(sizeof(uint64_t) * AMLatencyHistogramBucketCount);
+    
+    for (NSUInteger i = 0; i < AMLatencyHistogramBucketCount; ++i)
+        counts[i] = atomic_load_explicit(&_counts[i], memory_order_relaxed);
+    
+    return [[AMLatencyHistogramSnapshot alloc] initWithCounts:counts
+                                                        count:atomic_load_explicit(&_count, memory_order_relaxed)
+                                                      minimum:atomic_load_explicit(&_minimum, memory_order_relaxed)
+                                                      maximum:atomic_load_explicit(&_maximum, memory_order_relaxed)
+                                                          sum:atomic_load_explicit(&_sum, memory_order_relaxed)];
+}
+
+- (NSTimeInterval)valueAtPercentile:(double)percentile
+{
+    // Reads the buckets into the stack instead of allocating a snapshot.
+    uint64_t counts[AMLatencyHistogramBucketCount];
+    
+    for (NSUInteger i = 0; i < AMLatencyHistogramBucketCount; ++i)
+        counts[i] = atomic_load_explicit(&_counts[i], memory_order_relaxed);
+    
+    uint64_t minimum = atomic_load_explicit(&_minimum, memory_order_relaxed);
+    uint64_t maximum = atomic_load_explicit(&_maximum, memory_order_relaxed);
+    
+    return AMLatencyHistogramValueAtPercentile(counts, percentile, minimum <= maximum ? minimum / 1e6 : 0.0, maximum / 1e6);
+}
+
+- (void)reset
+{
+    for (NSUInteger i = 0; i < AMLatencyHistogramBucketCount; ++i)
+        atomic_store_explicit(&_counts[i], 0, memory_order_relaxed);
+    
+    atomic_store_explicit(&_count, 0, memory_order_relaxed);
+    atomic_store_explicit(&_sum, 0, memory_order_relaxed);
+    atomic_store_explicit(&_minimum, UINT64_MAX, memory_order_relaxed);
+    atomic_store_explicit(&_maximum, 0, memory_order_relaxed);
+}
+
+@end
@@ -0,0 +1,99 @@
+//
+//  AMMemoryBudget.h
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import <Foundation/Foundation.h>
+
+/*!
+ * Thread-safe budget of the bytes buffered by a set of transfers.
+ * @discussion Transfers reserve the bytes they buffer and release them when they are done with them. While the buffered bytes are over the budget, new transfers wait before starting and running transfers are suspended, except one, which keeps running so the buffered bytes can eventually be released. The waiting and suspended transfers are resumed when the buffered bytes fall under the budget. Transfers are identified by any object, usually the connection operation performing them.
+ */
+@interface AMMemoryBudget : NSObject
+
+/*!
+ * Default initializer.
+ * @param byteBudget The maximum number of bytes buffered by the transfers, or 0 for no limit.
+ */
+- (id)initWithByteBudget:(unsigned long long)byteBudget;
+
+/*!
+ * The maximum number of bytes buffered by the transfers, or 0 for no limit. It can be changed at any time.
+ */
+@property (nonatomic, assign) unsigned long long byteBudget;
+
+/*!
+ * The number of bytes currently buffered by the transfers.
+ */
+@property (nonatomic, assign, readonly) unsigned long long bufferedBytes;
+
+/*!
+ * The maximum number of bytes buffered at the same time by the transfers.
+ */
+@property (nonatomic, assign, readonly) unsigned long long peakBufferedBytes;
+
+/*!
+ * YES if the buffered bytes are over the budget.
+ */
+@property (nonatomic, assign, readonly, getter = isExhausted) BOOL exhausted;
+
+/*!
+ * Resets the peak of buffered bytes to the bytes currently buffered.
+ */
+- (void)resetPeakBufferedBytes;
+
+/*!
+ * Adds bytes to the buffered bytes. The bytes are reserved even if they exceed the budget.
+ * @param length The number of bytes.
+ */
+- (void)reserveBytes:(unsigned long long)length;
+
+/*!
+ * Removes bytes from the buffered bytes.
+ * @param length The number of bytes, previously reserved.
+ */
+- (void)releaseBytes:(unsigned long long)length;
+
+/*!
+ * Admits a new transfer if the budget allows it.
+ * @param transfer The object identifying the transfer.
+ * @param block The block called when the budget becomes available if the transfer is not admitted. Call this method again from it. It can be called from any thread.
+ * @return YES if the transfer can start. Transfers are always admitted when there is no other running transfer.
+ * @discussion Admitted transfers must call `finishTransfer:` when they finish, and so must transfers that are still waiting when they are cancelled.
+ */
+- (BOOL)admitTransfer:(id)transfer whenAvailable:(void (^)(void))block;
+
+/*!
+ * Suspends a running transfer if the buffered bytes are over the budget.
+ * @param transfer The object identifying an admitted transfer.
+ * @param block The block called to resume the transfer. It can be called from any thread.
+ * @return YES if the transfer must be suspended until the block is called. NO if it can go on, because the buffered bytes are under the budget or all the other running transfers are suspended.
+ */
+- (BOOL)suspendTransfer:(id)transfer untilAvailable:(void (^)(void))block;
+
+/*!
+ * Removes a transfer from the budget, resuming the other transfers if it was the last one running.
+ * @param transfer The object identifying the transfer.
+ * @discussion The bytes still reserved by the transfer must be released separately.
+ */
+- (void)finishTransfer:(id)transfer;
+
+@end
@@ -0,0 +1,237 @@
+//
+//  AMMemoryBudget.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMMemoryBudget.h"
+
+#import <pthread.h>
+
+@implementation AMMemoryBudget
+{
+    pthread_mutex_t _lock;
+    
+    unsigned long long _byteBudget;
+    unsigned long long _bufferedBytes;
+    unsigned long long _peakBufferedBytes;
+    
+    // Transfers are keyed by identity, without copying them.
+    NSHashTable *_runningTransfers;
+    NSMapTable *_waitingTransfers;
+    NSMapTable *_suspendedTransfers;
+}
+
+- (id)init
+{
+    return [self initWithByteBudget:0];
+}
+
+- (id)initWithByteBudget:(unsigned long long)byteBudget
+{
+    self = [super init];
+    if (self)
+    {
+        pthread_mutex_init(&_lock, NULL);
+        
+        _byteBudget = byteBudget;
+        
+        NSPointerFunctionsOptions keyOptions = NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality;
+        
+        _runningTransfers = [[NSHashTable alloc] initWithOptions:keyOptions capacity:0];
+        _waitingTransfers = [[NSMapTable alloc] initWithKeyOptions:keyOptions valueOptions:NSPointerFunctionsStrongMemory capacity:0];
+        _suspendedTransfers = [[NSMapTable alloc] initWithKeyOptions:keyOptions valueOptions:NSPointerFunctionsStrongMemory capacity:0];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    pthread_mutex_destroy(&_lock);
+}
+
+#pragma mark Properties
+
+- (unsigned long long)byteBudget
+{
+    pthread_mutex_lock(&_lock);
+    unsigned long long byteBudget = _byteBudget;
+    pthread_mutex_unlock(&_lock);
+    
+    return byteBudget;
+}
+
+- (void)setByteBudget:(unsigned long long)byteBudget
+{
+    pthread_mutex_lock(&_lock);
+    _byteBudget = byteBudget;
+    NSArray *blocks = [self _blocksToResume];
+    pthread_mutex_unlock(&_lock);
+    
+    [self _callBlocks:blocks];
+}
+
+- (unsigned long long)bufferedBytes
+{
+    pthread_mutex_lock(&_lock);
+    unsigned long long bufferedBytes = _bufferedBytes;
+    pthread_mutex_unlock(&_lock);
+    
+    return bufferedBytes;
+}
+
+- (unsigned long long)peakBufferedBytes
+{
+    pthread_mutex_lock(&_lock);
+    unsigned long long peakBufferedBytes = _peakBufferedBytes;
+    pthread_mutex_unlock(&_lock);
+    
+    return peakBufferedBytes;
+}
+
+- (BOOL)isExhausted
+{
+    pthread_mutex_lock(&_lock);
+    BOOL exhausted = [self _isExhausted];
+    pthread_mutex_unlock(&_lock);
+    
+    return exhausted;
+}
+
+#pragma mark Public Methods
+
+- (void)resetPeakBufferedBytes
+{
+    pthread_mutex_lock(&_lock);
+    _peakBufferedBytes = _bufferedBytes;
+    pthread_mutex_unlock(&_lock);
+}
+
+- (void)reserveBytes:(unsigned long long)length
+{
+    pthread_mutex_lock(&_lock);
+    
+    _bufferedBytes += length;
+    _peakBufferedBytes = MAX(_peakBufferedBytes, _bufferedBytes);
+    
+    pthread_mutex_unlock(&_lock);
+}
+
+- (void)releaseBytes:(unsigned long long)length
+{
+    pthread_mutex_lock(&_lock);
+    
+    _bufferedBytes -= MIN(length, _bufferedBytes);
+    NSArray *blocks = [self _blocksToResume];
+    
+    pthread_mutex_unlock(&_lock);
+    
+    [self _callBlocks:blocks];
+}
+
+- (BOOL)admitTransfer:(id)transfer whenAvailable:(void (^)(void))block
+{
+    pthread_mutex_lock(&_lock);
+    
+    BOOL admitted = ![self _isExhausted] || _runningTransfers.count == 0 || [_runningTransfers containsObject:transfer];
+    
+    if (admitted)
+    {
+        [_waitingTransfers removeObjectForKey:transfer];
+        [_runningTransfers addObject:transfer];
+    }
+    else
+    {
+        [_waitingTransfers setObject:[block copy] forKey:transfer];
+    }
+    
+    pthread_mutex_unlock(&_lock);
+    
+    return admitted;
+}
+
+- (BOOL)suspendTransfer:(id)transfer untilAvailable:(void (^)(void))block
+{
+    pthread_mutex_lock(&_lock);
+    
+    // At least one running transfer must go on, otherwise the buffered bytes would never be released.
+    BOOL suspended = [self _isExhausted] && [_runningTransfers containsObject:transfer] && _runningTransfers.count - _suspendedTransfers.count > 1;
+    
+    if (suspended)
+        [_suspendedTransfers setObject:[block copy] forKey:transfer];
+    
+    pthread_mutex_unlock(&_lock);
+    
+    return suspended;
+}
+
+- (void)finishTransfer:(id)transfer
+{
+    pthread_mutex_lock(&_lock);
+    
+    [_runningTransfers removeObject:transfer];
+    [_waitingTransfers removeObjectForKey:transfer];
+    [_suspendedTransfers removeObjectForKey:transfer];
+    
+    NSArray *blocks = [self _blocksToResume];
+    
+    pthread_mutex_unlock(&_lock);
+    
+    [self _callBlocks:blocks];
+}
+
+#pragma mark Private Methods
+
+- (BOOL)_isExhausted
+{
+    // Must be called while holding the lock.
+    return _byteBudget > 0 && _bufferedBytes >= _byteBudget;
+}
+
+- (NSArray*)_blocksToResume
+{
+    // Must be called while holding the lock.
+    NSMutableArray *blocks = [NSMutableArray array];
+    
+    BOOL available = ![self _isExhausted];
+    
+    // Over the budget, the suspended transfers are resumed if none is left running, and the waiting ones if none is left at all.
+    if (available || (_suspendedTransfers.count > 0 && _suspendedTransfers.count == _runningTransfers.count))
+    {
+        [blocks addObjectsFromArray:[[_suspendedTransfers objectEnumerator] allObjects]];
+        [_suspendedTransfers removeAllObjects];
+    }
+    
+    if (available || _runningTransfers.count == 0)
+    {
+        [blocks addObjectsFromArray:[[_waitingTransfers objectEnumerator] allObjects]];
+        [_waitingTransfers removeAllObjects];
+    }
+    
+    return blocks;
+}
+
+- (void)_callBlocks:(NSArray*)blocks
+{
+    for (void (^block)(void) in blocks)
+        block();
+}
+
+@end
@@ -0,0 +1,56 @@
+//
+//  AMNetworkThreadPool.h
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import <Foundation/Foundation.h>
+
+/*!
+ * This class keeps a fixed set of long-lived threads, each one running its own run loop, where the network connections are scheduled.
+ * @discussion Instead of detaching a new thread for each connection, connection operations pick one of these threads and schedule their connection in its run loop. This way, many connections are multiplexed over a small number of threads.
+ */
+@interface AMNetworkThreadPool : NSObject
+
+/*!
+ * Returns the default thread pool. The number of threads of the default pool is equal to the number of active processors.
+ * @return The default thread pool.
+ */
++ (AMNetworkThreadPool*)defaultPool;
+
+/*!
+ * Default initializer.
+ * @param threadCount The number of threads of the pool. If zero, the number of active processors is used.
+ * @discussion Threads are created lazily the first time they are requested.
+ */
+- (id)initWithThreadCount:(NSUInteger)threadCount;
+
+/*!
+ * The number of threads of the pool.
+ */
+@property (nonatomic, assign, readonly) NSUInteger threadCount;
+
+/*!
+ * Returns the next thread to be used, in a round-robin fashion.
+ * @return A thread with a running run loop.
+ */
+- (NSThread*)nextThread;
+
+@end
@@ -0,0 +1,119 @@
+//
+//  AMNetworkThreadPool.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMNetworkThreadPool.h"
+
+#import <dispatch/dispatch.h>
+#import <stdatomic.h>
+
+@implementation AMNetworkThreadPool
+{
+    NSArray *_threads;
+    atomic_uint_fast64_t _nextThreadIndex;
+}
+
++ (AMNetworkThreadPool*)defaultPool
+{
+    static dispatch_once_t pred = 0;
+    __strong static id _sharedObject = nil;
+    dispatch_once(&pred, ^{
+        _sharedObject = [[AMNetworkThreadPool alloc] initWithThreadCount:0];
+    });
+    return _sharedObject;
+}
+
+- (id)init
+{
+    return [self initWithThreadCount:0];
+}
+
+- (id)initWithThreadCount:(NSUInteger)threadCount
+{
+    self = [super init];
+    if (self)
+    {
+        if (threadCount == 0)
+            threadCount = MAX([[NSProcessInfo processInfo] activeProcessorCount], 1);
+        
+        _threadCount = threadCount;
+        atomic_init(&_nextThreadIndex, 0);
+    }
+    return self;
+}
+
+#pragma mark Public Methods
+
+- (NSThread*)nextThread
+{
+    NSArray *threads = [self _threads];
+    
+    uint_fast64_t index = atomic_fetch_add_explicit(&_nextThreadIndex, 1, memory_order_relaxed);
+    
+    return [threads objectAtIndex:(NSUInteger)(index % _threadCount)];
+}
+
+#pragma mark Private Methods
+
+- (NSArray*)_threads
+{
+    @synchronized(self)
+    {
+        if (!_threads)
+        {
+            NSMutableArray *threads = [NSMutableArray arrayWithCapacity:_threadCount];
+            
+            for (NSUInteger i=0; i<_threadCount; ++i)
+            {
+                NSThread *thread = [[NSThread alloc] initWithTarget:[self class] selector:@selector(_threadMain:) object:nil];
+                thread.name = [NSString stringWithFormat:@"com.vilanovi.AMNetworkThreadPool.%lu", (unsigned long)i];
+                [thread start];
+                [threads addObject:thread];
+            }
+            
+            _threads = [threads copy];
+        }
+        
+        return _threads;
+    }
+}
+
++ (void)_threadMain:(id)object
+{
+    @autoreleasepool
+    {
+        NSRunLoop *runLoop = [NSRunLoop currentRunLoop];
+        
+        // The port keeps the run loop alive when there are no connections scheduled on it.
+        [runLoop addPort:[NSPort port] forMode:NSDefaultRunLoopMode];
+        
+        while (YES)
+        {
+            @autoreleasepool
+            {
+                [runLoop runMode:NSDefaultRunLoopMode beforeDate:[NSDate distantFuture]];
+            }
+        }
+    }
+}
+
+@end
@@ -0,0 +1,79 @@
+//
+//  AMOperationRegistry.h
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import <Foundation/Foundation.h>
+
+/*!
+ * Thread-safe registry that maps connection keys to operations.
+ * @discussion The registry is split in several stripes, each one protected by its own lock. Keys are assigned using an atomic counter, so operations can be registered, looked up and removed concurrently from any thread without contending on a global lock.
+ */
+@interface AMOperationRegistry : NSObject
+
+/*!
+ * Returns a new unique key.
+ * @return The key.
+ */
+- (NSInteger)nextKey;
+
+/*!
+ * The number of registered operations.
+ */
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/*!
+ * Registers an operation for the given key. If there was an operation registered for the same key, it is replaced.
+ * @param operation The operation.
+ * @param key The key.
+ */
+- (void)setOperation:(id)operation forKey:(NSInteger)key;
+
+/*!
+ * Returns the operation registered for the given key.
+ * @param key The key.
+ * @return The operation or nil if there is no operation registered for the given key.
+ */
+- (id)operationForKey:(NSInteger)key;
+
+/*!
+ * Removes the operation registered for the given key.
+ * @param key The key.
+ * @return The removed operation or nil if there was no operation registered for the given key.
+ */
+- (id)removeOperationForKey:(NSInteger)key;
+
+/*!
+ * Removes the operation registered for the given key only if it is the given operation.
+ * @param operation The operation to remove.
+ * @param key The key.
+ * @return YES if the operation has been removed, otherwise NO.
+ * @discussion Use this method to avoid removing a different operation that has been registered later with the same key.
+ */
+- (BOOL)removeOperation:(id)operation forKey:(NSInteger)key;
+
+/*!
+ * Removes all the registered operations.
+ * @return The removed operations.
+ */
+- (NSArray*)removeAllOperations;
+
+@end
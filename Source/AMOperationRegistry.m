@@ -0,0 +1,173 @@
+//
+//  AMOperationRegistry.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMOperationRegistry.h"
+
+#import <pthread.h>
+#import <stdatomic.h>
+
+// Must be a power of two.
+#define AMOperationRegistryStripeCount 16
+
+@implementation AMOperationRegistry
+{
+    pthread_mutex_t _locks[AMOperationRegistryStripeCount];
+    NSMutableDictionary *_stripes[AMOperationRegistryStripeCount];
+    
+    atomic_long _lastKey;
+    atomic_long _count;
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self)
+    {
+        for (NSUInteger i=0; i<AMOperationRegistryStripeCount; ++i)
+        {
+            pthread_mutex_init(&_locks[i], NULL);
+            _stripes[i] = [NSMutableDictionary dictionary];
+        }
+        
+        atomic_init(&_lastKey, -1);
+        atomic_init(&_count, 0);
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    for (NSUInteger i=0; i<AMOperationRegistryStripeCount; ++i)
+        pthread_mutex_destroy(&_locks[i]);
+}
+
+#pragma mark Properties
+
+- (NSUInteger)count
+{
+    long count = atomic_load_explicit(&_count, memory_order_relaxed);
+    return count > 0 ? (NSUInteger)count : 0;
+}
+
+#pragma mark Public Methods
+
+- (NSInteger)nextKey
+{
+    return atomic_fetch_add_explicit(&_lastKey, 1, memory_order_relaxed) + 1;
+}
+
+- (void)setOperation:(id)operation forKey:(NSInteger)key
+{
+    if (!operation)
+        return;
+    
+    NSUInteger stripe = [self _stripeForKey:key];
+    NSNumber *numberKey = @(key);
+    
+    pthread_mutex_lock(&_locks[stripe]);
+    
+    if (![_stripes[stripe] objectForKey:numberKey])
+        atomic_fetch_add_explicit(&_count, 1, memory_order_relaxed);
+    
+    [_stripes[stripe] setObject:operation forKey:numberKey];
+    
+    pthread_mutex_unlock(&_locks[stripe]);
+}
+
+- (id)operationForKey:(NSInteger)key
+{
+    NSUInteger stripe = [self _stripeForKey:key];
+    
+    pthread_mutex_lock(&_locks[stripe]);
+    id operation = [_stripes[stripe] objectForKey:@(key)];
+    pthread_mutex_unlock(&_locks[stripe]);
+    
+    return operation;
+}
+
+- (id)removeOperationForKey:(NSInteger)key
+{
+    NSUInteger stripe = [self _stripeForKey:key];
+    NSNumber *numberKey = @(key);
+    
+    pthread_mutex_lock(&_locks[stripe]);
+    
+    id operation = [_stripes[stripe] objectForKey:numberKey];
+    
+    if (operation)
+    {
+        [_stripes[stripe] removeObjectForKey:numberKey];
+        atomic_fetch_sub_explicit(&_count, 1, memory_order_relaxed);
+    }
+    
+    pthread_mutex_unlock(&_locks[stripe]);
+    
+    return operation;
+}
+
+- (BOOL)removeOperation:(id)operation forKey:(NSInteger)key
+{
+    NSUInteger stripe = [self _stripeForKey:key];
+    NSNumber *numberKey = @(key);
+    BOOL removed = NO;
+    
+    pthread_mutex_lock(&_locks[stripe]);
+    
+    if (operation != nil && [_stripes[stripe] objectForKey:numberKey] == operation)
+    {
+        [_stripes[stripe] removeObjectForKey:numberKey];
+        atomic_fetch_sub_explicit(&_count, 1, memory_order_relaxed);
+        removed = YES;
+    }
+    
+    pthread_mutex_unlock(&_locks[stripe]);
+    
+    return removed;
+}
+
+- (NSArray*)removeAllOperations
+{
+    NSMutableArray *operations = [NSMutableArray array];
+    
+    for (NSUInteger i=0; i<AMOperationRegistryStripeCount; ++i)
+    {
+        pthread_mutex_lock(&_locks[i]);
+        
+        [operations addObjectsFromArray:[_stripes[i] allValues]];
+        atomic_fetch_sub_explicit(&_count, (long)_stripes[i].count, memory_order_relaxed);
+        [_stripes[i] removeAllObjects];
+        
+        pthread_mutex_unlock(&_locks[i]);
+    }
+    
+    return operations;
+}
+
+#pragma mark Private Methods
+
+- (NSUInteger)_stripeForKey:(NSInteger)key
+{
+    return ((NSUInteger)key) & (AMOperationRegistryStripeCount - 1);
+}
+
+@end
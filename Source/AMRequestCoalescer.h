@@ -0,0 +1,159 @@
+//
+//  AMRequestCoalescer.h
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import <Foundation/Foundation.h>
+
+@class AMRequestFlight;
+
+/*!
+ * A caller waiting for the result of a coalesced request.
+ */
+@interface AMRequestFlightWaiter : NSObject
+
+/*!
+ * The connection key assigned to the caller.
+ */
+@property (nonatomic, assign, readonly) NSInteger key;
+
+/*!
+ * The block to be called when the request ends.
+ */
+@property (nonatomic, strong, readonly) void (^completion)(NSURLResponse* response, NSData* data, NSError* error);
+
+/*!
+ * The block to be called with the progress status of the request.
+ */
+@property (nonatomic, strong, readonly) void (^progressStatusBlock)(NSDictionary *info);
+
+/*!
+ * The flight the waiter is or was attached to.
+ */
+@property (nonatomic, strong, readonly) AMRequestFlight *flight;
+
+@end
+
+/*!
+ * A request in flight shared by several callers.
+ */
+@interface AMRequestFlight : NSObject
+
+/*!
+ * The connection key of the operation performing the request.
+ * @discussion It is an internal key, never returned to the callers: the keys of the callers only reach the operation through their waiters.
+ */
+@property (nonatomic, assign, readonly) NSInteger operationKey;
+
+/*!
+ * The number of callers currently waiting for the request.
+ */
+@property (nonatomic, assign, readonly) NSUInteger waiterCount;
+
+/*!
+ * YES if the request was started by a prefetch.
+ */
+@property (nonatomic, assign, readonly, getter = isPrefetch) BOOL prefetch;
+
+/*!
+ * Forwards the given progress status to all the waiters.
+ * @param progressStatus The progress status.
+ */
+- (void)deliverProgressStatus:(NSDictionary*)progressStatus;
+
+@end
+
+/*!
+ * This class deduplicates identical idempotent requests while one of them is in flight.
+ * @discussion Two requests are identical if they have the same method, URL and header fields. Each caller keeps its own connection key and completion block, all of them fed from a single connection operation.
+ */
+@interface AMRequestCoalescer : NSObject
+
+/*!
+ * Returns the string identifying identical requests.
+ * @param request The request.
+ * @return The fingerprint or nil if the request cannot be coalesced (it is not a GET or HEAD request or it has a body).
+ */
++ (NSString*)fingerprintForRequest:(NSURLRequest*)request;
+
+/*!
+ * The number of prefetch flights in progress. It can be read without blocking, to skip the fingerprint of requests that can't join any flight.
+ */
+@property (nonatomic, assign, readonly) NSUInteger prefetchFlightCount;
+
+/*!
+ * Attaches a new waiter to the flight with the given fingerprint, if any.
+ * @param fingerprint The fingerprint of the request.
+ * @param key The connection key of the caller.
+ * @param completion The block to be called when the request ends.
+ * @param progressStatusBlock The block to be called with the progress status of the request.
+ * @return The flight or nil if there is no flight with the given fingerprint.
+ */
+- (AMRequestFlight*)joinFlightWithFingerprint:(NSString*)fingerprint
+                                          key:(NSInteger)key
+                                   completion:(void (^)(NSURLResponse* response, NSData* data, NSError* error))completion
+                               progressStatus:(void (^)(NSDictionary *info))progressStatusBlock;
+
+/*!
+ * Creates a new flight with a single waiter.
+ * @param fingerprint The fingerprint of the request.
+ * @param key The connection key of the caller.
+ * @param operationKey The connection key of the operation performing the request. It must be different from the keys of the callers.
+ * @param prefetch YES if the request is a prefetch.
+ * @param completion The block to be called when the request ends.
+ * @param progressStatusBlock The block to be called with the progress status of the request.
+ * @return The new flight.
+ */
+- (AMRequestFlight*)beginFlightWithFingerprint:(NSString*)fingerprint
+                                           key:(NSInteger)key
+                                  operationKey:(NSInteger)operationKey
+                                      prefetch:(BOOL)prefetch
+                                    completion:(void (^)(NSURLResponse* response, NSData* data, NSError* error))completion
+                                progressStatus:(void (^)(NSDictionary *info))progressStatusBlock;
+
+/*!
+ * Returns the flight the given connection key is waiting for.
+ * @param key The connection key.
+ * @return The flight or nil if the key is not waiting for any flight.
+ */
+- (AMRequestFlight*)flightForKey:(NSInteger)key;
+
+/*!
+ * Detaches the waiter with the given key from its flight.
+ * @param key The connection key.
+ * @return The detached waiter or nil if the key is not waiting for any flight.
+ * @discussion When the last waiter is detached the flight is discarded and its waiterCount is zero: the operation performing the request should be cancelled.
+ */
+- (AMRequestFlightWaiter*)removeWaiterWithKey:(NSInteger)key;
+
+/*!
+ * Discards the given flight.
+ * @param flight The flight.
+ * @return The waiters of the flight, which should be notified with the result of the request.
+ */
+- (NSArray*)finishFlight:(AMRequestFlight*)flight;
+
+/*!
+ * Discards all the flights.
+ */
+- (void)removeAllFlights;
+
+@end
@@ -0,0 +1,317 @@
+//
+//  AMRequestCoalescer.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMRequestCoalescer.h"
+
+#import <pthread.h>
+#import <stdatomic.h>
+
+@interface AMRequestFlightWaiter ()
+
+@property (nonatomic, assign, readwrite) NSInteger key;
+@property (nonatomic, strong, readwrite) void (^completion)(NSURLResponse* response, NSData* data, NSError* error);
+@property (nonatomic, strong, readwrite) void (^progressStatusBlock)(NSDictionary *info);
+@property (nonatomic, strong, readwrite) AMRequestFlight *flight;
+
+@end
+
+@implementation AMRequestFlightWaiter
+
+@end
+
+@interface AMRequestFlight ()
+
+@property (nonatomic, strong) NSString *fingerprint;
+@property (nonatomic, assign, readwrite) NSInteger operationKey;
+@property (nonatomic, assign, readwrite, getter = isPrefetch) BOOL prefetch;
+
+- (void)am_addWaiter:(AMRequestFlightWaiter*)waiter;
+- (void)am_removeWaiter:(AMRequestFlightWaiter*)waiter;
+- (NSArray*)am_waiters;
+
+@end
+
+@implementation AMRequestFlight
+{
+    NSMutableArray *_waiters;
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self)
+    {
+        _waiters = [NSMutableArray array];
+    }
+    return self;
+}
+
+#pragma mark Properties
+
+- (NSUInteger)waiterCount
+{
+    @synchronized(self)
+    {
+        return _waiters.count;
+    }
+}
+
+#pragma mark Public Methods
+
+- (void)deliverProgressStatus:(NSDictionary*)progressStatus
+{
+    for (AMRequestFlightWaiter *waiter in [self am_waiters])
+    {
+        if (waiter.progressStatusBlock)
+            waiter.progressStatusBlock(progressStatus);
+    }
+}
+
+#pragma mark Private Methods
+
+- (void)am_addWaiter:(AMRequestFlightWaiter*)waiter
+{
+    @synchronized(self)
+    {
+        [_waiters addObject:waiter];
+    }
+}
+
+- (void)am_removeWaiter:(AMRequestFlightWaiter*)waiter
+{
+    @synchronized(self)
+    {
+        [_waiters removeObjectIdenticalTo:waiter];
+    }
+}
+
+- (NSArray*)am_waiters
+{
+    @synchronized(self)
+    {
+        return [_waiters copy];
+    }
+}
+
+@end
+
+@implementation AMRequestCoalescer
+{
+    pthread_mutex_t _lock;
+    NSMutableDictionary *_flights;
+    NSMutableDictionary *_waiters;
+    atomic_ulong _prefetchFlightCount;
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self)
+    {
+        pthread_mutex_init(&_lock, NULL);
+        _flights = [NSMutableDictionary dictionary];
+        _waiters = [NSMutableDictionary dictionary];
+        atomic_init(&_prefetchFlightCount, 0);
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    pthread_mutex_destroy(&_lock);
+}
+
+#pragma mark Properties
+
+- (NSUInteger)prefetchFlightCount
+{
+    return (NSUInteger)atomic_load_explicit(&_prefetchFlightCount, memory_order_relaxed);
+}
+
+#pragma mark Public Methods
+
++ (NSString*)fingerprintForRequest:(NSURLRequest*)request
+{
+    NSString *method = request.HTTPMethod.length > 0 ? request.HTTPMethod : @"GET";
+    
+    if (![method isEqualToString:@"GET"] && ![method isEqualToString:@"HEAD"])
+        return nil;
+    
+    if (request.HTTPBody.length > 0 || request.HTTPBodyStream != nil || request.URL == nil)
+        return nil;
+    
+    NSMutableString *fingerprint = [NSMutableString stringWithFormat:@"%@ %@", method, request.URL.absoluteString];
+    
+    NSDictionary *headers = [request allHTTPHeaderFields];
+    NSArray *fields = [[headers allKeys] sortedArrayUsingSelector:@selector(caseInsensitiveCompare:)];
+    
+    for (NSString *field in fields)
+        [fingerprint appendFormat:@"\n%@: %@", [field lowercaseString], [headers valueForKey:field]];
+    
+    return fingerprint;
+}
+
+- (AMRequestFlight*)joinFlightWithFingerprint:(NSString*)fingerprint
+                                          key:(NSInteger)key
+                                   completion:(void (^)(NSURLResponse* response, NSData* data, NSError* error))completion
+                               progressStatus:(void (^)(NSDictionary *info))progressStatusBlock
+{
+    pthread_mutex_lock(&_lock);
+    
+    AMRequestFlight *flight = [_flights objectForKey:fingerprint];
+    
+    if (flight)
+        [self _addWaiterWithKey:key completion:completion progressStatus:progressStatusBlock toFlight:flight];
+    
+    pthread_mutex_unlock(&_lock);
+    
+    return flight;
+}
+
+- (AMRequestFlight*)beginFlightWithFingerprint:(NSString*)fingerprint
+                                           key:(NSInteger)key
+                                  operationKey:(NSInteger)operationKey
+                                      prefetch:(BOOL)prefetch
+                                    completion:(void (^)(NSURLResponse* response, NSData* data, NSError* error))completion
+                                progressStatus:(void (^)(NSDictionary *info))progressStatusBlock
+{
+    AMRequestFlight *flight = [[AMRequestFlight alloc] init];
+    flight.fingerprint = fingerprint;
+    flight.operationKey = operationKey;
+    flight.prefetch = prefetch;
+    
+    pthread_mutex_lock(&_lock);
+    
+    AMRequestFlight *replacedFlight = [_flights objectForKey:fingerprint];
+    
+    if (replacedFlight)
+        [self _removeFlight:replacedFlight];
+    
+    [_flights setObject:flight forKey:fingerprint];
+    
+    if (prefetch)
+        atomic_fetch_add_explicit(&_prefetchFlightCount, 1, memory_order_relaxed);
+    
+    [self _addWaiterWithKey:key completion:completion progressStatus:progressStatusBlock toFlight:flight];
+    
+    pthread_mutex_unlock(&_lock);
+    
+    return flight;
+}
+
+- (AMRequestFlight*)flightForKey:(NSInteger)key
+{
+    pthread_mutex_lock(&_lock);
+    AMRequestFlightWaiter *waiter = [_waiters objectForKey:@(key)];
+    AMRequestFlight *flight = waiter.flight;
+    pthread_mutex_unlock(&_lock);
+    
+    return flight;
+}
+
+- (AMRequestFlightWaiter*)removeWaiterWithKey:(NSInteger)key
+{
+    pthread_mutex_lock(&_lock);
+    
+    AMRequestFlightWaiter *waiter = [_waiters objectForKey:@(key)];
+    
+    if (waiter)
+    {
+        AMRequestFlight *flight = waiter.flight;
+        
+        [_waiters removeObjectForKey:@(key)];
+        [flight am_removeWaiter:waiter];
+        
+        if (flight.waiterCount == 0)
+            [self _removeFlight:flight];
+    }
+    
+    pthread_mutex_unlock(&_lock);
+    
+    return waiter;
+}
+
+- (NSArray*)finishFlight:(AMRequestFlight*)flight
+{
+    pthread_mutex_lock(&_lock);
+    
+    [self _removeFlight:flight];
+    
+    NSArray *waiters = [flight am_waiters];
+    
+    for (AMRequestFlightWaiter *waiter in waiters)
+    {
+        [_waiters removeObjectForKey:@(waiter.key)];
+        [flight am_removeWaiter:waiter];
+    }
+    
+    pthread_mutex_unlock(&_lock);
+    
+    return waiters;
+}
+
+- (void)removeAllFlights
+{
+    pthread_mutex_lock(&_lock);
+    
+    for (AMRequestFlightWaiter *waiter in [_waiters allValues])
+        [waiter.flight am_removeWaiter:waiter];
+    
+    [_flights removeAllObjects];
+    [_waiters removeAllObjects];
+    atomic_store_explicit(&_prefetchFlightCount, 0, memory_order_relaxed);
+    
+    pthread_mutex_unlock(&_lock);
+}
+
+#pragma mark Private Methods
+
+- (void)_removeFlight:(AMRequestFlight*)flight
+{
+    // Must be called while holding the lock.
+    if ([_flights objectForKey:flight.fingerprint] != flight)
+        return;
+    
+    [_flights removeObjectForKey:flight.fingerprint];
+    
+    if (flight.isPrefetch)
+        atomic_fetch_sub_explicit(&_prefetchFlightCount, 1, memory_order_relaxed);
+}
+
+- (void)_addWaiterWithKey:(NSInteger)key
+               completion:(void (^)(NSURLResponse* response, NSData* data, NSError* error))completion
+           progressStatus:(void (^)(NSDictionary *info))progressStatusBlock
+                 toFlight:(AMRequestFlight*)flight
+{
+    // Must be called while holding the lock.
+    AMRequestFlightWaiter *waiter = [[AMRequestFlightWaiter alloc] init];
+    waiter.key = key;
+    waiter.completion = completion;
+    waiter.progressStatusBlock = progressStatusBlock;
+    waiter.flight = flight;
+    
+    [flight am_addWaiter:waiter];
+    [_waiters setObject:waiter forKey:@(key)];
+}
+
+@end
@@ -0,0 +1,177 @@
+//
+//  AMResponseCache.h
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import <Foundation/Foundation.h>
+
+/*!
+ * A cached HTTP response with its data.
+ * @discussion The freshness of the response is computed from the Cache-Control, Expires, Date, Age and Last-Modified headers.
+ */
+@interface AMCachedResponse : NSObject <NSCoding>
+
+/*!
+ * Default initializer.
+ * @param response The HTTP response.
+ * @param data The response data.
+ * @param date The date when the response was received.
+ */
+- (id)initWithResponse:(NSHTTPURLResponse*)response data:(NSData*)data date:(NSDate*)date;
+
+/*!
+ * The HTTP response.
+ */
+@property (nonatomic, strong, readonly) NSHTTPURLResponse *response;
+
+/*!
+ * The response data.
+ */
+@property (nonatomic, strong, readonly) NSData *data;
+
+/*!
+ * The date when the response was received or last revalidated.
+ */
+@property (nonatomic, strong, readonly) NSDate *date;
+
+/*!
+ * The value of the ETag header, if any.
+ */
+@property (nonatomic, strong, readonly) NSString *entityTag;
+
+/*!
+ * The value of the Last-Modified header, if any.
+ */
+@property (nonatomic, strong, readonly) NSString *lastModified;
+
+/*!
+ * YES if the response can be used without contacting the server, otherwise NO.
+ */
+@property (nonatomic, assign, readonly, getter = isFresh) BOOL fresh;
+
+/*!
+ * YES if the response has a validator (ETag or Last-Modified) that can be used to revalidate it with a conditional request.
+ */
+@property (nonatomic, assign, readonly) BOOL canBeRevalidated;
+
+/*!
+ * Returns YES if the given response can be stored in a cache.
+ * @param response The response.
+ * @param request The request that originated the response.
+ * @return YES if the response is cacheable, otherwise NO.
+ */
++ (BOOL)isCacheableResponse:(NSURLResponse*)response forRequest:(NSURLRequest*)request;
+
+/*!
+ * Returns a copy of the request including the conditional headers (If-None-Match and If-Modified-Since) needed to revalidate the receiver.
+ * @param request The original request.
+ * @return The conditional request.
+ */
+- (NSURLRequest*)conditionalRequestForRequest:(NSURLRequest*)request;
+
+/*!
+ * Creates a new cached response after a successful revalidation.
+ * @param response The 304 (Not Modified) response received when revalidating the receiver.
+ * @return A new cached response with the same data, the headers updated with the ones of the given response and the current date.
+ */
+- (AMCachedResponse*)cachedResponseByRevalidatingWithResponse:(NSHTTPURLResponse*)response;
+
+@end
+
+/*!
+ * Protocol adopted by the response caches used by AMConnectionManager.
+ */
+@protocol AMResponseCaching <NSObject>
+
+/*!
+ * Returns the cached response for the given request.
+ * @param request The request.
+ * @return The cached response or nil if there is no cached response for the request.
+ * @discussion This method may be called from any thread.
+ */
+- (AMCachedResponse*)cachedResponseForRequest:(NSURLRequest*)request;
+
+/*!
+ * Stores a cached response for the given request.
+ * @param cachedResponse The cached response.
+ * @param request The request.
+ * @discussion This method may be called from any thread.
+ */
+- (void)storeCachedResponse:(AMCachedResponse*)cachedResponse forRequest:(NSURLRequest*)request;
+
+/*!
+ * Removes the cached response for the given request.
+ * @param request The request.
+ */
+- (void)removeCachedResponseForRequest:(NSURLRequest*)request;
+
+@end
+
+/*!
+ * Two-tier response cache: a memory LRU cache in front of a disk cache.
+ * @discussion Responses evicted from memory remain on disk. When the disk usage exceeds the disk capacity, the least recently stored responses are removed.
+ * Disk writes are performed on a serial queue. A lookup that misses the memory cache reads the disk on the calling thread and doesn't wait for the pending writes.
+ */
+@interface AMResponseCache : NSObject <AMResponseCaching>
+
+/*!
+ * Default initializer.
+ * @param memoryCapacity The maximum number of bytes of response data kept in memory.
+ * @param diskCapacity The maximum number of bytes of response data kept on disk. Pass zero to disable the disk cache.
+ * @param path The directory of the disk cache. Pass nil to use a directory inside the caches directory.
+ */
+- (id)initWithMemoryCapacity:(NSUInteger)memoryCapacity diskCapacity:(NSUInteger)diskCapacity diskPath:(NSString*)path;
+
+/*!
+ * The maximum number of bytes of response data kept in memory.
+ */
+@property (nonatomic, assign, readonly) NSUInteger memoryCapacity;
+
+/*!
+ * The maximum number of bytes of response data kept on disk.
+ */
+@property (nonatomic, assign, readonly) NSUInteger diskCapacity;
+
+/*!
+ * Removes all the cached responses.
+ */
+- (void)removeAllCachedResponses;
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Statistics
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * Number of lookups that returned a fresh response.
+ */
+@property (nonatomic, assign, readonly) NSUInteger hitCount;
+
+/*!
+ * Number of lookups that did not return a usable response.
+ */
+@property (nonatomic, assign, readonly) NSUInteger missCount;
+
+/*!
+ * Number of lookups that returned a stale response that must be revalidated.
+ */
+@property (nonatomic, assign, readonly) NSUInteger revalidationCount;
+
+@end
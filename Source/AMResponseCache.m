@@ -0,0 +1,712 @@
+//
+//  AMResponseCache.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMResponseCache.h"
+#import "AMUtilities.h"
+
+#import <pthread.h>
+#import <stdatomic.h>
+
+static NSString * const AMCachedResponseURLKey = @"url";
+static NSString * const AMCachedResponseStatusCodeKey = @"statusCode";
+static NSString * const AMCachedResponseHeadersKey = @"headers";
+static NSString * const AMCachedResponseDataKey = @"data";
+static NSString * const AMCachedResponseDateKey = @"date";
+static NSString * const AMResponseCacheEntryKeyKey = @"key";
+static NSString * const AMResponseCacheEntryResponseKey = @"response";
+
+static NSString *AMHeaderValue(NSDictionary *headers, NSString *field)
+{
+    NSString *value = [headers valueForKey:field];
+    
+    if (value)
+        return value;
+    
+    for (NSString *key in headers)
+    {
+        if ([key caseInsensitiveCompare:field] == NSOrderedSame)
+            return [headers valueForKey:key];
+    }
+    
+    return nil;
+}
+
+static NSDictionary *AMCacheControlDirectives(NSString *cacheControl)
+{
+    NSMutableDictionary *directives = [NSMutableDictionary dictionary];
+    NSCharacterSet *whitespaces = [NSCharacterSet whitespaceCharacterSet];
+    
+    for (NSString *component in [cacheControl componentsSeparatedByString:@","])
+    {
+        NSArray *pair = [component componentsSeparatedByString:@"="];
+        NSString *name = [[[pair objectAtIndex:0] stringByTrimmingCharactersInSet:whitespaces] lowercaseString];
+        
+        if (name.length == 0)
+            continue;
+        
+        NSString *value = pair.count > 1 ? [[pair objectAtIndex:1] stringByTrimmingCharactersInSet:whitespaces] : @"";
+        [directives setValue:value forKey:name];
+    }
+    
+    return directives;
+}
+
+static NSString *AMResponseCacheFileNameForKey(NSString *key)
+{
+    // 64-bit FNV-1a hash. Collisions are detected by storing the key with the response.
+    uint64_t hash = 14695981039346656037ULL;
+    
+    for (const char *c = key.UTF8String; *c != '\0'; ++c)
+    {
+        hash ^= (uint8_t)*c;
+        hash *= 1099511628211ULL;
+    }
+    
+    return [NSString stringWithFormat:@"%016llx", (unsigned long long)hash];
+}
+
+#pragma mark - AMCachedResponse
+
+@implementation AMCachedResponse
+{
+    NSDictionary *_headers;
+}
+
+- (id)initWithResponse:(NSHTTPURLResponse*)response data:(NSData*)data date:(NSDate*)date
+{
+    self = [super init];
+    if (self)
+    {
+        _response = response;
+        _data = data ?: [NSData data];
+        _date = date ?: [NSDate date];
+        _headers = [response allHeaderFields];
+    }
+    return self;
+}
+
+#pragma mark Properties
+
+- (NSString*)entityTag
+{
+    return AMHeaderValue(_headers, @"ETag");
+}
+
+- (NSString*)lastModified
+{
+    return AMHeaderValue(_headers, @"Last-Modified");
+}
+
+- (BOOL)isFresh
+{
+    NSTimeInterval age = MAX([AMHeaderValue(_headers, @"Age") doubleValue], 0.0) + [[NSDate date] timeIntervalSinceDate:_date];
+    return age < [self _freshnessLifetime];
+}
+
+- (BOOL)canBeRevalidated
+{
+    return self.entityTag.length > 0 || self.lastModified.length > 0;
+}
+
+#pragma mark Public Methods
+
++ (BOOL)isCacheableResponse:(NSURLResponse*)response forRequest:(NSURLRequest*)request
+{
+    if (request.HTTPMethod.length > 0 && ![request.HTTPMethod isEqualToString:@"GET"])
+        return NO;
+    
+    if (![response isKindOfClass:[NSHTTPURLResponse class]] || [(NSHTTPURLResponse*)response statusCode] != 200)
+        return NO;
+    
+    NSDictionary *headers = [(NSHTTPURLResponse*)response allHeaderFields];
+    
+    if ([AMCacheControlDirectives(AMHeaderValue(headers, @"Cache-Control")) objectForKey:@"no-store"] ||
+        [AMCacheControlDirectives([request valueForHTTPHeaderField:@"Cache-Control"]) objectForKey:@"no-store"])
+        return NO;
+    
+    // Responses varying on request headers other than the encoding are not supported.
+    NSString *vary = AMHeaderValue(headers, @"Vary");
+    if (vary.length > 0 && [vary caseInsensitiveCompare:@"Accept-Encoding"] != NSOrderedSame)
+        return NO;
+    
+    AMCachedResponse *cachedResponse = [[AMCachedResponse alloc] initWithResponse:(id)response data:nil date:nil];
+    
+    return cachedResponse.canBeRevalidated || [cachedResponse _freshnessLifetime] > 0;
+}
+
+- (NSURLRequest*)conditionalRequestForRequest:(NSURLRequest*)request
+{
+    NSMutableURLRequest *conditionalRequest = [request mutableCopy];
+    
+    // The conditional headers are handled by the connection manager: bypass the URL loading system cache.
+    conditionalRequest.cachePolicy = NSURLRequestReloadIgnoringLocalCacheData;
+    
+    NSString *entityTag = self.entityTag;
+    if (entityTag.length > 0)
+        [conditionalRequest setValue:entityTag forHTTPHeaderField:@"If-None-Match"];
+    
+    NSString *lastModified = self.lastModified;
+    if (lastModified.length > 0)
+        [conditionalRequest setValue:lastModified forHTTPHeaderField:@"If-Modified-Since"];
+    
+    return conditionalRequest;
+}
+
+- (AMCachedResponse*)cachedResponseByRevalidatingWithResponse:(NSHTTPURLResponse*)response
+{
+    NSMutableDictionary *headers = [_headers mutableCopy];
+    NSDictionary *updatedHeaders = [response allHeaderFields];
+    
+    for (NSString *field in updatedHeaders)
+    {
+        // A 304 response describes the stored representation, not its own (empty) body.
+        if ([field caseInsensitiveCompare:@"Content-Length"] == NSOrderedSame || [field caseInsensitiveCompare:@"Content-Encoding"] == NSOrderedSame)
+            continue;
+        
+        [headers setValue:[updatedHeaders valueForKey:field] forKey:field];
+    }
+    
+    NSHTTPURLResponse *updatedResponse = [[NSHTTPURLResponse alloc] initWithURL:_response.URL
+                                                                     statusCode:_response.statusCode
+                                                                    HTTPVersion:@"HTTP/1.1"
+                                                                   headerFields:headers];
+    
+    return [[AMCachedResponse alloc] initWithResponse:updatedResponse data:_data date:[NSDate date]];
+}
+
+#pragma mark Private Methods
+
+- (NSTimeInterval)_freshnessLifetime
+{
+    NSDictionary *directives = AMCacheControlDirectives(AMHeaderValue(_headers, @"Cache-Control"));
+    
+    if ([directives objectForKey:@"no-cache"])
+        return 0.0;
+    
+    NSString *maxAge = [directives objectForKey:@"max-age"];
+    if (maxAge)
+        return [maxAge doubleValue];
+    
+    NSDate *date = AMDateFromHTTPDate(AMHeaderValue(_headers, @"Date")) ?: _date;
+    
+    NSString *expires = AMHeaderValue(_headers, @"Expires");
+    if (expires)
+    {
+        // Invalid dates (like "0") mean already expired.
+        NSDate *expiresDate = AMDateFromHTTPDate(expires);
+        return expiresDate ? [expiresDate timeIntervalSinceDate:date] : 0.0;
+    }
+    
+    // Heuristic freshness: 10% of the time since the resource was last modified.
+    NSDate *lastModifiedDate = AMDateFromHTTPDate(self.lastModified);
+    if (lastModifiedDate)
+        return MAX([date timeIntervalSinceDate:lastModifiedDate] * 0.1, 0.0);
+    
+    return 0.0;
+}
+
+#pragma mark - Protocols
+
+#pragma mark NSCoding
+
+- (id)initWithCoder:(NSCoder *)aDecoder
+{
+    NSURL *url = [aDecoder decodeObjectForKey:AMCachedResponseURLKey];
+    NSInteger statusCode = [aDecoder decodeIntegerForKey:AMCachedResponseStatusCodeKey];
+    NSDictionary *headers = [aDecoder decodeObjectForKey:AMCachedResponseHeadersKey];
+    
+    NSHTTPURLResponse *response = [[NSHTTPURLResponse alloc] initWithURL:url statusCode:statusCode HTTPVersion:@"HTTP/1.1" headerFields:headers];
+    
+    return [self initWithResponse:response
+                             data:[aDecoder decodeObjectForKey:AMCachedResponseDataKey]
+                             date:[aDecoder decodeObjectForKey:AMCachedResponseDateKey]];
+}
+
+- (void)encodeWithCoder:(NSCoder *)aCoder
+{
+    [aCoder encodeObject:_response.URL forKey:AMCachedResponseURLKey];
+    [aCoder encodeInteger:_response.statusCode forKey:AMCachedResponseStatusCodeKey];
+    [aCoder encodeObject:_headers forKey:AMCachedResponseHeadersKey];
+    [aCoder encodeObject:_data forKey:AMCachedResponseDataKey];
+    [aCoder encodeObject:_date forKey:AMCachedResponseDateKey];
+}
+
+@end
+
+#pragma mark - AMResponseCacheNode
+
+/*!
+ * Node of the doubly linked list used to keep the memory cache in LRU order.
+ */
+@interface AMResponseCacheNode : NSObject
+
+@property (nonatomic, strong) NSString *key;
+@property (nonatomic, strong) AMCachedResponse *cachedResponse;
+@property (nonatomic, strong) AMResponseCacheNode *next;
+@property (nonatomic, unsafe_unretained) AMResponseCacheNode *previous;
+
+@end
+
+@implementation AMResponseCacheNode
+
+@end
+
+#pragma mark - AMResponseCache
+
+@implementation AMResponseCache
+{
+    pthread_mutex_t _lock;
+    NSMutableDictionary *_memoryNodes;
+    AMResponseCacheNode *_head;
+    __unsafe_unretained AMResponseCacheNode *_tail;
+    NSUInteger _memoryUsage;
+    
+    NSString *_diskPath;
+    dispatch_queue_t _diskQueue;
+    unsigned long long _diskUsage;
+    
+    // Guarded by _lock. Stores (the cached response) and removals (NSNull) not yet performed by the disk queue, the
+    // number of pending removals of all the files and a counter incremented by every change of the disk cache.
+    NSMutableDictionary *_pendingDiskChanges;
+    NSUInteger _pendingDiskClearCount;
+    NSUInteger _diskGeneration;
+    
+    atomic_ulong _hitCount;
+    atomic_ulong _missCount;
+    atomic_ulong _revalidationCount;
+}
+
+- (id)init
+{
+    return [self initWithMemoryCapacity:4*1024*1024 diskCapacity:20*1024*1024 diskPath:nil];
+}
+
+- (id)initWithMemoryCapacity:(NSUInteger)memoryCapacity diskCapacity:(NSUInteger)diskCapacity diskPath:(NSString*)path
+{
+    self = [super init];
+    if (self)
+    {
+        _memoryCapacity = memoryCapacity;
+        _diskCapacity = diskCapacity;
+        
+        pthread_mutex_init(&_lock, NULL);
+        _memoryNodes = [NSMutableDictionary dictionary];
+        _pendingDiskChanges = [NSMutableDictionary dictionary];
+        
+        atomic_init(&_hitCount, 0);
+        atomic_init(&_missCount, 0);
+        atomic_init(&_revalidationCount, 0);
+        
+        if (_diskCapacity > 0)
+        {
+            if (!path)
+            {
+                NSString *cachesPath = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) firstObject];
+                path = [cachesPath stringByAppendingPathComponent:@"com.vilanovi.AMResponseCache"];
+            }
+            
+            _diskPath = [path copy];
+            _diskQueue = dispatch_queue_create("com.vilanovi.AMResponseCache.disk", DISPATCH_QUEUE_SERIAL);
+            
+            dispatch_async(_diskQueue, ^{
+                [[NSFileManager defaultManager] createDirectoryAtPath:_diskPath withIntermediateDirectories:YES attributes:nil error:NULL];
+                _diskUsage = [self _diskFileSize];
+            });
+        }
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    pthread_mutex_destroy(&_lock);
+    AMDispatchRelease(_diskQueue);
+}
+
+#pragma mark Properties
+
+- (NSUInteger)hitCount
+{
+    return atomic_load_explicit(&_hitCount, memory_order_relaxed);
+}
+
+- (NSUInteger)missCount
+{
+    return atomic_load_explicit(&_missCount, memory_order_relaxed);
+}
+
+- (NSUInteger)revalidationCount
+{
+    return atomic_load_explicit(&_revalidationCount, memory_order_relaxed);
+}
+
+#pragma mark Public Methods
+
+- (AMCachedResponse*)cachedResponseForRequest:(NSURLRequest*)request
+{
+    NSString *key = [self _keyForRequest:request];
+    
+    AMCachedResponse *cachedResponse = nil;
+    
+    if (key)
+    {
+        BOOL readsDisk = NO;
+        NSUInteger diskGeneration = 0;
+        
+        pthread_mutex_lock(&_lock);
+        
+        AMResponseCacheNode *node = [_memoryNodes objectForKey:key];
+        
+        if (node)
+        {
+            [self _moveNodeToHead:node];
+            cachedResponse = node.cachedResponse;
+        }
+        else if (_diskQueue)
+        {
+            // A change waiting in the disk queue is more recent than the file.
+            id pendingChange = [_pendingDiskChanges objectForKey:key];
+            
+            if (pendingChange)
+                cachedResponse = pendingChange != [NSNull null] ? pendingChange : nil;
+            else
+                readsDisk = (_pendingDiskClearCount == 0);
+            
+            diskGeneration = _diskGeneration;
+        }
+        
+        pthread_mutex_unlock(&_lock);
+        
+        // The file is read on the calling thread instead of the disk queue, so a lookup doesn't wait behind the
+        // writes. Files are replaced atomically, a concurrent write or removal only makes the lookup miss.
+        if (readsDisk)
+        {
+            cachedResponse = [self _diskCachedResponseForKey:key];
+            
+            if (cachedResponse)
+            {
+                pthread_mutex_lock(&_lock);
+                
+                // Don't bring back in memory a response that has been replaced or removed while reading the file.
+                if (diskGeneration == _diskGeneration)
+                    [self _insertCachedResponseInMemory:cachedResponse forKey:key];
+                
+                pthread_mutex_unlock(&_lock);
+            }
+        }
+    }
+    
+    if (cachedResponse.isFresh)
+        atomic_fetch_add_explicit(&_hitCount, 1, memory_order_relaxed);
+    else if (cachedResponse.canBeRevalidated)
+        atomic_fetch_add_explicit(&_revalidationCount, 1, memory_order_relaxed);
+    else
+        atomic_fetch_add_explicit(&_missCount, 1, memory_order_relaxed);
+    
+    return cachedResponse;
+}
+
+- (void)storeCachedResponse:(AMCachedResponse*)cachedResponse forRequest:(NSURLRequest*)request
+{
+    NSString *key = [self _keyForRequest:request];
+    
+    if (!key || !cachedResponse)
+        return;
+    
+    pthread_mutex_lock(&_lock);
+    
+    [self _insertCachedResponseInMemory:cachedResponse forKey:key];
+    
+    if (_diskQueue)
+        [self _addPendingDiskChange:cachedResponse forKey:key];
+    
+    pthread_mutex_unlock(&_lock);
+    
+    if (_diskQueue)
+    {
+        dispatch_async(_diskQueue, ^{
+            [self _storeCachedResponseOnDisk:cachedResponse forKey:key];
+            [self _removePendingDiskChange:cachedResponse forKey:key];
+        });
+    }
+}
+
+- (void)removeCachedResponseForRequest:(NSURLRequest*)request
+{
+    NSString *key = [self _keyForRequest:request];
+    
+    if (!key)
+        return;
+    
+    pthread_mutex_lock(&_lock);
+    
+    AMResponseCacheNode *node = [_memoryNodes objectForKey:key];
+    if (node)
+        [self _removeNode:node];
+    
+    if (_diskQueue)
+        [self _addPendingDiskChange:[NSNull null] forKey:key];
+    
+    pthread_mutex_unlock(&_lock);
+    
+    if (_diskQueue)
+    {
+        dispatch_async(_diskQueue, ^{
+            [self _removeDiskFileAtPath:[_diskPath stringByAppendingPathComponent:AMResponseCacheFileNameForKey(key)]];
+            [self _removePendingDiskChange:[NSNull null] forKey:key];
+        });
+    }
+}
+
+- (void)removeAllCachedResponses
+{
+    pthread_mutex_lock(&_lock);
+    
+    [_memoryNodes removeAllObjects];
+    _head = nil;
+    _tail = nil;
+    _memoryUsage = 0;
+    
+    // The pending stores are performed before the files are removed.
+    [_pendingDiskChanges removeAllObjects];
+    _pendingDiskClearCount++;
+    _diskGeneration++;
+    
+    pthread_mutex_unlock(&_lock);
+    
+    if (_diskQueue)
+    {
+        dispatch_async(_diskQueue, ^{
+            NSFileManager *fileManager = [NSFileManager defaultManager];
+            
+            for (NSString *fileName in [fileManager contentsOfDirectoryAtPath:_diskPath error:NULL])
+                [fileManager removeItemAtPath:[_diskPath stringByAppendingPathComponent:fileName] error:NULL];
+            
+            _diskUsage = 0;
+            
+            pthread_mutex_lock(&_lock);
+            _pendingDiskClearCount--;
+            pthread_mutex_unlock(&_lock);
+        });
+    }
+}
+
+#pragma mark Private Methods
+
+- (NSString*)_keyForRequest:(NSURLRequest*)request
+{
+    if (request.HTTPMethod.length > 0 && ![request.HTTPMethod isEqualToString:@"GET"])
+        return nil;
+    
+    return request.URL.absoluteString;
+}
+
+- (void)_insertCachedResponseInMemory:(AMCachedResponse*)cachedResponse forKey:(NSString*)key
+{
+    // Must be called while holding _lock.
+    NSUInteger cost = cachedResponse.data.length;
+    
+    AMResponseCacheNode *node = [_memoryNodes objectForKey:key];
+    if (node)
+        [self _removeNode:node];
+    
+    if (cost <= _memoryCapacity)
+    {
+        node = [[AMResponseCacheNode alloc] init];
+        node.key = key;
+        node.cachedResponse = cachedResponse;
+        
+        [_memoryNodes setObject:node forKey:key];
+        [self _insertNodeAtHead:node];
+        _memoryUsage += cost;
+        
+        while (_memoryUsage > _memoryCapacity && _tail)
+            [self _removeNode:_tail];
+    }
+}
+
+- (void)_addPendingDiskChange:(id)change forKey:(NSString*)key
+{
+    // Must be called while holding _lock.
+    [_pendingDiskChanges setObject:change forKey:key];
+    _diskGeneration++;
+}
+
+- (void)_removePendingDiskChange:(id)change forKey:(NSString*)key
+{
+    // Must be called from the disk queue, once the change has been performed.
+    pthread_mutex_lock(&_lock);
+    
+    // A more recent change of the same key is still pending.
+    if ([_pendingDiskChanges objectForKey:key] == change)
+        [_pendingDiskChanges removeObjectForKey:key];
+    
+    pthread_mutex_unlock(&_lock);
+}
+
+- (void)_insertNodeAtHead:(AMResponseCacheNode*)node
+{
+    node.previous = nil;
+    node.next = _head;
+    
+    _head.previous = node;
+    _head = node;
+    
+    if (!_tail)
+        _tail = node;
+}
+
+- (void)_moveNodeToHead:(AMResponseCacheNode*)node
+{
+    if (node == _head)
+        return;
+    
+    AMResponseCacheNode *strongNode = node;
+    
+    strongNode.previous.next = strongNode.next;
+    strongNode.next.previous = strongNode.previous;
+    
+    if (strongNode == _tail)
+        _tail = strongNode.previous;
+    
+    [self _insertNodeAtHead:strongNode];
+}
+
+- (void)_removeNode:(AMResponseCacheNode*)node
+{
+    AMResponseCacheNode *strongNode = node;
+    
+    if (strongNode.previous)
+        strongNode.previous.next = strongNode.next;
+    else
+        _head = strongNode.next;
+    
+    if (strongNode.next)
+        strongNode.next.previous = strongNode.previous;
+    else
+        _tail = strongNode.previous;
+    
+    strongNode.next = nil;
+    strongNode.previous = nil;
+    
+    _memoryUsage -= strongNode.cachedResponse.data.length;
+    [_memoryNodes removeObjectForKey:strongNode.key];
+}
+
+- (AMCachedResponse*)_diskCachedResponseForKey:(NSString*)key
+{
+    // May be called from any thread: the disk queue writes the files atomically.
+    NSData *archive = [NSData dataWithContentsOfFile:[_diskPath stringByAppendingPathComponent:AMResponseCacheFileNameForKey(key)]];
+    
+    if (!archive)
+        return nil;
+    
+    NSDictionary *entry = nil;
+    
+    @try
+    {
+        entry = [NSKeyedUnarchiver unarchiveObjectWithData:archive];
+    }
+    @catch (NSException *exception)
+    {
+        // Corrupted file, ignore it.
+        return nil;
+    }
+    
+    if (![[entry objectForKey:AMResponseCacheEntryKeyKey] isEqualToString:key])
+        return nil;
+    
+    return [entry objectForKey:AMResponseCacheEntryResponseKey];
+}
+
+- (void)_storeCachedResponseOnDisk:(AMCachedResponse*)cachedResponse forKey:(NSString*)key
+{
+    // Must be called from the disk queue.
+    NSString *path = [_diskPath stringByAppendingPathComponent:AMResponseCacheFileNameForKey(key)];
+    NSData *archive = [NSKeyedArchiver archivedDataWithRootObject:@{AMResponseCacheEntryKeyKey : key,
+                                                                    AMResponseCacheEntryResponseKey : cachedResponse}];
+    
+    // A response too large for the disk cache still replaces the previous one.
+    [self _removeDiskFileAtPath:path];
+    
+    if (archive.length > _diskCapacity)
+        return;
+    
+    if ([archive writeToFile:path atomically:YES])
+        _diskUsage += archive.length;
+    
+    if (_diskUsage > _diskCapacity)
+        [self _trimDiskToCapacity];
+}
+
+- (void)_removeDiskFileAtPath:(NSString*)path
+{
+    // Must be called from the disk queue.
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    unsigned long long size = [[fileManager attributesOfItemAtPath:path error:NULL] fileSize];
+    
+    if ([fileManager removeItemAtPath:path error:NULL])
+        _diskUsage -= MIN(size, _diskUsage);
+}
+
+- (unsigned long long)_diskFileSize
+{
+    // Must be called from the disk queue.
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    unsigned long long size = 0;
+    
+    for (NSString *fileName in [fileManager contentsOfDirectoryAtPath:_diskPath error:NULL])
+        size += [[fileManager attributesOfItemAtPath:[_diskPath stringByAppendingPathComponent:fileName] error:NULL] fileSize];
+    
+    return size;
+}
+
+- (void)_trimDiskToCapacity
+{
+    // Must be called from the disk queue.
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    NSMutableArray *files = [NSMutableArray array];
+    
+    for (NSString *fileName in [fileManager contentsOfDirectoryAtPath:_diskPath error:NULL])
+    {
+        NSString *path = [_diskPath stringByAppendingPathComponent:fileName];
+        NSDictionary *attributes = [fileManager attributesOfItemAtPath:path error:NULL];
+        
+        if (attributes)
+            [files addObject:@{@"path" : path, @"date" : [attributes fileModificationDate]}];
+    }
+    
+    [files sortUsingComparator:^NSComparisonResult(NSDictionary *file1, NSDictionary *file2) {
+        return [[file1 objectForKey:@"date"] compare:[file2 objectForKey:@"date"]];
+    }];
+    
+    for (NSDictionary *file in files)
+    {
+        if (_diskUsage <= _diskCapacity)
+            break;
+        
+        [self _removeDiskFileAtPath:[file objectForKey:@"path"]];
+    }
+}
+
+@end
@@ -0,0 +1,67 @@
+//
+//  AMResponseDecoder.h
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import <Foundation/Foundation.h>
+
+/*!
+ * Protocol of the objects that convert the received data of a connection into an object.
+ * @discussion Decoders are used from the decoding threads of the connection manager, possibly from several threads at the same time, so implementations must be thread safe.
+ */
+@protocol AMResponseDecoding <NSObject>
+
+/*!
+ * Decodes the received data of a connection.
+ * @param response The response of the connection.
+ * @param data The received data.
+ * @param error On output, the error if the data can't be decoded.
+ * @return The decoded object, or nil if the data can't be decoded.
+ */
+- (id)decodedObjectForResponse:(NSURLResponse*)response data:(NSData*)data error:(NSError**)error;
+
+@end
+
+/*!
+ * Decodes JSON responses using NSJSONSerialization.
+ * @discussion Empty responses (for example, 204 No Content) are decoded as nil without error.
+ */
+@interface AMJSONResponseDecoder : NSObject <AMResponseDecoding>
+
+/*!
+ * The options used to read the JSON data. Default value is 0.
+ */
+@property (nonatomic, assign) NSJSONReadingOptions readingOptions;
+
+@end
+
+/*!
+ * Decodes property list responses (XML or binary) using NSPropertyListSerialization.
+ * @discussion Empty responses (for example, 204 No Content) are decoded as nil without error.
+ */
+@interface AMPropertyListResponseDecoder : NSObject <AMResponseDecoding>
+
+/*!
+ * The options used to read the property list. Default value is NSPropertyListImmutable.
+ */
+@property (nonatomic, assign) NSPropertyListReadOptions readOptions;
+
+@end
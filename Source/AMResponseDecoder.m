@@ -0,0 +1,66 @@
+//
+//  AMResponseDecoder.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMResponseDecoder.h"
+
+@implementation AMJSONResponseDecoder
+
+#pragma mark - Protocols
+
+#pragma mark AMResponseDecoding
+
+- (id)decodedObjectForResponse:(NSURLResponse*)response data:(NSData*)data error:(NSError**)error
+{
+    if (data.length == 0)
+        return nil;
+    
+    return [NSJSONSerialization JSONObjectWithData:data options:_readingOptions error:error];
+}
+
+@end
+
+@implementation AMPropertyListResponseDecoder
+
+- (id)init
+{
+    self = [super init];
+    if (self)
+    {
+        _readOptions = NSPropertyListImmutable;
+    }
+    return self;
+}
+
+#pragma mark - Protocols
+
+#pragma mark AMResponseDecoding
+
+- (id)decodedObjectForResponse:(NSURLResponse*)response data:(NSData*)data error:(NSError**)error
+{
+    if (data.length == 0)
+        return nil;
+    
+    return [NSPropertyListSerialization propertyListWithData:data options:_readOptions format:NULL error:error];
+}
+
+@end
@@ -0,0 +1,133 @@
+//
+//  AMRetryPolicy.h
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import <Foundation/Foundation.h>
+
+@class AMTokenBucket;
+
+/*!
+ * Describes when and how failed connections are retried.
+ * @discussion A connection is retried when it fails with one of the `retryableErrorCodes` or when the server answers with one of the `retryableStatusCodes`, up to `maximumAttemptCount` attempts. The delay before each retry grows exponentially from `baseDelay` up to `maximumDelay`, and it is randomized by `jitter` to spread the retries of many clients. When the response contains a Retry-After header the delay is taken from it.
+ *
+ * Retries take tokens from a retry budget, by default the one of the AMConnectionManager, shared by all its connections. When many connections fail at the same time (for example, after a server outage) the budget runs out and the failures are delivered without retrying, so the retries can't multiply the load of a server that is already overloaded.
+ *
+ * Configure the policy before using it. The same policy can be shared by many connections.
+ */
+@interface AMRetryPolicy : NSObject
+
+/*!
+ * Returns a policy with the default values.
+ * @return A new policy.
+ */
++ (AMRetryPolicy*)defaultPolicy;
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name What is retried
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * The maximum number of attempts, including the first one. Default value is 3.
+ */
+@property (nonatomic, assign) NSUInteger maximumAttemptCount;
+
+/*!
+ * The NSURLErrorDomain error codes that are retried. By default, timeouts, lost connections and host resolution or connection failures.
+ */
+@property (nonatomic, strong) NSIndexSet *retryableErrorCodes;
+
+/*!
+ * The HTTP status codes that are retried. By default 408, 429, 500, 502, 503 and 504.
+ */
+@property (nonatomic, strong) NSIndexSet *retryableStatusCodes;
+
+/*!
+ * If NO (the default), only requests with idempotent methods (GET, HEAD, OPTIONS, TRACE, PUT and DELETE) are retried.
+ */
+@property (nonatomic, assign) BOOL retriesNonIdempotentRequests;
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Delay between attempts
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * The delay before the first retry. Default value is 0.5 seconds.
+ */
+@property (nonatomic, assign) NSTimeInterval baseDelay;
+
+/*!
+ * The delay is multiplied by this factor after each attempt. Default value is 2.0.
+ */
+@property (nonatomic, assign) double backoffMultiplier;
+
+/*!
+ * The maximum delay between two attempts. Default value is 30 seconds.
+ */
+@property (nonatomic, assign) NSTimeInterval maximumDelay;
+
+/*!
+ * The fraction of the delay that is randomized, from 0.0 (no randomization) to 1.0 (the delay is a random value between zero and the computed delay). Default value is 1.0.
+ */
+@property (nonatomic, assign) double jitter;
+
+/*!
+ * If YES (the default), the delay is taken from the Retry-After header of the response when present. If the server asks to wait more than `maximumDelay`, the connection is not retried.
+ */
+@property (nonatomic, assign) BOOL honorsRetryAfter;
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Retry budget
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * Each retry takes one token from this bucket, and connections are not retried when the bucket is empty. Default value is nil: the retries take the tokens from the shared budget given when evaluating the policy, the `retryBudget` of the AMConnectionManager.
+ * @discussion Set a bucket to give the connections using this policy a budget of their own. The bucket is shared by all of them, so create it once instead of creating one per request.
+ */
+@property (nonatomic, strong) AMTokenBucket *retryBudget;
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Evaluating the policy
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * Returns the delay before retrying a failed attempt.
+ * @param request The request.
+ * @param response The response of the failed attempt or nil if no response has been received.
+ * @param error The error of the failed attempt or nil if the attempt failed because of the response status code.
+ * @param attempt The number of the failed attempt, starting at 1.
+ * @return The delay in seconds, or a negative value if the request must not be retried.
+ * @discussion If the request can be retried, a token is taken from the `retryBudget` of the policy. Without it, the retry is not limited by a budget.
+ */
+- (NSTimeInterval)retryDelayForRequest:(NSURLRequest*)request response:(NSURLResponse*)response error:(NSError*)error attempt:(NSUInteger)attempt;
+
+/*!
+ * Returns the delay before retrying a failed attempt, taking the retry token from a shared budget when the policy has no `retryBudget`.
+ * @param request The request.
+ * @param response The response of the failed attempt or nil if no response has been received.
+ * @param error The error of the failed attempt or nil if the attempt failed because of the response status code.
+ * @param attempt The number of the failed attempt, starting at 1.
+ * @param sharedBudget The budget shared by all the connections, or nil for no budget.
+ * @return The delay in seconds, or a negative value if the request must not be retried.
+ */
+- (NSTimeInterval)retryDelayForRequest:(NSURLRequest*)request response:(NSURLResponse*)response error:(NSError*)error attempt:(NSUInteger)attempt sharedBudget:(AMTokenBucket*)sharedBudget;
+
+@end
@@ -0,0 +1,176 @@
+//
+//  AMRetryPolicy.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMRetryPolicy.h"
+
+#import "AMTokenBucket.h"
+#import "AMUtilities.h"
+
+@implementation AMRetryPolicy
+
++ (AMRetryPolicy*)defaultPolicy
+{
+    return [[AMRetryPolicy alloc] init];
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self)
+    {
+        _maximumAttemptCount = 3;
+        
+        NSMutableIndexSet *errorCodes = [NSMutableIndexSet indexSet];
+        [errorCodes addIndex:-NSURLErrorTimedOut];
+        [errorCodes addIndex:-NSURLErrorCannotFindHost];
+        [errorCodes addIndex:-NSURLErrorCannotConnectToHost];
+        [errorCodes addIndex:-NSURLErrorNetworkConnectionLost];
+        [errorCodes addIndex:-NSURLErrorDNSLookupFailed];
+        [errorCodes addIndex:-NSURLErrorNotConnectedToInternet];
+        _retryableErrorCodes = errorCodes;
+        
+        NSMutableIndexSet *statusCodes = [NSMutableIndexSet indexSet];
+        [statusCodes addIndex:408];
+        [statusCodes addIndex:429];
+        [statusCodes addIndex:500];
+        [statusCodes addIndex:502];
+        [statusCodes addIndex:503];
+        [statusCodes addIndex:504];
+        _retryableStatusCodes = statusCodes;
+        
+        _retriesNonIdempotentRequests = NO;
+        
+        _baseDelay = 0.5;
+        _backoffMultiplier = 2.0;
+        _maximumDelay = 30.0;
+        _jitter = 1.0;
+        _honorsRetryAfter = YES;
+    }
+    return self;
+}
+
+#pragma mark Public Methods
+
+- (NSTimeInterval)retryDelayForRequest:(NSURLRequest*)request response:(NSURLResponse*)response error:(NSError*)error attempt:(NSUInteger)attempt
+{
+    return [self retryDelayForRequest:request response:response error:error attempt:attempt sharedBudget:nil];
+}
+
+- (NSTimeInterval)retryDelayForRequest:(NSURLRequest*)request response:(NSURLResponse*)response error:(NSError*)error attempt:(NSUInteger)attempt sharedBudget:(AMTokenBucket*)sharedBudget
+{
+    if (attempt >= _maximumAttemptCount)
+        return -1;
+    
+    if (![self _isRetryableRequest:request])
+        return -1;
+    
+    NSHTTPURLResponse *httpResponse = [response isKindOfClass:[NSHTTPURLResponse class]] ? (id)response : nil;
+    
+    if (error)
+    {
+        // NSURLErrorDomain codes are negative; the index set stores their absolute values.
+        if (![error.domain isEqualToString:NSURLErrorDomain] || error.code >= 0 || ![_retryableErrorCodes containsIndex:(NSUInteger)(-error.code)])
+            return -1;
+    }
+    else if (!httpResponse || ![_retryableStatusCodes containsIndex:(NSUInteger)httpResponse.statusCode])
+    {
+        return -1;
+    }
+    
+    NSTimeInterval delay = -1;
+    
+    if (_honorsRetryAfter && httpResponse)
+    {
+        delay = [self _retryAfterDelayForResponse:httpResponse];
+        
+        if (delay > _maximumDelay)
+            return -1;
+    }
+    
+    if (delay < 0)
+        delay = [self _backoffDelayForAttempt:attempt];
+    
+    // Checked last, so only the attempts that are going to be retried take a token.
+    AMTokenBucket *budget = _retryBudget ?: sharedBudget;
+    
+    if (budget && ![budget consumeTokens:1.0])
+        return -1;
+    
+    return delay;
+}
+
+#pragma mark Private Methods
+
+- (BOOL)_isRetryableRequest:(NSURLRequest*)request
+{
+    // A body stream can only be read once.
+    if (request.HTTPBodyStream)
+        return NO;
+    
+    if (_retriesNonIdempotentRequests)
+        return YES;
+    
+    static NSSet *idempotentMethods = nil;
+    static dispatch_once_t pred = 0;
+    dispatch_once(&pred, ^{
+        idempotentMethods = [NSSet setWithObjects:@"GET", @"HEAD", @"OPTIONS", @"TRACE", @"PUT", @"DELETE", nil];
+    });
+    
+    NSString *method = [request.HTTPMethod uppercaseString] ?: @"GET";
+    
+    return [idempotentMethods containsObject:method];
+}
+
+- (NSTimeInterval)_backoffDelayForAttempt:(NSUInteger)attempt
+{
+    NSTimeInterval delay = _baseDelay * pow(MAX(_backoffMultiplier, 1.0), (double)(attempt - 1));
+    delay = MIN(delay, _maximumDelay);
+    
+    double jitter = MIN(MAX(_jitter, 0.0), 1.0);
+    return delay * (1.0 - jitter * AMRandomUnitValue());
+}
+
+- (NSTimeInterval)_retryAfterDelayForResponse:(NSHTTPURLResponse*)response
+{
+    NSString *retryAfter = [[response allHeaderFields] valueForKey:@"Retry-After"];
+    retryAfter = [retryAfter stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+    
+    if (retryAfter.length == 0)
+        return -1;
+    
+    // Either a number of seconds...
+    NSScanner *scanner = [NSScanner scannerWithString:retryAfter];
+    long long seconds = 0;
+    if ([scanner scanLongLong:&seconds] && [scanner isAtEnd])
+        return seconds >= 0 ? (NSTimeInterval)seconds : -1;
+    
+    // ...or an HTTP date.
+    NSDate *date = AMDateFromHTTPDate(retryAfter);
+    
+    if (!date)
+        return -1;
+    
+    return MAX([date timeIntervalSinceNow], 0.0);
+}
+
+@end
@@ -0,0 +1,82 @@
+//
+//  AMTokenBucket.h
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import <Foundation/Foundation.h>
+
+/*!
+ * Thread-safe token bucket.
+ * @discussion The bucket holds up to `capacity` tokens and is refilled continuously at `refillRate` tokens per second. Consumers take tokens before performing an action and the action is not performed if there are not enough tokens, limiting the rate of the action while allowing bursts of up to `capacity` actions.
+ */
+@interface AMTokenBucket : NSObject
+
+/*!
+ * Default initializer. The bucket is created full.
+ * @param capacity The maximum number of tokens in the bucket.
+ * @param refillRate The number of tokens added to the bucket each second.
+ */
+- (id)initWithCapacity:(double)capacity refillRate:(double)refillRate;
+
+/*!
+ * The maximum number of tokens in the bucket.
+ */
+@property (nonatomic, assign, readonly) double capacity;
+
+/*!
+ * The number of tokens added to the bucket each second.
+ */
+@property (nonatomic, assign, readonly) double refillRate;
+
+/*!
+ * The number of tokens currently available.
+ */
+@property (nonatomic, assign, readonly) double availableTokens;
+
+/*!
+ * Takes the given number of tokens from the bucket if they are available.
+ * @param count The number of tokens.
+ * @return YES if the tokens have been taken, NO if there were not enough tokens. In that case the bucket is not modified.
+ */
+- (BOOL)consumeTokens:(double)count;
+
+/*!
+ * Adds the given number of tokens to the bucket, up to its capacity.
+ * @param count The number of tokens.
+ */
+- (void)depositTokens:(double)count;
+
+/*!
+ * Takes the given number of tokens from the bucket even if they are not available, leaving the bucket in debt.
+ * @param count The number of tokens.
+ * @return The time until the debt is paid by the refill, or 0 if the bucket is not in debt. If the refill rate is 0, returns 0.
+ * @discussion Use this method to pace an action that has already been performed, such as receiving a chunk of data: wait the returned time before performing it again.
+ */
+- (NSTimeInterval)takeTokens:(double)count;
+
+/*!
+ * Changes the capacity and the refill rate of the bucket. The tokens that exceed the new capacity and any debt are discarded.
+ * @param capacity The maximum number of tokens in the bucket.
+ * @param refillRate The number of tokens added to the bucket each second.
+ */
+- (void)setCapacity:(double)capacity refillRate:(double)refillRate;
+
+@end
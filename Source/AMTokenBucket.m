@@ -0,0 +1,163 @@
+//
+//  AMTokenBucket.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMTokenBucket.h"
+
+#import <pthread.h>
+
+@implementation AMTokenBucket
+{
+    pthread_mutex_t _lock;
+    
+    double _capacity;
+    double _refillRate;
+    double _tokens;
+    NSTimeInterval _lastRefillTime;
+}
+
+- (id)init
+{
+    return [self initWithCapacity:1.0 refillRate:1.0];
+}
+
+- (id)initWithCapacity:(double)capacity refillRate:(double)refillRate
+{
+    self = [super init];
+    if (self)
+    {
+        pthread_mutex_init(&_lock, NULL);
+        
+        _capacity = MAX(capacity, 0.0);
+        _refillRate = MAX(refillRate, 0.0);
+        
+        _tokens = _capacity;
+        _lastRefillTime = [NSDate timeIntervalSinceReferenceDate];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    pthread_mutex_destroy(&_lock);
+}
+
+#pragma mark Properties
+
+- (double)capacity
+{
+    pthread_mutex_lock(&_lock);
+    double capacity = _capacity;
+    pthread_mutex_unlock(&_lock);
+    
+    return capacity;
+}
+
+- (double)refillRate
+{
+    pthread_mutex_lock(&_lock);
+    double refillRate = _refillRate;
+    pthread_mutex_unlock(&_lock);
+    
+    return refillRate;
+}
+
+- (double)availableTokens
+{
+    pthread_mutex_lock(&_lock);
+    [self _refill];
+    double tokens = _tokens;
+    pthread_mutex_unlock(&_lock);
+    
+    return tokens;
+}
+
+#pragma mark Public Methods
+
+- (BOOL)consumeTokens:(double)count
+{
+    pthread_mutex_lock(&_lock);
+    
+    [self _refill];
+    
+    BOOL consumed = _tokens >= count;
+    if (consumed)
+        _tokens -= count;
+    
+    pthread_mutex_unlock(&_lock);
+    
+    return consumed;
+}
+
+- (void)depositTokens:(double)count
+{
+    pthread_mutex_lock(&_lock);
+    
+    [self _refill];
+    _tokens = MIN(_capacity, _tokens + count);
+    
+    pthread_mutex_unlock(&_lock);
+}
+
+- (NSTimeInterval)takeTokens:(double)count
+{
+    pthread_mutex_lock(&_lock);
+    
+    [self _refill];
+    _tokens -= count;
+    
+    NSTimeInterval delay = (_tokens < 0 && _refillRate > 0) ? -_tokens / _refillRate : 0.0;
+    
+    pthread_mutex_unlock(&_lock);
+    
+    return delay;
+}
+
+- (void)setCapacity:(double)capacity refillRate:(double)refillRate
+{
+    pthread_mutex_lock(&_lock);
+    
+    // The time elapsed until now is refilled at the previous rate.
+    [self _refill];
+    
+    _capacity = MAX(capacity, 0.0);
+    _refillRate = MAX(refillRate, 0.0);
+    _tokens = MIN(_capacity, MAX(_tokens, 0.0));
+    
+    pthread_mutex_unlock(&_lock);
+}
+
+#pragma mark Private Methods
+
+- (void)_refill
+{
+    // Must be called while holding the lock.
+    NSTimeInterval now = [NSDate timeIntervalSinceReferenceDate];
+    NSTimeInterval elapsed = now - _lastRefillTime;
+    
+    if (elapsed > 0)
+        _tokens = MIN(_capacity, _tokens + elapsed * _refillRate);
+    
+    _lastRefillTime = now;
+}
+
+@end
@@ -0,0 +1,117 @@
+//
+//  AMUploadBody.h
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import <Foundation/Foundation.h>
+
+#import "AMDataCompressor.h"
+
+/*!
+ * Request body streamed from a sequence of NSData and file segments.
+ * @discussion The body is never loaded in memory: each time a stream is requested, the segments are read in chunks and written to a bound pair of streams from a network thread, so the memory usage is bounded by the size of the chunks. Because a new stream is created every time, the same body can be sent again by retries, redirects and copies of the connection operation.
+ *
+ * Append all the segments before performing the request.
+ */
+@interface AMUploadBody : NSObject
+
+/*!
+ * Returns a body with the content of a file.
+ * @param fileURL The file URL.
+ * @return A new body.
+ */
++ (instancetype)bodyWithFileURL:(NSURL*)fileURL;
+
+/*!
+ * Appends a data segment.
+ * @param data The data.
+ */
+- (void)appendData:(NSData*)data;
+
+/*!
+ * Appends the content of a file.
+ * @param fileURL The file URL. The file is read when the body is sent, so it must exist until the request has finished.
+ */
+- (void)appendFileURL:(NSURL*)fileURL;
+
+/*!
+ * The value of the Content-Type header of the request. Default value is nil (the header of the request is kept).
+ */
+@property (nonatomic, strong) NSString *contentType;
+
+/*!
+ * The length of the body in bytes, or -1 if a file can't be read.
+ */
+@property (nonatomic, assign, readonly) long long contentLength;
+
+/*!
+ * Returns a new stream with the content of the body.
+ * @return An unopened stream, suitable as HTTPBodyStream.
+ */
+- (NSInputStream*)inputStream;
+
+/*!
+ * Returns a new stream with the content of the body compressed.
+ * @param format The compression format.
+ * @param consumedLengthBlock Block called from a network thread each time a chunk of the body is compressed, with the number of bytes of the body compressed so far. It can be nil.
+ * @return An unopened stream, suitable as HTTPBodyStream.
+ * @discussion The body is compressed as it is streamed. The length of the compressed body is not known in advance, so the request is sent without Content-Length.
+ */
+- (NSInputStream*)compressedInputStreamWithFormat:(AMCompressionFormat)format consumedLengthBlock:(void (^)(long long consumedLength))consumedLengthBlock;
+
+@end
+
+/*!
+ * multipart/form-data body. The multipart framing is generated as small data segments between the parts, so file parts are streamed from disk.
+ */
+@interface AMMultipartUploadBody : AMUploadBody
+
+/*!
+ * The boundary between parts. A random boundary is generated by default.
+ */
+@property (nonatomic, strong, readonly) NSString *boundary;
+
+/*!
+ * Appends a form field.
+ * @param name The name of the field.
+ * @param value The value of the field.
+ */
+- (void)appendPartWithName:(NSString*)name value:(NSString*)value;
+
+/*!
+ * Appends a part with the given data.
+ * @param name The name of the field.
+ * @param data The content of the part.
+ * @param fileName The file name or nil.
+ * @param mimeType The MIME type or nil for application/octet-stream.
+ */
+- (void)appendPartWithName:(NSString*)name data:(NSData*)data fileName:(NSString*)fileName mimeType:(NSString*)mimeType;
+
+/*!
+ * Appends a part with the content of a file.
+ * @param name The name of the field.
+ * @param fileURL The file URL. The file is read when the body is sent, so it must exist until the request has finished.
+ * @param fileName The file name or nil to use the last path component of the URL.
+ * @param mimeType The MIME type or nil for application/octet-stream.
+ */
+- (void)appendPartWithName:(NSString*)name fileURL:(NSURL*)fileURL fileName:(NSString*)fileName mimeType:(NSString*)mimeType;
+
+@end
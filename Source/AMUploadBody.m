@@ -0,0 +1,530 @@
+//
+//  AMUploadBody.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMUploadBody.h"
+
+#import "AMNetworkThreadPool.h"
+#import "AMUtilities.h"
+
+#define AMUploadBodyBufferSize (64 * 1024)
+
+/*!
+ * Writes the segments of a body to the output stream of a bound pair, from a network thread.
+ */
+@interface AMUploadBodyStreamWriter : NSObject <NSStreamDelegate>
+
+- (id)initWithOutputStream:(NSOutputStream*)outputStream segments:(NSArray*)segments;
+- (void)start;
+
+@property (nonatomic, strong) AMDataCompressor *compressor;
+@property (nonatomic, copy) void (^consumedLengthBlock)(long long consumedLength);
+
+@end
+
+@implementation AMUploadBodyStreamWriter
+{
+    NSOutputStream *_outputStream;
+    
+    NSArray *_segments;
+    NSUInteger _segmentIndex;
+    NSUInteger _segmentOffset;
+    NSInputStream *_segmentStream;
+    
+    uint8_t *_buffer;
+    NSUInteger _bufferLength;
+    NSUInteger _bufferOffset;
+    
+    // Compressed output waiting to be written, when the body is compressed.
+    NSData *_pendingData;
+    NSUInteger _pendingOffset;
+    long long _consumedLength;
+    BOOL _compressionFinished;
+    
+    // Streams don't retain their delegates. The writer keeps itself alive until the body has been written.
+    AMUploadBodyStreamWriter *_selfReference;
+}
+
+- (id)initWithOutputStream:(NSOutputStream*)outputStream segments:(NSArray*)segments
+{
+    self = [super init];
+    if (self)
+    {
+        _outputStream = outputStream;
+        _segments = [segments copy];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_buffer);
+}
+
+#pragma mark Public Methods
+
+- (void)start
+{
+    _selfReference = self;
+    
+    [self performSelector:@selector(_open) onThread:[[AMNetworkThreadPool defaultPool] nextThread] withObject:nil waitUntilDone:NO];
+}
+
+#pragma mark Private Methods
+
+- (void)_open
+{
+    _outputStream.delegate = self;
+    [_outputStream scheduleInRunLoop:[NSRunLoop currentRunLoop] forMode:NSDefaultRunLoopMode];
+    [_outputStream open];
+}
+
+- (void)_write
+{
+    if (_compressor)
+    {
+        [self _writeCompressed];
+        return;
+    }
+    
+    while (_segmentIndex < _segments.count)
+    {
+        id segment = [_segments objectAtIndex:_segmentIndex];
+        
+        if ([segment isKindOfClass:[NSData class]])
+        {
+            NSData *data = segment;
+            
+            if (_segmentOffset >= data.length)
+            {
+                [self _moveToNextSegment];
+                continue;
+            }
+            
+            // Data segments are written straight from their bytes.
+            NSInteger written = [_outputStream write:(const uint8_t*)data.bytes + _segmentOffset maxLength:data.length - _segmentOffset];
+            
+            if (written < 0)
+                [self _finish];
+            else
+                _segmentOffset += written;
+            
+            return;
+        }
+        
+        if (_bufferOffset == _bufferLength)
+        {
+            if (!_segmentStream)
+            {
+                _segmentStream = [NSInputStream inputStreamWithURL:segment];
+                [_segmentStream open];
+            }
+            
+            if (!_buffer)
+                _buffer = malloc(AMUploadBodyBufferSize);
+            
+            NSInteger read = [_segmentStream read:_buffer maxLength:AMUploadBodyBufferSize];
+            
+            if (read == 0)
+            {
+                [self _moveToNextSegment];
+                continue;
+            }
+            
+            // The body ends early, the server will reject it because it doesn't match the Content-Length.
+            if (read < 0)
+            {
+                [self _finish];
+                return;
+            }
+            
+            _bufferLength = read;
+            _bufferOffset = 0;
+        }
+        
+        NSInteger written = [_outputStream write:_buffer + _bufferOffset maxLength:_bufferLength - _bufferOffset];
+        
+        if (written < 0)
+            [self _finish];
+        else
+            _bufferOffset += written;
+        
+        return;
+    }
+    
+    // Closing the output stream signals the end of the body to the reader.
+    [self _finish];
+}
+
+- (void)_writeCompressed
+{
+    while (YES)
+    {
+        if (_pendingOffset < _pendingData.length)
+        {
+            NSInteger written = [_outputStream write:(const uint8_t*)_pendingData.bytes + _pendingOffset maxLength:_pendingData.length - _pendingOffset];
+            
+            if (written < 0)
+                [self _finish];
+            else
+                _pendingOffset += written;
+            
+            return;
+        }
+        
+        if (_compressionFinished)
+        {
+            [self _finish];
+            return;
+        }
+        
+        BOOL failed = NO;
+        NSData *chunk = [self _readNextChunkFailed:&failed];
+        
+        // Ending the stream without the compression trailer makes the server reject the body.
+        if (failed)
+        {
+            [self _finish];
+            return;
+        }
+        
+        if (chunk)
+        {
+            _pendingData = [_compressor compressBytes:chunk.bytes length:chunk.length];
+            _consumedLength += chunk.length;
+            
+            if (_consumedLengthBlock)
+                _consumedLengthBlock(_consumedLength);
+        }
+        else
+        {
+            _pendingData = [_compressor finish];
+            _compressionFinished = YES;
+        }
+        
+        _pendingOffset = 0;
+    }
+}
+
+- (NSData*)_readNextChunkFailed:(BOOL*)failed
+{
+    while (_segmentIndex < _segments.count)
+    {
+        id segment = [_segments objectAtIndex:_segmentIndex];
+        
+        if ([segment isKindOfClass:[NSData class]])
+        {
+            NSData *data = segment;
+            NSUInteger length = MIN(data.length - _segmentOffset, (NSUInteger)AMUploadBodyBufferSize);
+            
+            if (length == 0)
+            {
+                [self _moveToNextSegment];
+                continue;
+            }
+            
+            NSData *chunk = [data subdataWithRange:NSMakeRange(_segmentOffset, length)];
+            _segmentOffset += length;
+            return chunk;
+        }
+        
+        if (!_segmentStream)
+        {
+            _segmentStream = [NSInputStream inputStreamWithURL:segment];
+            [_segmentStream open];
+        }
+        
+        if (!_buffer)
+            _buffer = malloc(AMUploadBodyBufferSize);
+        
+        NSInteger read = [_segmentStream read:_buffer maxLength:AMUploadBodyBufferSize];
+        
+        if (read == 0)
+        {
+            [self _moveToNextSegment];
+            continue;
+        }
+        
+        if (read < 0)
+        {
+            *failed = YES;
+            return nil;
+        }
+        
+        // The buffer is reused for the next read, the compressor consumes the bytes before that.
+        return [NSData dataWithBytesNoCopy:_buffer length:read freeWhenDone:NO];
+    }
+    
+    return nil;
+}
+
+- (void)_moveToNextSegment
+{
+    [_segmentStream close];
+    _segmentStream = nil;
+    
+    _segmentIndex++;
+    _segmentOffset = 0;
+    _bufferLength = 0;
+    _bufferOffset = 0;
+}
+
+- (void)_finish
+{
+    [_segmentStream close];
+    _segmentStream = nil;
+    
+    _outputStream.delegate = nil;
+    [_outputStream removeFromRunLoop:[NSRunLoop currentRunLoop] forMode:NSDefaultRunLoopMode];
+    [_outputStream close];
+    
+    _consumedLengthBlock = nil;
+    _selfReference = nil;
+}
+
+#pragma mark - Protocols
+
+#pragma mark NSStreamDelegate
+
+- (void)stream:(NSStream *)stream handleEvent:(NSStreamEvent)eventCode
+{
+    switch (eventCode)
+    {
+        case NSStreamEventHasSpaceAvailable:
+            [self _write];
+            break;
+            
+        case NSStreamEventErrorOccurred:
+        case NSStreamEventEndEncountered:
+            // The reader has been closed.
+            [self _finish];
+            break;
+            
+        default:
+            break;
+    }
+}
+
+@end
+
+@interface AMUploadBody ()
+
+- (NSArray*)_allSegments;
+
+@end
+
+@implementation AMUploadBody
+{
+    NSMutableArray *_segments;
+}
+
++ (instancetype)bodyWithFileURL:(NSURL*)fileURL
+{
+    AMUploadBody *body = [[self alloc] init];
+    [body appendFileURL:fileURL];
+    return body;
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self)
+    {
+        _segments = [NSMutableArray array];
+    }
+    return self;
+}
+
+#pragma mark Properties
+
+- (long long)contentLength
+{
+    long long contentLength = 0;
+    
+    for (id segment in [self _allSegments])
+    {
+        if ([segment isKindOfClass:[NSData class]])
+        {
+            contentLength += [segment length];
+        }
+        else
+        {
+            NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:[segment path] error:nil];
+            
+            if (!attributes)
+                return -1;
+            
+            contentLength += [attributes fileSize];
+        }
+    }
+    
+    return contentLength;
+}
+
+#pragma mark Public Methods
+
+- (void)appendData:(NSData*)data
+{
+    if (data.length == 0)
+        return;
+    
+    @synchronized(_segments)
+    {
+        [_segments addObject:[data copy]];
+    }
+}
+
+- (void)appendFileURL:(NSURL*)fileURL
+{
+    if (!fileURL)
+        return;
+    
+    @synchronized(_segments)
+    {
+        [_segments addObject:fileURL];
+    }
+}
+
+- (NSInputStream*)inputStream
+{
+    NSInputStream *inputStream = nil;
+    NSOutputStream *outputStream = nil;
+    
+    [self _getBoundInputStream:&inputStream outputStream:&outputStream];
+    
+    AMUploadBodyStreamWriter *writer = [[AMUploadBodyStreamWriter alloc] initWithOutputStream:outputStream segments:[self _allSegments]];
+    [writer start];
+    
+    return inputStream;
+}
+
+- (NSInputStream*)compressedInputStreamWithFormat:(AMCompressionFormat)format consumedLengthBlock:(void (^)(long long consumedLength))consumedLengthBlock
+{
+    NSInputStream *inputStream = nil;
+    NSOutputStream *outputStream = nil;
+    
+    [self _getBoundInputStream:&inputStream outputStream:&outputStream];
+    
+    AMUploadBodyStreamWriter *writer = [[AMUploadBodyStreamWriter alloc] initWithOutputStream:outputStream segments:[self _allSegments]];
+    writer.compressor = [[AMDataCompressor alloc] initWithFormat:format];
+    writer.consumedLengthBlock = consumedLengthBlock;
+    [writer start];
+    
+    return inputStream;
+}
+
+#pragma mark Private Methods
+
+- (void)_getBoundInputStream:(NSInputStream**)inputStream outputStream:(NSOutputStream**)outputStream
+{
+#if defined(__APPLE__)
+    CFReadStreamRef readStream = NULL;
+    CFWriteStreamRef writeStream = NULL;
+    
+    CFStreamCreateBoundPair(kCFAllocatorDefault, &readStream, &writeStream, AMUploadBodyBufferSize);
+    
+    *inputStream = (__bridge_transfer NSInputStream*)readStream;
+    *outputStream = (__bridge_transfer NSOutputStream*)writeStream;
+#else
+    // GNUstep has no CFNetwork; its NSStream provides the same bound pair.
+    [NSStream getBoundStreamsWithBufferSize:AMUploadBodyBufferSize inputStream:inputStream outputStream:outputStream];
+#endif
+}
+
+- (NSArray*)_allSegments
+{
+    @synchronized(_segments)
+    {
+        return [_segments copy];
+    }
+}
+
+@end
+
+@implementation AMMultipartUploadBody
+
+- (id)init
+{
+    self = [super init];
+    if (self)
+    {
+        _boundary = [NSString stringWithFormat:@"AMBoundary%016llX", (unsigned long long)AMRandomValue()];
+        self.contentType = [NSString stringWithFormat:@"multipart/form-data; boundary=%@", _boundary];
+    }
+    return self;
+}
+
+#pragma mark Public Methods
+
+- (void)appendPartWithName:(NSString*)name value:(NSString*)value
+{
+    [self _appendPartHeaderWithName:name fileName:nil mimeType:nil];
+    [self appendData:[value dataUsingEncoding:NSUTF8StringEncoding]];
+    [self appendData:[@"\r\n" dataUsingEncoding:NSUTF8StringEncoding]];
+}
+
+- (void)appendPartWithName:(NSString*)name data:(NSData*)data fileName:(NSString*)fileName mimeType:(NSString*)mimeType
+{
+    [self _appendPartHeaderWithName:name fileName:fileName mimeType:mimeType ?: @"application/octet-stream"];
+    [self appendData:data];
+    [self appendData:[@"\r\n" dataUsingEncoding:NSUTF8StringEncoding]];
+}
+
+- (void)appendPartWithName:(NSString*)name fileURL:(NSURL*)fileURL fileName:(NSString*)fileName mimeType:(NSString*)mimeType
+{
+    [self _appendPartHeaderWithName:name fileName:fileName ?: [fileURL lastPathComponent] mimeType:mimeType ?: @"application/octet-stream"];
+    [self appendFileURL:fileURL];
+    [self appendData:[@"\r\n" dataUsingEncoding:NSUTF8StringEncoding]];
+}
+
+#pragma mark Private Methods
+
+- (void)_appendPartHeaderWithName:(NSString*)name fileName:(NSString*)fileName mimeType:(NSString*)mimeType
+{
+    NSMutableString *header = [NSMutableString stringWithFormat:@"--%@\r\nContent-Disposition: form-data; name=\"%@\"", _boundary, [self _quotedString:name]];
+    
+    if (fileName)
+        [header appendFormat:@"; filename=\"%@\"", [self _quotedString:fileName]];
+    
+    [header appendString:@"\r\n"];
+    
+    if (mimeType)
+        [header appendFormat:@"Content-Type: %@\r\n", mimeType];
+    
+    [header appendString:@"\r\n"];
+    
+    [self appendData:[header dataUsingEncoding:NSUTF8StringEncoding]];
+}
+
+- (NSString*)_quotedString:(NSString*)string
+{
+    return [[string ?: @"" stringByReplacingOccurrencesOfString:@"\"" withString:@"%22"] stringByReplacingOccurrencesOfString:@"\r\n" withString:@" "];
+}
+
+- (NSArray*)_allSegments
+{
+    // The closing boundary is not stored, so parts can still be appended.
+    NSData *closingBoundary = [[NSString stringWithFormat:@"--%@--\r\n", _boundary] dataUsingEncoding:NSUTF8StringEncoding];
+    return [[super _allSegments] arrayByAddingObject:closingBoundary];
+}
+
+@end
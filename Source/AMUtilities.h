@@ -0,0 +1,58 @@
+//
+//  AMUtilities.h
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import <Foundation/Foundation.h>
+#import <dispatch/dispatch.h>
+
+/*!
+ * Memory management for dispatch objects.
+ * @discussion Where dispatch objects are Objective-C objects (Apple platforms) ARC manages them and these macros do nothing beyond assigning. 
+ * Elsewhere (GNUstep with libdispatch) properties holding them are declared with AM_DISPATCH_PROPERTY and retained manually.
+ */
+#if OS_OBJECT_USE_OBJC
+#define AM_DISPATCH_PROPERTY strong
+#define AMDispatchRetain(object) (object)
+#define AMDispatchRelease(object) do { } while (0)
+#else
+#define AM_DISPATCH_PROPERTY assign
+#define AMDispatchRetain(object) ({ __typeof__(object) _am_object = (object); if (_am_object) dispatch_retain(_am_object); _am_object; })
+#define AMDispatchRelease(object) do { if (object) dispatch_release(object); } while (0)
+#endif
+
+/*!
+ * Parses an HTTP date (RFC 1123 format, for example "Sun, 06 Nov 1994 08:49:37 GMT").
+ * @param string The date string.
+ * @return The date, or nil if the string is empty or not a valid date.
+ */
+extern NSDate *AMDateFromHTTPDate(NSString *string);
+
+/*!
+ * Returns a pseudo-random 64-bit value. Thread-safe and available on all platforms.
+ * @discussion Not suitable for cryptographic purposes: use it for jitter and unique identifiers.
+ */
+extern uint64_t AMRandomValue(void);
+
+/*!
+ * Returns a pseudo-random value uniformly distributed in [0, 1).
+ */
+extern double AMRandomUnitValue(void);
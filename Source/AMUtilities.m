@@ -0,0 +1,73 @@
+//
+//  AMUtilities.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMUtilities.h"
+
+#import <stdatomic.h>
+#import <time.h>
+#import <unistd.h>
+
+static atomic_ullong AMRandomState;
+
+NSDate *AMDateFromHTTPDate(NSString *string)
+{
+    if (string.length == 0)
+        return nil;
+    
+    static NSDateFormatter *formatter = nil;
+    static dispatch_once_t pred = 0;
+    dispatch_once(&pred, ^{
+        formatter = [[NSDateFormatter alloc] init];
+        formatter.locale = [[NSLocale alloc] initWithLocaleIdentifier:@"en_US_POSIX"];
+        formatter.timeZone = [NSTimeZone timeZoneWithAbbreviation:@"GMT"];
+        formatter.dateFormat = @"EEE, dd MMM yyyy HH:mm:ss zzz";
+    });
+    
+    @synchronized(formatter)
+    {
+        return [formatter dateFromString:string];
+    }
+}
+
+uint64_t AMRandomValue(void)
+{
+    static dispatch_once_t pred = 0;
+    dispatch_once(&pred, ^{
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        atomic_store(&AMRandomState, ((uint64_t)now.tv_sec << 32) ^ (uint64_t)now.tv_nsec ^ ((uint64_t)getpid() << 16));
+    });
+    
+    // SplitMix64: each call takes its own step of the sequence, so concurrent callers never get the same value.
+    uint64_t z = atomic_fetch_add(&AMRandomState, 0x9E3779B97F4A7C15ULL) + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    
+    return z ^ (z >> 31);
+}
+
+double AMRandomUnitValue(void)
+{
+    // The 53 high bits fill the mantissa of a double.
+    return (double)(AMRandomValue() >> 11) * (1.0 / 9007199254740992.0);
+}
@@ -0,0 +1,185 @@
+//
+//  AMBandwidthLimitTests.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import <Foundation/Foundation.h>
+
+#import "AMConnectionManager.h"
+#import "AMStandInServer.h"
+#import "AMBenchmark.h"
+#import "AMTestSupport.h"
+
+/*!
+ * Downloads the given resources in a queue of the manager and returns the time taken, or a negative value if they didn't complete in time.
+ */
+static NSTimeInterval AMTestDownload(AMConnectionManager *manager, NSString *queueIdentifier, NSArray *requests, NSUInteger expectedLength)
+{
+    NSMutableArray *results = [NSMutableArray array];
+    NSDate *startDate = [NSDate date];
+    
+    for (NSURLRequest *request in requests)
+    {
+        [manager performRequest:request
+                       priority:AMConnectionPriorityNormal
+                        inQueue:queueIdentifier
+                 progressStatus:nil
+                completionBlock:^(NSURLResponse *response, NSData *data, NSError *error, NSInteger key) {
+                    AMTestAssert(error == nil, @"%@ failed: %@", request.URL, error);
+                    AMTestAssert(data.length == expectedLength, @"%@ received %lu bytes instead of %lu", request.URL, (unsigned long)data.length, (unsigned long)expectedLength);
+                    
+                    @synchronized(results)
+                    {
+                        [results addObject:@([[NSDate date] timeIntervalSinceDate:startDate])];
+                    }
+                }];
+    }
+    
+    BOOL completed = AMBenchmarkWaitUntil(60.0, ^BOOL{
+        @synchronized(results)
+        {
+            return results.count == requests.count;
+        }
+    });
+    
+    AMTestAssert(completed, @"%lu of %lu downloads completed in time", (unsigned long)results.count, (unsigned long)requests.count);
+    
+    return completed ? [[NSDate date] timeIntervalSinceDate:startDate] : -1.0;
+}
+
+static AMConnectionManager *AMTestConnectionManager(void)
+{
+    AMConnectionManager *manager = [[AMConnectionManager alloc] init];
+    manager.completionQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    return manager;
+}
+
+static void AMTestBandwidthLimitPacesDownloads(void)
+{
+    NSUInteger payloadLength = 256 * 1024;
+    double limit = 256 * 1024;
+    
+    AMStandInServer *server = [[AMStandInServer alloc] init];
+    server.payloadLength = payloadLength;
+    
+    if (![server start])
+    {
+        AMTestAssert(NO, @"The stand-in server could not start");
+        return;
+    }
+    
+    AMConnectionManager *manager = AMTestConnectionManager();
+    [manager setMaxConcurrentConnectionCount:4 inQueue:@"limited"];
+    [manager setBandwidthLimit:limit forQueue:@"limited"];
+    
+    NSMutableArray *requests = [NSMutableArray array];
+    
+    for (NSUInteger i = 0; i < 4; ++i)
+        [requests addObject:[server requestWithPath:[NSString stringWithFormat:@"/limited/%lu", (unsigned long)i] parameters:nil]];
+    
+    // The four downloads share the limit: after a burst of one second of transfer, the rest arrives at the limit.
+    NSTimeInterval duration = AMTestDownload(manager, @"limited", requests, payloadLength);
+    NSTimeInterval minimumDuration = (requests.count * payloadLength - limit) / limit;
+    
+    if (duration >= 0)
+        AMTestAssert(duration >= minimumDuration * 0.9, @"Downloaded %lu bytes in %.2f s, faster than the limit allows (%.2f s)", (unsigned long)(requests.count * payloadLength), duration, minimumDuration);
+    
+    [server stop];
+}
+
+static void AMTestBandwidthLimitAboveThrottledServer(void)
+{
+    NSUInteger payloadLength = 256 * 1024;
+    
+    // The server is the bottleneck: the limit must neither stall nor fail the downloads.
+    AMStandInServer *server = [[AMStandInServer alloc] init];
+    server.payloadLength = payloadLength;
+    server.bytesPerSecond = 128 * 1024;
+    server.sendBufferSize = 16 * 1024;
+    
+    if (![server start])
+    {
+        AMTestAssert(NO, @"The stand-in server could not start");
+        return;
+    }
+    
+    AMConnectionManager *manager = AMTestConnectionManager();
+    [manager setMaxConcurrentConnectionCount:2 inQueue:@"limited"];
+    [manager setBandwidthLimit:1024 * 1024 forQueue:@"limited"];
+    
+    NSArray *requests = @[[server requestWithPath:@"/limited/0" parameters:nil], [server requestWithPath:@"/limited/1" parameters:nil]];
+    NSTimeInterval duration = AMTestDownload(manager, @"limited", requests, payloadLength);
+    
+    // Each connection is paced by the server, not by the limit.
+    if (duration >= 0)
+        AMTestAssert(duration >= 1.5 && duration < 10.0, @"Downloaded from a server sending %lu bytes per second in %.2f s", (unsigned long)server.bytesPerSecond, duration);
+    
+    [server stop];
+}
+
+static void AMTestBandwidthLimitBelowThrottledServer(void)
+{
+    NSUInteger payloadLength = 512 * 1024;
+    double limit = 128 * 1024;
+    
+    // The server is throttled too, but faster than the limit: the limit paces the download.
+    AMStandInServer *server = [[AMStandInServer alloc] init];
+    server.payloadLength = payloadLength;
+    server.bytesPerSecond = 512 * 1024;
+    server.sendBufferSize = 16 * 1024;
+    
+    if (![server start])
+    {
+        AMTestAssert(NO, @"The stand-in server could not start");
+        return;
+    }
+    
+    AMConnectionManager *manager = AMTestConnectionManager();
+    [manager setBandwidthLimit:limit forQueue:@"limited"];
+    
+    // Raising the limit while the download runs applies to it right away.
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(2.0 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        [manager setBandwidthLimit:0 forQueue:@"limited"];
+    });
+    
+    NSTimeInterval duration = AMTestDownload(manager, @"limited", @[[server requestWithPath:@"/limited" parameters:nil]], payloadLength);
+    
+    // Two seconds at the limit (plus the burst) then at the rate of the server.
+    if (duration >= 0)
+        AMTestAssert(duration >= 1.8 && duration < 4.0, @"Downloaded %lu bytes in %.2f s", (unsigned long)payloadLength, duration);
+    
+    [server stop];
+}
+
+int main(int argc, const char *argv[])
+{
+    @autoreleasepool
+    {
+        static const AMTestCase testCases[] =
+        {
+            {"bandwidth limit: paces downloads sharing the limit", AMTestBandwidthLimitPacesDownloads},
+            {"bandwidth limit: above the rate of a throttled server", AMTestBandwidthLimitAboveThrottledServer},
+            {"bandwidth limit: below the rate of a throttled server, raised while running", AMTestBandwidthLimitBelowThrottledServer},
+        };
+        
+        return AMTestMain(testCases, sizeof(testCases) / sizeof(testCases[0]));
+    }
+}
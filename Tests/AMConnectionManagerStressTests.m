@@ -0,0 +1,224 @@
+//
+//  AMConnectionManagerStressTests.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import <Foundation/Foundation.h>
+
+#import "AMConnectionManager.h"
+#import "AMOperationRegistry.h"
+#import "AMStandInServer.h"
+#import "AMBenchmark.h"
+#import "AMTestSupport.h"
+
+#import <stdatomic.h>
+
+static const NSUInteger AMStressThreadCount = 8;
+
+static void AMTestRegistryConcurrentRegistration(void)
+{
+    AMOperationRegistry *registry = [[AMOperationRegistry alloc] init];
+    NSUInteger operationCount = 20000;
+    NSMutableArray *keysByThread = [NSMutableArray arrayWithCapacity:AMStressThreadCount];
+    
+    for (NSUInteger i = 0; i < AMStressThreadCount; ++i)
+        [keysByThread addObject:[NSMutableArray arrayWithCapacity:operationCount]];
+    
+    dispatch_apply(AMStressThreadCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t thread) {
+        
+        NSMutableArray *keys = keysByThread[thread];
+        
+        for (NSUInteger i = 0; i < operationCount; ++i)
+        {
+            NSObject *operation = [[NSObject alloc] init];
+            NSInteger key = [registry nextKey];
+            
+            [registry setOperation:operation forKey:key];
+            AMTestAssert([registry operationForKey:key] == operation, @"Lost the operation of key %ld", (long)key);
+            
+            // Every other operation stays registered until the end.
+            if (i % 2 == 0)
+                AMTestAssert([registry removeOperation:operation forKey:key], @"Could not remove the operation of key %ld", (long)key);
+            else
+                [keys addObject:@(key)];
+        }
+    });
+    
+    NSMutableSet *keys = [NSMutableSet set];
+    
+    for (NSArray *threadKeys in keysByThread)
+        [keys addObjectsFromArray:threadKeys];
+    
+    AMTestAssert(keys.count == AMStressThreadCount * operationCount / 2, @"%lu unique keys of %lu", (unsigned long)keys.count, (unsigned long)(AMStressThreadCount * operationCount / 2));
+    AMTestAssert(registry.count == keys.count, @"The registry has %lu operations instead of %lu", (unsigned long)registry.count, (unsigned long)keys.count);
+    AMTestAssert([registry removeAllOperations].count == keys.count, @"removeAllOperations didn't return every operation");
+    AMTestAssert(registry.count == 0, @"The registry is not empty");
+}
+
+static void AMTestRegistryConcurrentRemoval(void)
+{
+    AMOperationRegistry *registry = [[AMOperationRegistry alloc] init];
+    NSUInteger operationCount = 20000;
+    atomic_ulong removedCount;
+    atomic_init(&removedCount, 0);
+    atomic_ulong *removedCountPointer = &removedCount;
+    
+    NSMutableArray *keys = [NSMutableArray arrayWithCapacity:operationCount];
+    
+    for (NSUInteger i = 0; i < operationCount; ++i)
+    {
+        NSInteger key = [registry nextKey];
+        [registry setOperation:[[NSObject alloc] init] forKey:key];
+        [keys addObject:@(key)];
+    }
+    
+    // Every thread tries to remove every operation: each one must be removed exactly once.
+    dispatch_apply(AMStressThreadCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t thread) {
+        for (NSUInteger i = 0; i < operationCount; ++i)
+        {
+            if ([registry removeOperationForKey:[keys[(i + thread * 997) % operationCount] integerValue]])
+                atomic_fetch_add(removedCountPointer, 1);
+        }
+    });
+    
+    AMTestAssert(atomic_load(&removedCount) == operationCount, @"%lu removals of %lu operations", atomic_load(&removedCount), (unsigned long)operationCount);
+    AMTestAssert(registry.count == 0, @"The registry is not empty");
+}
+
+static void AMTestManagerSubmitCancelComplete(void)
+{
+    AMStandInServer *server = [[AMStandInServer alloc] init];
+    server.latency = 0.005;
+    
+    if (![server start])
+    {
+        AMTestAssert(NO, @"The stand-in server could not start");
+        return;
+    }
+    
+    // A manager of its own: its operations must report to it, not to the default manager.
+    AMConnectionManager *manager = [[AMConnectionManager alloc] init];
+    manager.completionQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    [manager setMaxConcurrentConnectionCount:32 inQueue:@"stress"];
+    
+    NSUInteger requestsPerThread = 250;
+    NSUInteger requestCount = AMStressThreadCount * requestsPerThread;
+    
+    NSMutableIndexSet *completedKeys = [NSMutableIndexSet indexSet];
+    NSMutableIndexSet *cancelledKeys = [NSMutableIndexSet indexSet];
+    NSMutableIndexSet *submittedKeys = [NSMutableIndexSet indexSet];
+    
+    dispatch_apply(AMStressThreadCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t thread) {
+        
+        NSMutableArray *keys = [NSMutableArray arrayWithCapacity:requestsPerThread];
+        
+        for (NSUInteger i = 0; i < requestsPerThread; ++i)
+        {
+            NSURLRequest *request = [server requestWithPath:[NSString stringWithFormat:@"/stress/%zu/%lu", thread, (unsigned long)i] parameters:nil];
+            
+            NSInteger key = [manager performRequest:request
+                                           priority:AMConnectionPriorityNormal
+                                            inQueue:@"stress"
+                                     progressStatus:nil
+                                    completionBlock:^(NSURLResponse *response, NSData *data, NSError *error, NSInteger completedKey) {
+                                        @synchronized(completedKeys)
+                                        {
+                                            AMTestAssert(![completedKeys containsIndex:completedKey], @"Request %ld completed twice", (long)completedKey);
+                                            [completedKeys addIndex:completedKey];
+                                        }
+                                    }];
+            
+            [keys addObject:@(key)];
+            
+            @synchronized(submittedKeys)
+            {
+                AMTestAssert(![submittedKeys containsIndex:key], @"Key %ld assigned twice", (long)key);
+                [submittedKeys addIndex:key];
+            }
+            
+            // Every third request is cancelled and every fifth one changes its priority, a few submissions later.
+            if (i >= 4 && i % 3 == 0)
+            {
+                NSInteger cancelledKey = [keys[i - 4] integerValue];
+                
+                if ([manager cancelRequestWithKey:cancelledKey])
+                {
+                    @synchronized(cancelledKeys)
+                    {
+                        [cancelledKeys addIndex:cancelledKey];
+                    }
+                }
+            }
+            else if (i >= 2 && i % 5 == 0)
+            {
+                [manager changeToPriority:AMConnectionPriorityHigh requestsWithKeys:[NSIndexSet indexSetWithIndex:[keys[i - 2] integerValue]]];
+            }
+        }
+    });
+    
+    NSOperationQueue *queue = [manager operationQueueForIdentifier:@"stress"];
+    
+    BOOL finished = AMBenchmarkWaitUntil(60.0, ^BOOL{
+        
+        NSMutableIndexSet *finishedKeys = nil;
+        
+        @synchronized(completedKeys)
+        {
+            finishedKeys = [completedKeys mutableCopy];
+        }
+        
+        @synchronized(cancelledKeys)
+        {
+            [finishedKeys addIndexes:cancelledKeys];
+        }
+        
+        return finishedKeys.count == requestCount && queue.operationCount == 0;
+    });
+    
+    AMTestAssert(finished, @"%lu completed and %lu cancelled of %lu requests", (unsigned long)completedKeys.count, (unsigned long)cancelledKeys.count, (unsigned long)requestCount);
+    AMTestAssert(submittedKeys.count == requestCount, @"%lu keys for %lu requests", (unsigned long)submittedKeys.count, (unsigned long)requestCount);
+    
+    // Finished operations have unregistered from their manager, so there is nothing left to cancel.
+    __block NSUInteger registeredCount = 0;
+    [submittedKeys enumerateIndexesUsingBlock:^(NSUInteger key, BOOL *stop) {
+        if ([manager cancelRequestWithKey:(NSInteger)key])
+            ++registeredCount;
+    }];
+    
+    AMTestAssert(registeredCount == 0, @"%lu finished requests are still registered", (unsigned long)registeredCount);
+    
+    [server stop];
+}
+
+int main(int argc, const char *argv[])
+{
+    @autoreleasepool
+    {
+        static const AMTestCase testCases[] =
+        {
+            {"registry: concurrent registration", AMTestRegistryConcurrentRegistration},
+            {"registry: concurrent removal", AMTestRegistryConcurrentRemoval},
+            {"manager: submit, cancel and complete from many threads", AMTestManagerSubmitCancelComplete},
+        };
+        
+        return AMTestMain(testCases, sizeof(testCases) / sizeof(testCases[0]));
+    }
+}
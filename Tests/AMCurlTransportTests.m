@@ -0,0 +1,315 @@
+//
+//  AMCurlTransportTests.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+
+#import <Foundation/Foundation.h>
+
+#import "AMConnectionManager.h"
+#import "AMCurlTransport.h"
+#import "AMStandInServer.h"
+#import "AMBenchmark.h"
+#import "AMTestSupport.h"
+
+static AMConnectionManager *AMTestCurlConnectionManager(void)
+{
+    AMConnectionManager *manager = [[AMConnectionManager alloc] init];
+    manager.completionQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    manager.transport = [AMCurlTransport defaultTransport];
+    return manager;
+}
+
+/*!
+ * Returns YES if the data is a body sent by the stand-in server: byte `i` is `i % 251`.
+ */
+static BOOL AMTestIsServerPayload(NSData *data)
+{
+    const unsigned char *bytes = data.bytes;
+    
+    for (NSUInteger i = 0; i < data.length; ++i)
+    {
+        if (bytes[i] != i % 251)
+            return NO;
+    }
+    
+    return YES;
+}
+
+static void AMTestCurlTransportReceivesBodies(void)
+{
+    NSUInteger payloadLength = 300 * 1024;
+    NSUInteger requestCount = 24;
+    
+    AMStandInServer *server = [[AMStandInServer alloc] init];
+    server.payloadLength = payloadLength;
+    
+    if (![server start])
+    {
+        AMTestAssert(NO, @"The stand-in server could not start");
+        return;
+    }
+    
+    AMConnectionManager *manager = AMTestCurlConnectionManager();
+    [manager setMaxConcurrentConnectionCount:4 inQueue:@"curl"];
+    
+    __block NSUInteger completionCount = 0;
+    
+    for (NSUInteger i = 0; i < requestCount; ++i)
+    {
+        NSURLRequest *request = [server requestWithPath:[NSString stringWithFormat:@"/curl/%lu", (unsigned long)i] parameters:nil];
+        
+        [manager performRequest:request
+                       priority:AMConnectionPriorityNormal
+                        inQueue:@"curl"
+                 progressStatus:nil
+                completionBlock:^(NSURLResponse *response, NSData *data, NSError *error, NSInteger key) {
+                    AMTestAssert(error == nil, @"%@ failed: %@", request.URL, error);
+                    AMTestAssert([(NSHTTPURLResponse*)response statusCode] == 200, @"%@ answered %ld", request.URL, (long)[(NSHTTPURLResponse*)response statusCode]);
+                    AMTestAssert(data.length == payloadLength, @"%@ received %lu bytes instead of %lu", request.URL, (unsigned long)data.length, (unsigned long)payloadLength);
+                    AMTestAssert(AMTestIsServerPayload(data), @"%@ received a corrupted body", request.URL);
+                    
+                    @synchronized(manager)
+                    {
+                        ++completionCount;
+                    }
+                }];
+    }
+    
+    BOOL completed = AMBenchmarkWaitUntil(60.0, ^BOOL{
+        @synchronized(manager)
+        {
+            return completionCount == requestCount;
+        }
+    });
+    
+    AMTestAssert(completed, @"%lu of %lu requests completed in time", (unsigned long)completionCount, (unsigned long)requestCount);
+    
+    // Four transfers at a time on kept-alive connections: the connections are reused instead of opened for each request.
+    AMTestAssert(server.connectionCount <= 6, @"%llu connections were opened for %lu requests", server.connectionCount, (unsigned long)requestCount);
+    
+    [server stop];
+}
+
+static void AMTestCurlTransportUploadsBodies(void)
+{
+    NSUInteger bodyLength = 2 * 1024 * 1024;
+    
+    AMStandInServer *server = [[AMStandInServer alloc] init];
+    
+    if (![server start])
+    {
+        AMTestAssert(NO, @"The stand-in server could not start");
+        return;
+    }
+    
+    AMConnectionManager *manager = AMTestCurlConnectionManager();
+    
+    NSMutableData *bodyData = [NSMutableData dataWithLength:bodyLength];
+    arc4random_buf(bodyData.mutableBytes, bodyLength);
+    
+    NSMutableURLRequest *request = [[server requestWithPath:@"/upload" parameters:nil] mutableCopy];
+    request.HTTPMethod = @"POST";
+    request.HTTPBody = bodyData;
+    
+    NSMutableURLRequest *streamRequest = [[server requestWithPath:@"/upload-stream" parameters:nil] mutableCopy];
+    streamRequest.HTTPMethod = @"POST";
+    
+    AMUploadBody *body = [[AMUploadBody alloc] init];
+    [body appendData:bodyData];
+    
+    __block NSUInteger completionCount = 0;
+    __block float uploadProgress = 0.0f;
+    
+    void (^completion)(NSURLResponse*, NSData*, NSError*, NSInteger) = ^(NSURLResponse *response, NSData *data, NSError *error, NSInteger key) {
+        AMTestAssert(error == nil, @"The upload failed: %@", error);
+        AMTestAssert([(NSHTTPURLResponse*)response statusCode] == 200, @"The upload was answered with %ld", (long)[(NSHTTPURLResponse*)response statusCode]);
+        
+        @synchronized(manager)
+        {
+            ++completionCount;
+        }
+    };
+    
+    [manager performRequest:request priority:AMConnectionPriorityNormal inQueue:nil progressStatus:nil completionBlock:completion];
+    
+    [manager performUploadRequest:streamRequest
+                             body:body
+                         priority:AMConnectionPriorityNormal
+                          inQueue:nil
+                   progressStatus:^(NSDictionary *progressStatus) {
+                       NSNumber *progress = progressStatus[AMAsynchronousConnectionStatusUploadProgressKey];
+                       
+                       @synchronized(manager)
+                       {
+                           if (progress)
+                               uploadProgress = MAX(uploadProgress, progress.floatValue);
+                       }
+                   }
+                  completionBlock:completion];
+    
+    BOOL completed = AMBenchmarkWaitUntil(60.0, ^BOOL{
+        @synchronized(manager)
+        {
+            return completionCount == 2;
+        }
+    });
+    
+    AMTestAssert(completed, @"%lu of 2 uploads completed in time", (unsigned long)completionCount);
+    AMTestAssert(uploadProgress == 1.0f, @"The upload progress of %lu bytes stopped at %.2f", (unsigned long)bodyLength, uploadProgress);
+    
+    [server stop];
+}
+
+static void AMTestCurlTransportCancelsTransfers(void)
+{
+    NSUInteger requestCount = 40;
+    
+    // Slow responses, so that every request is cancelled while its body is received.
+    AMStandInServer *server = [[AMStandInServer alloc] init];
+    server.payloadLength = 4 * 1024 * 1024;
+    server.bytesPerSecond = 1024 * 1024;
+    server.sendBufferSize = 16 * 1024;
+    
+    if (![server start])
+    {
+        AMTestAssert(NO, @"The stand-in server could not start");
+        return;
+    }
+    
+    AMConnectionManager *manager = AMTestCurlConnectionManager();
+    [manager setMaxConcurrentConnectionCount:8 inQueue:@"curl"];
+    
+    __block NSUInteger completionCount = 0;
+    NSMutableIndexSet *keys = [NSMutableIndexSet indexSet];
+    
+    for (NSUInteger i = 0; i < requestCount; ++i)
+    {
+        NSURLRequest *request = [server requestWithPath:[NSString stringWithFormat:@"/cancelled/%lu", (unsigned long)i] parameters:nil];
+        
+        NSInteger key = [manager performRequest:request
+                                       priority:AMConnectionPriorityNormal
+                                        inQueue:@"curl"
+                                 progressStatus:nil
+                                completionBlock:^(NSURLResponse *response, NSData *data, NSError *error, NSInteger key) {
+                                    @synchronized(manager)
+                                    {
+                                        ++completionCount;
+                                    }
+                                }];
+        
+        [keys addIndex:key];
+    }
+    
+    // Cancels the requests one by one while they run, from another thread than the transport thread.
+    AMBenchmarkWaitUntil(0.5, ^BOOL{ return NO; });
+    
+    [keys enumerateIndexesUsingBlock:^(NSUInteger key, BOOL *stop) {
+        [manager cancelRequestWithKey:key];
+        usleep(2000);
+    }];
+    
+    // The handles of the cancelled transfers are removed on the transport thread, and the server sees the connections close.
+    BOOL closed = AMBenchmarkWaitUntil(10.0, ^BOOL{
+        return server.activeConnectionCount == 0;
+    });
+    
+    AMTestAssert(closed, @"%llu connections are still open after cancelling every request", server.activeConnectionCount);
+    AMTestAssert(completionCount == 0, @"%lu cancelled requests called their completion", (unsigned long)completionCount);
+    
+    // The transport keeps working after the cancellations.
+    __block BOOL succeeded = NO;
+    
+    [manager performRequest:[server requestWithPath:@"/after-cancel" parameters:@{@"length": @"1024"}]
+                   priority:AMConnectionPriorityNormal
+                    inQueue:@"curl"
+             progressStatus:nil
+            completionBlock:^(NSURLResponse *response, NSData *data, NSError *error, NSInteger key) {
+                @synchronized(manager)
+                {
+                    succeeded = (error == nil && data.length == 1024 && AMTestIsServerPayload(data));
+                }
+            }];
+    
+    BOOL completed = AMBenchmarkWaitUntil(10.0, ^BOOL{
+        @synchronized(manager)
+        {
+            return succeeded;
+        }
+    });
+    
+    AMTestAssert(completed, @"A request following the cancellations did not succeed");
+    
+    [server stop];
+}
+
+static void AMTestCurlTransportSuspendStopsReading(void)
+{
+    NSUInteger payloadLength = 32 * 1024 * 1024;
+    double limit = 256 * 1024;
+    
+    // Small socket buffers on the server, so that it is blocked as soon as the client stops reading.
+    AMStandInServer *server = [[AMStandInServer alloc] init];
+    server.payloadLength = payloadLength;
+    server.sendBufferSize = 16 * 1024;
+    
+    if (![server start])
+    {
+        AMTestAssert(NO, @"The stand-in server could not start");
+        return;
+    }
+    
+    AMConnectionManager *manager = AMTestCurlConnectionManager();
+    [manager setBandwidthLimit:limit forQueue:@"curl"];
+    
+    NSInteger key = [manager performRequest:[server requestWithPath:@"/suspended" parameters:nil]
+                                   priority:AMConnectionPriorityNormal
+                                    inQueue:@"curl"
+                             progressStatus:nil
+                            completionBlock:^(NSURLResponse *response, NSData *data, NSError *error, NSInteger key) {
+                                AMTestAssert(NO, @"The limited download completed");
+                            }];
+    
+    AMBenchmarkWaitUntil(3.0, ^BOOL{ return NO; });
+    
+    // Suspending the transfer pauses the handle: the server is slowed down to the limit instead of sending the whole body.
+    unsigned long long bytesSent = server.bytesSent;
+    AMTestAssert(bytesSent < payloadLength / 2, @"The server sent %llu bytes in 3 s with a limit of %.0f bytes per second", bytesSent, limit);
+    
+    [manager cancelRequestWithKey:key];
+    [server stop];
+}
+
+int main(int argc, const char *argv[])
+{
+    @autoreleasepool
+    {
+        static const AMTestCase testCases[] =
+        {
+            {"curl transport: receives the bodies, reusing connections", AMTestCurlTransportReceivesBodies},
+            {"curl transport: uploads data and streamed bodies", AMTestCurlTransportUploadsBodies},
+            {"curl transport: cancels transfers from other threads", AMTestCurlTransportCancelsTransfers},
+            {"curl transport: a suspended transfer stops reading", AMTestCurlTransportSuspendStopsReading},
+        };
+        
+        return AMTestMain(testCases, sizeof(testCases) / sizeof(testCases[0]));
+    }
+}
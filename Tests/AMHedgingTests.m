@@ -0,0 +1,115 @@
+//
+//  AMHedgingTests.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+
+#import <Foundation/Foundation.h>
+
+#import "AMConnectionManager.h"
+#import "AMStandInServer.h"
+#import "AMBenchmark.h"
+#import "AMTestSupport.h"
+
+static void AMTestHedgeWinsOverSlowPrimary(void)
+{
+    NSUInteger payloadLength = 4 * 1024;
+    
+    // The first response is slow: the server only answers the hedge quickly.
+    AMStandInServer *server = [[AMStandInServer alloc] init];
+    server.payloadLength = payloadLength;
+    server.latency = 2.0;
+    
+    if (![server start])
+    {
+        AMTestAssert(NO, @"The stand-in server could not start");
+        return;
+    }
+    
+    AMConnectionManager *manager = [[AMConnectionManager alloc] init];
+    manager.completionQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    
+    AMHedgingPolicy *policy = [AMHedgingPolicy defaultPolicy];
+    policy.delay = 0.2;
+    [manager setHedgingPolicy:policy forQueue:@"hedged"];
+    
+    __block NSUInteger completionCount = 0;
+    __block NSError *completionError = nil;
+    __block NSUInteger receivedLength = 0;
+    
+    [manager performRequest:[server requestWithPath:@"/hedged" parameters:nil]
+                   priority:AMConnectionPriorityNormal
+                    inQueue:@"hedged"
+             progressStatus:nil
+            completionBlock:^(NSURLResponse *response, NSData *data, NSError *error, NSInteger key) {
+                @synchronized(manager)
+                {
+                    ++completionCount;
+                    completionError = error;
+                    receivedLength = data.length;
+                }
+            }];
+    
+    AMBenchmarkWaitUntil(5.0, ^BOOL{
+        return server.requestCount >= 1;
+    });
+    
+    server.latency = 0;
+    
+    BOOL completed = AMBenchmarkWaitUntil(1.5, ^BOOL{
+        @synchronized(manager)
+        {
+            return completionCount > 0;
+        }
+    });
+    
+    AMTestAssert(completed, @"The request did not complete before the slow first response");
+    AMTestAssert(server.requestCount == 2, @"%llu requests reached the server instead of the primary and the hedge", server.requestCount);
+    
+    // The primary operation is cancelled by the winning hedge. It must not complete the request again.
+    AMBenchmarkWaitUntil(3.0, ^BOOL{ return NO; });
+    
+    AMTestAssert(completionCount == 1, @"The completion was called %lu times", (unsigned long)completionCount);
+    AMTestAssert(completionError == nil, @"The request failed: %@", completionError);
+    AMTestAssert(receivedLength == payloadLength, @"Received %lu bytes instead of %lu", (unsigned long)receivedLength, (unsigned long)payloadLength);
+    
+    // The winning hedge is recorded as a success, not as cancelled by the primary operation it has beaten.
+    AMConnectionMetricsSnapshot *snapshot = [manager.metrics snapshotForHost:server.host];
+    
+    AMTestAssert(snapshot.hedgeWinCount == 1, @"%llu hedge wins recorded instead of 1", snapshot.hedgeWinCount);
+    AMTestAssert(snapshot.succeededCount == 1, @"%llu successes recorded for the host instead of 1", snapshot.succeededCount);
+    AMTestAssert(snapshot.timeToFirstByte.count >= 1, @"No time to first byte recorded for the winning hedge");
+    
+    [server stop];
+}
+
+int main(int argc, const char *argv[])
+{
+    @autoreleasepool
+    {
+        static const AMTestCase testCases[] =
+        {
+            {"hedging: the hedge wins over a slow primary and is recorded once as a success", AMTestHedgeWinsOverSlowPrimary},
+        };
+        
+        return AMTestMain(testCases, sizeof(testCases) / sizeof(testCases[0]));
+    }
+}
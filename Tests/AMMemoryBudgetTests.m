@@ -0,0 +1,150 @@
+//
+//  AMMemoryBudgetTests.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+
+#import <Foundation/Foundation.h>
+
+#import "AMConnectionManager.h"
+#import "AMStandInServer.h"
+#import "AMBenchmark.h"
+#import "AMTestSupport.h"
+
+static AMConnectionManager *AMTestConnectionManager(void)
+{
+    AMConnectionManager *manager = [[AMConnectionManager alloc] init];
+    manager.completionQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    return manager;
+}
+
+/*!
+ * Downloads the resources in memory and returns the number of downloads completed in time with the expected length.
+ */
+static NSUInteger AMTestDownloadInMemory(AMConnectionManager *manager, AMStandInServer *server, NSString *queueIdentifier, NSUInteger requestCount, NSUInteger expectedLength)
+{
+    __block NSUInteger completionCount = 0;
+    
+    for (NSUInteger i = 0; i < requestCount; ++i)
+    {
+        NSURLRequest *request = [server requestWithPath:[NSString stringWithFormat:@"/%@/%lu", queueIdentifier, (unsigned long)i] parameters:nil];
+        
+        [manager performRequest:request
+                       priority:AMConnectionPriorityNormal
+                        inQueue:queueIdentifier
+                 progressStatus:nil
+                completionBlock:^(NSURLResponse *response, NSData *data, NSError *error, NSInteger key) {
+                    AMTestAssert(error == nil, @"%@ failed: %@", request.URL, error);
+                    AMTestAssert(data.length == expectedLength, @"%@ received %lu bytes instead of %lu", request.URL, (unsigned long)data.length, (unsigned long)expectedLength);
+                    
+                    @synchronized(manager)
+                    {
+                        ++completionCount;
+                    }
+                }];
+    }
+    
+    AMBenchmarkWaitUntil(120.0, ^BOOL{
+        @synchronized(manager)
+        {
+            return completionCount == requestCount;
+        }
+    });
+    
+    @synchronized(manager)
+    {
+        return completionCount;
+    }
+}
+
+static void AMTestMemoryBudgetHoldsUnderLoad(void)
+{
+    NSUInteger payloadLength = 4 * 1024 * 1024;
+    NSUInteger requestCount = 32;
+    NSInteger concurrency = 8;
+    unsigned long long byteBudget = 4 * 1024 * 1024;
+    
+    AMStandInServer *server = [[AMStandInServer alloc] init];
+    server.payloadLength = payloadLength;
+    
+    if (![server start])
+    {
+        AMTestAssert(NO, @"The stand-in server could not start");
+        return;
+    }
+    
+    AMConnectionManager *manager = AMTestConnectionManager();
+    [manager setMaxConcurrentConnectionCount:concurrency inQueue:@"budget"];
+    manager.memoryBudget.byteBudget = byteBudget;
+    
+    NSUInteger completionCount = AMTestDownloadInMemory(manager, server, @"budget", requestCount, payloadLength);
+    AMTestAssert(completionCount == requestCount, @"%lu of %lu downloads completed in time", (unsigned long)completionCount, (unsigned long)requestCount);
+    
+    // Without the budget, the eight running downloads would buffer 32 MB. With it, only the transfer left running goes
+    // over the budget, up to a whole response, plus what the other transfers receive before they are suspended.
+    unsigned long long slack = payloadLength + concurrency * 256 * 1024;
+    unsigned long long peakBufferedBytes = manager.memoryBudget.peakBufferedBytes;
+    
+    AMTestAssert(peakBufferedBytes > 0, @"The downloads didn't use the memory budget");
+    AMTestAssert(peakBufferedBytes <= byteBudget + slack, @"%llu bytes were buffered with a budget of %llu bytes", peakBufferedBytes, byteBudget);
+    AMTestAssert(manager.memoryBudget.bufferedBytes == 0, @"%llu bytes are still buffered after the downloads", manager.memoryBudget.bufferedBytes);
+    
+    [server stop];
+}
+
+static void AMTestMemoryBudgetSmallerThanResponses(void)
+{
+    NSUInteger payloadLength = 2 * 1024 * 1024;
+    NSUInteger requestCount = 8;
+    
+    AMStandInServer *server = [[AMStandInServer alloc] init];
+    server.payloadLength = payloadLength;
+    
+    if (![server start])
+    {
+        AMTestAssert(NO, @"The stand-in server could not start");
+        return;
+    }
+    
+    // Every response is larger than the budget: the downloads go on one at a time instead of waiting forever.
+    AMConnectionManager *manager = AMTestConnectionManager();
+    [manager setMaxConcurrentConnectionCount:4 inQueue:@"small-budget"];
+    manager.memoryBudget.byteBudget = 256 * 1024;
+    
+    NSUInteger completionCount = AMTestDownloadInMemory(manager, server, @"small-budget", requestCount, payloadLength);
+    AMTestAssert(completionCount == requestCount, @"%lu of %lu downloads completed in time", (unsigned long)completionCount, (unsigned long)requestCount);
+    
+    [server stop];
+}
+
+int main(int argc, const char *argv[])
+{
+    @autoreleasepool
+    {
+        static const AMTestCase testCases[] =
+        {
+            {"memory budget: holds with many downloads running", AMTestMemoryBudgetHoldsUnderLoad},
+            {"memory budget: smaller than every response", AMTestMemoryBudgetSmallerThanResponses},
+        };
+        
+        return AMTestMain(testCases, sizeof(testCases) / sizeof(testCases[0]));
+    }
+}
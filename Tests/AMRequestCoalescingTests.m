@@ -0,0 +1,156 @@
+//
+//  AMRequestCoalescingTests.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+
+#import <Foundation/Foundation.h>
+
+#import "AMConnectionManager.h"
+#import "AMStandInServer.h"
+#import "AMBenchmark.h"
+#import "AMTestSupport.h"
+
+static AMConnectionManager *AMTestConnectionManager(void)
+{
+    AMConnectionManager *manager = [[AMConnectionManager alloc] init];
+    manager.completionQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    return manager;
+}
+
+/*!
+ * Performs the request and adds its key to the completed keys when it completes successfully.
+ */
+static NSInteger AMTestPerformRequest(AMConnectionManager *manager, NSURLRequest *request, NSUInteger expectedLength, NSMutableIndexSet *completedKeys)
+{
+    return [manager performRequest:request
+                          priority:AMConnectionPriorityNormal
+                           inQueue:nil
+                    progressStatus:nil
+                   completionBlock:^(NSURLResponse *response, NSData *data, NSError *error, NSInteger key) {
+                       AMTestAssert(error == nil, @"Request %ld failed: %@", (long)key, error);
+                       AMTestAssert(data.length == expectedLength, @"Request %ld received %lu bytes instead of %lu", (long)key, (unsigned long)data.length, (unsigned long)expectedLength);
+                       
+                       @synchronized(completedKeys)
+                       {
+                           AMTestAssert(![completedKeys containsIndex:key], @"Request %ld completed twice", (long)key);
+                           [completedKeys addIndex:key];
+                       }
+                   }];
+}
+
+static void AMTestCoalescedKeyCancelledTwice(void)
+{
+    NSUInteger payloadLength = 16 * 1024;
+    
+    AMStandInServer *server = [[AMStandInServer alloc] init];
+    server.payloadLength = payloadLength;
+    server.latency = 0.5;
+    
+    if (![server start])
+    {
+        AMTestAssert(NO, @"The stand-in server could not start");
+        return;
+    }
+    
+    AMConnectionManager *manager = AMTestConnectionManager();
+    manager.coalescesRequests = YES;
+    
+    NSURLRequest *request = [server requestWithPath:@"/coalesced" parameters:nil];
+    NSMutableIndexSet *completedKeys = [NSMutableIndexSet indexSet];
+    
+    NSInteger firstKey = AMTestPerformRequest(manager, request, payloadLength, completedKeys);
+    NSInteger secondKey = AMTestPerformRequest(manager, request, payloadLength, completedKeys);
+    NSInteger thirdKey = AMTestPerformRequest(manager, request, payloadLength, completedKeys);
+    
+    // The first caller started the flight. Cancelling its key again must not cancel the operation the others share.
+    AMTestAssert([manager cancelRequestWithKey:firstKey] != nil, @"The first request could not be cancelled");
+    AMTestAssert([manager cancelRequestWithKey:firstKey] == nil, @"The first request was cancelled twice");
+    [manager cancelRequestsWithKeys:[NSIndexSet indexSetWithIndex:firstKey]];
+    
+    BOOL completed = AMBenchmarkWaitUntil(10.0, ^BOOL{
+        @synchronized(completedKeys)
+        {
+            return [completedKeys containsIndex:secondKey] && [completedKeys containsIndex:thirdKey];
+        }
+    });
+    
+    AMTestAssert(completed, @"The requests sharing the flight of a cancelled key did not complete");
+    AMTestAssert(![completedKeys containsIndex:firstKey], @"The cancelled request completed");
+    AMTestAssert(server.requestCount == 1, @"%llu requests reached the server instead of 1", server.requestCount);
+    
+    [server stop];
+}
+
+static void AMTestPrefetchGroupCancelledTwice(void)
+{
+    NSUInteger payloadLength = 16 * 1024;
+    
+    AMStandInServer *server = [[AMStandInServer alloc] init];
+    server.payloadLength = payloadLength;
+    server.latency = 0.5;
+    
+    if (![server start])
+    {
+        AMTestAssert(NO, @"The stand-in server could not start");
+        return;
+    }
+    
+    AMConnectionManager *manager = AMTestConnectionManager();
+    
+    NSArray *requests = @[[server requestWithPath:@"/prefetched/0" parameters:nil], [server requestWithPath:@"/prefetched/1" parameters:nil]];
+    AMConnectionGroup *prefetchGroup = [manager prefetchRequests:requests];
+    
+    // The foreground requests join the prefetch flights, then the prefetch group is cancelled twice.
+    NSMutableIndexSet *completedKeys = [NSMutableIndexSet indexSet];
+    NSMutableIndexSet *keys = [NSMutableIndexSet indexSet];
+    
+    for (NSURLRequest *request in requests)
+        [keys addIndex:AMTestPerformRequest(manager, request, payloadLength, completedKeys)];
+    
+    [manager cancelRequestsWithKeys:prefetchGroup.connectionKeys];
+    [manager cancelRequestsWithKeys:prefetchGroup.connectionKeys];
+    
+    BOOL completed = AMBenchmarkWaitUntil(10.0, ^BOOL{
+        @synchronized(completedKeys)
+        {
+            return [completedKeys containsIndexes:keys];
+        }
+    });
+    
+    AMTestAssert(completed, @"%lu of %lu requests joining cancelled prefetch requests completed", (unsigned long)completedKeys.count, (unsigned long)keys.count);
+    
+    [server stop];
+}
+
+int main(int argc, const char *argv[])
+{
+    @autoreleasepool
+    {
+        static const AMTestCase testCases[] =
+        {
+            {"coalescing: a key cancelled twice leaves the other waiters alone", AMTestCoalescedKeyCancelledTwice},
+            {"coalescing: a prefetch group cancelled twice leaves the requests joining it alone", AMTestPrefetchGroupCancelledTwice},
+        };
+        
+        return AMTestMain(testCases, sizeof(testCases) / sizeof(testCases[0]));
+    }
+}
@@ -0,0 +1,110 @@
+//
+//  AMBenchmarks.h
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import <Foundation/Foundation.h>
+
+#import "AMConnectionManager.h"
+#import "AMStandInServer.h"
+#import "AMBenchmark.h"
+
+/*!
+ * A benchmark scenario.
+ * @param quick YES to run a reduced workload, like the test suite does.
+ * @return The AMBenchmarkRun of each measured configuration.
+ */
+typedef NSArray *(*AMBenchmarkScenario)(BOOL quick);
+
+/*!
+ * Returns a new connection manager to measure, delivering completion blocks in a global queue so the main thread is free to serve the run loop.
+ */
+extern AMConnectionManager *AMBenchmarkConnectionManager(void);
+
+/*!
+ * Returns a run marked as failed, for scenarios that can't be measured.
+ */
+extern AMBenchmarkRun *AMBenchmarkFailedRun(NSString *name, NSString *reason);
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Load scenarios
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * Many small requests, with 1% of them failing.
+ */
+extern NSArray *AMBenchmarkSmallRequestStorm(BOOL quick);
+
+/*!
+ * A few large downloads received in memory.
+ */
+extern NSArray *AMBenchmarkLargeDownloads(BOOL quick);
+
+/*!
+ * Requests cancelled while they are queued or running.
+ */
+extern NSArray *AMBenchmarkCancellationChurn(BOOL quick);
+
+/*!
+ * Requests in a queue frozen and unfrozen repeatedly until all of them complete.
+ */
+extern NSArray *AMBenchmarkFreezeCycles(BOOL quick);
+
+/*!
+ * The same large downloads received in a file and in memory, to compare the growth of the resident memory.
+ */
+extern NSArray *AMBenchmarkDiskDownloads(BOOL quick);
+
+/*!
+ * A backlog of requests to a slow host followed by requests to three fast hosts, with only a queue limit and with global and per host limits, to compare the tail latency of the fast hosts.
+ */
+extern NSArray *AMBenchmarkMultiHostTailLatency(BOOL quick);
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Threading scenarios
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * A thousand requests in flight at the same time, scheduled in the network thread pool and in a thread per connection.
+ */
+extern NSArray *AMBenchmarkThreadPool(BOOL quick);
+
+#if AM_HAS_LIBCURL
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Transport scenarios
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * The same requests performed with NSURLConnection and AMCurlTransport: one at a time on a kept-alive connection and on a new connection each, to compare the cost of setting up connections, and concurrently, to compare the requests per second.
+ */
+extern NSArray *AMBenchmarkTransports(BOOL quick);
+
+#endif
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Bookkeeping scenarios
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * Operations completing without a connection, spread over a growing number of queues, to measure the cost of submitting and completing them.
+ */
+extern NSArray *AMBenchmarkQueueScaling(BOOL quick);
@@ -0,0 +1,108 @@
+//
+//  AMDownloadBenchmarks.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMBenchmarks.h"
+
+#import "AMConnectionMetrics.h"
+
+static AMBenchmarkRun *AMBenchmarkDownload(NSString *name, AMStandInServer *server, NSUInteger requestCount, BOOL toFile)
+{
+    AMConnectionManager *manager = AMBenchmarkConnectionManager();
+    [manager setMaxConcurrentConnectionCount:requestCount inQueue:name];
+    
+    AMBenchmarkRun *run = [[AMBenchmarkRun alloc] initWithName:name];
+    NSMutableArray *fileURLs = [NSMutableArray arrayWithCapacity:requestCount];
+    
+    [run start];
+    
+    for (NSUInteger i = 0; i < requestCount; ++i)
+    {
+        uint64_t startTime = AMConnectionMetricsCurrentTime();
+        NSURLRequest *request = [server requestWithPath:[NSString stringWithFormat:@"/%@/%lu", name, (unsigned long)i] parameters:nil];
+        
+        if (toFile)
+        {
+            NSString *fileName = [NSString stringWithFormat:@"AMBenchmarks-%d-%@-%lu", [[NSProcessInfo processInfo] processIdentifier], name, (unsigned long)i];
+            NSURL *fileURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:fileName]];
+            [fileURLs addObject:fileURL];
+            
+            [manager performDownloadRequest:request
+                                  toFileURL:fileURL
+                                   priority:AMConnectionPriorityNormal
+                                    inQueue:name
+                             progressStatus:nil
+                            completionBlock:^(NSURLResponse *response, NSURL *fileURL, NSError *error, NSInteger key) {
+                                NSNumber *fileSize = nil;
+                                [fileURL getResourceValue:&fileSize forKey:NSURLFileSizeKey error:NULL];
+                                
+                                [run recordReceivedBytes:[fileSize unsignedLongLongValue]];
+                                [run recordCompletionWithStartTime:startTime response:response error:error];
+                            }];
+        }
+        else
+        {
+            [manager performRequest:request
+                           priority:AMConnectionPriorityNormal
+                            inQueue:name
+                     progressStatus:nil
+                    completionBlock:^(NSURLResponse *response, NSData *data, NSError *error, NSInteger key) {
+                        [run recordReceivedBytes:data.length];
+                        [run recordCompletionWithStartTime:startTime response:response error:error];
+                    }];
+        }
+    }
+    
+    [run waitForCompletionCount:requestCount timeout:300.0];
+    [run stop];
+    
+    unsigned long long expectedBytes = (unsigned long long)requestCount * server.payloadLength;
+    
+    if (run.receivedBytes != expectedBytes)
+        [run failWithReason:[NSString stringWithFormat:@"Received %llu bytes instead of %llu", run.receivedBytes, expectedBytes]];
+    
+    [run setValue:[NSString stringWithFormat:@"%.1f MB", (run.peakResidentMemory - MIN(run.initialResidentMemory, run.peakResidentMemory)) / 1048576.0] forMetric:@"resident memory growth"];
+    
+    for (NSURL *fileURL in fileURLs)
+        [[NSFileManager defaultManager] removeItemAtURL:fileURL error:NULL];
+    
+    return run;
+}
+
+NSArray *AMBenchmarkDiskDownloads(BOOL quick)
+{
+    NSUInteger requestCount = quick ? 2 : 4;
+    
+    AMStandInServer *server = [[AMStandInServer alloc] init];
+    server.payloadLength = quick ? 16 * 1024 * 1024 : 256 * 1024 * 1024;
+    
+    if (![server start])
+        return @[AMBenchmarkFailedRun(@"download-to-file", @"The stand-in server could not start")];
+    
+    // Downloads to a file go first: memory freed by the in-memory downloads may stay resident and hide the growth of a later run.
+    NSArray *runs = @[AMBenchmarkDownload(@"download-to-file", server, requestCount, YES),
+                      AMBenchmarkDownload(@"download-to-memory", server, requestCount, NO)];
+    
+    [server stop];
+    
+    return runs;
+}
@@ -0,0 +1,119 @@
+//
+//  AMHostBenchmarks.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMBenchmarks.h"
+
+#import "AMConnectionMetrics.h"
+
+static NSString *AMBenchmarkLatencySummary(AMLatencyHistogram *histogram)
+{
+    AMLatencyHistogramSnapshot *snapshot = [histogram snapshot];
+    
+    return [NSString stringWithFormat:@"p50 %.2f ms   p99 %.2f ms   p99.9 %.2f ms   max %.2f ms",
+            [snapshot valueAtPercentile:50.0] * 1000.0,
+            [snapshot valueAtPercentile:99.0] * 1000.0,
+            [snapshot valueAtPercentile:99.9] * 1000.0,
+            snapshot.maximum * 1000.0];
+}
+
+static AMBenchmarkRun *AMBenchmarkHostRequests(NSString *name, AMConnectionManager *manager, AMStandInServer *slowServer, NSArray *fastServers, NSUInteger requestCount)
+{
+    AMBenchmarkRun *run = [[AMBenchmarkRun alloc] initWithName:name];
+    AMLatencyHistogram *slowLatency = [[AMLatencyHistogram alloc] init];
+    AMLatencyHistogram *fastLatency = [[AMLatencyHistogram alloc] init];
+    NSUInteger totalCount = requestCount * (fastServers.count + 1);
+    
+    [slowServer resetStatistics];
+    [run start];
+    
+    // The backlog of the slow host is queued first, then the requests to the fast hosts.
+    for (NSUInteger i = 0; i < totalCount; ++i)
+    {
+        BOOL slow = i < requestCount;
+        AMStandInServer *server = slow ? slowServer : fastServers[i % fastServers.count];
+        AMLatencyHistogram *latency = slow ? slowLatency : fastLatency;
+        uint64_t startTime = AMConnectionMetricsCurrentTime();
+        
+        [manager performRequest:[server requestWithPath:[NSString stringWithFormat:@"/%@/%lu", name, (unsigned long)i] parameters:nil]
+                       priority:AMConnectionPriorityNormal
+                        inQueue:name
+                 progressStatus:nil
+                completionBlock:^(NSURLResponse *response, NSData *data, NSError *error, NSInteger key) {
+                    [latency recordMicroseconds:AMConnectionMetricsCurrentTime() - startTime];
+                    [run recordCompletionWithStartTime:startTime response:response error:error];
+                }];
+    }
+    
+    [run waitForCompletionCount:totalCount timeout:120.0];
+    [run stop];
+    
+    [run setValue:AMBenchmarkLatencySummary(fastLatency) forMetric:@"fast hosts"];
+    [run setValue:AMBenchmarkLatencySummary(slowLatency) forMetric:@"slow host"];
+    [run setValue:@(slowServer.peakConnectionCount) forMetric:@"peak slow host connections"];
+    
+    return run;
+}
+
+NSArray *AMBenchmarkMultiHostTailLatency(BOOL quick)
+{
+    NSUInteger requestCount = quick ? 32 : 200;
+    NSUInteger connectionCount = 16;
+    
+    // Each server listens on its own loopback address, so the connection manager sees four hosts.
+    NSMutableArray *servers = [NSMutableArray array];
+    
+    for (NSUInteger i = 0; i < 4; ++i)
+    {
+        AMStandInServer *server = [[AMStandInServer alloc] initWithHost:[NSString stringWithFormat:@"127.0.0.%lu", (unsigned long)(i + 1)]];
+        server.payloadLength = 4 * 1024;
+        server.latency = i == 0 ? 0.25 : 0.005;
+        
+        if (![server start])
+        {
+            [servers makeObjectsPerformSelector:@selector(stop)];
+            return @[AMBenchmarkFailedRun(@"multi-host", [NSString stringWithFormat:@"The stand-in server of %@ could not start (other loopback addresses than 127.0.0.1 need an alias on some systems)", server.host])];
+        }
+        
+        [servers addObject:server];
+    }
+    
+    AMStandInServer *slowServer = servers[0];
+    NSArray *fastServers = [servers subarrayWithRange:NSMakeRange(1, servers.count - 1)];
+    
+    // Only the limit of the queue: the backlog of the slow host takes every connection in turn.
+    AMConnectionManager *queueLimitedManager = AMBenchmarkConnectionManager();
+    [queueLimitedManager setMaxConcurrentConnectionCount:connectionCount inQueue:@"multi-host"];
+    
+    // The same number of connections shared fairly between the hosts, with at most half of them to the same host.
+    AMConnectionManager *hostLimitedManager = AMBenchmarkConnectionManager();
+    [hostLimitedManager setMaxConcurrentConnectionCount:requestCount * servers.count inQueue:@"multi-host-per-host"];
+    hostLimitedManager.maxTotalConcurrentConnectionCount = connectionCount;
+    hostLimitedManager.maxConcurrentConnectionCountPerHost = connectionCount / 2;
+    
+    NSArray *runs = @[AMBenchmarkHostRequests(@"multi-host", queueLimitedManager, slowServer, fastServers, requestCount),
+                      AMBenchmarkHostRequests(@"multi-host-per-host", hostLimitedManager, slowServer, fastServers, requestCount)];
+    
+    [servers makeObjectsPerformSelector:@selector(stop)];
+    
+    return runs;
+}
@@ -0,0 +1,218 @@
+//
+//  AMLoadBenchmarks.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMBenchmarks.h"
+
+#import "AMConnectionMetrics.h"
+
+NSArray *AMBenchmarkSmallRequestStorm(BOOL quick)
+{
+    NSUInteger requestCount = quick ? 200 : 5000;
+    
+    AMStandInServer *server = [[AMStandInServer alloc] init];
+    server.payloadLength = 1024;
+    server.latency = 0.002;
+    server.errorRate = 0.01;
+    
+    if (![server start])
+        return @[AMBenchmarkFailedRun(@"storm", @"The stand-in server could not start")];
+    
+    AMConnectionManager *manager = AMBenchmarkConnectionManager();
+    [manager setMaxConcurrentConnectionCount:64 inQueue:@"storm"];
+    
+    AMBenchmarkRun *run = [[AMBenchmarkRun alloc] initWithName:@"storm"];
+    [run start];
+    
+    for (NSUInteger i = 0; i < requestCount; ++i)
+    {
+        uint64_t startTime = AMConnectionMetricsCurrentTime();
+        
+        [manager performRequest:[server requestWithPath:[NSString stringWithFormat:@"/storm/%lu", (unsigned long)i] parameters:nil]
+                       priority:AMConnectionPriorityNormal
+                        inQueue:@"storm"
+                 progressStatus:nil
+                completionBlock:^(NSURLResponse *response, NSData *data, NSError *error, NSInteger key) {
+                    [run recordCompletionWithStartTime:startTime response:response error:error];
+                }];
+    }
+    
+    [run waitForCompletionCount:requestCount timeout:120.0];
+    [run stop];
+    
+    [run setValue:@(server.connectionCount) forMetric:@"server connections"];
+    [server stop];
+    
+    return @[run];
+}
+
+NSArray *AMBenchmarkLargeDownloads(BOOL quick)
+{
+    NSUInteger requestCount = quick ? 2 : 8;
+    NSUInteger payloadLength = quick ? 4 * 1024 * 1024 : 64 * 1024 * 1024;
+    
+    AMStandInServer *server = [[AMStandInServer alloc] init];
+    server.payloadLength = payloadLength;
+    
+    if (![server start])
+        return @[AMBenchmarkFailedRun(@"large-downloads", @"The stand-in server could not start")];
+    
+    AMConnectionManager *manager = AMBenchmarkConnectionManager();
+    [manager setMaxConcurrentConnectionCount:4 inQueue:@"large-downloads"];
+    
+    AMBenchmarkRun *run = [[AMBenchmarkRun alloc] initWithName:@"large-downloads"];
+    [run start];
+    
+    for (NSUInteger i = 0; i < requestCount; ++i)
+    {
+        uint64_t startTime = AMConnectionMetricsCurrentTime();
+        
+        [manager performRequest:[server requestWithPath:[NSString stringWithFormat:@"/large-downloads/%lu", (unsigned long)i] parameters:nil]
+                       priority:AMConnectionPriorityNormal
+                        inQueue:@"large-downloads"
+                 progressStatus:nil
+                completionBlock:^(NSURLResponse *response, NSData *data, NSError *error, NSInteger key) {
+                    [run recordReceivedBytes:data.length];
+                    [run recordCompletionWithStartTime:startTime response:response error:error];
+                }];
+    }
+    
+    [run waitForCompletionCount:requestCount timeout:300.0];
+    [run stop];
+    
+    if (run.receivedBytes != (unsigned long long)requestCount * payloadLength)
+        [run failWithReason:[NSString stringWithFormat:@"Received %llu bytes instead of %llu", run.receivedBytes, (unsigned long long)requestCount * payloadLength]];
+    
+    [server stop];
+    
+    return @[run];
+}
+
+NSArray *AMBenchmarkCancellationChurn(BOOL quick)
+{
+    NSUInteger requestCount = quick ? 200 : 5000;
+    
+    AMStandInServer *server = [[AMStandInServer alloc] init];
+    server.payloadLength = 16 * 1024;
+    server.latency = 0.02;
+    
+    if (![server start])
+        return @[AMBenchmarkFailedRun(@"cancel-churn", @"The stand-in server could not start")];
+    
+    AMConnectionManager *manager = AMBenchmarkConnectionManager();
+    [manager setMaxConcurrentConnectionCount:32 inQueue:@"cancel-churn"];
+    
+    AMBenchmarkRun *run = [[AMBenchmarkRun alloc] initWithName:@"cancel-churn"];
+    NSMutableArray *keys = [NSMutableArray arrayWithCapacity:requestCount];
+    NSUInteger cancelledCount = 0;
+    
+    [run start];
+    
+    // Every other request is cancelled a few submissions later, while it is queued or running. Cancelled requests don't call their completion block.
+    for (NSUInteger i = 0; i < requestCount; ++i)
+    {
+        uint64_t startTime = AMConnectionMetricsCurrentTime();
+        
+        NSInteger key = [manager performRequest:[server requestWithPath:[NSString stringWithFormat:@"/cancel-churn/%lu", (unsigned long)i] parameters:nil]
+                                       priority:AMConnectionPriorityNormal
+                                        inQueue:@"cancel-churn"
+                                 progressStatus:nil
+                                completionBlock:^(NSURLResponse *response, NSData *data, NSError *error, NSInteger key) {
+                                    [run recordCompletionWithStartTime:startTime response:response error:error];
+                                }];
+        
+        [keys addObject:@(key)];
+        
+        if (i >= 8 && i % 2 == 0 && [manager cancelRequestWithKey:[keys[i - 8] integerValue]])
+            ++cancelledCount;
+    }
+    
+    BOOL completed = AMBenchmarkWaitUntil(120.0, ^BOOL{
+        return run.completionCount + cancelledCount >= requestCount;
+    });
+    
+    [run stop];
+    
+    if (!completed)
+        [run failWithReason:[NSString stringWithFormat:@"%lu of %lu requests completed or cancelled in time", (unsigned long)(run.completionCount + cancelledCount), (unsigned long)requestCount]];
+    
+    [run setValue:@(cancelledCount) forMetric:@"cancelled"];
+    [run setValue:@(server.requestCount) forMetric:@"server requests"];
+    [server stop];
+    
+    return @[run];
+}
+
+NSArray *AMBenchmarkFreezeCycles(BOOL quick)
+{
+    NSUInteger requestCount = quick ? 200 : 2000;
+    
+    AMStandInServer *server = [[AMStandInServer alloc] init];
+    server.payloadLength = 64 * 1024;
+    server.latency = 0.01;
+    
+    if (![server start])
+        return @[AMBenchmarkFailedRun(@"freeze-cycles", @"The stand-in server could not start")];
+    
+    AMConnectionManager *manager = AMBenchmarkConnectionManager();
+    [manager setMaxConcurrentConnectionCount:16 inQueue:@"freeze-cycles"];
+    
+    AMBenchmarkRun *run = [[AMBenchmarkRun alloc] initWithName:@"freeze-cycles"];
+    [run start];
+    
+    for (NSUInteger i = 0; i < requestCount; ++i)
+    {
+        uint64_t startTime = AMConnectionMetricsCurrentTime();
+        
+        [manager performRequest:[server requestWithPath:[NSString stringWithFormat:@"/freeze-cycles/%lu", (unsigned long)i] parameters:nil]
+                       priority:AMConnectionPriorityNormal
+                        inQueue:@"freeze-cycles"
+                 progressStatus:nil
+                completionBlock:^(NSURLResponse *response, NSData *data, NSError *error, NSInteger key) {
+                    [run recordCompletionWithStartTime:startTime response:response error:error];
+                }];
+    }
+    
+    // 40 ms running, 10 ms frozen, until every request completes.
+    NSUInteger cycleCount = 0;
+    NSDate *limit = [NSDate dateWithTimeIntervalSinceNow:120.0];
+    
+    while (run.completionCount < requestCount && [limit timeIntervalSinceNow] > 0)
+    {
+        AMBenchmarkWaitUntil(0.04, ^BOOL{ return run.completionCount >= requestCount; });
+        
+        [manager freezeQueueWithIdentifier:@"freeze-cycles"];
+        AMBenchmarkWaitUntil(0.01, ^BOOL{ return NO; });
+        [manager unfreezeQueueWithIdentifier:@"freeze-cycles"];
+        
+        ++cycleCount;
+    }
+    
+    [run waitForCompletionCount:requestCount timeout:10.0];
+    [run stop];
+    
+    [run setValue:@(cycleCount) forMetric:@"freeze cycles"];
+    [run setValue:@(server.requestCount) forMetric:@"server requests"];
+    [server stop];
+    
+    return @[run];
+}
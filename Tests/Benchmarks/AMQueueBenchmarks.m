@@ -0,0 +1,101 @@
+//
+//  AMQueueBenchmarks.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMBenchmarks.h"
+
+#import "AMConnectionMetrics.h"
+
+/*!
+ * Connection operation completing as soon as it starts, without a connection, so only the bookkeeping of the manager and its queues is measured.
+ */
+@interface AMImmediateConnectionOperation : AMAsyncConnectionOperation
+
+@end
+
+@implementation AMImmediateConnectionOperation
+
+- (void)concurrentMain
+{
+    [self completeOperation];
+}
+
+@end
+
+static AMBenchmarkRun *AMBenchmarkQueueBookkeeping(NSUInteger queueCount, NSUInteger operationCount)
+{
+    NSString *name = [NSString stringWithFormat:@"queues-%lu", (unsigned long)queueCount];
+    NSURLRequest *request = [NSURLRequest requestWithURL:[NSURL URLWithString:@"http://127.0.0.1/queue-scaling"]];
+    
+    AMConnectionManager *manager = AMBenchmarkConnectionManager();
+    NSMutableArray *queueIdentifiers = [NSMutableArray arrayWithCapacity:queueCount];
+    
+    for (NSUInteger i = 0; i < queueCount; ++i)
+    {
+        NSString *queueIdentifier = [NSString stringWithFormat:@"%@/%lu", name, (unsigned long)i];
+        [manager setMaxConcurrentConnectionCount:4 inQueue:queueIdentifier];
+        [queueIdentifiers addObject:queueIdentifier];
+    }
+    
+    AMBenchmarkRun *run = [[AMBenchmarkRun alloc] initWithName:name];
+    [run start];
+    
+    uint64_t submitStartTime = AMConnectionMetricsCurrentTime();
+    
+    // Round-robin between the queues, so every queue is busy and changes its operation count all the time.
+    for (NSUInteger i = 0; i < operationCount; ++i)
+    {
+        uint64_t startTime = AMConnectionMetricsCurrentTime();
+        
+        AMAsyncConnectionOperation *operation = [[AMImmediateConnectionOperation alloc] initWithRequest:request completionBlock:^(NSURLResponse *response, NSData *data, NSError *error) {
+            [run recordCompletionWithStartTime:startTime response:response error:error];
+        }];
+        
+        [manager performConnectionOperation:operation inQueue:queueIdentifiers[i % queueCount]];
+    }
+    
+    uint64_t submitDuration = AMConnectionMetricsCurrentTime() - submitStartTime;
+    
+    [run waitForCompletionCount:operationCount timeout:120.0];
+    [run stop];
+    
+    [run setValue:[NSString stringWithFormat:@"%.2f us", (double)submitDuration / operationCount] forMetric:@"submit time per operation"];
+    
+    return run;
+}
+
+NSArray *AMBenchmarkQueueScaling(BOOL quick)
+{
+    NSUInteger operationCount = quick ? 2000 : 50000;
+    NSArray *queueCounts = quick ? @[@1, @16] : @[@1, @4, @16, @64, @256];
+    NSMutableArray *runs = [NSMutableArray arrayWithCapacity:queueCounts.count];
+    
+    for (NSNumber *queueCount in queueCounts)
+    {
+        @autoreleasepool
+        {
+            [runs addObject:AMBenchmarkQueueBookkeeping([queueCount unsignedIntegerValue], operationCount)];
+        }
+    }
+    
+    return runs;
+}
@@ -0,0 +1,110 @@
+//
+//  AMThreadPoolBenchmarks.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMBenchmarks.h"
+
+#import "AMConnectionMetrics.h"
+
+/*!
+ * Connection operation running as before the network thread pool: a thread is detached for each operation and runs its run loop until the connection finishes.
+ */
+@interface AMDedicatedThreadConnectionOperation : AMAsyncConnectionOperation
+
+@end
+
+@implementation AMDedicatedThreadConnectionOperation
+
+- (NSThread*)concurrentMainThread
+{
+    // AMConcurrentOperation detaches a new thread when there is none.
+    return nil;
+}
+
+- (void)concurrentMain
+{
+    [super concurrentMain];
+    
+    // Keeps the run loop alive between the sources of the connection.
+    NSRunLoop *runLoop = [NSRunLoop currentRunLoop];
+    [runLoop addPort:[NSPort port] forMode:NSDefaultRunLoopMode];
+    
+    while (!self.isFinished)
+    {
+        @autoreleasepool
+        {
+            [runLoop runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+        }
+    }
+}
+
+@end
+
+static AMBenchmarkRun *AMBenchmarkConcurrentRequests(NSString *name, Class operationClass, AMStandInServer *server, NSUInteger requestCount)
+{
+    AMConnectionManager *manager = AMBenchmarkConnectionManager();
+    [manager setMaxConcurrentConnectionCount:requestCount inQueue:name];
+    
+    AMBenchmarkRun *run = [[AMBenchmarkRun alloc] initWithName:name];
+    
+    [server resetStatistics];
+    [run start];
+    
+    for (NSUInteger i = 0; i < requestCount; ++i)
+    {
+        uint64_t startTime = AMConnectionMetricsCurrentTime();
+        NSURLRequest *request = [server requestWithPath:[NSString stringWithFormat:@"/%@/%lu", name, (unsigned long)i] parameters:nil];
+        
+        AMAsyncConnectionOperation *operation = [[operationClass alloc] initWithRequest:request completionBlock:^(NSURLResponse *response, NSData *data, NSError *error) {
+            [run recordCompletionWithStartTime:startTime response:response error:error];
+        }];
+        
+        [manager performConnectionOperation:operation inQueue:name];
+    }
+    
+    [run waitForCompletionCount:requestCount timeout:120.0];
+    [run stop];
+    
+    [run setValue:@(server.peakConnectionCount) forMetric:@"peak server connections"];
+    
+    return run;
+}
+
+NSArray *AMBenchmarkThreadPool(BOOL quick)
+{
+    NSUInteger requestCount = quick ? 100 : 1000;
+    
+    // The latency keeps every request in flight at the same time.
+    AMStandInServer *server = [[AMStandInServer alloc] init];
+    server.payloadLength = 4 * 1024;
+    server.latency = 0.2;
+    
+    if (![server start])
+        return @[AMBenchmarkFailedRun(@"thread-pool", @"The stand-in server could not start")];
+    
+    NSArray *runs = @[AMBenchmarkConcurrentRequests(@"thread-pool", [AMAsyncConnectionOperation class], server, requestCount),
+                      AMBenchmarkConcurrentRequests(@"thread-per-connection", [AMDedicatedThreadConnectionOperation class], server, requestCount)];
+    
+    [server stop];
+    
+    return runs;
+}
@@ -0,0 +1,109 @@
+//
+//  AMTransportBenchmarks.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+
+#import "AMBenchmarks.h"
+
+#if AM_HAS_LIBCURL
+
+#import "AMConnectionMetrics.h"
+#import "AMCurlTransport.h"
+
+/*!
+ * Performs the requests with a transport, at most `concurrency` at a time, and returns the run.
+ * @param closesConnections YES to send `Connection: close` with every request, so each of them pays for a new connection.
+ */
+static AMBenchmarkRun *AMBenchmarkTransportRun(NSString *name, AMStandInServer *server, id<AMConnectionTransport> transport, NSUInteger requestCount, NSInteger concurrency, BOOL closesConnections)
+{
+    AMConnectionManager *manager = AMBenchmarkConnectionManager();
+    manager.transport = transport;
+    [manager setMaxConcurrentConnectionCount:concurrency inQueue:name];
+    
+    [server resetStatistics];
+    
+    AMBenchmarkRun *run = [[AMBenchmarkRun alloc] initWithName:name];
+    [run start];
+    
+    for (NSUInteger i = 0; i < requestCount; ++i)
+    {
+        NSMutableURLRequest *request = [[server requestWithPath:[NSString stringWithFormat:@"/%@/%lu", name, (unsigned long)i] parameters:nil] mutableCopy];
+        
+        if (closesConnections)
+            [request setValue:@"close" forHTTPHeaderField:@"Connection"];
+        
+        uint64_t startTime = AMConnectionMetricsCurrentTime();
+        
+        [manager performRequest:request
+                       priority:AMConnectionPriorityNormal
+                        inQueue:name
+                 progressStatus:nil
+                completionBlock:^(NSURLResponse *response, NSData *data, NSError *error, NSInteger key) {
+                    [run recordReceivedBytes:data.length];
+                    [run recordCompletionWithStartTime:startTime response:response error:error];
+                }];
+        
+        // One request at a time: the latency of each request includes the setup of its connection, if any.
+        if (concurrency == 1 && ![run waitForCompletionCount:i + 1 timeout:30.0])
+            break;
+    }
+    
+    [run waitForCompletionCount:requestCount timeout:120.0];
+    [run stop];
+    
+    [run setValue:@(server.connectionCount) forMetric:@"server connections"];
+    
+    return run;
+}
+
+NSArray *AMBenchmarkTransports(BOOL quick)
+{
+    NSUInteger sequentialCount = quick ? 100 : 2000;
+    NSUInteger concurrentCount = quick ? 500 : 20000;
+    
+    AMStandInServer *server = [[AMStandInServer alloc] init];
+    server.payloadLength = 4 * 1024;
+    
+    if (![server start])
+        return @[AMBenchmarkFailedRun(@"transports", @"The stand-in server could not start")];
+    
+    NSMutableArray *runs = [NSMutableArray array];
+    
+    // A nil transport is NSURLConnection.
+    for (NSString *transportName in @[@"nsurlconnection", @"curl"])
+    {
+        id<AMConnectionTransport> transport = [transportName isEqualToString:@"curl"] ? [AMCurlTransport defaultTransport] : nil;
+        
+        // Sequential requests on a kept-alive connection and on a new connection each: the difference of latency is the cost of setting up a connection.
+        [runs addObject:AMBenchmarkTransportRun([NSString stringWithFormat:@"transports-%@-kept-alive", transportName], server, transport, sequentialCount, 1, NO)];
+        [runs addObject:AMBenchmarkTransportRun([NSString stringWithFormat:@"transports-%@-new-connections", transportName], server, transport, sequentialCount, 1, YES)];
+        
+        // Concurrent requests, for the throughput in requests per second.
+        [runs addObject:AMBenchmarkTransportRun([NSString stringWithFormat:@"transports-%@-concurrent", transportName], server, transport, concurrentCount, 32, NO)];
+    }
+    
+    [server stop];
+    
+    return runs;
+}
+
+#endif
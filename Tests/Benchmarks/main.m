@@ -0,0 +1,132 @@
+//
+//  main.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import <Foundation/Foundation.h>
+
+#import "AMBenchmarks.h"
+
+#import <stdio.h>
+#import <stdlib.h>
+#import <string.h>
+#import <sys/resource.h>
+
+static const struct
+{
+    const char *name;
+    AMBenchmarkScenario scenario;
+} AMBenchmarkScenarios[] =
+{
+    {"storm", AMBenchmarkSmallRequestStorm},
+    {"large-downloads", AMBenchmarkLargeDownloads},
+    {"disk-downloads", AMBenchmarkDiskDownloads},
+    {"multi-host", AMBenchmarkMultiHostTailLatency},
+    {"cancel-churn", AMBenchmarkCancellationChurn},
+    {"freeze-cycles", AMBenchmarkFreezeCycles},
+    {"thread-pool", AMBenchmarkThreadPool},
+#if AM_HAS_LIBCURL
+    {"transports", AMBenchmarkTransports},
+#endif
+    {"queue-scaling", AMBenchmarkQueueScaling},
+};
+
+static const size_t AMBenchmarkScenarioCount = sizeof(AMBenchmarkScenarios) / sizeof(AMBenchmarkScenarios[0]);
+
+AMConnectionManager *AMBenchmarkConnectionManager(void)
+{
+    AMConnectionManager *manager = [[AMConnectionManager alloc] init];
+    manager.completionQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    return manager;
+}
+
+AMBenchmarkRun *AMBenchmarkFailedRun(NSString *name, NSString *reason)
+{
+    AMBenchmarkRun *run = [[AMBenchmarkRun alloc] initWithName:name];
+    [run failWithReason:reason];
+    return run;
+}
+
+static void AMBenchmarkPrintUsage(const char *program)
+{
+    fprintf(stderr, "usage: %s [--quick] [scenario ...]\n\nscenarios:\n", program);
+    
+    for (size_t i = 0; i < AMBenchmarkScenarioCount; ++i)
+        fprintf(stderr, "    %s\n", AMBenchmarkScenarios[i].name);
+}
+
+int main(int argc, const char *argv[])
+{
+    @autoreleasepool
+    {
+        BOOL quick = NO;
+        NSMutableSet *names = [NSMutableSet set];
+        
+        for (int i = 1; i < argc; ++i)
+        {
+            if (strcmp(argv[i], "--quick") == 0)
+            {
+                quick = YES;
+                continue;
+            }
+            
+            BOOL known = NO;
+            
+            for (size_t j = 0; j < AMBenchmarkScenarioCount && !known; ++j)
+                known = strcmp(argv[i], AMBenchmarkScenarios[j].name) == 0;
+            
+            if (!known)
+            {
+                AMBenchmarkPrintUsage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            
+            [names addObject:@(argv[i])];
+        }
+        
+        // A thousand connections in flight go over the default limit of open files of some systems.
+        struct rlimit limit;
+        if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+        {
+            limit.rlim_cur = limit.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &limit);
+        }
+        
+        BOOL failed = NO;
+        
+        for (size_t i = 0; i < AMBenchmarkScenarioCount; ++i)
+        {
+            if (names.count > 0 && ![names containsObject:@(AMBenchmarkScenarios[i].name)])
+                continue;
+            
+            @autoreleasepool
+            {
+                for (AMBenchmarkRun *run in AMBenchmarkScenarios[i].scenario(quick))
+                {
+                    [run report];
+                    failed |= run.failed;
+                }
+            }
+        }
+        
+        return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+}
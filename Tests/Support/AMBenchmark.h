@@ -0,0 +1,162 @@
+//
+//  AMBenchmark.h
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import <Foundation/Foundation.h>
+
+#import "AMLatencyHistogram.h"
+
+/*!
+ * Returns the number of threads of the process.
+ */
+extern NSUInteger AMBenchmarkThreadCount(void);
+
+/*!
+ * Returns the resident memory of the process, in bytes.
+ */
+extern unsigned long long AMBenchmarkResidentMemory(void);
+
+/*!
+ * Runs the run loop of the current thread until the condition is true or the timeout expires.
+ * @param timeout The maximum time to wait.
+ * @param condition Block evaluated every few milliseconds.
+ * @return YES if the condition became true, NO if the timeout expired.
+ * @discussion Waiting in the main thread this way keeps serving the main queue, which the connection manager uses for its bookkeeping.
+ */
+extern BOOL AMBenchmarkWaitUntil(NSTimeInterval timeout, BOOL (^condition)(void));
+
+/*!
+ * Measurements of a benchmark scenario: throughput, latency, errors, peak threads and peak resident memory.
+ * @discussion Completions can be recorded concurrently from any thread. The peaks are sampled every few milliseconds between -start and -stop.
+ */
+@interface AMBenchmarkRun : NSObject
+
+/*!
+ * Designated initializer.
+ * @param name The name of the scenario.
+ * @return The initialized run.
+ */
+- (id)initWithName:(NSString*)name;
+
+/*!
+ * The name of the scenario.
+ */
+@property (nonatomic, strong, readonly) NSString *name;
+
+/*!
+ * Starts the clock and the sampling of threads and memory.
+ */
+- (void)start;
+
+/*!
+ * Stops the clock and the sampling.
+ */
+- (void)stop;
+
+/*!
+ * Records a completed request.
+ * @param startTime The time the request was performed, as returned by AMConnectionMetricsCurrentTime().
+ * @param response The response of the request. Responses with an HTTP status of 400 or higher count as errors.
+ * @param error The error of the request, or nil if it succeeded.
+ */
+- (void)recordCompletionWithStartTime:(uint64_t)startTime response:(NSURLResponse*)response error:(NSError*)error;
+
+/*!
+ * Adds bytes to the count of received bytes, reported with their rate.
+ * @param length The number of bytes.
+ */
+- (void)recordReceivedBytes:(unsigned long long)length;
+
+/*!
+ * Waits, serving the run loop of the current thread, until the given number of completions has been recorded.
+ * @param completionCount The number of completions to wait for.
+ * @param timeout The maximum time to wait. When it expires the run is marked as failed.
+ * @return YES if the completions were recorded in time.
+ */
+- (BOOL)waitForCompletionCount:(NSUInteger)completionCount timeout:(NSTimeInterval)timeout;
+
+/*!
+ * Adds a value to the report, like the bytes received or the connections opened.
+ * @param value The value, printed with its description.
+ * @param metric The name of the value.
+ */
+- (void)setValue:(id)value forMetric:(NSString*)metric;
+
+/*!
+ * Marks the run as failed, for example because the requests did not complete in time.
+ * @param reason The reason, printed in the report.
+ */
+- (void)failWithReason:(NSString*)reason;
+
+/*!
+ * YES if -failWithReason: was called.
+ */
+@property (nonatomic, assign, readonly) BOOL failed;
+
+/*!
+ * The number of recorded completions.
+ */
+@property (nonatomic, assign, readonly) NSUInteger completionCount;
+
+/*!
+ * The number of recorded completions with an error.
+ */
+@property (nonatomic, assign, readonly) NSUInteger errorCount;
+
+/*!
+ * The number of recorded received bytes.
+ */
+@property (nonatomic, assign, readonly) unsigned long long receivedBytes;
+
+/*!
+ * The latencies of the recorded completions.
+ */
+@property (nonatomic, strong, readonly) AMLatencyHistogram *latency;
+
+/*!
+ * The time between -start and -stop.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval duration;
+
+/*!
+ * The number of completions per second.
+ */
+@property (nonatomic, assign, readonly) double completionsPerSecond;
+
+/*!
+ * The number of threads of the process when the run started, and the highest number sampled.
+ */
+@property (nonatomic, assign, readonly) NSUInteger initialThreadCount;
+@property (nonatomic, assign, readonly) NSUInteger peakThreadCount;
+
+/*!
+ * The resident memory of the process when the run started, and the highest value sampled, in bytes.
+ */
+@property (nonatomic, assign, readonly) unsigned long long initialResidentMemory;
+@property (nonatomic, assign, readonly) unsigned long long peakResidentMemory;
+
+/*!
+ * Prints the measurements to the standard output.
+ */
+- (void)report;
+
+@end
@@ -0,0 +1,336 @@
+//
+//  AMBenchmark.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMBenchmark.h"
+
+#import "AMConnectionMetrics.h"
+
+#import <pthread.h>
+#import <stdatomic.h>
+#import <stdio.h>
+#import <string.h>
+#import <time.h>
+
+#if defined(__APPLE__)
+#import <mach/mach.h>
+#endif
+
+#if !defined(__APPLE__)
+/*!
+ * Returns the value of a field of /proc/self/status, or zero if it is missing.
+ */
+static unsigned long long AMBenchmarkProcessStatusValue(const char *field)
+{
+    FILE *file = fopen("/proc/self/status", "r");
+    
+    if (!file)
+        return 0;
+    
+    char line[256];
+    size_t fieldLength = strlen(field);
+    unsigned long long value = 0;
+    
+    while (fgets(line, sizeof(line), file))
+    {
+        if (strncmp(line, field, fieldLength) == 0 && line[fieldLength] == ':')
+        {
+            value = strtoull(line + fieldLength + 1, NULL, 10);
+            break;
+        }
+    }
+    
+    fclose(file);
+    return value;
+}
+#endif
+
+NSUInteger AMBenchmarkThreadCount(void)
+{
+#if defined(__APPLE__)
+    thread_act_array_t threads = NULL;
+    mach_msg_type_number_t count = 0;
+    
+    if (task_threads(mach_task_self(), &threads, &count) != KERN_SUCCESS)
+        return 0;
+    
+    for (mach_msg_type_number_t i = 0; i < count; ++i)
+        mach_port_deallocate(mach_task_self(), threads[i]);
+    
+    vm_deallocate(mach_task_self(), (vm_address_t)threads, count * sizeof(thread_act_t));
+    
+    return count;
+#else
+    return (NSUInteger)AMBenchmarkProcessStatusValue("Threads");
+#endif
+}
+
+unsigned long long AMBenchmarkResidentMemory(void)
+{
+#if defined(__APPLE__)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS)
+        return 0;
+    
+    return info.resident_size;
+#else
+    return AMBenchmarkProcessStatusValue("VmRSS") * 1024;
+#endif
+}
+
+BOOL AMBenchmarkWaitUntil(NSTimeInterval timeout, BOOL (^condition)(void))
+{
+    NSDate *limit = [NSDate dateWithTimeIntervalSinceNow:timeout];
+    
+    while (!condition())
+    {
+        if ([limit timeIntervalSinceNow] <= 0)
+            return NO;
+        
+        @autoreleasepool
+        {
+            [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.005]];
+        }
+    }
+    
+    return YES;
+}
+
+static void *AMBenchmarkRunSample(void *context);
+
+@implementation AMBenchmarkRun
+{
+    NSMutableArray *_metrics;
+    NSString *_failureReason;
+    
+    atomic_ulong _completionCount;
+    atomic_ulong _errorCount;
+    atomic_ullong _receivedBytes;
+    
+    uint64_t _startTime;
+    uint64_t _stopTime;
+    
+    pthread_t _samplingThread;
+    atomic_bool _sampling;
+    atomic_ulong _peakThreadCount;
+    atomic_ullong _peakResidentMemory;
+}
+
+- (id)init
+{
+    return [self initWithName:nil];
+}
+
+- (id)initWithName:(NSString*)name
+{
+    self = [super init];
+    if (self)
+    {
+        _name = [name copy];
+        _metrics = [NSMutableArray array];
+        _latency = [[AMLatencyHistogram alloc] init];
+        
+        atomic_init(&_completionCount, 0);
+        atomic_init(&_errorCount, 0);
+        atomic_init(&_receivedBytes, 0);
+        atomic_init(&_sampling, false);
+        atomic_init(&_peakThreadCount, 0);
+        atomic_init(&_peakResidentMemory, 0);
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [self stop];
+}
+
+#pragma mark Properties
+
+- (NSUInteger)completionCount
+{
+    return atomic_load(&_completionCount);
+}
+
+- (NSUInteger)errorCount
+{
+    return atomic_load(&_errorCount);
+}
+
+- (unsigned long long)receivedBytes
+{
+    return atomic_load(&_receivedBytes);
+}
+
+- (NSTimeInterval)duration
+{
+    uint64_t stopTime = _stopTime > 0 ? _stopTime : AMConnectionMetricsCurrentTime();
+    return (stopTime - _startTime) / 1000000.0;
+}
+
+- (double)completionsPerSecond
+{
+    NSTimeInterval duration = self.duration;
+    return duration > 0 ? self.completionCount / duration : 0.0;
+}
+
+- (NSUInteger)peakThreadCount
+{
+    return atomic_load(&_peakThreadCount);
+}
+
+- (unsigned long long)peakResidentMemory
+{
+    return atomic_load(&_peakResidentMemory);
+}
+
+- (BOOL)failed
+{
+    return _failureReason != nil;
+}
+
+#pragma mark Public Methods
+
+- (void)start
+{
+    _initialThreadCount = AMBenchmarkThreadCount();
+    _initialResidentMemory = AMBenchmarkResidentMemory();
+    
+    atomic_store(&_peakThreadCount, _initialThreadCount);
+    atomic_store(&_peakResidentMemory, _initialResidentMemory);
+    
+    _startTime = AMConnectionMetricsCurrentTime();
+    _stopTime = 0;
+    
+    // A plain thread, so sampling does not depend on the run loops or the queues being measured.
+    if (!atomic_exchange(&_sampling, true))
+        pthread_create(&_samplingThread, NULL, AMBenchmarkRunSample, (__bridge void*)self);
+}
+
+- (void)stop
+{
+    if (!atomic_exchange(&_sampling, false))
+        return;
+    
+    pthread_join(_samplingThread, NULL);
+    _stopTime = AMConnectionMetricsCurrentTime();
+}
+
+- (void)recordCompletionWithStartTime:(uint64_t)startTime response:(NSURLResponse*)response error:(NSError*)error
+{
+    [_latency recordMicroseconds:AMConnectionMetricsCurrentTime() - startTime];
+    
+    if (error || ([response isKindOfClass:[NSHTTPURLResponse class]] && [(NSHTTPURLResponse*)response statusCode] >= 400))
+        atomic_fetch_add(&_errorCount, 1);
+    
+    // Counted last, so a waiter that sees the completion also sees its error.
+    atomic_fetch_add(&_completionCount, 1);
+}
+
+- (void)recordReceivedBytes:(unsigned long long)length
+{
+    atomic_fetch_add(&_receivedBytes, length);
+}
+
+- (BOOL)waitForCompletionCount:(NSUInteger)completionCount timeout:(NSTimeInterval)timeout
+{
+    BOOL completed = AMBenchmarkWaitUntil(timeout, ^BOOL{
+        return self.completionCount >= completionCount;
+    });
+    
+    if (!completed)
+        [self failWithReason:[NSString stringWithFormat:@"%lu of %lu requests completed in %.0f s", (unsigned long)self.completionCount, (unsigned long)completionCount, timeout]];
+    
+    return completed;
+}
+
+- (void)setValue:(id)value forMetric:(NSString*)metric
+{
+    [_metrics addObject:[NSString stringWithFormat:@"%@: %@", metric, value]];
+}
+
+- (void)failWithReason:(NSString*)reason
+{
+    _failureReason = [reason copy];
+}
+
+- (void)report
+{
+    AMLatencyHistogramSnapshot *latency = [_latency snapshot];
+    
+    printf("%-24s %8lu done %6lu errors %10.1f req/s   p50 %8.2f ms   p99 %8.2f ms   threads %4lu (%lu)   RSS %7.1f MB (%.1f)\n",
+           [_name UTF8String],
+           (unsigned long)self.completionCount,
+           (unsigned long)self.errorCount,
+           self.completionsPerSecond,
+           [latency valueAtPercentile:50.0] * 1000.0,
+           [latency valueAtPercentile:99.0] * 1000.0,
+           (unsigned long)self.peakThreadCount,
+           (unsigned long)_initialThreadCount,
+           self.peakResidentMemory / 1048576.0,
+           _initialResidentMemory / 1048576.0);
+    
+    unsigned long long receivedBytes = self.receivedBytes;
+    NSTimeInterval duration = self.duration;
+    
+    if (receivedBytes > 0 && duration > 0)
+        printf("%-24s received %.1f MB (%.1f MB/s)\n", "", receivedBytes / 1048576.0, receivedBytes / 1048576.0 / duration);
+    
+    for (NSString *metric in _metrics)
+        printf("%-24s %s\n", "", [metric UTF8String]);
+    
+    if (_failureReason)
+        printf("%-24s FAILED: %s\n", "", [_failureReason UTF8String]);
+    
+    fflush(stdout);
+}
+
+#pragma mark Private Methods
+
+- (void)_sample
+{
+    struct timespec interval = {0, 5 * 1000 * 1000};
+    
+    while (atomic_load(&_sampling))
+    {
+        unsigned long threadCount = AMBenchmarkThreadCount();
+        unsigned long peakThreadCount = atomic_load(&_peakThreadCount);
+        while (threadCount > peakThreadCount && !atomic_compare_exchange_weak(&_peakThreadCount, &peakThreadCount, threadCount));
+        
+        unsigned long long residentMemory = AMBenchmarkResidentMemory();
+        unsigned long long peakResidentMemory = atomic_load(&_peakResidentMemory);
+        while (residentMemory > peakResidentMemory && !atomic_compare_exchange_weak(&_peakResidentMemory, &peakResidentMemory, residentMemory));
+        
+        nanosleep(&interval, NULL);
+    }
+}
+
+@end
+
+static void *AMBenchmarkRunSample(void *context)
+{
+    AMBenchmarkRun *run = (__bridge AMBenchmarkRun*)context;
+    [run _sample];
+    return NULL;
+}
@@ -0,0 +1,151 @@
+//
+//  AMStandInServer.h
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import <Foundation/Foundation.h>
+
+/*!
+ * Loopback HTTP/1.1 server standing in for a real server in the tests and the benchmarks.
+ * @discussion The server runs in a child process forked by -start, so its threads and its memory are not counted in the measurements of the process under test. 
+ * Every request is answered, after the configured latency, with a body of the configured length, and a fraction of the requests fail with a 500 status. Connections are kept alive so clients can reuse them.
+ * The query of a request overrides the configuration for that request: `length` (bytes), `latency` (milliseconds), `status` and `rate` (bytes per second).
+ */
+@interface AMStandInServer : NSObject
+
+/*!
+ * Designated initializer.
+ * @param host The IPv4 address to listen on. Any address of the 127.0.0.0/8 block works on Linux, so several servers can stand in for different hosts.
+ * @return The initialized server, not started yet.
+ */
+- (id)initWithHost:(NSString*)host;
+
+/*!
+ * The address the server listens on.
+ */
+@property (nonatomic, strong, readonly) NSString *host;
+
+/*!
+ * The port the server listens on, chosen by the system when the server starts. Zero if the server is not running.
+ */
+@property (nonatomic, assign, readonly) uint16_t port;
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Running the server
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * Starts listening and serving requests.
+ * @return YES if the server is running, NO if it could not listen or fork.
+ */
+- (BOOL)start;
+
+/*!
+ * Stops the server, closing its open connections.
+ */
+- (void)stop;
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Configuring responses
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * The length of the response bodies, in bytes. Default is 1024.
+ * @discussion The configuration can be changed while the server runs: it applies to the requests received from then on.
+ */
+@property (nonatomic, assign) NSUInteger payloadLength;
+
+/*!
+ * The time waited before answering each request. Default is zero.
+ */
+@property (nonatomic, assign) NSTimeInterval latency;
+
+/*!
+ * The fraction of the requests, from 0.0 to 1.0, answered with a 500 status. Default is zero.
+ */
+@property (nonatomic, assign) double errorRate;
+
+/*!
+ * The rate at which response bodies are sent, in bytes per second. Zero (the default) sends them as fast as the client reads.
+ */
+@property (nonatomic, assign) NSUInteger bytesPerSecond;
+
+/*!
+ * The size of the send buffer of the sockets, in bytes. Zero (the default) keeps the system size.
+ * @discussion Set a small buffer before starting the server to make `bytesSent` follow the rate at which the client reads from the socket.
+ */
+@property (nonatomic, assign) NSUInteger sendBufferSize;
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Building requests
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * Returns the URL of a resource of the server.
+ * @param path The path, for example "/resource". Each path is a different resource for the caches and the coalescing of requests.
+ * @param parameters The overrides of the configuration for the request (`length`, `latency`, `status` or `rate`), or nil.
+ * @return The URL.
+ */
+- (NSURL*)URLWithPath:(NSString*)path parameters:(NSDictionary*)parameters;
+
+/*!
+ * Returns a request that is never answered from a cache.
+ * @param path The path of the resource.
+ * @param parameters The overrides of the configuration for the request, or nil.
+ * @return The request.
+ */
+- (NSURLRequest*)requestWithPath:(NSString*)path parameters:(NSDictionary*)parameters;
+
+/// --------------------------------------------------------------------------------------------------------------------------------
+/// @name Statistics
+/// --------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+ * The number of requests received.
+ */
+@property (nonatomic, assign, readonly) unsigned long long requestCount;
+
+/*!
+ * The number of connections accepted.
+ */
+@property (nonatomic, assign, readonly) unsigned long long connectionCount;
+
+/*!
+ * The number of connections open right now.
+ */
+@property (nonatomic, assign, readonly) unsigned long long activeConnectionCount;
+
+/*!
+ * The highest number of connections open at the same time.
+ */
+@property (nonatomic, assign, readonly) unsigned long long peakConnectionCount;
+
+/*!
+ * The number of bytes written to the sockets, headers included.
+ */
+@property (nonatomic, assign, readonly) unsigned long long bytesSent;
+
+/*!
+ * Resets the statistics to zero.
+ */
+- (void)resetStatistics;
+
+@end
@@ -0,0 +1,575 @@
+//
+//  AMStandInServer.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMStandInServer.h"
+
+#import <arpa/inet.h>
+#import <errno.h>
+#import <netinet/in.h>
+#import <pthread.h>
+#import <signal.h>
+#import <stdatomic.h>
+#import <stdio.h>
+#import <stdlib.h>
+#import <string.h>
+#import <strings.h>
+#import <sys/mman.h>
+#import <sys/socket.h>
+#import <sys/wait.h>
+#import <time.h>
+#import <unistd.h>
+
+#if defined(__linux__)
+#import <sys/prctl.h>
+#endif
+
+#define AMStandInServerHeaderCapacity 8192
+#define AMStandInServerPatternPeriod 251
+#define AMStandInServerChunkLength 65536
+
+/*!
+ * State shared by the parent and the server process.
+ */
+typedef struct
+{
+    _Atomic(size_t) payloadLength;
+    _Atomic(uint64_t) latency;
+    _Atomic(double) errorRate;
+    _Atomic(size_t) bytesPerSecond;
+    _Atomic(size_t) sendBufferSize;
+    
+    atomic_ullong requestCount;
+    atomic_ullong connectionCount;
+    atomic_ullong activeConnectionCount;
+    atomic_ullong peakConnectionCount;
+    atomic_ullong bytesSent;
+} AMStandInServerState;
+
+typedef struct
+{
+    int socket;
+    AMStandInServerState *state;
+} AMStandInServerConnection;
+
+/*!
+ * Body bytes: byte `i` of every body is `i % AMStandInServerPatternPeriod`, so any chunk is a slice of this buffer.
+ */
+static unsigned char AMStandInServerPattern[AMStandInServerChunkLength + AMStandInServerPatternPeriod];
+
+static uint64_t AMStandInServerCurrentTime(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000;
+}
+
+static void AMStandInServerSleepUntil(uint64_t time)
+{
+    uint64_t now = AMStandInServerCurrentTime();
+    
+    while (now < time)
+    {
+        uint64_t interval = time - now;
+        struct timespec request = {(time_t)(interval / 1000000), (long)(interval % 1000000) * 1000};
+        nanosleep(&request, NULL);
+        now = AMStandInServerCurrentTime();
+    }
+}
+
+static BOOL AMStandInServerSend(AMStandInServerConnection *connection, const void *bytes, size_t length)
+{
+    const char *cursor = bytes;
+    
+    while (length > 0)
+    {
+        ssize_t sent = send(connection->socket, cursor, length, 0);
+        
+        if (sent < 0 && errno == EINTR)
+            continue;
+        
+        if (sent <= 0)
+            return NO;
+        
+        atomic_fetch_add(&connection->state->bytesSent, (unsigned long long)sent);
+        cursor += sent;
+        length -= (size_t)sent;
+    }
+    
+    return YES;
+}
+
+static BOOL AMStandInServerSendBody(AMStandInServerConnection *connection, size_t length, size_t bytesPerSecond)
+{
+    // Throttled bodies are sent in chunks of about 50 ms, each one when it is due.
+    size_t chunkLength = bytesPerSecond > 0 ? MAX(MIN(bytesPerSecond / 20, AMStandInServerChunkLength), 1) : AMStandInServerChunkLength;
+    uint64_t startTime = AMStandInServerCurrentTime();
+    size_t offset = 0;
+    
+    while (offset < length)
+    {
+        size_t count = MIN(chunkLength, length - offset);
+        
+        if (!AMStandInServerSend(connection, &AMStandInServerPattern[offset % AMStandInServerPatternPeriod], count))
+            return NO;
+        
+        offset += count;
+        
+        if (bytesPerSecond > 0)
+            AMStandInServerSleepUntil(startTime + (uint64_t)((double)offset / bytesPerSecond * 1000000.0));
+    }
+    
+    return YES;
+}
+
+static const char *AMStandInServerReasonPhrase(long status)
+{
+    switch (status)
+    {
+        case 200: return "OK";
+        case 404: return "Not Found";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        default: return "Unknown";
+    }
+}
+
+static const char *AMStandInServerHeaderField(const char *header, const char *name)
+{
+    // The header starts with the request line, so every field is preceded by a line break.
+    size_t nameLength = strlen(name);
+    const char *line = strstr(header, "\r\n");
+    
+    while (line)
+    {
+        line += 2;
+        
+        if (strncasecmp(line, name, nameLength) == 0 && line[nameLength] == ':')
+            return line + nameLength + 1 + strspn(line + nameLength + 1, " \t");
+        
+        line = strstr(line, "\r\n");
+    }
+    
+    return NULL;
+}
+
+static void *AMStandInServerConnectionMain(void *context)
+{
+    AMStandInServerConnection connection = *(AMStandInServerConnection*)context;
+    AMStandInServerState *state = connection.state;
+    free(context);
+    
+    unsigned long long active = atomic_fetch_add(&state->activeConnectionCount, 1) + 1;
+    unsigned long long peak = atomic_load(&state->peakConnectionCount);
+    while (active > peak && !atomic_compare_exchange_weak(&state->peakConnectionCount, &peak, active));
+    
+    unsigned int seed = (unsigned int)AMStandInServerCurrentTime() ^ (unsigned int)connection.socket;
+    char buffer[AMStandInServerHeaderCapacity + 1];
+    size_t length = 0;
+    
+    while (YES)
+    {
+        // Reads the request header.
+        char *end = NULL;
+        
+        while (YES)
+        {
+            buffer[length] = '\0';
+            end = strstr(buffer, "\r\n\r\n");
+            
+            if (end || length == AMStandInServerHeaderCapacity)
+                break;
+            
+            ssize_t count = recv(connection.socket, buffer + length, AMStandInServerHeaderCapacity - length, 0);
+            
+            if (count < 0 && errno == EINTR)
+                continue;
+            
+            if (count <= 0)
+                break;
+            
+            length += (size_t)count;
+        }
+        
+        if (!end)
+            break;
+        
+        size_t headerLength = (size_t)(end - buffer) + 4;
+        end[2] = '\0';
+        
+        // Discards the request body.
+        const char *contentLength = AMStandInServerHeaderField(buffer, "Content-Length");
+        const char *connectionOption = AMStandInServerHeaderField(buffer, "Connection");
+        long long bodyLength = contentLength ? MAX(strtoll(contentLength, NULL, 10), 0) : 0;
+        BOOL keepAlive = !connectionOption || strncasecmp(connectionOption, "close", 5) != 0;
+        size_t buffered = MIN(length - headerLength, (size_t)bodyLength);
+        
+        char target[1024] = "";
+        sscanf(buffer, "%*s %1023s", target);
+        
+        bodyLength -= buffered;
+        length -= headerLength + buffered;
+        memmove(buffer, buffer + headerLength + buffered, length);
+        
+        while (bodyLength > 0)
+        {
+            char discarded[16384];
+            ssize_t count = recv(connection.socket, discarded, (size_t)MIN(bodyLength, (long long)sizeof(discarded)), 0);
+            
+            if (count < 0 && errno == EINTR)
+                continue;
+            
+            if (count <= 0)
+                break;
+            
+            bodyLength -= count;
+        }
+        
+        if (bodyLength > 0)
+            break;
+        
+        atomic_fetch_add(&state->requestCount, 1);
+        
+        // The query overrides the configuration.
+        size_t payloadLength = atomic_load(&state->payloadLength);
+        uint64_t latency = atomic_load(&state->latency);
+        size_t bytesPerSecond = atomic_load(&state->bytesPerSecond);
+        long status = (double)rand_r(&seed) / ((double)RAND_MAX + 1.0) < atomic_load(&state->errorRate) ? 500 : 200;
+        
+        char *query = strchr(target, '?');
+        char *position = NULL;
+        char *parameter = query ? strtok_r(query + 1, "&", &position) : NULL;
+        
+        while (parameter)
+        {
+            char *value = strchr(parameter, '=');
+            
+            if (value)
+            {
+                *value++ = '\0';
+                unsigned long long number = strtoull(value, NULL, 10);
+                
+                if (strcmp(parameter, "length") == 0)
+                    payloadLength = (size_t)number;
+                else if (strcmp(parameter, "latency") == 0)
+                    latency = number * 1000;
+                else if (strcmp(parameter, "status") == 0)
+                    status = (long)number;
+                else if (strcmp(parameter, "rate") == 0)
+                    bytesPerSecond = (size_t)number;
+            }
+            
+            parameter = strtok_r(NULL, "&", &position);
+        }
+        
+        if (latency > 0)
+            AMStandInServerSleepUntil(AMStandInServerCurrentTime() + latency);
+        
+        if (status != 200)
+            payloadLength = 0;
+        
+        char header[512];
+        int count = snprintf(header, sizeof(header),
+                             "HTTP/1.1 %ld %s\r\nContent-Type: application/octet-stream\r\nContent-Length: %zu\r\nCache-Control: no-store\r\nConnection: %s\r\n\r\n",
+                             status, AMStandInServerReasonPhrase(status), payloadLength, keepAlive ? "keep-alive" : "close");
+        
+        if (!AMStandInServerSend(&connection, header, (size_t)count) || !AMStandInServerSendBody(&connection, payloadLength, bytesPerSecond) || !keepAlive)
+            break;
+    }
+    
+    close(connection.socket);
+    atomic_fetch_sub(&state->activeConnectionCount, 1);
+    
+    return NULL;
+}
+
+static void AMStandInServerMain(int listeningSocket, AMStandInServerState *state) __attribute__((noreturn));
+
+static void AMStandInServerMain(int listeningSocket, AMStandInServerState *state)
+{
+#if defined(__linux__)
+    // Don't outlive a parent that crashes before stopping the server.
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+#endif
+    signal(SIGPIPE, SIG_IGN);
+    
+    // Keeping copies of the sockets of the parent would keep its connections open after it closes them.
+    for (int descriptor = getdtablesize() - 1; descriptor > STDERR_FILENO; --descriptor)
+    {
+        if (descriptor != listeningSocket)
+            close(descriptor);
+    }
+    
+    for (size_t i = 0; i < sizeof(AMStandInServerPattern); ++i)
+        AMStandInServerPattern[i] = (unsigned char)(i % AMStandInServerPatternPeriod);
+    
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+    pthread_attr_setstacksize(&attributes, 256 * 1024);
+    
+    while (YES)
+    {
+        int connectionSocket = accept(listeningSocket, NULL, NULL);
+        
+        if (connectionSocket < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED || errno == EMFILE || errno == ENFILE)
+                continue;
+            
+            _exit(EXIT_FAILURE);
+        }
+        
+        atomic_fetch_add(&state->connectionCount, 1);
+        
+        int sendBufferSize = (int)atomic_load(&state->sendBufferSize);
+        if (sendBufferSize > 0)
+            setsockopt(connectionSocket, SOL_SOCKET, SO_SNDBUF, &sendBufferSize, sizeof(sendBufferSize));
+        
+        AMStandInServerConnection *connection = malloc(sizeof(AMStandInServerConnection));
+        connection->socket = connectionSocket;
+        connection->state = state;
+        
+        pthread_t thread;
+        if (pthread_create(&thread, &attributes, AMStandInServerConnectionMain, connection) != 0)
+        {
+            close(connectionSocket);
+            free(connection);
+        }
+    }
+}
+
+@implementation AMStandInServer
+{
+    AMStandInServerState *_state;
+    pid_t _processIdentifier;
+}
+
+- (id)init
+{
+    return [self initWithHost:@"127.0.0.1"];
+}
+
+- (id)initWithHost:(NSString*)host
+{
+    self = [super init];
+    if (self)
+    {
+        _host = [host copy];
+        _processIdentifier = -1;
+        
+        // The state lives in shared memory so the parent can configure the server and read its statistics.
+        _state = mmap(NULL, sizeof(AMStandInServerState), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANON, -1, 0);
+        
+        if (_state == MAP_FAILED)
+            return nil;
+        
+        atomic_init(&_state->payloadLength, 1024);
+        atomic_init(&_state->latency, 0);
+        atomic_init(&_state->errorRate, 0.0);
+        atomic_init(&_state->bytesPerSecond, 0);
+        atomic_init(&_state->sendBufferSize, 0);
+        
+        atomic_init(&_state->requestCount, 0);
+        atomic_init(&_state->connectionCount, 0);
+        atomic_init(&_state->activeConnectionCount, 0);
+        atomic_init(&_state->peakConnectionCount, 0);
+        atomic_init(&_state->bytesSent, 0);
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [self stop];
+    munmap(_state, sizeof(AMStandInServerState));
+}
+
+#pragma mark Properties
+
+- (NSUInteger)payloadLength
+{
+    return atomic_load(&_state->payloadLength);
+}
+
+- (void)setPayloadLength:(NSUInteger)payloadLength
+{
+    atomic_store(&_state->payloadLength, payloadLength);
+}
+
+- (NSTimeInterval)latency
+{
+    return atomic_load(&_state->latency) / 1000000.0;
+}
+
+- (void)setLatency:(NSTimeInterval)latency
+{
+    atomic_store(&_state->latency, (uint64_t)(MAX(latency, 0.0) * 1000000.0));
+}
+
+- (double)errorRate
+{
+    return atomic_load(&_state->errorRate);
+}
+
+- (void)setErrorRate:(double)errorRate
+{
+    atomic_store(&_state->errorRate, errorRate);
+}
+
+- (NSUInteger)bytesPerSecond
+{
+    return atomic_load(&_state->bytesPerSecond);
+}
+
+- (void)setBytesPerSecond:(NSUInteger)bytesPerSecond
+{
+    atomic_store(&_state->bytesPerSecond, bytesPerSecond);
+}
+
+- (NSUInteger)sendBufferSize
+{
+    return atomic_load(&_state->sendBufferSize);
+}
+
+- (void)setSendBufferSize:(NSUInteger)sendBufferSize
+{
+    atomic_store(&_state->sendBufferSize, sendBufferSize);
+}
+
+- (unsigned long long)requestCount
+{
+    return atomic_load(&_state->requestCount);
+}
+
+- (unsigned long long)connectionCount
+{
+    return atomic_load(&_state->connectionCount);
+}
+
+- (unsigned long long)activeConnectionCount
+{
+    return atomic_load(&_state->activeConnectionCount);
+}
+
+- (unsigned long long)peakConnectionCount
+{
+    return atomic_load(&_state->peakConnectionCount);
+}
+
+- (unsigned long long)bytesSent
+{
+    return atomic_load(&_state->bytesSent);
+}
+
+#pragma mark Public Methods
+
+- (BOOL)start
+{
+    if (_processIdentifier > 0)
+        return YES;
+    
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = 0;
+    
+    if (inet_pton(AF_INET, [_host UTF8String], &address.sin_addr) != 1)
+        return NO;
+    
+    int listeningSocket = socket(AF_INET, SOCK_STREAM, 0);
+    
+    if (listeningSocket < 0)
+        return NO;
+    
+    int reuse = 1;
+    setsockopt(listeningSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    
+    socklen_t addressLength = sizeof(address);
+    
+    if (bind(listeningSocket, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+        listen(listeningSocket, 1024) != 0 ||
+        getsockname(listeningSocket, (struct sockaddr*)&address, &addressLength) != 0)
+    {
+        close(listeningSocket);
+        return NO;
+    }
+    
+    // The child process only runs the C code above: it never touches the Objective-C runtime or libdispatch, which are not safe to use after a fork.
+    pid_t processIdentifier = fork();
+    
+    if (processIdentifier == 0)
+        AMStandInServerMain(listeningSocket, _state);
+    
+    close(listeningSocket);
+    
+    if (processIdentifier < 0)
+        return NO;
+    
+    _processIdentifier = processIdentifier;
+    _port = ntohs(address.sin_port);
+    
+    return YES;
+}
+
+- (void)stop
+{
+    if (_processIdentifier <= 0)
+        return;
+    
+    kill(_processIdentifier, SIGKILL);
+    waitpid(_processIdentifier, NULL, 0);
+    
+    _processIdentifier = -1;
+    _port = 0;
+    atomic_store(&_state->activeConnectionCount, 0);
+}
+
+- (NSURL*)URLWithPath:(NSString*)path parameters:(NSDictionary*)parameters
+{
+    NSMutableString *string = [NSMutableString stringWithFormat:@"http://%@:%u%@", _host, _port, path.length > 0 ? path : @"/"];
+    
+    __block NSString *separator = @"?";
+    [parameters enumerateKeysAndObjectsUsingBlock:^(id key, id value, BOOL *stop) {
+        [string appendFormat:@"%@%@=%@", separator, key, value];
+        separator = @"&";
+    }];
+    
+    return [NSURL URLWithString:string];
+}
+
+- (NSURLRequest*)requestWithPath:(NSString*)path parameters:(NSDictionary*)parameters
+{
+    return [NSURLRequest requestWithURL:[self URLWithPath:path parameters:parameters]
+                            cachePolicy:NSURLRequestReloadIgnoringLocalCacheData
+                        timeoutInterval:60.0];
+}
+
+- (void)resetStatistics
+{
+    atomic_store(&_state->requestCount, 0);
+    atomic_store(&_state->connectionCount, 0);
+    atomic_store(&_state->peakConnectionCount, atomic_load(&_state->activeConnectionCount));
+    atomic_store(&_state->bytesSent, 0);
+}
+
+@end
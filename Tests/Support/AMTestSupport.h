@@ -0,0 +1,56 @@
+//
+//  AMTestSupport.h
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import <Foundation/Foundation.h>
+
+/*!
+ * A test case: a function that records failures with AMTestAssert.
+ */
+typedef struct
+{
+    const char *name;
+    void (*function)(void);
+} AMTestCase;
+
+/*!
+ * Records a failure when the condition is false. Can be used from any thread.
+ */
+#define AMTestAssert(condition, ...) \
+    do { if (!(condition)) AMTestRecordFailure(__FILE__, __LINE__, @#condition, [NSString stringWithFormat:__VA_ARGS__]); } while (0)
+
+/*!
+ * Records a failure of the running test case.
+ * @param file The source file.
+ * @param line The line in the source file.
+ * @param condition The condition that failed.
+ * @param message The explanation of the failure.
+ */
+extern void AMTestRecordFailure(const char *file, int line, NSString *condition, NSString *message);
+
+/*!
+ * Runs test cases, printing the result of each one.
+ * @param testCases The test cases.
+ * @param count The number of test cases.
+ * @return EXIT_SUCCESS if all the test cases passed, otherwise EXIT_FAILURE. Return it from main().
+ */
+extern int AMTestMain(const AMTestCase *testCases, size_t count);
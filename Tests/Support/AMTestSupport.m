@@ -0,0 +1,64 @@
+//
+//  AMTestSupport.m
+//  Created by agent.
+//
+// Copyright (c) 2026 agent, agent@local.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE
+
+#import "AMTestSupport.h"
+
+#import <stdatomic.h>
+#import <stdio.h>
+#import <stdlib.h>
+
+static atomic_ulong AMTestFailureCount;
+
+void AMTestRecordFailure(const char *file, int line, NSString *condition, NSString *message)
+{
+    atomic_fetch_add(&AMTestFailureCount, 1);
+    
+    fprintf(stderr, "%s:%d: failed (%s): %s\n", file, line, [condition UTF8String], [message UTF8String]);
+}
+
+int AMTestMain(const AMTestCase *testCases, size_t count)
+{
+    unsigned long failedCount = 0;
+    
+    for (size_t i = 0; i < count; ++i)
+    {
+        unsigned long failureCount = atomic_load(&AMTestFailureCount);
+        
+        @autoreleasepool
+        {
+            testCases[i].function();
+        }
+        
+        BOOL passed = atomic_load(&AMTestFailureCount) == failureCount;
+        
+        if (!passed)
+            ++failedCount;
+        
+        printf("[%s] %s\n", passed ? " OK " : "FAIL", testCases[i].name);
+        fflush(stdout);
+    }
+    
+    printf("%zu tests, %lu failed\n", count, failedCount);
+    
+    return failedCount > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}